@@ -0,0 +1,132 @@
+#include "AllocationCounter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<std::uint64_t> s_allocationCount = 0;
+
+	void* Allocate(std::size_t size)
+	{
+		s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+		// aligned_alloc requires the size to be a multiple of the alignment
+		const auto align = static_cast<std::size_t>(alignment);
+		const std::size_t alignedSize = (std::max(size, std::size_t{ 1 }) + align - 1) / align * align;
+#ifdef _MSC_VER
+		return _aligned_malloc(alignedSize, align);
+#else
+		return std::aligned_alloc(align, alignedSize);
+#endif
+	}
+
+	void FreeAligned(void* ptr)
+	{
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+
+	[[noreturn]]
+	void OnAllocationFailure()
+	{
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+		throw std::bad_alloc();
+#else
+		std::abort();
+#endif
+	}
+}
+
+std::uint64_t AllocationCount()
+{
+	return s_allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+	if (void* ptr = Allocate(size))
+	{
+		return ptr;
+	}
+	OnAllocationFailure();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void* ptr = AllocateAligned(size, alignment))
+	{
+		return ptr;
+	}
+	OnAllocationFailure();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(ptr);
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+
+// Number of calls to the global operator new since the program started
+// (counted by replacing the global allocation functions in AllocationCounter.cpp)
+[[nodiscard]]
+std::uint64_t AllocationCount();
@@ -0,0 +1,212 @@
+#include "FrameSimulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "kson/Util/GraphUtils.hpp"
+#include "kson/Util/JudgementLanes.hpp"
+#include "kson/Util/LaserGeometry.hpp"
+#include "kson/Util/ScrollCulling.hpp"
+#include "kson/Util/ScrollUtils.hpp"
+#include "kson/Util/TiltTimeline.hpp"
+#include "kson/Util/TimingUtils.hpp"
+#include "AllocationCounter.hpp"
+
+namespace
+{
+	using namespace kson;
+
+	// Notes are visible for this many pulses ahead of the current position
+	constexpr Pulse kVisiblePulses = kResolution4 * 4;
+
+	// Notes are visible for this many scroll units ahead of the current scroll position
+	constexpr double kVisibleScrollLength = static_cast<double>(kVisiblePulses);
+
+	// Notes later than this are regarded as missed
+	constexpr double kMissWindowMs = 150.0;
+
+	// Accumulates results so that the measured queries are not optimized away
+	volatile double s_sink = 0.0;
+
+	struct FrameState
+	{
+		const ChartData& chartData;
+		const TimingCache& timingCache;
+		const ScrollPositionCache& scrollCache;
+		const ScrollCullingIndex& scrollCullingIndex;
+		std::vector<std::size_t>& visibleNoteIndices;
+		JudgementLanes& judgementLanes;
+		LaserGeometry& laserGeometry;
+		TiltTimelineCursor& tiltCursor;
+	};
+
+	// Runs the queries a game performs in one frame and returns a value depending on all of their results
+	double SimulateFrame(FrameState& state, double ms, Pulse prevPulse)
+	{
+		const ChartData& chartData = state.chartData;
+		const BeatInfo& beat = chartData.beat;
+
+		const Pulse pulse = MsToPulse(ms, beat, state.timingCache);
+		const double pulseDouble = MsToPulseDouble(ms, beat, state.timingCache);
+		double result = PulseDoubleToScrollPosition(pulseDouble, state.scrollCache);
+		result += static_cast<double>(PulseToMeasureIdx(pulse, beat, state.timingCache));
+		result += GraphValueAt(beat.scrollSpeed, pulse);
+
+		// Visible notes (looked up by scroll position, since they are not a contiguous time window with negative scroll speeds)
+		const Pulse visibleEnd = pulse + kVisiblePulses;
+		FindVisibleNotes(state.scrollCullingIndex, state.scrollCache, pulseDouble, 0.0, kVisibleScrollLength, &state.visibleNoteIndices);
+		for (const std::size_t idx : state.visibleNoteIndices)
+		{
+			result += state.scrollCullingIndex.notes[idx].minScrollPosition;
+		}
+
+		// Lasers
+		for (const auto& lane : chartData.note.laser)
+		{
+			result += GraphSectionValueAt(lane, pulse).value_or(0.0);
+		}
+		BuildLaserGeometry(chartData.note.laser, pulse, visibleEnd, state.scrollCache, LaserGeometryParams{}, &state.laserGeometry);
+		for (const auto& lane : state.laserGeometry.lanes)
+		{
+			result += static_cast<double>(lane.vertices.size());
+		}
+
+		// Camera
+		const auto& cam = chartData.camera.cam.body;
+		result += GraphValueAt(cam.zoomBottom, pulse);
+		result += GraphValueAt(cam.zoomSide, pulse);
+		result += GraphValueAt(cam.zoomTop, pulse);
+		result += GraphValueAt(cam.rotationDeg, pulse);
+		result += GraphValueAt(cam.centerSplit, pulse);
+		result += state.tiltCursor.valueAt(pulseDouble);
+
+		// Key sounds triggered since the previous frame
+		if (prevPulse < pulse)
+		{
+			for (const auto& [name, lanes] : chartData.audio.keySound.fx.chipEvent)
+			{
+				for (const auto& lane : lanes)
+				{
+					result += static_cast<double>(CountInRange(lane, prevPulse, pulse));
+				}
+			}
+			for (const auto& [name, pulses] : chartData.audio.keySound.laser.slamEvent)
+			{
+				result += static_cast<double>(std::distance(pulses.lower_bound(prevPulse), pulses.lower_bound(pulse)));
+			}
+		}
+		result += ValueAtOrDefault(chartData.audio.keySound.laser.vol, pulse, 1.0);
+
+		// Judgement
+		for (auto& lane : state.judgementLanes.bt)
+		{
+			result += static_cast<double>(lane.advanceMisses(ms, kMissWindowMs));
+		}
+		for (auto& lane : state.judgementLanes.fx)
+		{
+			result += static_cast<double>(lane.advanceMisses(ms, kMissWindowMs));
+		}
+
+		return result;
+	}
+
+	std::int64_t Percentile(const std::vector<std::int64_t>& sortedValues, double percentile)
+	{
+		if (sortedValues.empty())
+		{
+			return 0;
+		}
+		const auto idx = static_cast<std::size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sortedValues.size()))) - 1;
+		return sortedValues[std::min(idx, sortedValues.size() - 1)];
+	}
+}
+
+FrameSimulationResult RunFrameSimulation(const kson::ChartData& chartData, const FrameSimulationOptions& options)
+{
+	const TimingCache timingCache = CreateTimingCache(chartData.beat);
+	const ScrollPositionCache scrollCache = CreateScrollPositionCache(chartData.beat);
+	const ScrollCullingIndex scrollCullingIndex = CreateScrollCullingIndex(chartData.note, scrollCache);
+	std::vector<std::size_t> visibleNoteIndices;
+	visibleNoteIndices.reserve(scrollCullingIndex.notes.size()); // So that no frame allocates
+	JudgementLanes judgementLanes = CreateJudgementLanes(chartData.note, chartData.beat, timingCache);
+	LaserGeometry laserGeometry;
+	const TiltTimeline tiltTimeline = CreateTiltTimeline(chartData.note, chartData.camera.tilt);
+	TiltTimelineCursor tiltCursor(tiltTimeline);
+	FrameState state{
+		.chartData = chartData,
+		.timingCache = timingCache,
+		.scrollCache = scrollCache,
+		.scrollCullingIndex = scrollCullingIndex,
+		.visibleNoteIndices = visibleNoteIndices,
+		.judgementLanes = judgementLanes,
+		.laserGeometry = laserGeometry,
+		.tiltCursor = tiltCursor,
+	};
+
+	const double frameMs = 1000.0 / options.fps;
+	const double endMs = PulseToMs(LastNoteEndY(chartData.note) + kResolution4, chartData.beat, timingCache);
+	const double seekIntervalMs = options.seekIntervalSec * 1000.0;
+	const double seekBackMs = options.seekBackSec * 1000.0;
+
+	FrameSimulationResult result;
+	std::vector<std::int64_t> frameNs;
+	frameNs.reserve(static_cast<std::size_t>(endMs / frameMs * (seekIntervalMs > 0.0 ? 1.0 + seekBackMs / seekIntervalMs : 1.0)) + 16);
+
+	double sink = 0.0;
+	double ms = 0.0;
+	double nextSeekMs = seekIntervalMs > 0.0 ? seekIntervalMs : endMs;
+	Pulse prevPulse = 0;
+	while (ms < endMs)
+	{
+		const bool seek = seekIntervalMs > 0.0 && ms >= nextSeekMs;
+		if (seek)
+		{
+			nextSeekMs = ms + seekIntervalMs;
+			ms = std::max(ms - seekBackMs, 0.0);
+			++result.numSeeks;
+		}
+
+		const std::uint64_t allocationCountBefore = AllocationCount();
+		const auto start = std::chrono::steady_clock::now();
+
+		if (seek)
+		{
+			// Seeking backward invalidates the judged states and the key sound cursor
+			judgementLanes.reset();
+			prevPulse = MsToPulse(ms, chartData.beat, timingCache);
+		}
+		sink += SimulateFrame(state, ms, prevPulse);
+		prevPulse = MsToPulse(ms, chartData.beat, timingCache);
+
+		const auto end = std::chrono::steady_clock::now();
+		const std::uint64_t numAllocations = AllocationCount() - allocationCountBefore;
+
+		frameNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+		result.numAllocations += numAllocations;
+		result.maxAllocationsPerFrame = std::max(result.maxAllocationsPerFrame, numAllocations);
+		if (numAllocations > 0)
+		{
+			++result.numFramesWithAllocations;
+		}
+
+		ms += frameMs;
+	}
+	s_sink = s_sink + sink;
+
+	result.numFrames = frameNs.size();
+	if (!frameNs.empty())
+	{
+		std::int64_t sum = 0;
+		for (const std::int64_t ns : frameNs)
+		{
+			sum += ns;
+		}
+		result.meanNs = sum / static_cast<std::int64_t>(frameNs.size());
+
+		std::sort(frameNs.begin(), frameNs.end());
+		result.p50Ns = Percentile(frameNs, 50.0);
+		result.p99Ns = Percentile(frameNs, 99.0);
+		result.p999Ns = Percentile(frameNs, 99.9);
+		result.maxNs = frameNs.back();
+	}
+	return result;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include "kson/ChartData.hpp"
+
+struct FrameSimulationOptions
+{
+	double fps = 240.0;
+
+	// A backward seek by seekBackSec happens every seekIntervalSec of playback (0 disables seeking)
+	double seekIntervalSec = 20.0;
+	double seekBackSec = 5.0;
+};
+
+struct FrameSimulationResult
+{
+	std::size_t numFrames = 0;
+	std::size_t numSeeks = 0;
+
+	std::int64_t p50Ns = 0;
+	std::int64_t p99Ns = 0;
+	std::int64_t p999Ns = 0;
+	std::int64_t maxNs = 0;
+	std::int64_t meanNs = 0;
+
+	std::uint64_t numAllocations = 0;
+	std::uint64_t maxAllocationsPerFrame = 0;
+	std::size_t numFramesWithAllocations = 0;
+};
+
+// Plays the whole chart frame by frame and measures the cost of the per-frame queries a game performs
+// (timing, scroll position, visible notes, laser geometry, camera graphs, tilt, key sounds and judgement)
+// Caches are created before the measurement as a game would do on loading
+[[nodiscard]]
+FrameSimulationResult RunFrameSimulation(const kson::ChartData& chartData, const FrameSimulationOptions& options);
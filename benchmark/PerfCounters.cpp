@@ -0,0 +1,160 @@
+#include "PerfCounters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace
+{
+	constexpr std::array<std::string_view, kNumPerfCounterKinds> kPerfCounterNames = {
+		"cycles",
+		"instructions",
+		"l1d_misses",
+		"llc_misses",
+		"branch_misses",
+	};
+
+#ifdef __linux__
+	constexpr std::uint64_t HWCacheConfig(std::uint64_t cache, std::uint64_t op, std::uint64_t result)
+	{
+		return cache | (op << 8) | (result << 16);
+	}
+
+	int OpenCounter(PerfCounterKind kind)
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1; // Allowed with perf_event_paranoid <= 2
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		switch (kind)
+		{
+		case kPerfCounterCycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case kPerfCounterInstructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case kPerfCounterL1DMisses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = HWCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+			break;
+		case kPerfCounterLLCMisses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = HWCacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+			break;
+		case kPerfCounterBranchMisses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		default:
+			return -1;
+		}
+
+		// Current thread, any CPU
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+#endif
+}
+
+std::string_view PerfCounterName(PerfCounterKind kind)
+{
+	return kind < kNumPerfCounterKinds ? kPerfCounterNames[kind] : "unknown";
+}
+
+PerfCounters::PerfCounters()
+{
+	m_fds.fill(-1);
+#ifdef __linux__
+	for (std::size_t i = 0; i < kNumPerfCounterKinds; ++i)
+	{
+		m_fds[i] = OpenCounter(static_cast<PerfCounterKind>(i));
+	}
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+	for (const int fd : m_fds)
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+#endif
+}
+
+bool PerfCounters::isAvailable(PerfCounterKind kind) const
+{
+	return m_fds[kind] >= 0;
+}
+
+bool PerfCounters::anyAvailable() const
+{
+	for (const int fd : m_fds)
+	{
+		if (fd >= 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+	for (const int fd : m_fds)
+	{
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+}
+
+PerfCounterValues PerfCounters::stop()
+{
+	PerfCounterValues values;
+#ifdef __linux__
+	for (const int fd : m_fds)
+	{
+		if (fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+
+	for (std::size_t i = 0; i < kNumPerfCounterKinds; ++i)
+	{
+		if (m_fds[i] < 0)
+		{
+			continue;
+		}
+
+		// value, time_enabled, time_running
+		std::uint64_t buf[3] = {};
+		if (read(m_fds[i], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)) || buf[2] == 0)
+		{
+			continue;
+		}
+
+		const double scale = static_cast<double>(buf[1]) / static_cast<double>(buf[2]);
+		values[i] = static_cast<std::uint64_t>(static_cast<double>(buf[0]) * scale);
+	}
+#endif
+	return values;
+}
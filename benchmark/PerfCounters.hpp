@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Hardware performance counters via Linux perf_event_open
+// Counters that cannot be opened (non-Linux, containers, perf_event_paranoid, unsupported events) are reported as unavailable
+enum PerfCounterKind : std::size_t
+{
+	kPerfCounterCycles = 0,
+	kPerfCounterInstructions,
+	kPerfCounterL1DMisses,
+	kPerfCounterLLCMisses,
+	kPerfCounterBranchMisses,
+
+	kNumPerfCounterKinds,
+};
+
+[[nodiscard]]
+std::string_view PerfCounterName(PerfCounterKind kind);
+
+using PerfCounterValues = std::array<std::optional<std::uint64_t>, kNumPerfCounterKinds>;
+
+class PerfCounters
+{
+private:
+	std::array<int, kNumPerfCounterKinds> m_fds;
+
+public:
+	PerfCounters();
+
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	[[nodiscard]]
+	bool isAvailable(PerfCounterKind kind) const;
+
+	[[nodiscard]]
+	bool anyAvailable() const;
+
+	// Resets and enables the counters
+	void start();
+
+	// Disables the counters and returns the counts since start()
+	// Counts are scaled if the kernel multiplexed the counters
+	[[nodiscard]]
+	PerfCounterValues stop();
+};
@@ -0,0 +1,438 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include "kson/kson.hpp"
+#include "FrameSimulation.hpp"
+#include "PerfCounters.hpp"
+
+#ifndef KSON_BENCH_VERSION
+#define KSON_BENCH_VERSION "unknown"
+#endif
+
+enum ExitCode : int
+{
+	kExitSuccess = 0,
+	kExitInvalidArgument,
+	kExitError,
+};
+
+namespace
+{
+	struct BenchOptions
+	{
+		std::size_t repeat = 10;
+
+		std::size_t numMeasures = 512;
+
+		std::string filter;
+
+		double fps = 240.0;
+
+		std::vector<std::string> inputFiles;
+	};
+
+	struct BenchInput
+	{
+		std::string name;
+
+		kson::ChartData chartData;
+
+		std::string ksh;
+
+		std::string kson;
+	};
+
+	struct BenchCase
+	{
+		std::string name;
+
+		std::function<void(const BenchInput&)> func;
+	};
+
+	// Accumulates results so that the measured work is not optimized away
+	volatile double g_sink = 0.0;
+
+	void PrintHelp()
+	{
+		std::cerr <<
+			"kson_bench benchmark harness\n"
+			"  Usage:\n"
+			"    kson_bench [options] [input.ksh|input.kson ...]\n"
+			"  Options:\n"
+			"    --repeat <n>      Number of measured iterations per case (default: 10)\n"
+			"    --measures <n>    Number of measures in the generated chart (default: 512)\n"
+			"    --filter <str>    Run only cases whose name contains <str>\n"
+			"    --fps <n>         Frame rate of the frame_simulation case (default: 240)\n"
+			"  Results are written to stdout as JSON. A generated chart is used if no input is given.\n"
+			"  Hardware counters are reported as null if perf_event_open is unavailable.\n"
+			"  frame_simulation plays whole charts at --fps (with backward seeks) and reports per-frame\n"
+			"  latency percentiles and allocation counts instead of per-iteration wall-clock time.\n";
+	}
+
+	bool ParseSize(const char* str, std::size_t* pValue)
+	{
+		char* end = nullptr;
+		const unsigned long long value = std::strtoull(str, &end, 10);
+		if (end == str || *end != '\0' || value == 0)
+		{
+			return false;
+		}
+		*pValue = static_cast<std::size_t>(value);
+		return true;
+	}
+
+	bool ParsePositiveDouble(const char* str, double* pValue)
+	{
+		char* end = nullptr;
+		const double value = std::strtod(str, &end);
+		if (end == str || *end != '\0' || !(value > 0.0) || !std::isfinite(value))
+		{
+			return false;
+		}
+		*pValue = value;
+		return true;
+	}
+
+	bool ParseArgs(int argc, char* argv[], BenchOptions* pOptions)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			if (arg == "--help" || arg == "-h")
+			{
+				return false;
+			}
+			else if (arg == "--repeat" || arg == "--measures" || arg == "--filter" || arg == "--fps")
+			{
+				if (i + 1 >= argc)
+				{
+					std::cerr << "Error: Missing value for " << arg << '\n';
+					return false;
+				}
+				const char* value = argv[++i];
+				if (arg == "--filter")
+				{
+					pOptions->filter = value;
+				}
+				else if (arg == "--fps")
+				{
+					if (!ParsePositiveDouble(value, &pOptions->fps))
+					{
+						std::cerr << "Error: Invalid value for " << arg << ": " << value << '\n';
+						return false;
+					}
+				}
+				else if (!ParseSize(value, arg == "--repeat" ? &pOptions->repeat : &pOptions->numMeasures))
+				{
+					std::cerr << "Error: Invalid value for " << arg << ": " << value << '\n';
+					return false;
+				}
+			}
+			else if (arg.starts_with("--"))
+			{
+				std::cerr << "Error: Unknown option: " << arg << '\n';
+				return false;
+			}
+			else
+			{
+				pOptions->inputFiles.emplace_back(arg);
+			}
+		}
+		return true;
+	}
+
+	// Generates a chart with the specified number of 4/4 measures containing typical notes and events
+	kson::ChartData GenerateChart(std::size_t numMeasures)
+	{
+		kson::ChartData chartData;
+		chartData.meta.title = "generated";
+		chartData.beat.bpm[0] = 180.0;
+		chartData.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+		chartData.beat.scrollSpeed[0] = kson::GraphValue{ 1.0 };
+
+		constexpr kson::Pulse kMeasure = kson::kResolution4;
+		for (std::size_t i = 0; i < numMeasures; ++i)
+		{
+			const kson::Pulse y = static_cast<kson::Pulse>(i) * kMeasure;
+
+			for (kson::Pulse j = 0; j < 16; ++j)
+			{
+				chartData.note.bt[j % kson::kNumBTLanes][y + j * kMeasure / 16] = kson::Interval{ 0 };
+			}
+			chartData.note.fx[i % kson::kNumFXLanes][y] = kson::Interval{ kMeasure / 2 };
+
+			auto& section = chartData.note.laser[i % kson::kNumLaserLanes][y];
+			section.v.emplace(0, kson::GraphPoint{ kson::GraphValue{ 0.0, 1.0 } });
+			section.v.emplace(kMeasure / 2, kson::GraphPoint{ kson::GraphValue{ 0.5 }, kson::GraphCurveValue{ 0.2, 0.8 } });
+			section.v.emplace(kMeasure * 3 / 4, kson::GraphPoint{ kson::GraphValue{ 0.0 } });
+
+			if (i % 8 == 0)
+			{
+				chartData.beat.bpm[y] = 180.0 + static_cast<double>(i % 16);
+				chartData.beat.scrollSpeed[y] = kson::GraphValue{ 1.0 + static_cast<double>(i % 3) * 0.5 };
+				chartData.camera.cam.body.zoomBottom[y] = kson::GraphValue{ static_cast<double>(i % 5) * 0.1 };
+				chartData.camera.tilt[y] = i % 16 == 0 ? kson::TiltValue{ kson::AutoTiltType::kBigger } : kson::TiltValue{ kson::AutoTiltType::kNormal };
+			}
+			chartData.audio.keySound.fx.chipEvent["clap"][i % kson::kNumFXLanes][y + kMeasure / 2] = kson::KeySoundInvokeFX{};
+			chartData.audio.keySound.laser.slamEvent["slam_up"].insert(y + kMeasure / 2);
+		}
+		return chartData;
+	}
+
+	bool PrepareInput(BenchInput* pInput)
+	{
+		std::ostringstream kshStream;
+		std::ostringstream ksonStream;
+		if (kson::SaveKshChartData(kshStream, pInput->chartData) != kson::ErrorType::None
+			|| kson::SaveKsonChartData(ksonStream, pInput->chartData) != kson::ErrorType::None)
+		{
+			std::cerr << "Error: Cannot serialize input: " << pInput->name << '\n';
+			return false;
+		}
+		pInput->ksh = kshStream.str();
+		pInput->kson = ksonStream.str();
+		return true;
+	}
+
+	std::vector<BenchCase> CreateBenchCases()
+	{
+		return {
+			{ "load_ksh", [](const BenchInput& input)
+			{
+				std::istringstream iss(input.ksh);
+				g_sink = g_sink + static_cast<double>(kson::LoadKshChartData(iss).note.bt[0].size());
+			} },
+			{ "save_ksh", [](const BenchInput& input)
+			{
+				std::ostringstream oss;
+				static_cast<void>(kson::SaveKshChartData(oss, input.chartData));
+				g_sink = g_sink + static_cast<double>(oss.tellp());
+			} },
+			{ "load_kson", [](const BenchInput& input)
+			{
+				std::istringstream iss(input.kson);
+				g_sink = g_sink + static_cast<double>(kson::LoadKsonChartData(iss).note.bt[0].size());
+			} },
+			{ "save_kson", [](const BenchInput& input)
+			{
+				std::ostringstream oss;
+				static_cast<void>(kson::SaveKsonChartData(oss, input.chartData));
+				g_sink = g_sink + static_cast<double>(oss.tellp());
+			} },
+			{ "timing_pulse_to_ms", [](const BenchInput& input)
+			{
+				const kson::TimingCache cache = kson::CreateTimingCache(input.chartData.beat);
+				double sum = 0.0;
+				for (const auto& lane : input.chartData.note.bt)
+				{
+					for (const auto& [y, _] : lane)
+					{
+						sum += kson::PulseToMs(y, input.chartData.beat, cache);
+					}
+				}
+				g_sink = g_sink + sum;
+			} },
+			{ "graph_value_at", [](const BenchInput& input)
+			{
+				const kson::Pulse lastPulse = input.chartData.beat.scrollSpeed.empty() ? 0 : input.chartData.beat.scrollSpeed.rbegin()->first + kson::kResolution4;
+				double sum = 0.0;
+				for (kson::Pulse y = 0; y < lastPulse; y += kson::kResolution4 / 16)
+				{
+					sum += kson::GraphValueAt(input.chartData.beat.scrollSpeed, y);
+				}
+				g_sink = g_sink + sum;
+			} },
+		};
+	}
+
+	nlohmann::json RunFrameSimulationCase(const BenchInput& input, double fps)
+	{
+		const FrameSimulationResult result = RunFrameSimulation(input.chartData, { .fps = fps });
+		return {
+			{ "name", "frame_simulation" },
+			{ "input", input.name },
+			{ "fps", fps },
+			{ "num_frames", result.numFrames },
+			{ "num_seeks", result.numSeeks },
+			{ "frame_ns", {
+				{ "p50", result.p50Ns },
+				{ "p99", result.p99Ns },
+				{ "p999", result.p999Ns },
+				{ "max", result.maxNs },
+				{ "mean", result.meanNs },
+			} },
+			{ "allocations", {
+				{ "total", result.numAllocations },
+				{ "max_per_frame", result.maxAllocationsPerFrame },
+				{ "frames_with_allocations", result.numFramesWithAllocations },
+			} },
+		};
+	}
+
+	nlohmann::json RunBenchCase(const BenchCase& benchCase, const BenchInput& input, std::size_t repeat, PerfCounters& counters)
+	{
+		// Warm-up
+		benchCase.func(input);
+
+		std::vector<std::int64_t> wallNs;
+		std::array<std::vector<std::uint64_t>, kNumPerfCounterKinds> counterValues;
+		wallNs.reserve(repeat);
+		for (std::size_t i = 0; i < repeat; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			counters.start();
+			benchCase.func(input);
+			const PerfCounterValues values = counters.stop();
+			const auto end = std::chrono::steady_clock::now();
+
+			wallNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+			for (std::size_t k = 0; k < kNumPerfCounterKinds; ++k)
+			{
+				if (values[k].has_value())
+				{
+					counterValues[k].push_back(*values[k]);
+				}
+			}
+		}
+
+		std::sort(wallNs.begin(), wallNs.end());
+		std::int64_t wallSum = 0;
+		for (const std::int64_t ns : wallNs)
+		{
+			wallSum += ns;
+		}
+
+		nlohmann::json counterJson = nlohmann::json::object();
+		for (std::size_t k = 0; k < kNumPerfCounterKinds; ++k)
+		{
+			const std::string name(PerfCounterName(static_cast<PerfCounterKind>(k)));
+			auto& values = counterValues[k];
+			if (values.size() != repeat)
+			{
+				// Unavailable or failed to read in some iterations
+				counterJson[name] = nullptr;
+				continue;
+			}
+			std::sort(values.begin(), values.end());
+			counterJson[name] = values[values.size() / 2];
+		}
+
+		return {
+			{ "name", benchCase.name },
+			{ "input", input.name },
+			{ "iterations", repeat },
+			{ "wall_ns", {
+				{ "min", wallNs.front() },
+				{ "median", wallNs[wallNs.size() / 2] },
+				{ "mean", wallSum / static_cast<std::int64_t>(wallNs.size()) },
+			} },
+			{ "counters", counterJson }, // Median per iteration
+		};
+	}
+}
+
+int Run(int argc, char* argv[])
+{
+	BenchOptions options;
+	if (!ParseArgs(argc, argv, &options))
+	{
+		PrintHelp();
+		return kExitInvalidArgument;
+	}
+
+	std::vector<BenchInput> inputs;
+	if (options.inputFiles.empty())
+	{
+		inputs.push_back({ .name = "generated_" + std::to_string(options.numMeasures), .chartData = GenerateChart(options.numMeasures) });
+	}
+	for (const std::string& filePath : options.inputFiles)
+	{
+		const bool isKson = std::filesystem::path(filePath).extension() == ".kson";
+		kson::ChartData chartData = isKson ? kson::LoadKsonChartData(filePath) : kson::LoadKshChartData(filePath);
+		if (chartData.error != kson::ErrorType::None)
+		{
+			std::cerr << "Error: " << kson::GetErrorString(chartData.error) << ": " << filePath << '\n';
+			return kExitError;
+		}
+		inputs.push_back({ .name = filePath, .chartData = std::move(chartData) });
+	}
+	for (BenchInput& input : inputs)
+	{
+		if (!PrepareInput(&input))
+		{
+			return kExitError;
+		}
+	}
+
+	PerfCounters counters;
+	nlohmann::json countersAvailable = nlohmann::json::object();
+	for (std::size_t k = 0; k < kNumPerfCounterKinds; ++k)
+	{
+		const auto kind = static_cast<PerfCounterKind>(k);
+		countersAvailable[std::string(PerfCounterName(kind))] = counters.isAvailable(kind);
+	}
+	if (!counters.anyAvailable())
+	{
+		std::cerr << "Warning: Hardware performance counters are unavailable; only wall-clock time is reported\n";
+	}
+
+	nlohmann::json benchmarks = nlohmann::json::array();
+	for (const BenchCase& benchCase : CreateBenchCases())
+	{
+		if (!options.filter.empty() && benchCase.name.find(options.filter) == std::string::npos)
+		{
+			continue;
+		}
+		for (const BenchInput& input : inputs)
+		{
+			benchmarks.push_back(RunBenchCase(benchCase, input, options.repeat, counters));
+		}
+	}
+
+	nlohmann::json frameSimulations = nlohmann::json::array();
+	if (options.filter.empty() || std::string_view{ "frame_simulation" }.find(options.filter) != std::string_view::npos)
+	{
+		for (const BenchInput& input : inputs)
+		{
+			frameSimulations.push_back(RunFrameSimulationCase(input, options.fps));
+		}
+	}
+
+	const nlohmann::json result = {
+		{ "version", KSON_BENCH_VERSION },
+		{ "perf_counters_available", countersAvailable },
+		{ "benchmarks", benchmarks },
+		{ "frame_simulations", frameSimulations },
+	};
+	std::cout << result.dump(2) << '\n';
+
+	return kExitSuccess;
+}
+
+int main(int argc, char* argv[])
+{
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		return Run(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: Uncaught exception '" << e.what() << "'\n";
+		return kExitError;
+	}
+	catch (...)
+	{
+		std::cerr << "Error: Uncaught exception (unknown)\n";
+		return kExitError;
+	}
+#else
+	return Run(argc, argv);
+#endif
+}
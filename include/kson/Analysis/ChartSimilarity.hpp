@@ -0,0 +1,93 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+#include <unordered_map>
+
+namespace kson
+{
+	constexpr std::size_t kMinHashSignatureSize = 128;
+
+	using MinHashSignature = std::array<std::uint32_t, kMinHashSignatureSize>;
+
+	struct ChartShingleParams
+	{
+		// Number of grid cells per measure for quantizing note positions and lengths
+		std::int32_t measureDivision = 48;
+
+		// Number of consecutive non-empty measures in a shingle
+		std::int32_t measuresPerShingle = 2;
+
+		// Number of steps for quantizing laser values (0.0-1.0)
+		std::int32_t laserValueSteps = 10;
+	};
+
+	// Returns the sorted hashes of shingles derived from the quantized note and laser patterns
+	// Positions are relative to the measure, and empty measures are skipped, so the shingles do not depend on the metadata,
+	// the audio offset or the number of leading empty measures
+	[[nodiscard]]
+	std::vector<std::uint64_t> ExtractChartShingles(const ChartData& chartData, const ChartShingleParams& params = {});
+
+	// The values are stable across platforms, so signatures can be stored
+	[[nodiscard]]
+	MinHashSignature ComputeMinHashSignature(const std::vector<std::uint64_t>& shingles);
+
+	[[nodiscard]]
+	MinHashSignature ComputeMinHashSignature(const ChartData& chartData, const ChartShingleParams& params = {});
+
+	// Estimates the Jaccard similarity (0.0-1.0) of the shingle sets
+	[[nodiscard]]
+	double EstimateSimilarity(const MinHashSignature& a, const MinHashSignature& b);
+
+	struct ChartSimilarityIndexParams
+	{
+		// Number of LSH bands (rounded down to a divisor of kMinHashSignatureSize)
+		// More bands find candidates with lower similarity (16 bands: candidates mostly have similarity >= 0.7)
+		std::size_t numBands = 16;
+	};
+
+	struct SimilarChart
+	{
+		std::uint64_t id = 0;
+
+		double similarity = 0.0;
+	};
+
+	// Finds near-duplicate charts with locality-sensitive hashing of MinHash signatures
+	class ChartSimilarityIndex
+	{
+	private:
+		std::size_t m_numBands;
+		std::size_t m_numRows;
+
+		std::vector<std::uint64_t> m_ids;
+		std::vector<MinHashSignature> m_signatures;
+
+		// Band hash -> entry indices, for each band
+		std::vector<std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>> m_buckets;
+
+		[[nodiscard]]
+		std::uint64_t bandHash(const MinHashSignature& signature, std::size_t bandIdx) const;
+
+		[[nodiscard]]
+		std::vector<std::uint32_t> candidateIndices(const MinHashSignature& signature) const;
+
+	public:
+		explicit ChartSimilarityIndex(const ChartSimilarityIndexParams& params = {});
+
+		void add(std::uint64_t id, const MinHashSignature& signature);
+
+		[[nodiscard]]
+		std::size_t size() const;
+
+		[[nodiscard]]
+		std::size_t numBands() const;
+
+		// Returns the ids of the charts sharing at least one band
+		[[nodiscard]]
+		std::vector<std::uint64_t> findCandidates(const MinHashSignature& signature) const;
+
+		// Returns the candidates with the estimated similarity >= minSimilarity, in descending order of similarity
+		[[nodiscard]]
+		std::vector<SimilarChart> findSimilar(const MinHashSignature& signature, double minSimilarity) const;
+	};
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+
+namespace kson
+{
+	// Grid size of the lane bitsets (1/192 of a 4/4 measure, same as the KSH resolution)
+	constexpr Pulse kPatternGridPulse = kResolution4 / 192;
+
+	struct PatternAnalysisParams
+	{
+		// Intervals are in grid cells (kPatternGridPulse)
+		std::int32_t jackMaxInterval = 24; // 1/8
+		std::int32_t trillMaxInterval = 12; // 1/16
+		std::int32_t streamMaxInterval = 12; // 1/16
+		std::int32_t streamMinLength = 8; // Minimum number of notes in a stream
+	};
+
+	struct PatternFeatures
+	{
+		std::int64_t numNotes = 0; // BT and FX notes (chips and long notes)
+		std::int64_t numChords = 0; // Grid cells where two or more BT/FX notes start
+		std::int64_t numJacks = 0; // Notes followed by another note in the same lane within jackMaxInterval
+		std::int64_t numTrills = 0; // Notes followed by notes in another lane and then the same lane at the same interval (<= trillMaxInterval)
+		std::int64_t numStreamNotes = 0; // BT note cells in streams
+		std::int64_t maxStreamLength = 0;
+		std::int64_t numCrossovers = 0; // BT notes on the opposite side of a simultaneously pressed FX
+	};
+
+	// Rasterizes lanes into per-lane bitsets and extracts pattern features with word-parallel bit operations
+	// The buffers are reused, so an analyzer should be reused across charts (an analyzer is not thread-safe)
+	class PatternAnalyzer
+	{
+	private:
+		using Bitset = std::vector<std::uint64_t>;
+
+		std::array<Bitset, kNumBTLanesSZ> m_btHeads;
+		std::array<Bitset, kNumFXLanesSZ> m_fxHeads;
+		std::array<Bitset, kNumFXLanesSZ> m_fxHolds; // Cells pressed by FX notes (including the start cell)
+		Bitset m_btHeadUnion;
+
+		std::size_t m_numWords = 0;
+
+		void rasterize(const NoteInfo& note);
+
+	public:
+		PatternAnalyzer() = default;
+
+		[[nodiscard]]
+		PatternFeatures analyze(const ChartData& chartData, const PatternAnalysisParams& params = {});
+	};
+
+	[[nodiscard]]
+	PatternFeatures AnalyzePatternFeatures(const ChartData& chartData, const PatternAnalysisParams& params = {});
+
+	// Analyzes charts in parallel (numThreads = 0 uses the number of hardware threads)
+	[[nodiscard]]
+	std::vector<PatternFeatures> AnalyzePatternFeatures(const std::vector<const ChartData*>& charts, const PatternAnalysisParams& params = {}, std::size_t numThreads = 0);
+}
@@ -49,9 +49,14 @@ namespace kson
 		bool defContains(std::string_view name) const;
 
 		// Note: This is inefficient, so be careful when using it
+		// Throws std::runtime_error if not found
 		[[nodiscard]]
 		const AudioEffectDef& defByName(std::string_view name) const;
 
+		// Same as defByName, but returns nullptr if not found
+		[[nodiscard]]
+		const AudioEffectDef* findDef(std::string_view name) const;
+
 		[[nodiscard]]
 		Dict<AudioEffectDef> defAsDict() const;
 	};
@@ -76,9 +81,14 @@ namespace kson
 
 		// Note: If you call this function frequently, it's recommended to first call defAsDict to get the dictionary and use it,
 		//       as this function uses linear search.
+		// Throws std::runtime_error if not found
 		[[nodiscard]]
 		const AudioEffectDef& defByName(std::string_view name) const;
 
+		// Same as defByName, but returns nullptr if not found
+		[[nodiscard]]
+		const AudioEffectDef* findDef(std::string_view name) const;
+
 		[[nodiscard]]
 		Dict<AudioEffectDef> defAsDict() const;
 	};
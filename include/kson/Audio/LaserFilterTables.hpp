@@ -0,0 +1,126 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/Audio/AudioEffect.hpp"
+#include <optional>
+
+namespace kson
+{
+	enum class LaserFilterParamUnit
+	{
+		Frequency, // "Hz", "kHz" (Hz if no unit)
+		Gain, // "dB", or "%" of kPeakingFilterMaxGainDb (dB if no unit)
+		Plain, // Unitless (e.g., q)
+	};
+
+	// Peak gain of peaking_filter for gain="100%"
+	constexpr double kPeakingFilterMaxGainDb = 18.0;
+
+	// Audio effect parameter value in "<off>><on_min>-<on_max>" format
+	// ("<off>>" and "-<on_max>" can be omitted; the off value is used while the effect is inactive)
+	struct LaserFilterParamValue
+	{
+		double off = 0.0;
+		double onMin = 0.0; // Value at laser position 0.0
+		double onMax = 0.0; // Value at laser position 1.0
+
+		// Interpolates between onMin and onMax (geometrically if logScale, e.g., for frequencies)
+		[[nodiscard]]
+		double at(double laserPosition, bool logScale) const;
+	};
+
+	[[nodiscard]]
+	std::optional<LaserFilterParamValue> ParseLaserFilterParamValue(std::string_view str, LaserFilterParamUnit unit);
+
+	// Normalized biquad coefficients (a0 = 1):
+	// y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+	struct BiquadCoefficients
+	{
+		float b0 = 1.0f;
+		float b1 = 0.0f;
+		float b2 = 0.0f;
+		float a1 = 0.0f;
+		float a2 = 0.0f;
+	};
+
+	// Coefficients by the Audio EQ Cookbook (RBJ) formulas
+	[[nodiscard]]
+	BiquadCoefficients LowPassFilterCoefficients(double freq, double q, double sampleRate);
+
+	[[nodiscard]]
+	BiquadCoefficients HighPassFilterCoefficients(double freq, double q, double sampleRate);
+
+	[[nodiscard]]
+	BiquadCoefficients PeakingFilterCoefficients(double freq, double q, double gainDb, double sampleRate);
+
+	// Parameters of a laser filter resolved from the definition and the param changes
+	struct LaserFilterParams
+	{
+		AudioEffectType type = AudioEffectType::Unspecified;
+		LaserFilterParamValue freq;
+		LaserFilterParamValue q;
+		LaserFilterParamValue gain; // In dB (peaking_filter only)
+	};
+
+	// Returns the default parameters of peaking_filter, low_pass_filter and high_pass_filter
+	// (approximations of KSM's preset filters), or std::nullopt for other types
+	[[nodiscard]]
+	std::optional<LaserFilterParams> DefaultLaserFilterParams(AudioEffectType type);
+
+	// Overwrites the parameters with the values in params ("freq", "q" and "gain"; unparsable values are ignored)
+	void ApplyLaserFilterParams(const AudioEffectParams& params, LaserFilterParams* pFilterParams);
+
+	struct LaserFilterTableOptions
+	{
+		double sampleRate = 44100.0;
+
+		// Number of quantization steps of the laser position (0.0-1.0)
+		std::size_t numPositionSteps = 256;
+
+		// Number of quantization steps of the legacy filter gain (0.0-1.0; peaking_filter only)
+		std::size_t numFilterGainSteps = 16;
+	};
+
+	// Biquad coefficients precomputed for quantized laser positions (and legacy filter gains for peaking_filter)
+	class LaserFilterCoefficientTable
+	{
+	private:
+		std::vector<BiquadCoefficients> m_coefficients; // [filterGainIdx][positionIdx]
+		std::size_t m_numPositionSteps = 0;
+		std::size_t m_numFilterGainSteps = 0;
+
+	public:
+		LaserFilterCoefficientTable() = default;
+
+		LaserFilterCoefficientTable(const LaserFilterParams& filterParams, const LaserFilterTableOptions& options);
+
+		[[nodiscard]]
+		bool empty() const;
+
+		// Linearly interpolates the coefficients of the neighboring table entries
+		// No transcendental functions or allocations, so this is safe to call from the audio callback
+		// filterGain scales the gain of peaking_filter (1.0 = as specified) and is ignored for other types
+		[[nodiscard]]
+		BiquadCoefficients at(double laserPosition, double filterGain = 1.0) const;
+	};
+
+	// Coefficient tables of the laser filters in a chart, one per effect and param change segment
+	class LaserFilterTables
+	{
+	private:
+		std::map<std::string, ByPulse<LaserFilterCoefficientTable>, std::less<>> m_tables; // Looked up without allocating a key
+		ByPulse<double> m_filterGain;
+
+	public:
+		LaserFilterTables() = default;
+
+		explicit LaserFilterTables(const AudioEffectLaserInfo& laserInfo, const LaserFilterTableOptions& options = {});
+
+		// Returns nullptr if the effect is not a filter
+		[[nodiscard]]
+		const LaserFilterCoefficientTable* find(std::string_view effectName, Pulse pulse) const;
+
+		// Legacy filter gain ("pfiltergain" in KSH format) at the pulse, or 1.0 if not specified
+		[[nodiscard]]
+		double filterGainAt(Pulse pulse) const;
+	};
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include "kson/Common/Common.hpp"
+#include "kson/Error.hpp"
+
+namespace kson
+{
+	// Shard idx of count (e.g., "2/8" in command lines; idx is 0-based)
+	struct BatchShard
+	{
+		std::size_t idx = 0;
+		std::size_t count = 1;
+	};
+
+	// Parses "<idx>/<count>" (0 <= idx < count)
+	[[nodiscard]]
+	std::optional<BatchShard> ParseBatchShard(std::string_view str);
+
+	// Shard of the path, determined by a hash of the path string so that every node computes the same partition
+	// regardless of the order of the manifest
+	[[nodiscard]]
+	std::size_t BatchShardIdxOf(std::string_view path, std::size_t numShards);
+
+	// Paths of the manifest in the shard (in manifest order)
+	[[nodiscard]]
+	std::vector<std::string> SelectBatchShard(const std::vector<std::string>& paths, const BatchShard& shard);
+
+	struct BatchManifest
+	{
+		std::vector<std::string> paths;
+
+		ErrorType error = ErrorType::None;
+	};
+
+	// One input path per line (empty lines and lines starting with '#' are ignored)
+	[[nodiscard]]
+	BatchManifest LoadBatchManifest(std::istream& stream);
+
+	[[nodiscard]]
+	BatchManifest LoadBatchManifest(const std::string& filePath);
+
+	enum class BatchStatus
+	{
+		Done,
+		Failed,
+	};
+
+	// Result of one file (fields are tool-defined, e.g., the output path and stats, or the error message)
+	struct BatchRecord
+	{
+		BatchStatus status = BatchStatus::Done;
+		std::string path;
+		std::vector<std::string> fields;
+
+		bool operator==(const BatchRecord&) const = default;
+	};
+
+	// Tab-separated line without the line break ("done" or "failed", path, fields...)
+	// Tabs, line breaks and backslashes in the values are escaped
+	[[nodiscard]]
+	std::string FormatBatchRecord(const BatchRecord& record);
+
+	[[nodiscard]]
+	std::optional<BatchRecord> ParseBatchRecord(std::string_view line);
+
+	// Append-only journal of the processed files
+	// Each record is flushed as soon as it is appended, so an interrupted job resumes from the files not recorded as done
+	// (a partially written last line is ignored; failed files are processed again)
+	// Thread-safe
+	class BatchJournal
+	{
+	private:
+		mutable std::mutex m_mutex;
+		std::ofstream m_stream;
+		std::unordered_map<std::string, BatchStatus> m_statuses;
+
+	public:
+		BatchJournal() = default;
+
+		BatchJournal(const BatchJournal&) = delete;
+
+		BatchJournal& operator=(const BatchJournal&) = delete;
+
+		// Reads the existing records and opens the file for appending
+		[[nodiscard]]
+		ErrorType open(const std::string& filePath);
+
+		[[nodiscard]]
+		bool isDone(const std::string& path) const;
+
+		[[nodiscard]]
+		ErrorType append(const BatchRecord& record);
+	};
+
+	// Reads the records of a journal (partially written lines are skipped)
+	[[nodiscard]]
+	ErrorType LoadBatchJournal(const std::string& filePath, std::vector<BatchRecord>* pRecords);
+
+	// Combines the journals of all shards, keeping the last record of each path, sorted by path
+	[[nodiscard]]
+	ErrorType MergeBatchJournals(const std::vector<std::string>& journalFilePaths, std::vector<BatchRecord>* pRecords);
+
+	struct BatchJobOptions
+	{
+		BatchShard shard;
+
+		std::string journalFilePath;
+
+		std::size_t numThreads = 0; // 0 = number of hardware threads
+	};
+
+	struct BatchJobResult
+	{
+		std::size_t numFiles = 0; // Files in the shard
+		std::size_t numSkipped = 0; // Files already done in the journal
+		std::size_t numDone = 0;
+		std::size_t numFailed = 0;
+
+		ErrorType error = ErrorType::None;
+	};
+
+	// Returns the record of the file (the path of the returned record is ignored)
+	// Called from multiple threads at the same time
+	using BatchFileProcessor = std::function<BatchRecord(const std::string& path)>;
+
+	// Processes the files of the shard that are not done in the journal in parallel and appends their records to the journal
+	[[nodiscard]]
+	BatchJobResult RunBatchJob(const std::vector<std::string>& manifestPaths, const BatchJobOptions& options, const BatchFileProcessor& processor);
+}
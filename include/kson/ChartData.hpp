@@ -25,6 +25,9 @@ namespace kson
 		ErrorType error = ErrorType::None;
 	};
 
+	// Reading functions (const member functions and free functions taking const references) have no hidden mutable state,
+	// so one ChartData and the caches created from it can be read by multiple threads at the same time
+	// Modification requires exclusive access
 	struct ChartData
 	{
 		MetaInfo meta;
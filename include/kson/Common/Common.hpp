@@ -11,8 +11,19 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include "kson/Encoding/Encoding.hpp"
 
+// libkson can be built without exceptions (KSON_NO_EXCEPTIONS in CMake)
+// Throwing functions terminate instead of throwing in that case, so use the non-throwing variants
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+#define KSON_HAS_EXCEPTIONS 1
+#define KSON_THROW(exception) throw exception
+#else
+#define KSON_HAS_EXCEPTIONS 0
+#define KSON_THROW(exception) std::abort()
+#endif
+
 namespace kson
 {
 	constexpr std::int32_t kNumBTLanes = 4;
@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace kson
+{
+	namespace detail
+	{
+		// Not constexpr, so calling this in MakeLookupTable makes the compilation fail
+		inline void LookupTableHasDuplicateKeys()
+		{
+		}
+	}
+
+	// Immutable table sorted by key at compile time
+	// Unlike static std::unordered_map, this needs no allocation or initialization at startup
+	template <typename K, typename V, std::size_t N>
+	class LookupTable
+	{
+	private:
+		std::array<std::pair<K, V>, N> m_entries;
+
+	public:
+		constexpr explicit LookupTable(const std::array<std::pair<K, V>, N>& entries)
+			: m_entries(entries)
+		{
+			std::sort(m_entries.begin(), m_entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		}
+
+		// Returns nullptr if not found
+		template <typename Key>
+		[[nodiscard]]
+		constexpr const V* find(const Key& key) const
+		{
+			if constexpr (N == 0)
+			{
+				return nullptr;
+			}
+			else
+			{
+				// Branchless binary search (the loop count depends only on N)
+				const std::pair<K, V>* base = m_entries.data();
+				std::size_t length = N;
+				while (length > 1)
+				{
+					const std::size_t half = length / 2;
+					base = (base[half - 1].first < key) ? base + half : base;
+					length -= half;
+				}
+				return (base->first == key) ? &base->second : nullptr;
+			}
+		}
+
+		template <typename Key>
+		[[nodiscard]]
+		constexpr bool contains(const Key& key) const
+		{
+			return find(key) != nullptr;
+		}
+
+		template <typename Key>
+		[[nodiscard]]
+		constexpr V valueOr(const Key& key, const V& defaultValue) const
+		{
+			const V* pValue = find(key);
+			return pValue ? *pValue : defaultValue;
+		}
+
+		[[nodiscard]]
+		constexpr std::size_t size() const
+		{
+			return N;
+		}
+
+		[[nodiscard]]
+		constexpr auto begin() const
+		{
+			return m_entries.begin();
+		}
+
+		[[nodiscard]]
+		constexpr auto end() const
+		{
+			return m_entries.end();
+		}
+	};
+
+	// Usage: constexpr auto kTable = MakeLookupTable<std::string_view, int>({ { "a", 1 }, { "b", 2 } });
+	template <typename K, typename V, std::size_t N>
+	[[nodiscard]]
+	consteval LookupTable<K, V, N> MakeLookupTable(const std::pair<K, V> (&entries)[N])
+	{
+		std::array<std::pair<K, V>, N> array;
+		std::copy(std::begin(entries), std::end(entries), array.begin());
+
+		const LookupTable<K, V, N> table(array);
+		for (auto itr = table.begin(); itr != table.end() && std::next(itr) != table.end(); ++itr)
+		{
+			if (itr->first == std::next(itr)->first)
+			{
+				detail::LookupTableHasDuplicateKeys();
+			}
+		}
+		return table;
+	}
+}
@@ -5,7 +5,13 @@ namespace kson
 {
 	namespace Encoding
 	{
+		// Thread-safe (the conversion state is not shared between threads)
 		[[nodiscard]]
 		std::string ShiftJISToUTF8(std::string_view shiftJISStr);
+
+		// Returns the Shift-JIS (CP932) code of the Unicode code point (single-byte codes are returned as 0x00XX)
+		// Returns 0 if the code point cannot be represented in Shift-JIS
+		[[nodiscard]]
+		std::uint16_t CodePointToShiftJIS(char32_t codePoint);
 	}
 }
@@ -0,0 +1,118 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+#include "kson/Error.hpp"
+#include "kson/IO/KshIO.hpp"
+
+namespace kson
+{
+	enum class ChartFileFormat
+	{
+		Kson,
+		Ksh,
+	};
+
+	struct ChartSavingOptions
+	{
+		ChartFileFormat format = ChartFileFormat::Kson;
+
+		KshSavingOptions kshOptions; // Used if format is Ksh
+	};
+
+	// Saves into a temporary file next to filePath and renames it to filePath only after the whole chart is written,
+	// so that the destination holds either the previous or the new chart even if the process stops in the middle
+	[[nodiscard]]
+	ErrorType SaveChartDataAtomically(const std::string& filePath, const ChartData& chartData, const ChartSavingOptions& options = {});
+
+	struct AsyncChartSaverOptions
+	{
+		ChartSavingOptions savingOptions;
+
+		// Minimum time between the starts of two writes (requests during the interval are coalesced into one write)
+		std::chrono::milliseconds minWriteInterval{ 0 };
+	};
+
+	// Saves chart snapshots to one file on a background thread (e.g., editor autosave)
+	// Requests made while a write is pending or running are coalesced, so that only the latest snapshot is written
+	// and at most one write is queued. Each write is done by SaveChartDataAtomically().
+	// Thread-safe (requests may be made from any thread)
+	class AsyncChartSaver
+	{
+	public:
+		// Sequence number of a request (starts from 1)
+		using Generation = std::uint64_t;
+
+	private:
+		const std::string m_filePath;
+
+		const AsyncChartSaverOptions m_options;
+
+		mutable std::mutex m_mutex;
+
+		std::condition_variable m_requestCondition;
+
+		std::condition_variable m_writtenCondition;
+
+		std::shared_ptr<const ChartData> m_pPendingChartData;
+
+		Generation m_requestedGeneration = 0;
+
+		Generation m_writtenGeneration = 0; // Latest request written (or failed to be written)
+
+		Generation m_flushGeneration = 0; // Requests up to this generation skip minWriteInterval
+
+		std::size_t m_numWrites = 0;
+
+		ErrorType m_lastError = ErrorType::None;
+
+		bool m_stopRequested = false;
+
+		std::thread m_thread;
+
+		void threadMain();
+
+	public:
+		explicit AsyncChartSaver(std::string filePath, const AsyncChartSaverOptions& options = {});
+
+		AsyncChartSaver(const AsyncChartSaver&) = delete;
+
+		AsyncChartSaver& operator=(const AsyncChartSaver&) = delete;
+
+		// Writes the pending snapshot (if any) before returning
+		~AsyncChartSaver();
+
+		// Schedules a save of the snapshot; the caller must not modify it afterwards
+		// Returns immediately (serialization and the file write are done on the background thread)
+		Generation requestSave(std::shared_ptr<const ChartData> pChartData);
+
+		// Same as above, taking the chart data by value (pass a copy, or move a snapshot that is no longer needed)
+		Generation requestSave(ChartData chartData);
+
+		// Waits until every request made so far is written (skipping minWriteInterval) and returns the error of the last write
+		ErrorType flush();
+
+		[[nodiscard]]
+		const std::string& filePath() const;
+
+		// Generation of the latest request
+		[[nodiscard]]
+		Generation requestedGeneration() const;
+
+		// Generation of the latest request written (or failed to be written)
+		[[nodiscard]]
+		Generation writtenGeneration() const;
+
+		// Number of writes so far (fewer than the requests when they are coalesced)
+		[[nodiscard]]
+		std::size_t numWrites() const;
+
+		// Error of the last write
+		[[nodiscard]]
+		ErrorType lastError() const;
+	};
+}
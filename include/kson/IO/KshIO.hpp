@@ -6,6 +6,17 @@
 
 namespace kson
 {
+	enum class KshEncoding
+	{
+		UTF8, // UTF-8 with BOM
+		ShiftJIS, // Shift-JIS (CP932) for legacy clients
+	};
+
+	struct KshSavingOptions
+	{
+		KshEncoding encoding = KshEncoding::UTF8;
+	};
+
 	MetaChartData LoadKshMetaChartData(std::istream& stream);
 
 	MetaChartData LoadKshMetaChartData(const std::string& filePath);
@@ -17,4 +28,8 @@ namespace kson
 	ErrorType SaveKshChartData(std::ostream& stream, const ChartData& chartData, KshSavingDiag* pKshSavingDiag = nullptr);
 
 	ErrorType SaveKshChartData(const std::string& filePath, const ChartData& chartData, KshSavingDiag* pKshSavingDiag = nullptr);
+
+	ErrorType SaveKshChartData(std::ostream& stream, const ChartData& chartData, const KshSavingOptions& options, KshSavingDiag* pKshSavingDiag = nullptr);
+
+	ErrorType SaveKshChartData(const std::string& filePath, const ChartData& chartData, const KshSavingOptions& options, KshSavingDiag* pKshSavingDiag = nullptr);
 }
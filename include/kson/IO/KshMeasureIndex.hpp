@@ -0,0 +1,105 @@
+#pragma once
+#include <optional>
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+#include "kson/IO/KshLoadingDiag.hpp"
+
+namespace kson
+{
+	// Laser point as written in .ksh (laserX: 0-50, see CharToLaserX)
+	struct KshLaserPoint
+	{
+		Pulse y = 0;
+		std::int32_t laserX = 0;
+
+		bool operator==(const KshLaserPoint&) const = default;
+	};
+
+	struct KshOpenLongNote
+	{
+		Pulse y = 0; // Start of the note
+		RelPulse elapsed = 0; // Length accumulated before the measure
+		RelPulse length = 0; // Total length of the note
+
+		bool operator==(const KshOpenLongNote&) const = default;
+	};
+
+	struct KshOpenLaserSection
+	{
+		bool wide = false;
+		std::optional<KshLaserPoint> prevPoint; // Point before lastPoint (needed to restore laser slams)
+		KshLaserPoint lastPoint; // Last point before the measure
+		std::optional<KshLaserPoint> nextPoint; // First point after the measure start, if the section has more points
+
+		bool operator==(const KshOpenLaserSection&) const = default;
+	};
+
+	// State carried over the bar line before a measure
+	struct KshMeasureCarriedState
+	{
+		TimeSig timeSig; // Time signature of the measure
+		double bpm = 0.0; // BPM at the start of the measure
+		std::array<std::optional<KshOpenLongNote>, kNumBTLanesSZ> bt;
+		std::array<std::optional<KshOpenLongNote>, kNumFXLanesSZ> fx;
+		std::array<std::optional<KshOpenLaserSection>, kNumLaserLanesSZ> laser;
+	};
+
+	struct KshMeasureIndexEntry
+	{
+		std::int64_t byteOffset = 0; // Stream position of the first line of the measure
+		std::int64_t lineNo = 0; // Line number of the bar line ("--") before the measure
+		Pulse y = 0;
+		KshMeasureCarriedState state;
+	};
+
+	// Byte offsets and carried states of the measures of a .ksh file for loading a measure range without parsing from the start
+	struct KshMeasureIndex
+	{
+		// Size and last write time of the indexed file (both 0 if built from a stream)
+		std::uint64_t fileSize = 0;
+		std::int64_t fileTime = 0;
+
+		// Tempo, time signature and stop changes of the whole chart (scrollSpeed is not used)
+		BeatInfo beat;
+
+		std::vector<KshMeasureIndexEntry> measures;
+
+		// Position of the lines after the last bar line (user-defined audio effects)
+		std::int64_t trailerByteOffset = 0;
+		std::int64_t trailerLineNo = 0;
+
+		ErrorType error = ErrorType::None;
+	};
+
+	// Builds the index in one pass over the lines without creating ChartData
+	KshMeasureIndex BuildKshMeasureIndex(std::istream& stream);
+
+	KshMeasureIndex BuildKshMeasureIndex(const std::string& filePath);
+
+	// Path of the index file saved next to the chart file ("<filePath>.kshidx")
+	std::string KshMeasureIndexFilePath(const std::string& filePath);
+
+	ErrorType SaveKshMeasureIndex(std::ostream& stream, const KshMeasureIndex& index);
+
+	ErrorType SaveKshMeasureIndex(const std::string& indexFilePath, const KshMeasureIndex& index);
+
+	KshMeasureIndex LoadKshMeasureIndex(std::istream& stream);
+
+	KshMeasureIndex LoadKshMeasureIndex(const std::string& indexFilePath);
+
+	// Returns true if the index was built from the current version of the file (compared by size and last write time)
+	bool IsKshMeasureIndexUpToDate(const KshMeasureIndex& index, const std::string& filePath);
+
+	// Loads the index saved next to the file, or builds and saves it if it is missing or outdated
+	// (Failure to save is ignored, so this also works for read-only directories)
+	KshMeasureIndex LoadOrBuildKshMeasureIndex(const std::string& filePath);
+
+	// Loads the chart meta data and the measures [firstMeasureIdx, firstMeasureIdx + numMeasures)
+	// - Notes are placed at the same pulses as LoadKshChartData(), and beat contains the tempo map of the whole chart
+	// - Long notes and laser segments crossing the range boundaries are included with their full length
+	//   (laser sections crossing the range start begin from the last two points before the range)
+	// - Other events before the range (e.g., camera, tilt, audio effects, curves) are not loaded
+	ChartData LoadKshChartDataRange(std::istream& stream, const KshMeasureIndex& index, std::int64_t firstMeasureIdx, std::int64_t numMeasures, KshLoadingDiag* pKshDiag = nullptr);
+
+	ChartData LoadKshChartDataRange(const std::string& filePath, std::int64_t firstMeasureIdx, std::int64_t numMeasures, KshLoadingDiag* pKshDiag = nullptr);
+}
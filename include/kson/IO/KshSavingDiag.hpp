@@ -16,6 +16,7 @@ namespace kson
 		ZoomFractionLost,
 		LaserPrecisionLost,
 		FXLongEventParamsLost,
+		UnmappableCharacter,
 	};
 
 	struct KshSavingWarning
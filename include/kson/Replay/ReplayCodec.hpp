@@ -0,0 +1,82 @@
+#pragma once
+#include <optional>
+#include <span>
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+#include "kson/Util/TimingUtils.hpp"
+
+namespace kson
+{
+	// Laser cursor positions are stored as integers (1.0 = kReplayLaserPositionScale)
+	// The range is 0.0-1.0 for normal lasers and -0.5-1.5 for 2x-widen lasers, same as LaserGeometryVertex::x
+	constexpr std::int32_t kReplayLaserPositionScale = 1024;
+
+	struct ReplayPress
+	{
+		std::int64_t pressUs = 0; // Time in microseconds from the beginning of the chart (same origin as PulseToMs)
+		std::int64_t releaseUs = 0;
+
+		bool operator==(const ReplayPress&) const = default;
+	};
+
+	struct ReplayLaserSample
+	{
+		std::int64_t timeUs = 0;
+		std::int32_t position = 0; // Cursor position (see kReplayLaserPositionScale)
+
+		bool operator==(const ReplayLaserSample&) const = default;
+	};
+
+	// Raw inputs of one play, sorted by time in each lane
+	struct ReplayData
+	{
+		std::array<std::vector<ReplayPress>, kNumBTLanesSZ> bt;
+		std::array<std::vector<ReplayPress>, kNumFXLanesSZ> fx;
+		std::array<std::vector<ReplayLaserSample>, kNumLaserLanesSZ> laser;
+
+		void clear();
+
+		bool operator==(const ReplayData&) const = default;
+	};
+
+	// Encodes replays relative to a chart:
+	// - Presses are stored as the note index delta in the lane and the timing delta from the nearest note
+	//   (releases relative to the end of long notes or to the press for chip notes)
+	// - Laser samples are stored as the delta-of-delta of the sample time and the deviation from the ideal laser path
+	// All values are integers, so decoding with the same chart restores the replay exactly
+	// The chart data is referenced, so it must outlive the codec; a codec is immutable and can be shared between threads
+	class ReplayCodec
+	{
+	private:
+		struct Lane
+		{
+			std::vector<std::int64_t> noteUs;
+			std::vector<std::int64_t> noteEndUs;
+			std::vector<bool> isLong;
+		};
+
+		const ChartData& m_chartData;
+		TimingCache m_timingCache;
+		std::array<Lane, kNumBTLanesSZ + kNumFXLanesSZ> m_lanes;
+		std::array<std::pair<std::int64_t, std::int64_t>, kNumLaserLanesSZ> m_laserRangeUs{}; // [first section start, last section end]
+		std::uint64_t m_chartHash = 0;
+
+		[[nodiscard]]
+		std::optional<std::int32_t> idealLaserPosition(std::size_t laneIdx, std::int64_t timeUs) const;
+
+	public:
+		explicit ReplayCodec(const ChartData& chartData);
+
+		// Hash of the note timings and laser paths the encoding depends on (stored in the encoded data)
+		[[nodiscard]]
+		std::uint64_t chartHash() const;
+
+		[[nodiscard]]
+		std::vector<std::uint8_t> encode(const ReplayData& replay) const;
+
+		// Returns false if the data is malformed or was encoded with another chart
+		// The buffers of pReplay are reused, so reuse a ReplayData when decoding in bulk
+		[[nodiscard]]
+		bool decode(std::span<const std::uint8_t> data, ReplayData* pReplay) const;
+	};
+}
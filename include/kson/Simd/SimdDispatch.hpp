@@ -0,0 +1,50 @@
+#pragma once
+#include <optional>
+#include "kson/Common/Common.hpp"
+
+namespace kson
+{
+	namespace Simd
+	{
+		// Instruction set levels of the kernels (each level includes the lower ones)
+		enum class SimdLevel : std::int32_t
+		{
+			kScalar = 0,
+			kSSE2,
+			kAVX2,
+			kAVX512, // AVX-512F and AVX-512BW
+		};
+
+		// Highest level supported by both the CPU and the build (detected once with CPUID)
+		// Only kScalar unless the library is built with KSON_SIMD_DISPATCH on x86-64
+		[[nodiscard]]
+		SimdLevel SupportedSimdLevel();
+
+		// Level used by the kernels: SupportedSimdLevel(), or lower if the KSON_SIMD_LEVEL environment variable is set
+		// to "scalar", "sse2", "avx2" or "avx512" (read once at the first use of a kernel; higher levels than supported are ignored)
+		[[nodiscard]]
+		SimdLevel ActiveSimdLevel();
+
+		[[nodiscard]]
+		std::string_view SimdLevelName(SimdLevel level);
+
+		[[nodiscard]]
+		std::optional<SimdLevel> ParseSimdLevel(std::string_view str);
+
+		// Kernels
+		// The variants with a level argument are for tests and benchmarks (levels above SupportedSimdLevel() run the
+		// highest supported variant). All variants return identical results.
+
+		// Number of leading bytes below 0x80
+		[[nodiscard]]
+		std::size_t AsciiPrefixLength(std::string_view str);
+
+		[[nodiscard]]
+		std::size_t AsciiPrefixLength(std::string_view str, SimdLevel level);
+
+		// pResults[i] = EvaluateCurve(a, b, pXs[i]) for each i < count (pXs and pResults may be the same array)
+		void EvaluateCurves(double a, double b, const double* pXs, double* pResults, std::size_t count);
+
+		void EvaluateCurves(double a, double b, const double* pXs, double* pResults, std::size_t count, SimdLevel level);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+
+namespace kson
+{
+	struct CanonicalizeOptions
+	{
+		// Maximum allowed deviation of evaluated graph and laser values
+		// (0.0 removes only the points that do not change the evaluated values)
+		double tolerance = 0.0;
+
+		// Simplify graph and laser points with the Ramer-Douglas-Peucker algorithm instead of the linear sweep
+		bool useRDP = false;
+	};
+
+	// Removes points from the graph that are on the line between their neighbors
+	// Points with curves or slams (v != vf) are always kept
+	// Returns the number of removed points
+	std::size_t CanonicalizeGraph(Graph& graph, const CanonicalizeOptions& options = {});
+
+	// Same as CanonicalizeGraph, but the first and last points are always kept
+	std::size_t CanonicalizeLaserSection(LaserSection& laserSection, const CanonicalizeOptions& options = {});
+
+	// Removes redundant events from the chart:
+	// - BPM and time signature changes to the same value
+	// - Points on the line between their neighbors in scroll_speed, camera graphs and laser sections
+	// - Repeated tilt values
+	// - Audio effect parameter changes and key sound volume changes to the same value
+	// Returns the number of removed events and points
+	std::size_t CanonicalizeChart(ChartData& chartData, const CanonicalizeOptions& options = {});
+}
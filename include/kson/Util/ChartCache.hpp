@@ -0,0 +1,134 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace kson
+{
+	// Returns the approximate heap memory used by the chart data (in bytes)
+	[[nodiscard]]
+	std::size_t EstimateChartDataSize(const ChartData& chartData);
+
+	struct ChartCacheOptions
+	{
+		// Maximum total estimated size of the resident charts
+		std::size_t byteBudget = 256 * 1024 * 1024;
+
+		// Maximum total size of the compressed charts (0 disables the compressed tier)
+		// Charts evicted from the resident tier are kept compressed and decoded again on the next access
+		std::size_t compressedByteBudget = 0;
+	};
+
+	struct ChartCacheStats
+	{
+		std::size_t numHits = 0;
+		std::size_t numCompressedHits = 0;
+		std::size_t numMisses = 0;
+		std::size_t numEvictions = 0;
+
+		std::size_t numResident = 0;
+		std::size_t residentBytes = 0;
+
+		std::size_t numCompressed = 0;
+		std::size_t compressedBytes = 0;
+	};
+
+	// Thread-safe cache of loaded charts keyed by path or content hash
+	// Charts are evicted in least-recently-used order when the byte budget is exceeded, except pinned ones
+	// Returned charts are shared, so eviction does not invalidate them
+	class ChartCache
+	{
+	public:
+		using Loader = std::function<ChartData()>;
+
+	private:
+		struct Entry
+		{
+			std::shared_ptr<const ChartData> chartData;
+			std::size_t size = 0;
+			std::int32_t pinCount = 0;
+			std::list<std::string>::iterator lruItr;
+		};
+
+		struct CompressedEntry
+		{
+			std::string data;
+			std::size_t originalSize = 0;
+			std::list<std::string>::iterator lruItr;
+		};
+
+		using Victim = std::pair<std::string, std::shared_ptr<const ChartData>>;
+
+		const ChartCacheOptions m_options;
+
+		mutable std::mutex m_mutex;
+
+		// Most recently used first
+		std::unordered_map<std::string, Entry> m_entries;
+		std::list<std::string> m_lru;
+		std::size_t m_residentBytes = 0;
+
+		std::unordered_map<std::string, CompressedEntry> m_compressedEntries;
+		std::list<std::string> m_compressedLRU;
+		std::size_t m_compressedBytes = 0;
+
+		// Loads in progress, shared by concurrent getOrLoad calls for the same key
+		std::unordered_map<std::string, std::shared_future<std::shared_ptr<const ChartData>>> m_loading;
+
+		ChartCacheStats m_stats;
+
+		// The following functions must be called with m_mutex locked
+
+		std::shared_ptr<const ChartData> findResident(const std::string& key);
+
+		void insertResident(const std::string& key, std::shared_ptr<const ChartData> chartData);
+
+		void eraseCompressed(const std::string& key);
+
+		void insertCompressed(const std::string& key, std::string&& data, std::size_t originalSize);
+
+		// Removes the least recently used unpinned charts exceeding the budget from the resident tier
+		[[nodiscard]]
+		std::vector<Victim> evict();
+
+		// Compresses the evicted charts into the compressed tier (must be called without m_mutex locked)
+		void compressVictims(std::vector<Victim>&& victims);
+
+	public:
+		explicit ChartCache(const ChartCacheOptions& options = {});
+
+		ChartCache(const ChartCache&) = delete;
+
+		ChartCache& operator=(const ChartCache&) = delete;
+
+		// Returns the cached chart, or loads it with the loader
+		// Concurrent calls for the same key wait for a single load
+		// Charts with an error are returned but not cached
+		[[nodiscard]]
+		std::shared_ptr<const ChartData> getOrLoad(const std::string& key, const Loader& loader);
+
+		// Returns the cached chart, or nullptr if not cached
+		[[nodiscard]]
+		std::shared_ptr<const ChartData> find(const std::string& key);
+
+		void insert(const std::string& key, ChartData&& chartData);
+
+		// Pinned charts are not evicted until unpinned as many times as pinned
+		// Returns false if the chart is not resident
+		bool pin(const std::string& key);
+
+		void unpin(const std::string& key);
+
+		void erase(const std::string& key);
+
+		void clear();
+
+		[[nodiscard]]
+		ChartCacheStats stats() const;
+	};
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+#include <functional>
+#include <limits>
+
+namespace kson
+{
+	constexpr Pulse kPulseRangeUnbounded = std::numeric_limits<Pulse>::max();
+
+	// Half-open pulse range [begin, end)
+	struct PulseRange
+	{
+		Pulse begin = 0;
+		Pulse end = kPulseRangeUnbounded;
+
+		[[nodiscard]]
+		bool empty() const
+		{
+			return begin >= end;
+		}
+
+		[[nodiscard]]
+		bool contains(Pulse y) const
+		{
+			return begin <= y && y < end;
+		}
+	};
+
+	// Set of disjoint pulse ranges (overlapping or adjacent ranges are merged on insertion)
+	class PulseRangeSet
+	{
+	private:
+		ByPulse<Pulse> m_ranges; // begin -> end
+
+	public:
+		void add(const PulseRange& range);
+
+		void add(const PulseRangeSet& rangeSet);
+
+		[[nodiscard]]
+		bool empty() const;
+
+		[[nodiscard]]
+		bool overlaps(const PulseRange& range) const;
+
+		// Returns the begin of the first range, or kPulseRangeUnbounded if empty
+		[[nodiscard]]
+		Pulse minPulse() const;
+
+		[[nodiscard]]
+		std::vector<PulseRange> ranges() const;
+
+		void clear();
+	};
+
+	// Ranges of the chart data modified since the last flush
+	// Each range covers the pulses whose values in the section changed; derived data integrated over pulses
+	// (e.g., timing and scroll position) must be recomputed from the begin of the range to the end of the chart
+	struct ChartDirtyRanges
+	{
+		PulseRangeSet bpm;
+		PulseRangeSet timeSig;
+		PulseRangeSet scrollSpeed;
+		PulseRangeSet stop;
+
+		std::array<PulseRangeSet, kNumBTLanesSZ> bt;
+		std::array<PulseRangeSet, kNumFXLanesSZ> fx;
+		std::array<PulseRangeSet, kNumLaserLanesSZ> laser;
+
+		// Modified outside of the above sections (e.g., meta or audio)
+		bool other = false;
+
+		[[nodiscard]]
+		bool empty() const;
+
+		// Whether the tempo or the time signature changed
+		[[nodiscard]]
+		bool timingDirty() const;
+
+		// Whether any note lane changed
+		[[nodiscard]]
+		bool notesDirty() const;
+
+		void add(const ChartDirtyRanges& dirtyRanges);
+
+		void clear();
+	};
+
+	// Editing facade over ChartData that records modifications as dirty ranges
+	// Modifications are accumulated until flush(), which notifies the subscribers so that derived data
+	// (timing cache, scroll position cache, note lists, etc.) can be rebuilt only where needed
+	// Not thread-safe
+	class ChartEditor
+	{
+	public:
+		using SubscriptionId = std::size_t;
+
+		using Subscriber = std::function<void(const ChartData&, const ChartDirtyRanges&)>;
+
+	private:
+		ChartData m_chartData;
+
+		ChartDirtyRanges m_dirtyRanges;
+
+		std::vector<std::pair<SubscriptionId, Subscriber>> m_subscribers;
+
+		SubscriptionId m_nextSubscriptionId = 0;
+
+	public:
+		ChartEditor() = default;
+
+		explicit ChartEditor(ChartData chartData);
+
+		[[nodiscard]]
+		const ChartData& chartData() const;
+
+		// Takes the chart data out of the editor (pending modifications are discarded without notification)
+		[[nodiscard]]
+		ChartData release();
+
+		[[nodiscard]]
+		const ChartDirtyRanges& dirtyRanges() const;
+
+		[[nodiscard]]
+		bool hasPendingChanges() const;
+
+		void setBPM(Pulse y, double bpm);
+
+		bool removeBPM(Pulse y);
+
+		void setTimeSig(std::int64_t measureIdx, const TimeSig& timeSig);
+
+		bool removeTimeSig(std::int64_t measureIdx);
+
+		void setScrollSpeed(Pulse y, const GraphPoint& point);
+
+		bool removeScrollSpeed(Pulse y);
+
+		void setStop(Pulse y, RelPulse length);
+
+		bool removeStop(Pulse y);
+
+		// Adds a note, replacing the note at the same pulse if any
+		void setBTNote(std::size_t lane, Pulse y, const Interval& note);
+
+		bool removeBTNote(std::size_t lane, Pulse y);
+
+		void setFXNote(std::size_t lane, Pulse y, const Interval& note);
+
+		bool removeFXNote(std::size_t lane, Pulse y);
+
+		void setLaserSection(std::size_t lane, Pulse y, const LaserSection& section);
+
+		bool removeLaserSection(std::size_t lane, Pulse y);
+
+		// Arbitrary modification; func must record the modified ranges itself
+		void modify(const std::function<void(ChartData&, ChartDirtyRanges&)>& func);
+
+		[[nodiscard]]
+		SubscriptionId subscribe(Subscriber subscriber);
+
+		void unsubscribe(SubscriptionId id);
+
+		// Notifies the subscribers of the pending modifications (in subscription order) and clears them
+		void flush();
+	};
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <optional>
+#include <variant>
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+
+namespace kson
+{
+	enum class ChartQueryValueType
+	{
+		Bool,
+		Number,
+		String,
+	};
+
+	using ChartQueryValue = std::variant<bool, double, std::string>;
+
+	enum class ChartQueryOp
+	{
+		Literal,
+		Field,
+		Function,
+		Not,
+		Negate,
+		And,
+		Or,
+		Equal,
+		NotEqual,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+		Add,
+		Subtract,
+		Multiply,
+		Divide,
+	};
+
+	struct ChartQueryNode
+	{
+		ChartQueryOp op = ChartQueryOp::Literal;
+		ChartQueryValueType type = ChartQueryValueType::Bool;
+		ChartQueryValue literal; // ChartQueryOp::Literal
+		std::size_t idx = 0; // Index in the field or function table (ChartQueryOp::Field/Function)
+		std::vector<std::size_t> args; // Indices of operand nodes
+	};
+
+	// Filter expression evaluated over a chart, e.g.:
+	//   max_bpm > 300 && laser_slam_count > 100
+	//   defines_fx_type("sidechain") or contains(title, "remix")
+	// Operators: ! not && and || or == != < <= > >= + - * / (arithmetic is for numbers only)
+	// See ChartQueryFieldNames()/ChartQueryFunctionNames() for the available fields and functions
+	// Types are checked on parsing, so evaluation never fails
+	class ChartQuery
+	{
+	private:
+		std::vector<ChartQueryNode> m_nodes; // The last node is the root
+
+		explicit ChartQuery(std::vector<ChartQueryNode>&& nodes);
+
+		friend std::optional<ChartQuery> ParseChartQuery(std::string_view expression, std::string* pErrorMessage);
+
+	public:
+		[[nodiscard]]
+		ChartQueryValueType type() const;
+
+		[[nodiscard]]
+		ChartQueryValue evaluate(const ChartData& chartData) const;
+
+		// Returns whether the result is true, non-zero or non-empty
+		[[nodiscard]]
+		bool matches(const ChartData& chartData) const;
+	};
+
+	// Returns std::nullopt and sets pErrorMessage (if not nullptr) if the expression is invalid
+	[[nodiscard]]
+	std::optional<ChartQuery> ParseChartQuery(std::string_view expression, std::string* pErrorMessage = nullptr);
+
+	[[nodiscard]]
+	std::vector<std::string_view> ChartQueryFieldNames();
+
+	[[nodiscard]]
+	std::vector<std::string_view> ChartQueryFunctionNames();
+
+	// Formats numbers without trailing zeros (integers without a decimal point)
+	[[nodiscard]]
+	std::string ChartQueryValueToString(const ChartQueryValue& value);
+}
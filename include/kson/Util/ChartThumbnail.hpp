@@ -0,0 +1,70 @@
+#pragma once
+#include <ostream>
+#include "kson/Common/Common.hpp"
+#include "kson/ChartData.hpp"
+#include "kson/Error.hpp"
+
+namespace kson
+{
+	struct ThumbnailColor
+	{
+		std::uint8_t r = 0;
+		std::uint8_t g = 0;
+		std::uint8_t b = 0;
+		std::uint8_t a = 255;
+	};
+
+	struct ChartThumbnailParams
+	{
+		std::int32_t width = 48;
+		std::int32_t height = 512;
+
+		ThumbnailColor backgroundColor{ 16, 16, 24, 255 };
+		ThumbnailColor barLineColor{ 56, 56, 64, 255 };
+		ThumbnailColor btChipColor{ 255, 255, 255, 255 };
+		ThumbnailColor btLongColor{ 176, 176, 176, 255 };
+		ThumbnailColor fxChipColor{ 255, 144, 32, 255 };
+		ThumbnailColor fxLongColor{ 176, 96, 24, 255 };
+		std::array<ThumbnailColor, kNumLaserLanesSZ> laserColors{ ThumbnailColor{ 0, 168, 255, 255 }, ThumbnailColor{ 255, 56, 168, 255 } };
+
+		// BPM gutter at the left edge (the color goes from low to high between the minimum and maximum BPM of the chart)
+		std::int32_t bpmGutterWidth = 4;
+		ThumbnailColor lowBPMColor{ 32, 64, 32, 255 };
+		ThumbnailColor highBPMColor{ 160, 255, 96, 255 };
+		ThumbnailColor bpmChangeColor{ 255, 255, 128, 255 };
+	};
+
+	// Vertical overview image of a chart (the chart start is at the bottom and the last note end is at the top,
+	// linear in pulses)
+	struct ChartThumbnail
+	{
+		std::int32_t width = 0;
+		std::int32_t height = 0;
+
+		// RGBA, 4 bytes per pixel, rows from top to bottom
+		std::vector<std::uint8_t> pixels;
+
+		ErrorType error = ErrorType::None;
+	};
+
+	// Rasterizes the bar lines, BPM changes, notes and lasers in time linear in the number of notes and pixels
+	// The buffer in pThumbnail is reused, so rendering many charts with one instance per thread does not reallocate it
+	void RenderChartThumbnail(const ChartData& chartData, const ChartThumbnailParams& params, ChartThumbnail* pThumbnail);
+
+	[[nodiscard]]
+	ChartThumbnail CreateChartThumbnail(const ChartData& chartData, const ChartThumbnailParams& params = {});
+
+	// Binary PPM (P6, alpha is dropped)
+	[[nodiscard]]
+	ErrorType SaveChartThumbnailPPM(std::ostream& stream, const ChartThumbnail& thumbnail);
+
+	[[nodiscard]]
+	ErrorType SaveChartThumbnailPPM(const std::string& filePath, const ChartThumbnail& thumbnail);
+
+	// PAM (P7, RGB_ALPHA)
+	[[nodiscard]]
+	ErrorType SaveChartThumbnailPAM(std::ostream& stream, const ChartThumbnail& thumbnail);
+
+	[[nodiscard]]
+	ErrorType SaveChartThumbnailPAM(const std::string& filePath, const ChartThumbnail& thumbnail);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "kson/Common/Common.hpp"
+#include <optional>
 
 namespace kson
 {
@@ -16,22 +17,35 @@ namespace kson
 	// Used for laser sections and scroll_speed where pre-conversion is required
 	// subdivisionInterval: interval in ticks for subdividing curve segments
 	// Returns a new graph with curve segments subdivided into linear segments
+	// Throws std::invalid_argument if subdivisionInterval is not positive
 	[[nodiscard]]
 	Graph ExpandCurveSegments(const Graph& graph, Pulse subdivisionInterval);
 
+	// Same as ExpandCurveSegments, but returns std::nullopt instead of throwing
+	[[nodiscard]]
+	std::optional<Graph> TryExpandCurveSegments(const Graph& graph, Pulse subdivisionInterval);
+
 	// Expands a graph section with curve data into linear segments at specified intervals
 	// Used for laser sections where pre-conversion is required
 	// subdivisionInterval: interval in ticks for subdividing curve segments
 	// Returns a new graph section with curve segments subdivided into linear segments
+	// Throws std::invalid_argument if subdivisionInterval is not positive
 	[[nodiscard]]
 	GraphSection ExpandCurveSegments(const GraphSection& graphSection, RelPulse subdivisionInterval);
 
+	[[nodiscard]]
+	std::optional<GraphSection> TryExpandCurveSegments(const GraphSection& graphSection, RelPulse subdivisionInterval);
+
 	// Forward declaration for LaserSection
 	struct LaserSection;
 
 	// Expands a laser section with curve data into linear segments at specified intervals
 	// subdivisionInterval: interval in ticks for subdividing curve segments
 	// Returns a new laser section with curve segments subdivided into linear segments
+	// Throws std::invalid_argument if subdivisionInterval is not positive
 	[[nodiscard]]
 	LaserSection ExpandCurveSegments(const LaserSection& laserSection, RelPulse subdivisionInterval);
+
+	[[nodiscard]]
+	std::optional<LaserSection> TryExpandCurveSegments(const LaserSection& laserSection, RelPulse subdivisionInterval);
 }
@@ -0,0 +1,80 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/Note/NoteInfo.hpp"
+#include "kson/Beat/BeatInfo.hpp"
+#include "kson/Util/TimingUtils.hpp"
+
+namespace kson
+{
+	constexpr std::size_t kJudgementNoNote = static_cast<std::size_t>(-1);
+
+	struct JudgementNote
+	{
+		double ms = 0.0;
+		double endMs = 0.0; // Same as ms for chip notes
+		Pulse y = 0;
+		RelPulse length = 0;
+	};
+
+	// Notes of one lane sorted by time with their judged states
+	// Queries are expected to move forward in time, so the cursor makes them amortized O(1)
+	// Not thread-safe (each judge thread needs its own instance)
+	class JudgementLane
+	{
+	private:
+		std::vector<JudgementNote> m_notes;
+		std::vector<std::uint64_t> m_judgedBits;
+
+		// All notes before this index are judged
+		std::size_t m_cursor = 0;
+
+		std::size_t m_numJudged = 0;
+
+		[[nodiscard]]
+		std::size_t nextUnjudged(std::size_t idx) const;
+
+		void advanceCursor();
+
+	public:
+		JudgementLane() = default;
+
+		JudgementLane(const ByPulse<Interval>& lane, const BeatInfo& beatInfo, const TimingCache& timingCache);
+
+		[[nodiscard]]
+		std::size_t size() const;
+
+		[[nodiscard]]
+		const JudgementNote& note(std::size_t idx) const;
+
+		[[nodiscard]]
+		bool isJudged(std::size_t idx) const;
+
+		[[nodiscard]]
+		std::size_t numJudged() const;
+
+		// Returns the unjudged note nearest to ms within [ms - windowMs, ms + windowMs] (the earlier one if tied),
+		// or kJudgementNoNote if there is none
+		[[nodiscard]]
+		std::size_t findCandidate(double ms, double windowMs) const;
+
+		void markJudged(std::size_t idx);
+
+		// Marks unjudged notes with note.ms + windowMs < ms as judged and returns the number of them
+		// The indices of the missed notes are appended to pMissedIndices if not nullptr
+		std::size_t advanceMisses(double ms, double windowMs, std::vector<std::size_t>* pMissedIndices = nullptr);
+
+		// Clears the judged states (e.g., for seeking backward)
+		void reset();
+	};
+
+	struct JudgementLanes
+	{
+		std::array<JudgementLane, kNumBTLanesSZ> bt;
+		std::array<JudgementLane, kNumFXLanesSZ> fx;
+
+		void reset();
+	};
+
+	[[nodiscard]]
+	JudgementLanes CreateJudgementLanes(const NoteInfo& noteInfo, const BeatInfo& beatInfo, const TimingCache& timingCache);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/Note/NoteInfo.hpp"
+#include "kson/Util/ScrollUtils.hpp"
+
+namespace kson
+{
+	struct LaserGeometryVertex
+	{
+		double x = 0.0; // Horizontal position (0.0-1.0 for normal lasers, -0.5-1.5 for 2x-widen lasers)
+		double y = 0.0; // Pulse or scroll position
+	};
+
+	// A continuous run of vertices in LaserGeometryLane::vertices (laser sections are split at slams)
+	struct LaserGeometryStrip
+	{
+		std::size_t vertexOffset = 0;
+		std::size_t vertexCount = 0;
+		Pulse sectionY = 0; // Pulse of the laser section the strip belongs to
+		bool wide = false;
+	};
+
+	struct LaserGeometrySlam
+	{
+		double y = 0.0;
+		double xFrom = 0.0;
+		double xTo = 0.0;
+		Pulse sectionY = 0; // Pulse of the laser section the slam belongs to
+		bool wide = false;
+	};
+
+	struct LaserGeometryLane
+	{
+		std::vector<LaserGeometryVertex> vertices;
+		std::vector<LaserGeometryStrip> strips;
+		std::vector<LaserGeometrySlam> slams;
+
+		// Clears the geometry while keeping the capacity of the buffers
+		void clear();
+	};
+
+	struct LaserGeometry
+	{
+		std::array<LaserGeometryLane, kNumLaserLanesSZ> lanes;
+
+		void clear();
+	};
+
+	struct LaserGeometryParams
+	{
+		// Maximum horizontal deviation from the exact curve in x units
+		// (e.g. pixel tolerance divided by the lane width in pixels)
+		double tolerance = 1.0 / 512;
+
+		std::int32_t maxSubdivisionDepth = 10;
+	};
+
+	// Builds laser geometry of sections overlapping the pulse range [startPulse, endPulse] with y in pulses
+	// The buffers in pGeometry are reused, so no allocation occurs once they have grown large enough
+	void BuildLaserGeometry(const LaserLane<LaserSection>& laser, Pulse startPulse, Pulse endPulse, const LaserGeometryParams& params, LaserGeometry* pGeometry);
+
+	// Same as above but with y in scroll positions
+	// (vertices are also inserted at scroll speed changes inside laser segments)
+	void BuildLaserGeometry(const LaserLane<LaserSection>& laser, Pulse startPulse, Pulse endPulse, const ScrollPositionCache& scrollCache, const LaserGeometryParams& params, LaserGeometry* pGeometry);
+
+	void BuildLaserGeometryLane(const ByPulse<LaserSection>& lane, Pulse startPulse, Pulse endPulse, const LaserGeometryParams& params, LaserGeometryLane* pLane);
+
+	void BuildLaserGeometryLane(const ByPulse<LaserSection>& lane, Pulse startPulse, Pulse endPulse, const ScrollPositionCache& scrollCache, const LaserGeometryParams& params, LaserGeometryLane* pLane);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/Note/NoteInfo.hpp"
+#include "kson/Util/ScrollUtils.hpp"
+
+namespace kson
+{
+	enum class ScrollCullingLaneType
+	{
+		BT,
+		FX,
+		Laser,
+	};
+
+	struct ScrollCullingNote
+	{
+		ScrollCullingLaneType laneType = ScrollCullingLaneType::BT;
+		std::int32_t laneIdx = 0;
+		Pulse y = 0;
+		RelPulse length = 0; // Length of the long note or the laser section (0 for chip notes)
+
+		// Range of the scroll positions the note covers
+		// (a long note or a laser section may go back and forth with negative scroll speeds, so the ends are not always the bounds)
+		double minScrollPosition = 0.0;
+		double maxScrollPosition = 0.0;
+	};
+
+	// Node of the centered interval tree
+	struct ScrollCullingNode
+	{
+		double center = 0.0;
+
+		// Notes containing center, in ScrollCullingIndex::midByMin and midByMax
+		std::size_t midOffset = 0;
+		std::size_t midCount = 0;
+
+		std::int32_t left = -1; // Node of the notes entirely below center (-1 if none)
+		std::int32_t right = -1; // Node of the notes entirely above center (-1 if none)
+	};
+
+	// Notes indexed by the range of their scroll positions, so that the notes on screen can be found even where
+	// scroll speeds are negative or zero and the visible notes are not a contiguous time window
+	// Immutable after creation, so it can be shared between threads
+	struct ScrollCullingIndex
+	{
+		std::vector<ScrollCullingNote> notes; // Sorted by minScrollPosition
+
+		std::vector<ScrollCullingNode> nodes; // nodes[0] is the root if not empty
+
+		std::vector<std::size_t> midByMin; // Indices of notes per node, sorted by minScrollPosition in ascending order
+
+		std::vector<std::size_t> midByMax; // Indices of notes per node, sorted by maxScrollPosition in descending order
+	};
+
+	[[nodiscard]]
+	ScrollCullingIndex CreateScrollCullingIndex(const NoteInfo& noteInfo, const ScrollPositionCache& scrollCache);
+
+	// Finds the notes overlapping the scroll position range [minPosition, maxPosition] in O(log n + k)
+	// The indices into index.notes are written to pNoteIndices in no particular order
+	// The buffer is reused, so no allocation occurs once it has grown large enough
+	void FindNotesInScrollRange(const ScrollCullingIndex& index, double minPosition, double maxPosition, std::vector<std::size_t>* pNoteIndices);
+
+	// Same as above with the range relative to the scroll position at the pulse
+	// (e.g., [0, the visible length of the lane] for the notes on screen at the current pulse)
+	void FindVisibleNotes(const ScrollCullingIndex& index, const ScrollPositionCache& scrollCache, double pulse, double minRelPosition, double maxRelPosition, std::vector<std::size_t>* pNoteIndices);
+}
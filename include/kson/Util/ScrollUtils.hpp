@@ -0,0 +1,24 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/Beat/BeatInfo.hpp"
+
+namespace kson
+{
+	// Scroll position is the integral of the scroll speed over pulses
+	// (1 scroll unit = 1 pulse at scroll_speed 1.0)
+	// Immutable after creation, so it can be shared between threads
+	struct ScrollPositionCache
+	{
+		Graph scrollSpeed; // Scroll speed with stops baked and curves expanded into linear segments
+		std::map<Pulse, double> scrollPosition; // Scroll position at each point of scrollSpeed
+	};
+
+	[[nodiscard]]
+	ScrollPositionCache CreateScrollPositionCache(const BeatInfo& beatInfo);
+
+	[[nodiscard]]
+	double PulseToScrollPosition(Pulse pulse, const ScrollPositionCache& cache);
+
+	[[nodiscard]]
+	double PulseDoubleToScrollPosition(double pulse, const ScrollPositionCache& cache);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "kson/Common/Common.hpp"
+#include "kson/Camera/Tilt.hpp"
+#include "kson/Note/NoteInfo.hpp"
+
+namespace kson
+{
+	struct TiltTimelinePoint
+	{
+		double y = 0.0; // Pulse (fractional where a kept value is exceeded between pulses)
+		double v = 0.0; // Value approaching y
+		double vf = 0.0; // Value at y and after (differs from v at slams and other discontinuities)
+	};
+
+	// Tilt value over the whole chart, precomputed from the laser positions and camera.tilt
+	//   - Manual tilt (where ManualTiltValueAt() has a value) overrides auto tilt
+	//   - Auto tilt is (left laser + right laser - 1) * GetAutoTiltScale(type), where an absent left laser counts as 0
+	//     and an absent right laser as 1 (so it is positive when the lasers are on the right side)
+	//   - With keep types, the value stays while the lasers return toward the center, and changes only when the lasers
+	//     go further in the same direction or move to the opposite side
+	// The value is piecewise linear in pulses (curves are subdivided) and linear between vf of a point and v of the next
+	// Immutable after creation, so it can be shared between threads
+	struct TiltTimeline
+	{
+		std::vector<TiltTimelinePoint> points; // Sorted by y
+	};
+
+	struct TiltTimelineParams
+	{
+		// Interval of the linear segments for laser and manual tilt curves
+		RelPulse curveSubdivisionInterval = kResolution / 16;
+	};
+
+	[[nodiscard]]
+	TiltTimeline CreateTiltTimeline(const NoteInfo& noteInfo, const ByPulse<TiltValue>& tilt, const TiltTimelineParams& params = {});
+
+	[[nodiscard]]
+	double TiltTimelineValueAt(const TiltTimeline& timeline, double pulse);
+
+	// Evaluates a timeline at a pulse moving forward every frame in amortized O(1)
+	// (seeking backward falls back to a binary search)
+	// Not thread-safe (each thread needs its own instance)
+	class TiltTimelineCursor
+	{
+	private:
+		const TiltTimeline* m_pTimeline;
+
+		// Index of the first point after the last queried pulse
+		std::size_t m_idx = 0;
+
+	public:
+		explicit TiltTimelineCursor(const TiltTimeline& timeline);
+
+		[[nodiscard]]
+		double valueAt(double pulse);
+	};
+}
@@ -6,6 +6,7 @@
 
 namespace kson
 {
+	// Immutable after creation, so it can be shared between threads together with the BeatInfo it was created from
 	struct TimingCache
 	{
 		std::map<Pulse, double> bpmChangeSec;
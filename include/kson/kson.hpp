@@ -4,10 +4,27 @@
 #include "IO/IDiag.hpp"
 #include "IO/KshIO.hpp"
 #include "IO/KshLoadingDiag.hpp"
+#include "IO/KshMeasureIndex.hpp"
 #include "IO/KshSavingDiag.hpp"
 #include "IO/KsonIO.hpp"
 #include "IO/KsonLoadingDiag.hpp"
+#include "IO/AsyncChartSaver.hpp"
 #include "Util/TimingUtils.hpp"
 #include "Util/GraphUtils.hpp"
 #include "Util/GraphCurve.hpp"
 #include "Util/TiltUtils.hpp"
+#include "Util/TiltTimeline.hpp"
+#include "Util/ScrollUtils.hpp"
+#include "Util/ScrollCulling.hpp"
+#include "Util/LaserGeometry.hpp"
+#include "Util/Canonicalize.hpp"
+#include "Util/JudgementLanes.hpp"
+#include "Util/ChartCache.hpp"
+#include "Util/ChartEditor.hpp"
+#include "Util/ChartQuery.hpp"
+#include "Util/ChartThumbnail.hpp"
+#include "Audio/LaserFilterTables.hpp"
+#include "Analysis/PatternFeatures.hpp"
+#include "Analysis/ChartSimilarity.hpp"
+#include "Replay/ReplayCodec.hpp"
+#include "Batch/BatchJob.hpp"
@@ -0,0 +1,287 @@
+#include "kson/Analysis/ChartSimilarity.hpp"
+#include "kson/Util/TimingUtils.hpp"
+#include <limits>
+#include <tuple>
+
+namespace
+{
+	using namespace kson;
+
+	// Kinds of shingle tokens
+	enum TokenKind : std::uint64_t
+	{
+		kTokenKindBT = 1,
+		kTokenKindFX,
+		kTokenKindLaser,
+	};
+
+	constexpr std::uint64_t SplitMix64(std::uint64_t x)
+	{
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	constexpr std::uint64_t HashCombine(std::uint64_t seed, std::uint64_t value)
+	{
+		return SplitMix64(seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2)));
+	}
+
+	// Parameters of the multiply-shift hash functions for MinHash (multipliers are odd)
+	struct MinHashFunctions
+	{
+		std::array<std::uint64_t, kMinHashSignatureSize> a{};
+		std::array<std::uint64_t, kMinHashSignatureSize> b{};
+
+		constexpr MinHashFunctions()
+		{
+			for (std::size_t i = 0; i < kMinHashSignatureSize; ++i)
+			{
+				a[i] = SplitMix64(2 * i) | 1;
+				b[i] = SplitMix64(2 * i + 1);
+			}
+		}
+	};
+
+	constexpr MinHashFunctions kMinHashFunctions;
+
+	struct MeasureEvent
+	{
+		std::int64_t measureIdx;
+		std::uint64_t token;
+
+		bool operator<(const MeasureEvent& other) const
+		{
+			return measureIdx != other.measureIdx ? measureIdx < other.measureIdx : token < other.token;
+		}
+	};
+
+	class MeasureQuantizer
+	{
+	private:
+		const BeatInfo& m_beatInfo;
+		const TimingCache m_timingCache;
+		const std::int64_t m_division;
+
+	public:
+		MeasureQuantizer(const BeatInfo& beatInfo, std::int32_t division)
+			: m_beatInfo(beatInfo)
+			, m_timingCache(CreateTimingCache(beatInfo))
+			, m_division(std::max(division, 1))
+		{
+		}
+
+		// Returns the measure index, the grid cell in the measure and the measure length
+		std::tuple<std::int64_t, std::int64_t, Pulse> position(Pulse y) const
+		{
+			const std::int64_t measureIdx = PulseToMeasureIdx(y, m_beatInfo, m_timingCache);
+			const Pulse measureY = MeasureIdxToPulse(measureIdx, m_beatInfo, m_timingCache);
+			const Pulse measureLength = std::max(MeasureIdxToPulse(measureIdx + 1, m_beatInfo, m_timingCache) - measureY, Pulse{ 1 });
+			return { measureIdx, (y - measureY) * m_division / measureLength, measureLength };
+		}
+
+		std::int64_t length(RelPulse length, Pulse measureLength) const
+		{
+			return (length * m_division + measureLength / 2) / measureLength;
+		}
+	};
+
+	template <typename Lanes>
+	void AddIntervalEvents(const Lanes& lanes, TokenKind kind, const MeasureQuantizer& quantizer, std::vector<MeasureEvent>& events)
+	{
+		for (std::size_t laneIdx = 0; laneIdx < lanes.size(); ++laneIdx)
+		{
+			for (const auto& [y, interval] : lanes[laneIdx])
+			{
+				const auto [measureIdx, cell, measureLength] = quantizer.position(y);
+				std::uint64_t token = HashCombine(kind, laneIdx);
+				token = HashCombine(token, static_cast<std::uint64_t>(cell));
+				token = HashCombine(token, static_cast<std::uint64_t>(quantizer.length(interval.length, measureLength)));
+				events.push_back({ measureIdx, token });
+			}
+		}
+	}
+
+	std::uint64_t QuantizeLaserValue(double value, std::int32_t steps)
+	{
+		return static_cast<std::uint64_t>(std::llround(std::clamp(value, 0.0, 1.0) * std::max(steps, 1)));
+	}
+}
+
+std::vector<std::uint64_t> kson::ExtractChartShingles(const ChartData& chartData, const ChartShingleParams& params)
+{
+	const MeasureQuantizer quantizer(chartData.beat, params.measureDivision);
+
+	std::vector<MeasureEvent> events;
+	AddIntervalEvents(chartData.note.bt, kTokenKindBT, quantizer, events);
+	AddIntervalEvents(chartData.note.fx, kTokenKindFX, quantizer, events);
+	for (std::size_t laneIdx = 0; laneIdx < chartData.note.laser.size(); ++laneIdx)
+	{
+		for (const auto& [y, section] : chartData.note.laser[laneIdx])
+		{
+			for (const auto& [ry, point] : section.v)
+			{
+				const auto [measureIdx, cell, measureLength] = quantizer.position(y + ry);
+				std::uint64_t token = HashCombine(kTokenKindLaser, laneIdx);
+				token = HashCombine(token, static_cast<std::uint64_t>(cell));
+				token = HashCombine(token, QuantizeLaserValue(point.v.v, params.laserValueSteps));
+				token = HashCombine(token, QuantizeLaserValue(point.v.vf, params.laserValueSteps));
+				token = HashCombine(token, static_cast<std::uint64_t>(section.w));
+				events.push_back({ measureIdx, token });
+			}
+		}
+	}
+	std::sort(events.begin(), events.end());
+
+	// Hash of the events of each non-empty measure
+	std::vector<std::uint64_t> measureHashes;
+	for (std::size_t i = 0; i < events.size();)
+	{
+		std::uint64_t hash = 0;
+		const std::int64_t measureIdx = events[i].measureIdx;
+		for (; i < events.size() && events[i].measureIdx == measureIdx; ++i)
+		{
+			hash = HashCombine(hash, events[i].token);
+		}
+		measureHashes.push_back(hash);
+	}
+
+	std::vector<std::uint64_t> shingles;
+	const std::size_t measuresPerShingle = static_cast<std::size_t>(std::max(params.measuresPerShingle, 1));
+	if (!measureHashes.empty())
+	{
+		const std::size_t numShingles = measureHashes.size() >= measuresPerShingle ? measureHashes.size() - measuresPerShingle + 1 : 1;
+		shingles.reserve(numShingles);
+		for (std::size_t i = 0; i < numShingles; ++i)
+		{
+			std::uint64_t hash = 0;
+			for (std::size_t j = i; j < std::min(i + measuresPerShingle, measureHashes.size()); ++j)
+			{
+				hash = HashCombine(hash, measureHashes[j]);
+			}
+			shingles.push_back(hash);
+		}
+	}
+	std::sort(shingles.begin(), shingles.end());
+	shingles.erase(std::unique(shingles.begin(), shingles.end()), shingles.end());
+
+	return shingles;
+}
+
+kson::MinHashSignature kson::ComputeMinHashSignature(const std::vector<std::uint64_t>& shingles)
+{
+	MinHashSignature signature;
+	signature.fill(std::numeric_limits<std::uint32_t>::max());
+	for (const std::uint64_t shingle : shingles)
+	{
+		const std::uint64_t x = SplitMix64(shingle);
+		for (std::size_t i = 0; i < kMinHashSignatureSize; ++i)
+		{
+			const auto h = static_cast<std::uint32_t>((x * kMinHashFunctions.a[i] + kMinHashFunctions.b[i]) >> 32);
+			signature[i] = std::min(signature[i], h);
+		}
+	}
+	return signature;
+}
+
+kson::MinHashSignature kson::ComputeMinHashSignature(const ChartData& chartData, const ChartShingleParams& params)
+{
+	return ComputeMinHashSignature(ExtractChartShingles(chartData, params));
+}
+
+double kson::EstimateSimilarity(const MinHashSignature& a, const MinHashSignature& b)
+{
+	std::size_t numEqual = 0;
+	for (std::size_t i = 0; i < kMinHashSignatureSize; ++i)
+	{
+		if (a[i] == b[i])
+		{
+			++numEqual;
+		}
+	}
+	return static_cast<double>(numEqual) / static_cast<double>(kMinHashSignatureSize);
+}
+
+kson::ChartSimilarityIndex::ChartSimilarityIndex(const ChartSimilarityIndexParams& params)
+	: m_numBands(std::clamp(params.numBands, std::size_t{ 1 }, kMinHashSignatureSize))
+{
+	while (kMinHashSignatureSize % m_numBands != 0)
+	{
+		--m_numBands;
+	}
+	m_numRows = kMinHashSignatureSize / m_numBands;
+	m_buckets.resize(m_numBands);
+}
+
+std::uint64_t kson::ChartSimilarityIndex::bandHash(const MinHashSignature& signature, std::size_t bandIdx) const
+{
+	std::uint64_t hash = bandIdx;
+	for (std::size_t i = bandIdx * m_numRows; i < (bandIdx + 1) * m_numRows; ++i)
+	{
+		hash = HashCombine(hash, signature[i]);
+	}
+	return hash;
+}
+
+std::vector<std::uint32_t> kson::ChartSimilarityIndex::candidateIndices(const MinHashSignature& signature) const
+{
+	std::vector<std::uint32_t> indices;
+	for (std::size_t bandIdx = 0; bandIdx < m_numBands; ++bandIdx)
+	{
+		const auto& buckets = m_buckets[bandIdx];
+		if (const auto it = buckets.find(bandHash(signature, bandIdx)); it != buckets.end())
+		{
+			indices.insert(indices.end(), it->second.begin(), it->second.end());
+		}
+	}
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	return indices;
+}
+
+void kson::ChartSimilarityIndex::add(std::uint64_t id, const MinHashSignature& signature)
+{
+	const auto idx = static_cast<std::uint32_t>(m_ids.size());
+	m_ids.push_back(id);
+	m_signatures.push_back(signature);
+	for (std::size_t bandIdx = 0; bandIdx < m_numBands; ++bandIdx)
+	{
+		m_buckets[bandIdx][bandHash(signature, bandIdx)].push_back(idx);
+	}
+}
+
+std::size_t kson::ChartSimilarityIndex::size() const
+{
+	return m_ids.size();
+}
+
+std::size_t kson::ChartSimilarityIndex::numBands() const
+{
+	return m_numBands;
+}
+
+std::vector<std::uint64_t> kson::ChartSimilarityIndex::findCandidates(const MinHashSignature& signature) const
+{
+	std::vector<std::uint64_t> ids;
+	for (const std::uint32_t idx : candidateIndices(signature))
+	{
+		ids.push_back(m_ids[idx]);
+	}
+	return ids;
+}
+
+std::vector<kson::SimilarChart> kson::ChartSimilarityIndex::findSimilar(const MinHashSignature& signature, double minSimilarity) const
+{
+	std::vector<SimilarChart> result;
+	for (const std::uint32_t idx : candidateIndices(signature))
+	{
+		const double similarity = EstimateSimilarity(signature, m_signatures[idx]);
+		if (similarity >= minSimilarity)
+		{
+			result.push_back({ .id = m_ids[idx], .similarity = similarity });
+		}
+	}
+	std::stable_sort(result.begin(), result.end(), [](const SimilarChart& a, const SimilarChart& b) { return a.similarity > b.similarity; });
+	return result;
+}
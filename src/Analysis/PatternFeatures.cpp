@@ -0,0 +1,276 @@
+#include "kson/Analysis/PatternFeatures.hpp"
+#include <atomic>
+#include <bit>
+#include <thread>
+
+namespace
+{
+	using namespace kson;
+
+	using Bitset = std::vector<std::uint64_t>;
+
+	constexpr std::size_t kWordBits = 64;
+
+	std::size_t CellAt(Pulse y)
+	{
+		return static_cast<std::size_t>(std::max(y, Pulse{ 0 }) / kPatternGridPulse);
+	}
+
+	void SetBit(Bitset& bitset, std::size_t idx)
+	{
+		bitset[idx / kWordBits] |= std::uint64_t{ 1 } << (idx % kWordBits);
+	}
+
+	// Sets bits in [first, last)
+	void SetRange(Bitset& bitset, std::size_t first, std::size_t last)
+	{
+		while (first < last && first % kWordBits != 0)
+		{
+			SetBit(bitset, first++);
+		}
+		while (first + kWordBits <= last)
+		{
+			bitset[first / kWordBits] = ~std::uint64_t{ 0 };
+			first += kWordBits;
+		}
+		while (first < last)
+		{
+			SetBit(bitset, first++);
+		}
+	}
+
+	// Returns the word idx of the bitset shifted by d bits toward the lower index
+	// (bit t of the result is bit t + d of the bitset)
+	std::uint64_t ShiftedWord(const Bitset& bitset, std::size_t idx, std::size_t d)
+	{
+		const std::size_t srcIdx = idx + d / kWordBits;
+		const std::size_t bitShift = d % kWordBits;
+		if (srcIdx >= bitset.size())
+		{
+			return 0;
+		}
+
+		std::uint64_t word = bitset[srcIdx] >> bitShift;
+		if (bitShift != 0 && srcIdx + 1 < bitset.size())
+		{
+			word |= bitset[srcIdx + 1] << (kWordBits - bitShift);
+		}
+		return word;
+	}
+
+	template <typename Lanes>
+	Pulse LastNoteEnd(const Lanes& lanes)
+	{
+		Pulse lastEnd = 0;
+		for (const auto& lane : lanes)
+		{
+			if (!lane.empty())
+			{
+				const auto& [y, interval] = *lane.rbegin();
+				lastEnd = std::max(lastEnd, y + interval.length);
+			}
+		}
+		return lastEnd;
+	}
+}
+
+void kson::PatternAnalyzer::rasterize(const NoteInfo& note)
+{
+	const Pulse lastEnd = std::max(LastNoteEnd(note.bt), LastNoteEnd(note.fx));
+	m_numWords = CellAt(lastEnd) / kWordBits + 1;
+
+	for (std::size_t i = 0; i < kNumBTLanesSZ; ++i)
+	{
+		m_btHeads[i].assign(m_numWords, 0);
+		for (const auto& [y, interval] : note.bt[i])
+		{
+			SetBit(m_btHeads[i], CellAt(y));
+		}
+	}
+
+	for (std::size_t i = 0; i < kNumFXLanesSZ; ++i)
+	{
+		m_fxHeads[i].assign(m_numWords, 0);
+		m_fxHolds[i].assign(m_numWords, 0);
+		for (const auto& [y, interval] : note.fx[i])
+		{
+			const std::size_t cell = CellAt(y);
+			SetBit(m_fxHeads[i], cell);
+			SetRange(m_fxHolds[i], cell, std::max(cell + 1, CellAt(y + interval.length)));
+		}
+	}
+
+	// Union of BT heads
+	m_btHeadUnion.assign(m_numWords, 0);
+	for (const auto& heads : m_btHeads)
+	{
+		for (std::size_t w = 0; w < m_numWords; ++w)
+		{
+			m_btHeadUnion[w] |= heads[w];
+		}
+	}
+}
+
+kson::PatternFeatures kson::PatternAnalyzer::analyze(const ChartData& chartData, const PatternAnalysisParams& params)
+{
+	rasterize(chartData.note);
+
+	PatternFeatures features;
+
+	for (const auto& lane : chartData.note.bt)
+	{
+		features.numNotes += static_cast<std::int64_t>(lane.size());
+	}
+	for (const auto& lane : chartData.note.fx)
+	{
+		features.numNotes += static_cast<std::int64_t>(lane.size());
+	}
+
+	const std::size_t jackMaxInterval = static_cast<std::size_t>(std::max(params.jackMaxInterval, 0));
+	const std::size_t trillMaxInterval = static_cast<std::size_t>(std::max(params.trillMaxInterval, 0));
+
+	for (std::size_t w = 0; w < m_numWords; ++w)
+	{
+		// Chords (two or more bits set among all lanes)
+		std::uint64_t ones = 0;
+		std::uint64_t twos = 0;
+		for (const auto& heads : m_btHeads)
+		{
+			twos |= ones & heads[w];
+			ones |= heads[w];
+		}
+		for (const auto& heads : m_fxHeads)
+		{
+			twos |= ones & heads[w];
+			ones |= heads[w];
+		}
+		features.numChords += std::popcount(twos);
+
+		// Jacks
+		for (const auto& heads : m_btHeads)
+		{
+			if (heads[w] == 0)
+			{
+				continue;
+			}
+			std::uint64_t followed = 0;
+			for (std::size_t d = 1; d <= jackMaxInterval; ++d)
+			{
+				followed |= ShiftedWord(heads, w, d);
+			}
+			features.numJacks += std::popcount(heads[w] & followed);
+		}
+
+		// Trills (a note in lane A at t, lane B at t + d and lane A at t + 2d)
+		for (std::size_t a = 0; a < kNumBTLanesSZ; ++a)
+		{
+			if (m_btHeads[a][w] == 0)
+			{
+				continue;
+			}
+			std::uint64_t followed = 0;
+			for (std::size_t b = 0; b < kNumBTLanesSZ; ++b)
+			{
+				if (a == b)
+				{
+					continue;
+				}
+				for (std::size_t d = 1; d <= trillMaxInterval; ++d)
+				{
+					followed |= ShiftedWord(m_btHeads[b], w, d) & ShiftedWord(m_btHeads[a], w, 2 * d);
+				}
+			}
+			features.numTrills += std::popcount(m_btHeads[a][w] & followed);
+		}
+
+		// Crossovers (FX-L with BT-C/D, FX-R with BT-A/B)
+		features.numCrossovers += std::popcount(m_fxHolds[0][w] & (m_btHeads[2][w] | m_btHeads[3][w]));
+		features.numCrossovers += std::popcount(m_fxHolds[1][w] & (m_btHeads[0][w] | m_btHeads[1][w]));
+	}
+
+	// Streams (runs of BT note cells with short gaps)
+	const std::int64_t streamMaxInterval = params.streamMaxInterval;
+	const std::int64_t streamMinLength = std::max(params.streamMinLength, 1);
+	std::int64_t runLength = 0;
+	std::int64_t prevCell = 0;
+	const auto closeRun = [&]()
+	{
+		if (runLength >= streamMinLength)
+		{
+			features.numStreamNotes += runLength;
+			features.maxStreamLength = std::max(features.maxStreamLength, runLength);
+		}
+	};
+	for (std::size_t w = 0; w < m_numWords; ++w)
+	{
+		std::uint64_t word = m_btHeadUnion[w];
+		while (word != 0)
+		{
+			const std::int64_t cell = static_cast<std::int64_t>(w * kWordBits) + std::countr_zero(word);
+			word &= word - 1;
+			if (runLength > 0 && cell - prevCell <= streamMaxInterval)
+			{
+				++runLength;
+			}
+			else
+			{
+				closeRun();
+				runLength = 1;
+			}
+			prevCell = cell;
+		}
+	}
+	closeRun();
+
+	return features;
+}
+
+kson::PatternFeatures kson::AnalyzePatternFeatures(const ChartData& chartData, const PatternAnalysisParams& params)
+{
+	PatternAnalyzer analyzer;
+	return analyzer.analyze(chartData, params);
+}
+
+std::vector<kson::PatternFeatures> kson::AnalyzePatternFeatures(const std::vector<const ChartData*>& charts, const PatternAnalysisParams& params, std::size_t numThreads)
+{
+	std::vector<PatternFeatures> results(charts.size());
+	if (numThreads == 0)
+	{
+		numThreads = std::max(std::thread::hardware_concurrency(), 1U);
+	}
+	numThreads = std::min(numThreads, charts.size());
+
+	// Each worker takes the next chart and reuses its own analyzer
+	std::atomic<std::size_t> nextIdx = 0;
+	const auto worker = [&]()
+	{
+		PatternAnalyzer analyzer;
+		for (std::size_t idx = nextIdx++; idx < charts.size(); idx = nextIdx++)
+		{
+			if (charts[idx] != nullptr)
+			{
+				results[idx] = analyzer.analyze(*charts[idx], params);
+			}
+		}
+	};
+
+	if (numThreads <= 1)
+	{
+		worker();
+		return results;
+	}
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for (std::size_t i = 0; i + 1 < numThreads; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	return results;
+}
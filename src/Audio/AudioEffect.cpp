@@ -1,11 +1,11 @@
 #include "kson/Audio/AudioEffect.hpp"
+#include "kson/Common/LookupTable.hpp"
 
 namespace
 {
 	using namespace kson;
 
-	const std::unordered_map<std::string_view, AudioEffectType> s_strToAudioEffectType
-	{
+	constexpr auto kStrToAudioEffectType = MakeLookupTable<std::string_view, AudioEffectType>({
 		{ "retrigger", AudioEffectType::Retrigger },
 		{ "gate", AudioEffectType::Gate },
 		{ "flanger", AudioEffectType::Flanger },
@@ -20,10 +20,9 @@ namespace
 		{ "high_pass_filter", AudioEffectType::HighPassFilter },
 		{ "low_pass_filter", AudioEffectType::LowPassFilter },
 		{ "peaking_filter", AudioEffectType::PeakingFilter },
-	};
+	});
 
-	const std::unordered_map<AudioEffectType, std::string_view> s_audioEffectTypeToStr
-	{
+	constexpr auto kAudioEffectTypeToStr = MakeLookupTable<AudioEffectType, std::string_view>({
 		{ AudioEffectType::Retrigger, "retrigger" },
 		{ AudioEffectType::Gate, "gate" },
 		{ AudioEffectType::Flanger, "flanger" },
@@ -38,31 +37,17 @@ namespace
 		{ AudioEffectType::HighPassFilter, "high_pass_filter" },
 		{ AudioEffectType::LowPassFilter, "low_pass_filter" },
 		{ AudioEffectType::PeakingFilter, "peaking_filter" },
-	};
+	});
 }
 
 kson::AudioEffectType kson::StrToAudioEffectType(std::string_view str)
 {
-	if (s_strToAudioEffectType.contains(str))
-	{
-		return s_strToAudioEffectType.at(str);
-	}
-	else
-	{
-		return AudioEffectType::Unspecified;
-	}
+	return kStrToAudioEffectType.valueOr(str, AudioEffectType::Unspecified);
 }
 
 std::string_view kson::AudioEffectTypeToStr(AudioEffectType type)
 {
-	if (s_audioEffectTypeToStr.contains(type))
-	{
-		return s_audioEffectTypeToStr.at(type);
-	}
-	else
-	{
-		return "";
-	}
+	return kAudioEffectTypeToStr.valueOr(type, "");
 }
 
 bool kson::AudioEffectFXInfo::defContains(std::string_view name) const
@@ -73,13 +58,19 @@ bool kson::AudioEffectFXInfo::defContains(std::string_view name) const
 
 const AudioEffectDef& kson::AudioEffectFXInfo::defByName(std::string_view name) const
 {
-	// Note: This is inefficient, so we recommend caching the result of defAsDict if this is used often
-	const auto it = std::find_if(def.begin(), def.end(), [name](const auto& kvp) { return kvp.name == name; });
-	if (it == def.end())
+	const AudioEffectDef* pDef = findDef(name);
+	if (pDef == nullptr)
 	{
-		throw std::runtime_error("audio.audio_effect.fx.def does not contain name '" + std::string(name) + "'");
+		KSON_THROW(std::runtime_error("audio.audio_effect.fx.def does not contain name '" + std::string(name) + "'"));
 	}
-	return it->v;
+	return *pDef;
+}
+
+const AudioEffectDef* kson::AudioEffectFXInfo::findDef(std::string_view name) const
+{
+	// Note: This is inefficient, so we recommend caching the result of defAsDict if this is used often
+	const auto it = std::find_if(def.begin(), def.end(), [name](const auto& kvp) { return kvp.name == name; });
+	return it == def.end() ? nullptr : &it->v;
 }
 
 Dict<AudioEffectDef> kson::AudioEffectFXInfo::defAsDict() const
@@ -100,15 +91,21 @@ bool kson::AudioEffectLaserInfo::defContains(std::string_view name) const
 }
 
 const AudioEffectDef& kson::AudioEffectLaserInfo::defByName(std::string_view name) const
+{
+	const AudioEffectDef* pDef = findDef(name);
+	if (pDef == nullptr)
+	{
+		KSON_THROW(std::runtime_error("audio.audio_effect.laser.def does not contain name '" + std::string(name) + "'"));
+	}
+	return *pDef;
+}
+
+const AudioEffectDef* kson::AudioEffectLaserInfo::findDef(std::string_view name) const
 {
 	// Note: If you call this function frequently, it's recommended to first call defAsDict to get the dictionary and use it,
 	//       as this function uses linear search.
 	const auto it = std::find_if(def.begin(), def.end(), [name](const auto& kvp) { return kvp.name == name; });
-	if (it == def.end())
-	{
-		throw std::runtime_error("audio.audio_effect.laser.def does not contain name '" + std::string(name) + "'");
-	}
-	return it->v;
+	return it == def.end() ? nullptr : &it->v;
 }
 
 Dict<AudioEffectDef> kson::AudioEffectLaserInfo::defAsDict() const
@@ -0,0 +1,400 @@
+#include "kson/Audio/LaserFilterTables.hpp"
+#include <numbers>
+
+namespace
+{
+	using namespace kson;
+
+	constexpr double kMinFilterFreq = 10.0;
+	constexpr double kMaxFilterFreqRate = 0.49; // Relative to the sample rate (slightly below the Nyquist frequency)
+	constexpr double kMinFilterQ = 0.01;
+
+	constexpr std::string_view kPresetLaserFilterNames[] = {
+		"peaking_filter",
+		"low_pass_filter",
+		"high_pass_filter",
+	};
+
+	std::string_view Trim(std::string_view str)
+	{
+		const std::size_t first = str.find_first_not_of(" \t");
+		if (first == std::string_view::npos)
+		{
+			return {};
+		}
+		const std::size_t last = str.find_last_not_of(" \t");
+		return str.substr(first, last - first + 1);
+	}
+
+	std::optional<double> ParseScalar(std::string_view str, LaserFilterParamUnit unit)
+	{
+		str = Trim(str);
+
+		double scale = 1.0;
+		bool isPercent = false;
+		const auto removeSuffix = [&str](std::string_view suffix)
+		{
+			if (str.ends_with(suffix))
+			{
+				str.remove_suffix(suffix.size());
+				return true;
+			}
+			return false;
+		};
+		switch (unit)
+		{
+		case LaserFilterParamUnit::Frequency:
+			if (removeSuffix("kHz"))
+			{
+				scale = 1000.0;
+			}
+			else
+			{
+				removeSuffix("Hz");
+			}
+			break;
+		case LaserFilterParamUnit::Gain:
+			if (removeSuffix("%"))
+			{
+				isPercent = true;
+				scale = kPeakingFilterMaxGainDb / 100;
+			}
+			else
+			{
+				removeSuffix("dB");
+			}
+			break;
+		default:
+			break;
+		}
+
+		str = Trim(str);
+		if (str.empty())
+		{
+			return std::nullopt;
+		}
+
+		// The values are short, so a copy for strtod is cheap (this is not called in the audio callback)
+		const std::string buffer(str);
+		char* end = nullptr;
+		const double value = std::strtod(buffer.c_str(), &end);
+		if (end != buffer.c_str() + buffer.size() || !std::isfinite(value))
+		{
+			return std::nullopt;
+		}
+		if (unit == LaserFilterParamUnit::Frequency && value <= 0.0)
+		{
+			return std::nullopt;
+		}
+		if (isPercent && value < 0.0)
+		{
+			return std::nullopt;
+		}
+		return value * scale;
+	}
+
+	double ClampFreq(double freq, double sampleRate)
+	{
+		return std::clamp(freq, kMinFilterFreq, sampleRate * kMaxFilterFreqRate);
+	}
+
+	BiquadCoefficients Normalize(double b0, double b1, double b2, double a0, double a1, double a2)
+	{
+		return {
+			.b0 = static_cast<float>(b0 / a0),
+			.b1 = static_cast<float>(b1 / a0),
+			.b2 = static_cast<float>(b2 / a0),
+			.a1 = static_cast<float>(a1 / a0),
+			.a2 = static_cast<float>(a2 / a0),
+		};
+	}
+
+	BiquadCoefficients Lerp(const BiquadCoefficients& a, const BiquadCoefficients& b, float t)
+	{
+		return {
+			.b0 = a.b0 + (b.b0 - a.b0) * t,
+			.b1 = a.b1 + (b.b1 - a.b1) * t,
+			.b2 = a.b2 + (b.b2 - a.b2) * t,
+			.a1 = a.a1 + (b.a1 - a.a1) * t,
+			.a2 = a.a2 + (b.a2 - a.a2) * t,
+		};
+	}
+
+	// Splits a normalized value (0.0-1.0) into the table index and the interpolation rate
+	std::pair<std::size_t, float> QuantizeIndex(double value, std::size_t numSteps)
+	{
+		if (numSteps == 0)
+		{
+			return { 0, 0.0f };
+		}
+		const double scaled = std::clamp(value, 0.0, 1.0) * static_cast<double>(numSteps);
+		const std::size_t idx = std::min(static_cast<std::size_t>(scaled), numSteps - 1);
+		return { idx, static_cast<float>(scaled - static_cast<double>(idx)) };
+	}
+
+	LaserFilterParams ResolveParams(LaserFilterParams filterParams, const Dict<ByPulse<std::string>>* pParamChange, Pulse pulse)
+	{
+		if (pParamChange == nullptr)
+		{
+			return filterParams;
+		}
+
+		AudioEffectParams params;
+		for (const auto& [paramName, values] : *pParamChange)
+		{
+			const auto itr = ValueItrAt(values, pulse);
+			if (itr != values.end() && itr->first <= pulse)
+			{
+				params.emplace(paramName, itr->second);
+			}
+		}
+		ApplyLaserFilterParams(params, &filterParams);
+		return filterParams;
+	}
+}
+
+double kson::LaserFilterParamValue::at(double laserPosition, bool logScale) const
+{
+	const double t = std::clamp(laserPosition, 0.0, 1.0);
+	if (logScale && onMin > 0.0 && onMax > 0.0)
+	{
+		return onMin * std::pow(onMax / onMin, t);
+	}
+	return std::lerp(onMin, onMax, t);
+}
+
+std::optional<kson::LaserFilterParamValue> kson::ParseLaserFilterParamValue(std::string_view str, LaserFilterParamUnit unit)
+{
+	std::optional<double> off;
+	if (const std::size_t offDelimiterIdx = str.find('>'); offDelimiterIdx != std::string_view::npos)
+	{
+		off = ParseScalar(str.substr(0, offDelimiterIdx), unit);
+		if (!off.has_value())
+		{
+			return std::nullopt;
+		}
+		str.remove_prefix(offDelimiterIdx + 1);
+	}
+
+	// Skip the first character so that a negative value is not taken as the delimiter (e.g., "-3dB--6dB")
+	str = Trim(str);
+	const std::size_t rangeDelimiterIdx = str.empty() ? std::string_view::npos : str.find('-', 1);
+	const std::optional<double> onMin = ParseScalar(str.substr(0, rangeDelimiterIdx), unit);
+	if (!onMin.has_value())
+	{
+		return std::nullopt;
+	}
+
+	std::optional<double> onMax = onMin;
+	if (rangeDelimiterIdx != std::string_view::npos)
+	{
+		onMax = ParseScalar(str.substr(rangeDelimiterIdx + 1), unit);
+		if (!onMax.has_value())
+		{
+			return std::nullopt;
+		}
+	}
+
+	return LaserFilterParamValue{
+		.off = off.value_or(*onMin),
+		.onMin = *onMin,
+		.onMax = *onMax,
+	};
+}
+
+kson::BiquadCoefficients kson::LowPassFilterCoefficients(double freq, double q, double sampleRate)
+{
+	const double w0 = 2 * std::numbers::pi * ClampFreq(freq, sampleRate) / sampleRate;
+	const double cosW0 = std::cos(w0);
+	const double alpha = std::sin(w0) / (2 * std::max(q, kMinFilterQ));
+	return Normalize((1 - cosW0) / 2, 1 - cosW0, (1 - cosW0) / 2, 1 + alpha, -2 * cosW0, 1 - alpha);
+}
+
+kson::BiquadCoefficients kson::HighPassFilterCoefficients(double freq, double q, double sampleRate)
+{
+	const double w0 = 2 * std::numbers::pi * ClampFreq(freq, sampleRate) / sampleRate;
+	const double cosW0 = std::cos(w0);
+	const double alpha = std::sin(w0) / (2 * std::max(q, kMinFilterQ));
+	return Normalize((1 + cosW0) / 2, -(1 + cosW0), (1 + cosW0) / 2, 1 + alpha, -2 * cosW0, 1 - alpha);
+}
+
+kson::BiquadCoefficients kson::PeakingFilterCoefficients(double freq, double q, double gainDb, double sampleRate)
+{
+	const double w0 = 2 * std::numbers::pi * ClampFreq(freq, sampleRate) / sampleRate;
+	const double cosW0 = std::cos(w0);
+	const double alpha = std::sin(w0) / (2 * std::max(q, kMinFilterQ));
+	const double a = std::pow(10.0, gainDb / 40);
+	return Normalize(1 + alpha * a, -2 * cosW0, 1 - alpha * a, 1 + alpha / a, -2 * cosW0, 1 - alpha / a);
+}
+
+std::optional<kson::LaserFilterParams> kson::DefaultLaserFilterParams(AudioEffectType type)
+{
+	switch (type)
+	{
+	case AudioEffectType::PeakingFilter:
+		return LaserFilterParams{
+			.type = type,
+			.freq = { .off = 80.0, .onMin = 80.0, .onMax = 10000.0 },
+			.q = { .off = 1.0, .onMin = 1.0, .onMax = 1.0 },
+			.gain = { .off = 0.0, .onMin = kPeakingFilterMaxGainDb / 2, .onMax = kPeakingFilterMaxGainDb / 2 },
+		};
+	case AudioEffectType::LowPassFilter:
+		return LaserFilterParams{
+			.type = type,
+			.freq = { .off = 15000.0, .onMin = 15000.0, .onMax = 600.0 },
+			.q = { .off = 1.5, .onMin = 1.5, .onMax = 1.5 },
+		};
+	case AudioEffectType::HighPassFilter:
+		return LaserFilterParams{
+			.type = type,
+			.freq = { .off = 80.0, .onMin = 80.0, .onMax = 2000.0 },
+			.q = { .off = 1.5, .onMin = 1.5, .onMax = 1.5 },
+		};
+	default:
+		return std::nullopt;
+	}
+}
+
+void kson::ApplyLaserFilterParams(const AudioEffectParams& params, LaserFilterParams* pFilterParams)
+{
+	const auto apply = [&params](const std::string& name, LaserFilterParamUnit unit, LaserFilterParamValue* pValue)
+	{
+		const auto itr = params.find(name);
+		if (itr == params.end())
+		{
+			return;
+		}
+		if (const auto value = ParseLaserFilterParamValue(itr->second, unit))
+		{
+			*pValue = *value;
+		}
+	};
+	apply("freq", LaserFilterParamUnit::Frequency, &pFilterParams->freq);
+	apply("q", LaserFilterParamUnit::Plain, &pFilterParams->q);
+	apply("gain", LaserFilterParamUnit::Gain, &pFilterParams->gain);
+}
+
+kson::LaserFilterCoefficientTable::LaserFilterCoefficientTable(const LaserFilterParams& filterParams, const LaserFilterTableOptions& options)
+	: m_numPositionSteps(std::max(options.numPositionSteps, std::size_t{ 1 }))
+	, m_numFilterGainSteps(filterParams.type == AudioEffectType::PeakingFilter ? std::max(options.numFilterGainSteps, std::size_t{ 1 }) : 0)
+{
+	const std::size_t numPositions = m_numPositionSteps + 1;
+	const std::size_t numFilterGains = m_numFilterGainSteps + 1;
+	m_coefficients.reserve(numPositions * numFilterGains);
+
+	for (std::size_t gainIdx = 0; gainIdx < numFilterGains; ++gainIdx)
+	{
+		const double filterGain = m_numFilterGainSteps == 0 ? 1.0 : static_cast<double>(gainIdx) / static_cast<double>(m_numFilterGainSteps);
+		for (std::size_t positionIdx = 0; positionIdx < numPositions; ++positionIdx)
+		{
+			const double position = static_cast<double>(positionIdx) / static_cast<double>(m_numPositionSteps);
+			const double freq = filterParams.freq.at(position, true);
+			const double q = filterParams.q.at(position, false);
+			switch (filterParams.type)
+			{
+			case AudioEffectType::LowPassFilter:
+				m_coefficients.push_back(LowPassFilterCoefficients(freq, q, options.sampleRate));
+				break;
+			case AudioEffectType::HighPassFilter:
+				m_coefficients.push_back(HighPassFilterCoefficients(freq, q, options.sampleRate));
+				break;
+			case AudioEffectType::PeakingFilter:
+				m_coefficients.push_back(PeakingFilterCoefficients(freq, q, filterParams.gain.at(position, false) * filterGain, options.sampleRate));
+				break;
+			default:
+				m_coefficients.push_back(BiquadCoefficients{}); // Pass-through
+				break;
+			}
+		}
+	}
+}
+
+bool kson::LaserFilterCoefficientTable::empty() const
+{
+	return m_coefficients.empty();
+}
+
+kson::BiquadCoefficients kson::LaserFilterCoefficientTable::at(double laserPosition, double filterGain) const
+{
+	if (m_coefficients.empty())
+	{
+		return BiquadCoefficients{};
+	}
+
+	const std::size_t numPositions = m_numPositionSteps + 1;
+	const auto [positionIdx, positionRate] = QuantizeIndex(laserPosition, m_numPositionSteps);
+	const BiquadCoefficients* row = m_coefficients.data();
+	if (m_numFilterGainSteps == 0)
+	{
+		return Lerp(row[positionIdx], row[positionIdx + 1], positionRate);
+	}
+
+	const auto [gainIdx, gainRate] = QuantizeIndex(filterGain, m_numFilterGainSteps);
+	row += gainIdx * numPositions;
+	const BiquadCoefficients lower = Lerp(row[positionIdx], row[positionIdx + 1], positionRate);
+	row += numPositions;
+	const BiquadCoefficients upper = Lerp(row[positionIdx], row[positionIdx + 1], positionRate);
+	return Lerp(lower, upper, gainRate);
+}
+
+kson::LaserFilterTables::LaserFilterTables(const AudioEffectLaserInfo& laserInfo, const LaserFilterTableOptions& options)
+	: m_filterGain(laserInfo.legacy.filterGain)
+{
+	// Preset filters and user-defined filters (which can overwrite the presets)
+	Dict<LaserFilterParams> baseParams;
+	for (const std::string_view name : kPresetLaserFilterNames)
+	{
+		baseParams.emplace(name, *DefaultLaserFilterParams(StrToAudioEffectType(name)));
+	}
+	for (const auto& [name, def] : laserInfo.def)
+	{
+		std::optional<LaserFilterParams> filterParams = DefaultLaserFilterParams(def.type);
+		if (!filterParams.has_value())
+		{
+			baseParams.erase(name);
+			continue;
+		}
+		ApplyLaserFilterParams(def.v, &*filterParams);
+		baseParams.insert_or_assign(name, *filterParams);
+	}
+
+	for (const auto& [name, filterParams] : baseParams)
+	{
+		const auto paramChangeItr = laserInfo.paramChange.find(name);
+		const Dict<ByPulse<std::string>>* pParamChange = paramChangeItr == laserInfo.paramChange.end() ? nullptr : &paramChangeItr->second;
+
+		// One table for each segment between param changes
+		std::set<Pulse> segmentPulses = { 0 };
+		if (pParamChange != nullptr)
+		{
+			for (const auto& [paramName, values] : *pParamChange)
+			{
+				for (const auto& [y, value] : values)
+				{
+					segmentPulses.insert(y);
+				}
+			}
+		}
+
+		auto& tables = m_tables[name];
+		for (const Pulse y : segmentPulses)
+		{
+			tables.emplace(y, LaserFilterCoefficientTable(ResolveParams(filterParams, pParamChange, y), options));
+		}
+	}
+}
+
+const kson::LaserFilterCoefficientTable* kson::LaserFilterTables::find(std::string_view effectName, Pulse pulse) const
+{
+	const auto itr = m_tables.find(effectName);
+	if (itr == m_tables.end() || itr->second.empty())
+	{
+		return nullptr;
+	}
+	return &ValueItrAt(itr->second, pulse)->second;
+}
+
+double kson::LaserFilterTables::filterGainAt(Pulse pulse) const
+{
+	return ValueAtOrDefault(m_filterGain, pulse, 1.0);
+}
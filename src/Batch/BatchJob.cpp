@@ -0,0 +1,420 @@
+#include "kson/Batch/BatchJob.hpp"
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <filesystem>
+#include <map>
+#include <thread>
+
+namespace
+{
+	using namespace kson;
+
+	std::filesystem::path U8Path(const std::string& utf8Str)
+	{
+		return std::filesystem::path(
+			std::u8string_view(reinterpret_cast<const char8_t*>(utf8Str.data()), utf8Str.size()));
+	}
+
+	constexpr std::string_view kStatusDone = "done";
+	constexpr std::string_view kStatusFailed = "failed";
+
+	void AppendEscaped(std::string& dst, std::string_view str)
+	{
+		for (const char c : str)
+		{
+			switch (c)
+			{
+			case '\\':
+				dst += "\\\\";
+				break;
+			case '\t':
+				dst += "\\t";
+				break;
+			case '\n':
+				dst += "\\n";
+				break;
+			case '\r':
+				dst += "\\r";
+				break;
+			default:
+				dst += c;
+				break;
+			}
+		}
+	}
+
+	std::optional<std::string> Unescape(std::string_view str)
+	{
+		std::string result;
+		result.reserve(str.size());
+		for (std::size_t i = 0; i < str.size(); ++i)
+		{
+			if (str[i] != '\\')
+			{
+				result += str[i];
+				continue;
+			}
+			if (++i >= str.size())
+			{
+				return std::nullopt;
+			}
+			switch (str[i])
+			{
+			case '\\':
+				result += '\\';
+				break;
+			case 't':
+				result += '\t';
+				break;
+			case 'n':
+				result += '\n';
+				break;
+			case 'r':
+				result += '\r';
+				break;
+			default:
+				return std::nullopt;
+			}
+		}
+		return result;
+	}
+
+	// Reads the complete lines of a journal and returns the size of them in bytes
+	// (the rest is a line partially written by an interrupted job)
+	std::size_t ReadJournalLines(std::istream& stream, std::vector<BatchRecord>* pRecords)
+	{
+		std::size_t completeSize = 0;
+		std::string line;
+		while (std::getline(stream, line, '\n'))
+		{
+			if (stream.eof())
+			{
+				// No line break at the end
+				break;
+			}
+			completeSize += line.size() + 1;
+			if (auto record = ParseBatchRecord(line))
+			{
+				pRecords->push_back(std::move(*record));
+			}
+		}
+		return completeSize;
+	}
+}
+
+std::optional<BatchShard> kson::ParseBatchShard(std::string_view str)
+{
+	const std::size_t slashIdx = str.find('/');
+	if (slashIdx == std::string_view::npos)
+	{
+		return std::nullopt;
+	}
+
+	const auto parse = [](std::string_view s) -> std::optional<std::size_t>
+	{
+		std::size_t value = 0;
+		const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value, 10);
+		if (ec != std::errc{} || ptr != s.data() + s.size() || s.empty())
+		{
+			return std::nullopt;
+		}
+		return value;
+	};
+	const auto idx = parse(str.substr(0, slashIdx));
+	const auto count = parse(str.substr(slashIdx + 1));
+	if (!idx.has_value() || !count.has_value() || *idx >= *count)
+	{
+		return std::nullopt;
+	}
+	return BatchShard{ .idx = *idx, .count = *count };
+}
+
+std::size_t kson::BatchShardIdxOf(std::string_view path, std::size_t numShards)
+{
+	// FNV-1a (stable across platforms and runs, unlike std::hash)
+	std::uint64_t hash = 0xCBF29CE484222325ULL;
+	for (const char c : path)
+	{
+		hash ^= static_cast<std::uint8_t>(c);
+		hash *= 0x100000001B3ULL;
+	}
+	return numShards == 0 ? 0 : static_cast<std::size_t>(hash % numShards);
+}
+
+std::vector<std::string> kson::SelectBatchShard(const std::vector<std::string>& paths, const BatchShard& shard)
+{
+	std::vector<std::string> result;
+	for (const std::string& path : paths)
+	{
+		if (BatchShardIdxOf(path, shard.count) == shard.idx)
+		{
+			result.push_back(path);
+		}
+	}
+	return result;
+}
+
+BatchManifest kson::LoadBatchManifest(std::istream& stream)
+{
+	if (!stream.good())
+	{
+		return { .error = ErrorType::GeneralIOError };
+	}
+
+	BatchManifest manifest;
+	std::string line;
+	while (std::getline(stream, line, '\n'))
+	{
+		if (!line.empty() && *line.crbegin() == '\r')
+		{
+			line.pop_back();
+		}
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		manifest.paths.push_back(std::move(line));
+	}
+	return manifest;
+}
+
+BatchManifest kson::LoadBatchManifest(const std::string& filePath)
+{
+	const auto fsPath = U8Path(filePath);
+	if (!std::filesystem::exists(fsPath))
+	{
+		return { .error = ErrorType::FileNotFound };
+	}
+
+	std::ifstream ifs(fsPath, std::ios_base::binary);
+	if (!ifs.good())
+	{
+		return { .error = ErrorType::CouldNotOpenInputFileStream };
+	}
+
+	return LoadBatchManifest(ifs);
+}
+
+std::string kson::FormatBatchRecord(const BatchRecord& record)
+{
+	std::string line(record.status == BatchStatus::Done ? kStatusDone : kStatusFailed);
+	line += '\t';
+	AppendEscaped(line, record.path);
+	for (const std::string& field : record.fields)
+	{
+		line += '\t';
+		AppendEscaped(line, field);
+	}
+	return line;
+}
+
+std::optional<BatchRecord> kson::ParseBatchRecord(std::string_view line)
+{
+	std::vector<std::string> values;
+	while (true)
+	{
+		const std::size_t tabIdx = line.find('\t');
+		auto value = Unescape(line.substr(0, tabIdx));
+		if (!value.has_value())
+		{
+			return std::nullopt;
+		}
+		values.push_back(std::move(*value));
+		if (tabIdx == std::string_view::npos)
+		{
+			break;
+		}
+		line.remove_prefix(tabIdx + 1);
+	}
+
+	if (values.size() < 2 || (values[0] != kStatusDone && values[0] != kStatusFailed) || values[1].empty())
+	{
+		return std::nullopt;
+	}
+	return BatchRecord{
+		.status = values[0] == kStatusDone ? BatchStatus::Done : BatchStatus::Failed,
+		.path = std::move(values[1]),
+		.fields = std::vector<std::string>(std::make_move_iterator(values.begin() + 2), std::make_move_iterator(values.end())),
+	};
+}
+
+ErrorType kson::BatchJournal::open(const std::string& filePath)
+{
+	const std::lock_guard lock(m_mutex);
+	const auto fsPath = U8Path(filePath);
+	m_statuses.clear();
+
+	std::error_code ec;
+	if (std::filesystem::exists(fsPath, ec))
+	{
+		std::vector<BatchRecord> records;
+		std::size_t completeSize = 0;
+		{
+			std::ifstream ifs(fsPath, std::ios_base::binary);
+			if (!ifs.good())
+			{
+				return ErrorType::CouldNotOpenInputFileStream;
+			}
+			completeSize = ReadJournalLines(ifs, &records);
+		}
+		for (const BatchRecord& record : records)
+		{
+			m_statuses.insert_or_assign(record.path, record.status);
+		}
+
+		// Remove the partially written line so that the next record starts at the beginning of a line
+		if (std::filesystem::file_size(fsPath, ec) != completeSize && !ec)
+		{
+			std::filesystem::resize_file(fsPath, completeSize, ec);
+		}
+		if (ec)
+		{
+			return ErrorType::GeneralIOError;
+		}
+	}
+
+	m_stream = std::ofstream(fsPath, std::ios_base::binary | std::ios_base::app);
+	if (!m_stream.good())
+	{
+		return ErrorType::CouldNotOpenOutputFileStream;
+	}
+	return ErrorType::None;
+}
+
+bool kson::BatchJournal::isDone(const std::string& path) const
+{
+	const std::lock_guard lock(m_mutex);
+	const auto itr = m_statuses.find(path);
+	return itr != m_statuses.end() && itr->second == BatchStatus::Done;
+}
+
+ErrorType kson::BatchJournal::append(const BatchRecord& record)
+{
+	const std::string line = FormatBatchRecord(record) + '\n';
+
+	const std::lock_guard lock(m_mutex);
+	m_stream << line << std::flush;
+	if (!m_stream.good())
+	{
+		return ErrorType::GeneralIOError;
+	}
+	m_statuses.insert_or_assign(record.path, record.status);
+	return ErrorType::None;
+}
+
+ErrorType kson::LoadBatchJournal(const std::string& filePath, std::vector<BatchRecord>* pRecords)
+{
+	const auto fsPath = U8Path(filePath);
+	if (!std::filesystem::exists(fsPath))
+	{
+		return ErrorType::FileNotFound;
+	}
+
+	std::ifstream ifs(fsPath, std::ios_base::binary);
+	if (!ifs.good())
+	{
+		return ErrorType::CouldNotOpenInputFileStream;
+	}
+
+	ReadJournalLines(ifs, pRecords);
+	return ErrorType::None;
+}
+
+ErrorType kson::MergeBatchJournals(const std::vector<std::string>& journalFilePaths, std::vector<BatchRecord>* pRecords)
+{
+	std::map<std::string, BatchRecord> lastRecords;
+	std::vector<BatchRecord> records;
+	for (const std::string& journalFilePath : journalFilePaths)
+	{
+		records.clear();
+		if (const ErrorType error = LoadBatchJournal(journalFilePath, &records); error != ErrorType::None)
+		{
+			return error;
+		}
+		for (BatchRecord& record : records)
+		{
+			std::string path = record.path;
+			lastRecords.insert_or_assign(std::move(path), std::move(record));
+		}
+	}
+
+	pRecords->clear();
+	pRecords->reserve(lastRecords.size());
+	for (auto& [path, record] : lastRecords)
+	{
+		pRecords->push_back(std::move(record));
+	}
+	return ErrorType::None;
+}
+
+BatchJobResult kson::RunBatchJob(const std::vector<std::string>& manifestPaths, const BatchJobOptions& options, const BatchFileProcessor& processor)
+{
+	assert(options.shard.idx < options.shard.count);
+
+	BatchJobResult result;
+	const std::vector<std::string> files = SelectBatchShard(manifestPaths, options.shard);
+	result.numFiles = files.size();
+
+	BatchJournal journal;
+	if (const ErrorType error = journal.open(options.journalFilePath); error != ErrorType::None)
+	{
+		result.error = error;
+		return result;
+	}
+
+	std::vector<const std::string*> pendingFiles;
+	for (const std::string& file : files)
+	{
+		if (journal.isDone(file))
+		{
+			++result.numSkipped;
+		}
+		else
+		{
+			pendingFiles.push_back(&file);
+		}
+	}
+
+	std::atomic<std::size_t> nextIdx = 0;
+	std::atomic<std::size_t> numDone = 0;
+	std::atomic<std::size_t> numFailed = 0;
+	std::atomic<bool> journalError = false;
+	const auto worker = [&]()
+	{
+		for (std::size_t idx = nextIdx++; idx < pendingFiles.size() && !journalError; idx = nextIdx++)
+		{
+			const std::string& file = *pendingFiles[idx];
+			BatchRecord record = processor(file);
+			record.path = file;
+			if (journal.append(record) != ErrorType::None)
+			{
+				journalError = true;
+				break;
+			}
+			++(record.status == BatchStatus::Done ? numDone : numFailed);
+		}
+	};
+
+	std::size_t numThreads = options.numThreads != 0 ? options.numThreads : std::max(std::thread::hardware_concurrency(), 1U);
+	numThreads = std::max(std::min(numThreads, pendingFiles.size()), std::size_t{ 1 });
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for (std::size_t i = 0; i + 1 < numThreads; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	result.numDone = numDone;
+	result.numFailed = numFailed;
+	if (journalError)
+	{
+		result.error = ErrorType::GeneralIOError;
+	}
+	return result;
+}
@@ -0,0 +1,24 @@
+#include "kson/Encoding/Encoding.hpp"
+#include "CP932Table.hpp"
+
+std::uint16_t kson::Encoding::CodePointToShiftJIS(char32_t codePoint)
+{
+	// ASCII is identical in Shift-JIS
+	if (codePoint < 0x80)
+	{
+		return static_cast<std::uint16_t>(codePoint);
+	}
+
+	if (codePoint > 0xFFFF)
+	{
+		return 0;
+	}
+
+	const auto itr = std::lower_bound(kCP932Table.begin(), kCP932Table.end(), codePoint,
+		[](const CP932TableEntry& entry, char32_t cp) { return entry.codePoint < cp; });
+	if (itr == kCP932Table.end() || itr->codePoint != codePoint)
+	{
+		return 0;
+	}
+	return itr->cp932;
+}
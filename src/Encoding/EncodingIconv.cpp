@@ -4,15 +4,68 @@
 #include <cerrno>
 #include <iconv.h>
 
+namespace
+{
+	// iconv_t holds the conversion state, so it must not be used by multiple threads at the same time
+	// Each thread opens its own descriptor on the first conversion and closes it on exit
+	class ThreadLocalIconv
+	{
+	private:
+		iconv_t m_cd;
+		int m_openErrno = 0;
+
+	public:
+		ThreadLocalIconv()
+			: m_cd(iconv_open("UTF-8", "CP932"))
+		{
+			if (m_cd == (iconv_t)(-1))
+			{
+				m_openErrno = errno;
+			}
+		}
+
+		~ThreadLocalIconv()
+		{
+			if (valid())
+			{
+				iconv_close(m_cd);
+			}
+		}
+
+		ThreadLocalIconv(const ThreadLocalIconv&) = delete;
+
+		ThreadLocalIconv& operator=(const ThreadLocalIconv&) = delete;
+
+		bool valid() const
+		{
+			return m_cd != (iconv_t)(-1);
+		}
+
+		int openErrno() const
+		{
+			return m_openErrno;
+		}
+
+		iconv_t get() const
+		{
+			return m_cd;
+		}
+	};
+}
+
 std::string kson::Encoding::ShiftJISToUTF8(std::string_view shiftJISStr)
 {
 	// Convert Shift-JIS (CP932) to UTF-8
-	const iconv_t cd = iconv_open("UTF-8", "CP932");
-	if (cd == (iconv_t)(-1))
+	thread_local ThreadLocalIconv iconvCD;
+	if (!iconvCD.valid())
 	{
-		std::cerr << "iconv_open error (errno:" << errno << "). The system may not support Shift-JIS to UTF-8 conversion.\n";
+		std::cerr << "iconv_open error (errno:" << iconvCD.openErrno() << "). The system may not support Shift-JIS to UTF-8 conversion.\n";
 		return std::string();
 	}
+	const iconv_t cd = iconvCD.get();
+
+	// Reset the shift state left by the previous (possibly failed) conversion
+	iconv(cd, nullptr, nullptr, nullptr, nullptr);
 
 	std::string src(shiftJISStr);
 	char *pSrc = src.data();
@@ -23,7 +76,6 @@ std::string kson::Encoding::ShiftJISToUTF8(std::string_view shiftJISStr)
 	if (iconv(cd, &pSrc, &srcSize, &pDst, &dstSize) == (size_t)-1)
 	{
 		const int errnoCopy = errno;
-		iconv_close(cd);
 
 		// Fallback to UTF-8 on conversion failure (e.g., UTF-8 without BOM)
 		if (errnoCopy == EILSEQ || errnoCopy == EINVAL)
@@ -35,7 +87,6 @@ std::string kson::Encoding::ShiftJISToUTF8(std::string_view shiftJISStr)
 		std::cerr << "iconv error (errno:" << errnoCopy << "). Input encoding may not be Shift-JIS.\n";
 		return std::string();
 	}
-	iconv_close(cd);
 
 	return std::string(dst.data());
 }
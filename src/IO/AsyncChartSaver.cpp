@@ -0,0 +1,183 @@
+#include "kson/IO/AsyncChartSaver.hpp"
+#include "kson/IO/KsonIO.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+namespace
+{
+	using namespace kson;
+
+	std::filesystem::path U8Path(const std::string& utf8Str)
+	{
+		return std::filesystem::path(
+			std::u8string_view(reinterpret_cast<const char8_t*>(utf8Str.data()), utf8Str.size()));
+	}
+
+	ErrorType SaveChartDataToStream(std::ostream& stream, const ChartData& chartData, const ChartSavingOptions& options)
+	{
+		switch (options.format)
+		{
+		case ChartFileFormat::Ksh:
+			return SaveKshChartData(stream, chartData, options.kshOptions);
+
+		case ChartFileFormat::Kson:
+#ifndef KSON_WITHOUT_JSON_DEPENDENCY
+			return SaveKsonChartData(stream, chartData);
+#else
+			return ErrorType::UnknownError;
+#endif
+
+		default:
+			return ErrorType::UnknownError;
+		}
+	}
+}
+
+kson::ErrorType kson::SaveChartDataAtomically(const std::string& filePath, const ChartData& chartData, const ChartSavingOptions& options)
+{
+	const std::filesystem::path path = U8Path(filePath);
+	std::filesystem::path tmpPath = path;
+	tmpPath += ".tmp";
+
+	ErrorType error = ErrorType::None;
+	{
+		std::ofstream ofs(tmpPath, std::ios_base::binary);
+		if (!ofs.good())
+		{
+			return ErrorType::CouldNotOpenOutputFileStream;
+		}
+		error = SaveChartDataToStream(ofs, chartData, options);
+		ofs.close();
+		if (error == ErrorType::None && ofs.fail())
+		{
+			error = ErrorType::GeneralIOError;
+		}
+	}
+
+	std::error_code ec;
+	if (error == ErrorType::None)
+	{
+		// Replaces the destination in one step
+		std::filesystem::rename(tmpPath, path, ec);
+		if (!ec)
+		{
+			return ErrorType::None;
+		}
+		error = ErrorType::GeneralIOError;
+	}
+	std::filesystem::remove(tmpPath, ec);
+	return error;
+}
+
+kson::AsyncChartSaver::AsyncChartSaver(std::string filePath, const AsyncChartSaverOptions& options)
+	: m_filePath(std::move(filePath))
+	, m_options(options)
+	, m_thread([this] { threadMain(); })
+{
+}
+
+kson::AsyncChartSaver::~AsyncChartSaver()
+{
+	{
+		const std::lock_guard lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_requestCondition.notify_all();
+	m_thread.join();
+}
+
+void kson::AsyncChartSaver::threadMain()
+{
+	using Clock = std::chrono::steady_clock;
+	std::optional<Clock::time_point> lastWriteStart;
+
+	std::unique_lock lock(m_mutex);
+	while (true)
+	{
+		m_requestCondition.wait(lock, [this] { return m_pPendingChartData != nullptr || m_stopRequested; });
+		if (m_pPendingChartData == nullptr)
+		{
+			// Stop requested with nothing left to write
+			return;
+		}
+
+		// Wait for the interval from the previous write unless flushing or stopping (requests keep being coalesced meanwhile)
+		if (lastWriteStart.has_value() && m_options.minWriteInterval.count() > 0)
+		{
+			const Clock::time_point writeTime = *lastWriteStart + m_options.minWriteInterval;
+			m_requestCondition.wait_until(lock, writeTime, [this] { return m_stopRequested || m_flushGeneration > m_writtenGeneration; });
+		}
+
+		const std::shared_ptr<const ChartData> pChartData = std::move(m_pPendingChartData);
+		m_pPendingChartData = nullptr;
+		const Generation generation = m_requestedGeneration;
+		lastWriteStart = Clock::now();
+
+		lock.unlock();
+		const ErrorType error = SaveChartDataAtomically(m_filePath, *pChartData, m_options.savingOptions);
+		lock.lock();
+
+		m_writtenGeneration = generation;
+		m_lastError = error;
+		++m_numWrites;
+		m_writtenCondition.notify_all();
+	}
+}
+
+kson::AsyncChartSaver::Generation kson::AsyncChartSaver::requestSave(std::shared_ptr<const ChartData> pChartData)
+{
+	Generation generation;
+	{
+		const std::lock_guard lock(m_mutex);
+		m_pPendingChartData = std::move(pChartData);
+		generation = ++m_requestedGeneration;
+	}
+	m_requestCondition.notify_all();
+	return generation;
+}
+
+kson::AsyncChartSaver::Generation kson::AsyncChartSaver::requestSave(ChartData chartData)
+{
+	return requestSave(std::make_shared<const ChartData>(std::move(chartData)));
+}
+
+kson::ErrorType kson::AsyncChartSaver::flush()
+{
+	std::unique_lock lock(m_mutex);
+	const Generation generation = m_requestedGeneration;
+	m_flushGeneration = std::max(m_flushGeneration, generation);
+	m_requestCondition.notify_all();
+	m_writtenCondition.wait(lock, [this, generation] { return m_writtenGeneration >= generation; });
+	return m_lastError;
+}
+
+const std::string& kson::AsyncChartSaver::filePath() const
+{
+	return m_filePath;
+}
+
+kson::AsyncChartSaver::Generation kson::AsyncChartSaver::requestedGeneration() const
+{
+	const std::lock_guard lock(m_mutex);
+	return m_requestedGeneration;
+}
+
+kson::AsyncChartSaver::Generation kson::AsyncChartSaver::writtenGeneration() const
+{
+	const std::lock_guard lock(m_mutex);
+	return m_writtenGeneration;
+}
+
+std::size_t kson::AsyncChartSaver::numWrites() const
+{
+	const std::lock_guard lock(m_mutex);
+	return m_numWrites;
+}
+
+kson::ErrorType kson::AsyncChartSaver::lastError() const
+{
+	const std::lock_guard lock(m_mutex);
+	return m_lastError;
+}
@@ -1,5 +1,8 @@
 #include "kson/IO/KshIO.hpp"
+#include "kson/IO/KshMeasureIndex.hpp"
 #include "kson/Encoding/Encoding.hpp"
+#include "kson/Common/LookupTable.hpp"
+#include "kson/Simd/SimdDispatch.hpp"
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -7,6 +10,8 @@
 #include <optional>
 #include <charconv>
 #include <cmath>
+#include <cerrno>
+#include <cstdlib>
 
 namespace
 {
@@ -56,52 +61,52 @@ namespace
 	template <typename T>
 	T ParseNumeric(std::string_view str, T defaultValue = T{ 0 })
 	{
-#ifdef _MSC_VER
-		T result{ defaultValue };
-		std::from_chars_result r;
-		if constexpr (std::is_integral_v<T>)
+		// Same leading characters as std::stoll/std::stod, without exceptions
+		const std::size_t firstIdx = str.find_first_not_of(" \t\n\v\f\r");
+		if (firstIdx == std::string_view::npos)
 		{
-			r = std::from_chars(str.data(), str.data() + str.size(), result, 10);
+			return defaultValue;
 		}
-		else
+		str.remove_prefix(firstIdx);
+		if (str.starts_with('+') && !str.substr(1).starts_with('-'))
 		{
-			r = std::from_chars(str.data(), str.data() + str.size(), result, std::chars_format::fixed);
+			str.remove_prefix(1);
 		}
 
-		if (r.ec == std::errc{})
+		if constexpr (std::is_integral_v<T>)
 		{
+			using ParseType = std::conditional_t<std::is_unsigned_v<T>, unsigned long long, long long>;
+			ParseType result{};
+			const auto r = std::from_chars(str.data(), str.data() + str.size(), result, 10);
+			if (r.ec != std::errc{})
+			{
+				return defaultValue;
+			}
 			return static_cast<T>(result);
 		}
-
-		return defaultValue;
-#else
-		try
+		else
 		{
-			if constexpr (std::is_integral_v<T>)
+#if defined(__cpp_lib_to_chars)
+			double result{};
+			const auto r = std::from_chars(str.data(), str.data() + str.size(), result, std::chars_format::general);
+			if (r.ec != std::errc{})
 			{
-				if constexpr (std::is_unsigned_v<T>)
-				{
-					return static_cast<T>(std::stoull(std::string(str)));
-				}
-				else
-				{
-					return static_cast<T>(std::stoll(std::string(str)));
-				}
+				return defaultValue;
 			}
-			else
+			return static_cast<T>(result);
+#else
+			// Floating-point std::from_chars is not available in this standard library
+			const std::string s(str);
+			char* pEnd = nullptr;
+			errno = 0;
+			const double result = std::strtod(s.c_str(), &pEnd);
+			if (pEnd == s.c_str() || errno == ERANGE)
 			{
-				return static_cast<T>(std::stod(std::string(str)));
+				return defaultValue;
 			}
-		}
-		catch (const std::out_of_range& e)
-		{
-			return defaultValue;
-		}
-		catch (const std::invalid_argument& e)
-		{
-			return defaultValue;
-		}
+			return static_cast<T>(result);
 #endif
+		}
 	}
 
 	template <typename T, typename U>
@@ -116,6 +121,12 @@ namespace
 		{
 			return std::string(str.cbegin(), str.cend());
 		}
+		else if (Simd::AsciiPrefixLength(str) == str.size())
+		{
+			// ASCII is identical in Shift-JIS, so most lines skip the conversion
+			// (the conversion stops at a null character, so the result is cut there as well)
+			return std::string(str.substr(0, str.find('\0')));
+		}
 		else
 		{
 			return Encoding::ShiftJISToUTF8(str);
@@ -236,8 +247,7 @@ namespace
 		}
 	}
 
-	const std::unordered_map<std::string_view, std::string_view> s_kshFXToKsonAudioEffectNameTable
-	{
+	constexpr auto kKshFXToKsonAudioEffectNameTable = MakeLookupTable<std::string_view, std::string_view>({
 		{ "Retrigger", "retrigger" },
 		{ "Gate", "gate" },
 		{ "Flanger", "flanger" },
@@ -248,20 +258,18 @@ namespace
 		{ "TapeStop", "tapestop" },
 		{ "Echo", "echo" },
 		{ "SideChain", "sidechain" },
-	};
+	});
 
-	const std::unordered_map<std::string_view, std::string_view> s_kshFilterToKsonAudioEffectNameTable
-	{
+	constexpr auto kKshFilterToKsonAudioEffectNameTable = MakeLookupTable<std::string_view, std::string_view>({
 		{ "peak", "peaking_filter" },
 		{ "hpf1", "high_pass_filter" },
 		{ "lpf1", "low_pass_filter" },
 		{ "bitc", "bitcrusher" },
 		{ "fx", "fx" },
 		{ "fx;bitc", "fx;bitcrusher" },
-	};
+	});
 
-	const std::unordered_map<std::string_view, AudioEffectType> s_audioEffectTypeTable
-	{
+	constexpr auto kAudioEffectTypeTable = MakeLookupTable<std::string_view, AudioEffectType>({
 		{ "Retrigger", AudioEffectType::Retrigger },
 		{ "Gate", AudioEffectType::Gate },
 		{ "Flanger", AudioEffectType::Flanger },
@@ -273,10 +281,9 @@ namespace
 		{ "Echo", AudioEffectType::Echo },
 		{ "SideChain", AudioEffectType::Sidechain },
 		{ "SwitchAudio", AudioEffectType::SwitchAudio },
-	};
+	});
 
-	const std::unordered_map<std::string_view, std::string_view> s_audioEffectParamNameTable
-	{
+	constexpr auto kAudioEffectParamNameTable = MakeLookupTable<std::string_view, std::string_view>({
 		{ "attackTime", "attack_time" },
 		{ "bandwidth", "bandwidth" },
 		{ "chunkSize", "chunk_size" },
@@ -310,7 +317,7 @@ namespace
 		{ "volume", "vol" }, // renamed
 		{ "waveLength", "wave_length" },
 		{ "updatePeriod", "update_period" },
-	};
+	});
 
 	constexpr std::int32_t kLaserXMax = 50;
 
@@ -425,9 +432,9 @@ namespace
 	void InsertFiltertype(ChartData& chartData, Pulse time, const std::string& value)
 	{
 		auto& audioEffectLaser = chartData.audio.audioEffect.laser;
-		if (s_kshFilterToKsonAudioEffectNameTable.contains(value))
+		if (const std::string_view* pName = kKshFilterToKsonAudioEffectNameTable.find(value))
 		{
-			std::string name(s_kshFilterToKsonAudioEffectNameTable.at(value));
+			std::string name(*pName);
 			if (name == "fx" && !audioEffectLaser.defContains(name))
 			{
 				if (chartData.audio.bgm.legacy.filenameF.empty())
@@ -829,10 +836,10 @@ namespace
 				// Note: Legacy parameters do not support audioEffectParamValue2 (for Echo), so only audioEffectParamValue1 is sufficient.
 				audioEffectParamValue1 = ParseNumeric<std::int32_t>(audioEffectParamStr);
 			}
-			if (s_kshFXToKsonAudioEffectNameTable.contains(audioEffectName))
+			if (const std::string_view* pName = kKshFXToKsonAudioEffectNameTable.find(audioEffectName))
 			{
 				// Convert the name of preset audio effects
-				audioEffectName = s_kshFXToKsonAudioEffectNameTable.at(audioEffectName);
+				audioEffectName = *pName;
 			}
 			m_pTargetChartData->audio.audioEffect.fx.longEvent[audioEffectName][m_targetLaneIdx].emplace(time, AudioEffectParams{
 				// Store the value of the parameters in temporary keys
@@ -1010,32 +1017,6 @@ namespace
 		}
 	};
 
-	const std::unordered_map<std::string_view, double> s_tiltTypeScaleTable
-	{
-		{ "normal", 1.0 },
-		{ "bigger", 1.75 },
-		{ "biggest", 2.5 },
-		{ "keep_normal", 1.0 },
-		{ "keep_bigger", 1.75 },
-		{ "keep_biggest", 2.5 },
-		{ "zero", 0.0 },
-		{ "big", 1.75 },  // legacy
-		{ "keep", 1.75 }, // legacy
-	};
-
-	const std::unordered_map<std::string_view, bool> s_tiltTypeKeepTable
-	{
-		{ "normal", false },
-		{ "bigger", false },
-		{ "biggest", false },
-		{ "keep_normal", true },
-		{ "keep_bigger", true },
-		{ "keep_biggest", true },
-		{ "zero", false },
-		{ "big", false }, // legacy
-		{ "keep", true }, // legacy
-	};
-
 	AutoTiltType ParseAutoTiltType(std::string_view str)
 	{
 		if (str == "bigger" || str == "big") return AutoTiltType::kBigger;
@@ -1241,13 +1222,12 @@ namespace
 		return std::clamp(value, minValue, maxValue);
 	}
 
-	const std::unordered_map<std::string_view, std::int32_t> s_difficultyNameTable
-	{
+	constexpr auto kDifficultyNameTable = MakeLookupTable<std::string_view, std::int32_t>({
 		{ "light", 0 },
 		{ "challenge", 1 },
 		{ "extended", 2 },
 		{ "infinite", 3 },
-	};
+	});
 
 	template <typename ChartDataType>
 	ChartDataType CreateChartDataFromMetaDataStream(std::istream& stream, bool* pIsUTF8, KshLoadingDiag* pKshDiag = nullptr, std::int64_t* pFileLineNo = nullptr)
@@ -1379,9 +1359,9 @@ namespace
 			chartData.meta.iconFilename = Pop(metaDataHashMap, "icon");
 
 			const std::string difficultyName = Pop(metaDataHashMap, "difficulty", "infinite");
-			if (s_difficultyNameTable.contains(difficultyName))
+			if (const std::int32_t* pIdx = kDifficultyNameTable.find(difficultyName))
 			{
-				chartData.meta.difficulty.idx = s_difficultyNameTable.at(difficultyName);
+				chartData.meta.difficulty.idx = *pIdx;
 			}
 			else
 			{
@@ -1502,12 +1482,94 @@ namespace
 		return chartData;
 	}
 
+	// Measure range to parse with the state carried over the bar line before it (see LoadKshChartDataRange)
+	struct KshBodyRange
+	{
+		const KshMeasureIndex* pIndex = nullptr;
+		std::int64_t firstMeasureIdx = 0;
+		std::int64_t endMeasureIdx = 0; // Exclusive
+	};
+
+	void SeedPreparedLongNotes(PreparedLongNoteArray& preparedLongNoteArray, const KshMeasureCarriedState& state)
+	{
+		for (std::size_t i = 0; i < kNumBTLanesSZ; ++i)
+		{
+			// Notes that end at the bar line are not needed
+			if (const auto& note = state.bt[i]; note.has_value() && note->elapsed < note->length)
+			{
+				preparedLongNoteArray.bt[i].prepare(note->y);
+				preparedLongNoteArray.bt[i].extendLength(note->elapsed);
+			}
+		}
+		for (std::size_t i = 0; i < kNumFXLanesSZ; ++i)
+		{
+			// Notes that end at the bar line are not needed
+			if (const auto& note = state.fx[i]; note.has_value() && note->elapsed < note->length)
+			{
+				preparedLongNoteArray.fx[i].prepare(note->y);
+				preparedLongNoteArray.fx[i].extendLength(note->elapsed);
+			}
+		}
+		for (std::size_t i = 0; i < kNumLaserLanesSZ; ++i)
+		{
+			if (const auto& section = state.laser[i])
+			{
+				auto& preparedLaserSectionRef = preparedLongNoteArray.laser[i];
+				preparedLaserSectionRef.prepare(section->prevPoint.value_or(section->lastPoint).y, section->wide);
+				if (section->prevPoint.has_value())
+				{
+					preparedLaserSectionRef.addGraphPoint(section->prevPoint->y, LaserXToGraphValue(section->prevPoint->laserX, section->wide));
+				}
+				preparedLaserSectionRef.addGraphPoint(section->lastPoint.y, LaserXToGraphValue(section->lastPoint.laserX, section->wide));
+			}
+		}
+	}
+
+	// Completes the long notes crossing the end of the range with the state after the range and publishes them
+	void PublishRangeEndLongNotes(PreparedLongNoteArray& preparedLongNoteArray, const KshMeasureCarriedState* pStateAfterRange, std::int64_t fileLineNo)
+	{
+		for (std::size_t i = 0; i < kNumBTLanesSZ; ++i)
+		{
+			auto& preparedLongNoteRef = preparedLongNoteArray.bt[i];
+			if (preparedLongNoteRef.prepared() && pStateAfterRange && pStateAfterRange->bt[i].has_value())
+			{
+				const KshOpenLongNote& note = *pStateAfterRange->bt[i];
+				preparedLongNoteRef.extendLength(note.length - note.elapsed);
+			}
+			preparedLongNoteRef.publishLongBTNote();
+		}
+		for (std::size_t i = 0; i < kNumFXLanesSZ; ++i)
+		{
+			auto& preparedLongNoteRef = preparedLongNoteArray.fx[i];
+			if (preparedLongNoteRef.prepared() && pStateAfterRange && pStateAfterRange->fx[i].has_value())
+			{
+				const KshOpenLongNote& note = *pStateAfterRange->fx[i];
+				preparedLongNoteRef.extendLength(note.length - note.elapsed);
+			}
+			preparedLongNoteRef.publishLongFXNote();
+		}
+		for (std::size_t i = 0; i < kNumLaserLanesSZ; ++i)
+		{
+			auto& preparedLaserSectionRef = preparedLongNoteArray.laser[i];
+			if (preparedLaserSectionRef.prepared() && pStateAfterRange && pStateAfterRange->laser[i].has_value())
+			{
+				const KshOpenLaserSection& section = *pStateAfterRange->laser[i];
+				if (section.nextPoint.has_value())
+				{
+					preparedLaserSectionRef.addGraphPoint(section.nextPoint->y, LaserXToGraphValue(section.nextPoint->laserX, preparedLaserSectionRef.wide()));
+				}
+			}
+			preparedLaserSectionRef.publishLaserNote(fileLineNo);
+		}
+	}
+
 	void ParseKshChartBody(
 		std::istream& stream,
 		ChartData* pChartData,
 		KshLoadingDiag* pKshDiag,
 		bool isUTF8,
-		std::int64_t* pFileLineNo)
+		std::int64_t* pFileLineNo,
+		const KshBodyRange* pRange = nullptr)
 	{
 		auto& chartData = *pChartData;
 		auto& fileLineNo = *pFileLineNo;
@@ -1556,6 +1618,16 @@ namespace
 		Pulse currentPulse = 0;
 		std::int64_t currentMeasureIdx = 0;
 
+		// The stream is already at the first measure of the range
+		if (pRange)
+		{
+			const KshMeasureIndexEntry& entry = pRange->pIndex->measures.at(static_cast<std::size_t>(pRange->firstMeasureIdx));
+			currentPulse = entry.y;
+			currentMeasureIdx = pRange->firstMeasureIdx;
+			currentTimeSig = entry.state.timeSig;
+			SeedPreparedLongNotes(preparedLongNoteArray, entry.state);
+		}
+
 		bool useLegacyScaleForManualTilt = false;
 
 		// Read chart body
@@ -1690,7 +1762,8 @@ namespace
 
 					const std::string type = params.at("type");
 					params.erase("type");
-					if (!s_audioEffectTypeTable.contains(type))
+					const AudioEffectType* pType = kAudioEffectTypeTable.find(type);
+					if (pType == nullptr)
 					{
 						pKshDiag->warnings.push_back({
 							.type = KshLoadingWarningType::AudioEffectInvalidType,
@@ -1704,16 +1777,16 @@ namespace
 					AudioEffectParams paramsKson;
 					for (const auto& [paramName, value] : params)
 					{
-						if (s_audioEffectParamNameTable.contains(paramName))
+						if (const std::string_view* pParamName = kAudioEffectParamNameTable.find(paramName))
 						{
-							paramsKson.emplace(s_audioEffectParamNameTable.at(paramName), value);
+							paramsKson.emplace(*pParamName, value);
 						}
 					}
 
 					// Name conversion for user-defined audio effects overwriting preset ones
-					if (s_kshFXToKsonAudioEffectNameTable.contains(name))
+					if (const std::string_view* pName = kKshFXToKsonAudioEffectNameTable.find(name))
 					{
-						name = s_kshFXToKsonAudioEffectNameTable.at(name);
+						name = *pName;
 					}
 
 					auto& def = isDefineFX ? chartData.audio.audioEffect.fx.def : chartData.audio.audioEffect.laser.def;
@@ -1728,7 +1801,7 @@ namespace
 							.lineNo = fileLineNo,
 						});
 						existingIt->v = AudioEffectDef{
-							.type = s_audioEffectTypeTable.at(type),
+							.type = *pType,
 							.v = std::move(paramsKson),
 						};
 					}
@@ -1738,7 +1811,7 @@ namespace
 							AudioEffectDefKVP{
 								.name = name,
 								.v = AudioEffectDef{
-									.type = s_audioEffectTypeTable.at(type),
+									.type = *pType,
 									.v = std::move(paramsKson),
 								},
 							});
@@ -1998,16 +2071,13 @@ namespace
 							if (!a[kAudioEffectNameIdx].empty() && !a[kParamNameIdx].empty())
 							{
 								auto& paramChange = isFX ? chartData.audio.audioEffect.fx.paramChange : chartData.audio.audioEffect.laser.paramChange;
-								if (s_audioEffectParamNameTable.contains(a[kParamNameIdx]))
+								if (const std::string_view* pParamName = kAudioEffectParamNameTable.find(a[kParamNameIdx]))
 								{
-									const std::string effectName = isFX
-										? (s_kshFXToKsonAudioEffectNameTable.contains(a[kAudioEffectNameIdx])
-											? std::string{ s_kshFXToKsonAudioEffectNameTable.at(a[kAudioEffectNameIdx]) }
-											: std::string{ a[kAudioEffectNameIdx] })
-										: (s_kshFilterToKsonAudioEffectNameTable.contains(a[kAudioEffectNameIdx])
-											? std::string{ s_kshFilterToKsonAudioEffectNameTable.at(a[kAudioEffectNameIdx]) }
-											: std::string{ a[kAudioEffectNameIdx] });
-									paramChange[effectName][std::string{ s_audioEffectParamNameTable.at(a[kParamNameIdx]) }].insert_or_assign(time, value);
+									const std::string_view* pEffectName = isFX
+										? kKshFXToKsonAudioEffectNameTable.find(a[kAudioEffectNameIdx])
+										: kKshFilterToKsonAudioEffectNameTable.find(a[kAudioEffectNameIdx]);
+									const std::string effectName{ pEffectName ? *pEffectName : std::string_view{ a[kAudioEffectNameIdx] } };
+									paramChange[effectName][std::string{ *pParamName }].insert_or_assign(time, value);
 								}
 							}
 						}
@@ -2228,6 +2298,21 @@ namespace
 				currentMeasureLaserKeySounds.clear();
 				currentPulse += kResolution4 * currentTimeSig.n / currentTimeSig.d;
 				++currentMeasureIdx;
+
+				// Skip the measures after the range
+				if (pRange && currentMeasureIdx == pRange->endMeasureIdx)
+				{
+					const auto& measures = pRange->pIndex->measures;
+					const bool hasMeasuresAfterRange = static_cast<std::size_t>(currentMeasureIdx) < measures.size();
+					PublishRangeEndLongNotes(preparedLongNoteArray, hasMeasuresAfterRange ? &measures[static_cast<std::size_t>(currentMeasureIdx)].state : nullptr, fileLineNo);
+					if (hasMeasuresAfterRange)
+					{
+						stream.clear();
+						stream.seekg(pRange->pIndex->trailerByteOffset, std::ios_base::beg);
+						fileLineNo = pRange->pIndex->trailerLineNo;
+					}
+					pRange = nullptr;
+				}
 				continue;
 			}
 
@@ -2308,10 +2393,10 @@ namespace
 		for (auto& [audioEffectName, lanes] : chartData.audio.audioEffect.fx.longEvent)
 		{
 			AudioEffectType type = AudioEffectType::Unspecified;
-			if (chartData.audio.audioEffect.fx.defContains(audioEffectName))
+			if (const AudioEffectDef* pDef = chartData.audio.audioEffect.fx.findDef(audioEffectName))
 			{
 				// User-defined audio effects
-				type = chartData.audio.audioEffect.fx.defByName(audioEffectName).type;
+				type = pDef->type;
 			}
 			else
 			{
@@ -2477,6 +2562,315 @@ namespace
 		}
 
 	}
+
+	// Mirrors the measure, tempo and long note handling of ParseKshChartBody() without creating ChartData
+	class KshMeasureIndexBuilder
+	{
+	private:
+		struct OpenLongNote
+		{
+			Pulse y = 0;
+			RelPulse length = 0;
+			std::vector<std::size_t> pendingEntryIdxs; // Entries waiting for the total length
+		};
+
+		struct OpenLaserSection
+		{
+			bool wide = false;
+			std::optional<KshLaserPoint> prevPoint;
+			KshLaserPoint lastPoint;
+			std::vector<std::size_t> pendingEntryIdxs; // Entries waiting for the next point
+		};
+
+		struct BufOption
+		{
+			std::size_t lineIdx = 0;
+			std::string key;
+			std::string value;
+		};
+
+		KshMeasureIndex* m_pIndex;
+		std::int32_t m_kshVersionInt;
+		TimeSig m_currentTimeSig;
+		Pulse m_currentPulse = 0;
+		std::int64_t m_currentMeasureIdx = 0;
+
+		std::vector<std::string> m_chartLines;
+		std::vector<BufOption> m_optionLines;
+		std::array<std::optional<OpenLongNote>, kNumBTLanesSZ> m_bt;
+		std::array<std::optional<OpenLongNote>, kNumFXLanesSZ> m_fx;
+		std::array<std::optional<OpenLaserSection>, kNumLaserLanesSZ> m_laser;
+
+		static void ExtendLongNote(std::optional<OpenLongNote>& note, Pulse time, RelPulse length)
+		{
+			if (!note.has_value())
+			{
+				note = OpenLongNote{ .y = time };
+			}
+			note->length += length;
+		}
+
+		template <std::size_t N>
+		void closeLongNote(std::array<std::optional<OpenLongNote>, N>& notes, std::array<std::optional<KshOpenLongNote>, N> KshMeasureCarriedState::*pLanes, std::size_t laneIdx)
+		{
+			auto& note = notes[laneIdx];
+			if (!note.has_value())
+			{
+				return;
+			}
+			for (const std::size_t entryIdx : note->pendingEntryIdxs)
+			{
+				(m_pIndex->measures[entryIdx].state.*pLanes)[laneIdx]->length = note->length;
+			}
+			note.reset();
+		}
+
+		void addLaserPoint(std::size_t laneIdx, Pulse time, std::int32_t laserX, bool wide)
+		{
+			auto& section = m_laser[laneIdx];
+			const KshLaserPoint point{ .y = time, .laserX = laserX };
+			if (!section.has_value())
+			{
+				section = OpenLaserSection{ .wide = wide, .lastPoint = point };
+				return;
+			}
+			if (section->lastPoint.y == time)
+			{
+				// Overwritten as in LaserSectionData::addPoint()
+				section->lastPoint.laserX = laserX;
+				return;
+			}
+			for (const std::size_t entryIdx : section->pendingEntryIdxs)
+			{
+				m_pIndex->measures[entryIdx].state.laser[laneIdx]->nextPoint = point;
+			}
+			section->pendingEntryIdxs.clear();
+			section->prevPoint = section->lastPoint;
+			section->lastPoint = point;
+		}
+
+		void processMeasure()
+		{
+			const std::size_t bufLineCount = m_chartLines.size();
+			if (bufLineCount == 0)
+			{
+				return;
+			}
+
+			const RelPulse measurePulse = kResolution4 * m_currentTimeSig.n / m_currentTimeSig.d;
+			const RelPulse oneLinePulse = measurePulse / bufLineCount;
+
+			std::array<std::unordered_set<std::size_t>, kNumLaserLanesSZ> laserXScale2x;
+			for (const auto& [lineIdx, key, value] : m_optionLines)
+			{
+				const Pulse time = m_currentPulse + lineIdx * oneLinePulse;
+				if (key == "t")
+				{
+					InsertBPMChange(m_pIndex->beat.bpm, m_pIndex->beat.bpm.empty() ? 0 : time, value, m_kshVersionInt);
+				}
+				else if (key == "stop")
+				{
+					const RelPulse length = KshLengthToRelPulse(value);
+					if (length > 0)
+					{
+						m_pIndex->beat.stop[time] = length;
+					}
+				}
+				else if ((key == "laserrange_l" || key == "laserrange_r") && value == "2x")
+				{
+					laserXScale2x[key == "laserrange_l" ? 0 : 1].emplace(lineIdx);
+				}
+			}
+
+			for (std::size_t i = 0; i < bufLineCount; ++i)
+			{
+				const std::string_view buf = m_chartLines[i];
+				const Pulse time = m_currentPulse + i * oneLinePulse;
+				std::size_t currentBlock = 0;
+				std::size_t laneIdx = 0;
+				for (const char c : buf)
+				{
+					if (c == kBlockSeparator)
+					{
+						++currentBlock;
+						laneIdx = 0;
+						continue;
+					}
+
+					if (currentBlock == kBlockIdxBT && laneIdx < kNumBTLanesSZ)
+					{
+						if (c == '2')
+						{
+							ExtendLongNote(m_bt[laneIdx], time, oneLinePulse);
+						}
+						else
+						{
+							closeLongNote(m_bt, &KshMeasureCarriedState::bt, laneIdx);
+						}
+					}
+					else if (currentBlock == kBlockIdxFX && laneIdx < kNumFXLanesSZ)
+					{
+						if (c == '0')
+						{
+							closeLongNote(m_fx, &KshMeasureCarriedState::fx, laneIdx);
+						}
+						else if (c != '2')
+						{
+							ExtendLongNote(m_fx[laneIdx], time, oneLinePulse);
+						}
+					}
+					else if (currentBlock == kBlockIdxLaser && laneIdx < kNumLaserLanesSZ)
+					{
+						if (c == '-')
+						{
+							m_laser[laneIdx].reset();
+						}
+						else if (c != ':')
+						{
+							addLaserPoint(laneIdx, time, CharToLaserX(c), laserXScale2x[laneIdx].contains(i));
+						}
+					}
+					++laneIdx;
+				}
+			}
+		}
+
+		void addEntry(std::int64_t byteOffset, std::int64_t lineNo)
+		{
+			const std::size_t entryIdx = m_pIndex->measures.size();
+			KshMeasureIndexEntry& entry = m_pIndex->measures.emplace_back(KshMeasureIndexEntry{
+				.byteOffset = byteOffset,
+				.lineNo = lineNo,
+				.y = m_currentPulse,
+			});
+			for (std::size_t i = 0; i < kNumBTLanesSZ; ++i)
+			{
+				if (m_bt[i].has_value())
+				{
+					entry.state.bt[i] = KshOpenLongNote{ .y = m_bt[i]->y, .elapsed = m_bt[i]->length };
+					m_bt[i]->pendingEntryIdxs.push_back(entryIdx);
+				}
+			}
+			for (std::size_t i = 0; i < kNumFXLanesSZ; ++i)
+			{
+				if (m_fx[i].has_value())
+				{
+					entry.state.fx[i] = KshOpenLongNote{ .y = m_fx[i]->y, .elapsed = m_fx[i]->length };
+					m_fx[i]->pendingEntryIdxs.push_back(entryIdx);
+				}
+			}
+			for (std::size_t i = 0; i < kNumLaserLanesSZ; ++i)
+			{
+				if (m_laser[i].has_value())
+				{
+					entry.state.laser[i] = KshOpenLaserSection{
+						.wide = m_laser[i]->wide,
+						.prevPoint = m_laser[i]->prevPoint,
+						.lastPoint = m_laser[i]->lastPoint,
+					};
+					m_laser[i]->pendingEntryIdxs.push_back(entryIdx);
+				}
+			}
+		}
+
+	public:
+		KshMeasureIndexBuilder(KshMeasureIndex* pIndex, std::string_view kshVersion, const TimeSig& firstTimeSig)
+			: m_pIndex(pIndex)
+			, m_kshVersionInt(ParseNumeric<std::int32_t>(kshVersion, 170)) // Same default as ParseKshChartBody()
+			, m_currentTimeSig(firstTimeSig)
+		{
+		}
+
+		// The stream starts from the next of the first bar line ("--")
+		void build(std::istream& stream, std::int64_t byteOffset, std::int64_t lineNo)
+		{
+			addEntry(byteOffset, lineNo);
+
+			std::string line;
+			while (std::getline(stream, line, '\n'))
+			{
+				++lineNo;
+				byteOffset += static_cast<std::int64_t>(line.size()) + (stream.eof() ? 0 : 1);
+
+				if (!line.empty() && *line.crbegin() == '\r')
+				{
+					line.pop_back();
+				}
+
+				if (line.empty() || IsCommentLine(line) || line[0] == '#')
+				{
+					continue;
+				}
+
+				if (IsChartLine(line))
+				{
+					m_chartLines.push_back(std::move(line));
+					continue;
+				}
+
+				if (IsOptionLine(line))
+				{
+					// Only ASCII keys are needed here, so the line is not converted to UTF-8
+					// ('=' never appears in the second byte of Shift-JIS characters)
+					const std::size_t equalIdx = line.find(kOptionSeparator);
+					std::string key = line.substr(0, equalIdx);
+					std::string value = line.substr(equalIdx + 1);
+					if (key == "beat")
+					{
+						m_currentTimeSig = ParseTimeSig(value);
+						m_pIndex->beat.timeSig.insert_or_assign(m_currentMeasureIdx, m_currentTimeSig);
+					}
+					else if (key == "t" || key == "stop" || key == "laserrange_l" || key == "laserrange_r")
+					{
+						m_optionLines.push_back({
+							.lineIdx = m_chartLines.size(),
+							.key = std::move(key),
+							.value = std::move(value),
+						});
+					}
+					continue;
+				}
+
+				if (IsBarLine(line))
+				{
+					processMeasure();
+					m_chartLines.clear();
+					m_optionLines.clear();
+					m_currentPulse += kResolution4 * m_currentTimeSig.n / m_currentTimeSig.d;
+					++m_currentMeasureIdx;
+					addEntry(byteOffset, lineNo);
+				}
+			}
+
+			// Long notes not closed until the end are treated as ending there
+			for (std::size_t i = 0; i < kNumBTLanesSZ; ++i)
+			{
+				closeLongNote(m_bt, &KshMeasureCarriedState::bt, i);
+			}
+			for (std::size_t i = 0; i < kNumFXLanesSZ; ++i)
+			{
+				closeLongNote(m_fx, &KshMeasureCarriedState::fx, i);
+			}
+
+			// The entry after the last bar line is not a measure
+			m_pIndex->trailerByteOffset = m_pIndex->measures.back().byteOffset;
+			m_pIndex->trailerLineNo = m_pIndex->measures.back().lineNo;
+			m_pIndex->measures.pop_back();
+
+			for (auto& entry : m_pIndex->measures)
+			{
+				const auto& bpm = m_pIndex->beat.bpm;
+				const auto bpmItr = ValueItrAt(bpm, entry.y);
+				entry.state.bpm = bpmItr == bpm.end() ? 0.0 : bpmItr->second;
+			}
+			std::int64_t measureIdx = 0;
+			for (auto& entry : m_pIndex->measures)
+			{
+				entry.state.timeSig = ValueAtOrDefault(m_pIndex->beat.timeSig, measureIdx, TimeSig{ 4, 4 });
+				++measureIdx;
+			}
+		}
+	};
 }
 
 std::vector<std::string> kson::KshLoadingDiag::playerWarnings() const
@@ -2548,6 +2942,7 @@ kson::ChartData kson::LoadKshChartData(std::istream& stream, KshLoadingDiag* pKs
 		return chartData;
 	}
 
+#if KSON_HAS_EXCEPTIONS
 	try
 	{
 		ParseKshChartBody(stream, &chartData, pKshDiag, isUTF8, &fileLineNo);
@@ -2562,6 +2957,9 @@ kson::ChartData kson::LoadKshChartData(std::istream& stream, KshLoadingDiag* pKs
 			.lineNo = fileLineNo,
 		});
 	}
+#else
+	ParseKshChartBody(stream, &chartData, pKshDiag, isUTF8, &fileLineNo);
+#endif
 
 	return chartData;
 }
@@ -2582,3 +2980,156 @@ ChartData kson::LoadKshChartData(const std::string& filePath, KshLoadingDiag* pK
 
 	return LoadKshChartData(ifs, pKshDiag);
 }
+
+KshMeasureIndex kson::BuildKshMeasureIndex(std::istream& stream)
+{
+	if (!stream.good())
+	{
+		return { .error = ErrorType::GeneralIOError };
+	}
+
+	EliminateUTF8BOM(stream);
+	std::int64_t byteOffset = static_cast<std::int64_t>(stream.tellg());
+
+	// Read the header options needed for the tempo map (see CreateChartDataFromMetaDataStream())
+	bool barLineExists = false;
+	bool titleExists = false;
+	std::string kshVersion = "100";
+	std::string kshVersionCompat;
+	std::optional<std::string> firstBPM;
+	TimeSig firstTimeSig{ 4, 4 };
+	std::int64_t lineNo = 0;
+	std::string line;
+	while (std::getline(stream, line, '\n'))
+	{
+		++lineNo;
+		byteOffset += static_cast<std::int64_t>(line.size()) + (stream.eof() ? 0 : 1);
+
+		if (!line.empty() && *line.crbegin() == '\r')
+		{
+			line.pop_back();
+		}
+
+		if (IsBarLine(line))
+		{
+			barLineExists = true;
+			break;
+		}
+
+		if (IsCommentLine(line) || !IsOptionLine(line))
+		{
+			continue;
+		}
+
+		const std::size_t equalIdx = line.find(kOptionSeparator);
+		const std::string_view key = std::string_view(line).substr(0, equalIdx);
+		const std::string_view value = std::string_view(line).substr(equalIdx + 1);
+		if (key == "title")
+		{
+			titleExists = true;
+		}
+		else if (key == "ver")
+		{
+			kshVersion = value;
+		}
+		else if (key == "ver_compat")
+		{
+			kshVersionCompat = value;
+		}
+		else if (key == "t")
+		{
+			firstBPM = value;
+		}
+		else if (key == "beat")
+		{
+			firstTimeSig = ParseTimeSig(value);
+		}
+	}
+
+	if (!barLineExists || !titleExists)
+	{
+		return { .error = ErrorType::GeneralChartFormatError };
+	}
+
+	KshMeasureIndex index;
+	const std::string_view kshVersionStr = kshVersionCompat.empty() ? kshVersion : kshVersionCompat;
+	index.beat.timeSig.emplace(0, firstTimeSig);
+	if (firstBPM.has_value())
+	{
+		InsertBPMChange(index.beat.bpm, 0, *firstBPM, ParseNumeric<std::int32_t>(kshVersionStr, 100));
+	}
+
+	KshMeasureIndexBuilder builder(&index, kshVersionStr, firstTimeSig);
+	builder.build(stream, byteOffset, lineNo);
+	return index;
+}
+
+ChartData kson::LoadKshChartDataRange(std::istream& stream, const KshMeasureIndex& index, std::int64_t firstMeasureIdx, std::int64_t numMeasures, KshLoadingDiag* pKshDiag)
+{
+	KshLoadingDiag localDiag;
+	if (!pKshDiag)
+	{
+		pKshDiag = &localDiag;
+	}
+
+	if (!stream.good())
+	{
+		return { .error = ErrorType::GeneralIOError };
+	}
+
+	if (index.error != ErrorType::None)
+	{
+		return { .error = index.error };
+	}
+
+	// Load chart meta data
+	bool isUTF8;
+	std::int64_t fileLineNo = 0;
+	ChartData chartData = CreateChartDataFromMetaDataStream<ChartData>(stream, &isUTF8, pKshDiag, &fileLineNo);
+	if (chartData.error != ErrorType::None)
+	{
+		return chartData;
+	}
+	chartData.beat.bpm = index.beat.bpm;
+	chartData.beat.timeSig = index.beat.timeSig;
+	chartData.beat.stop = index.beat.stop;
+
+	const std::int64_t numIndexedMeasures = static_cast<std::int64_t>(index.measures.size());
+	firstMeasureIdx = std::max(firstMeasureIdx, std::int64_t{ 0 });
+	numMeasures = std::min(numMeasures, numIndexedMeasures - firstMeasureIdx);
+	if (numMeasures <= 0)
+	{
+		return chartData;
+	}
+
+	const KshBodyRange range{
+		.pIndex = &index,
+		.firstMeasureIdx = firstMeasureIdx,
+		.endMeasureIdx = firstMeasureIdx + numMeasures,
+	};
+	const KshMeasureIndexEntry& firstEntry = index.measures[static_cast<std::size_t>(firstMeasureIdx)];
+	stream.clear();
+	stream.seekg(firstEntry.byteOffset, std::ios_base::beg);
+	fileLineNo = firstEntry.lineNo;
+
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		ParseKshChartBody(stream, &chartData, pKshDiag, isUTF8, &fileLineNo, &range);
+	}
+	catch (const std::exception& e)
+	{
+		chartData.error = ErrorType::UnknownError;
+		pKshDiag->warnings.push_back({
+			.type = KshLoadingWarningType::UnexpectedError,
+			.scope = WarningScope::PlayerAndEditor,
+			.message = "Unexpected error: " + std::string(e.what()),
+			.lineNo = fileLineNo,
+		});
+	}
+#else
+	ParseKshChartBody(stream, &chartData, pKshDiag, isUTF8, &fileLineNo, &range);
+#endif
+
+	return chartData;
+}
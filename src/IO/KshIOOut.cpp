@@ -1,5 +1,6 @@
 #include "kson/IO/KshIO.hpp"
 #include "kson/Util/GraphUtils.hpp"
+#include "kson/Common/LookupTable.hpp"
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -8,6 +9,8 @@
 #include <cmath>
 #include <limits>
 #include <set>
+#include <ranges>
+#include <charconv>
 
 namespace
 {
@@ -56,9 +59,8 @@ namespace
 	constexpr std::int32_t kVerLayerDelimiterChanged = 166; // Layer delimiter changed from "/" to ";"
 	constexpr std::int32_t kVerManualTiltScaleChanged = 170; // Manual tilt scale changed from 14 degrees to 10 degrees
 
-	// KSON to KSH parameter name mapping (reverse of s_audioEffectParamNameTable)
-	const std::unordered_map<std::string_view, std::string_view> kKsonToKshParamName
-	{
+	// KSON to KSH parameter name mapping (reverse of kAudioEffectParamNameTable in KshIOIn.cpp)
+	constexpr auto kKsonToKshParamName = MakeLookupTable<std::string_view, std::string_view>({
 		{ "attack_time", "attackTime" },
 		{ "bandwidth", "bandwidth" },
 		{ "chunk_size", "chunkSize" },
@@ -92,11 +94,10 @@ namespace
 		{ "vol", "volume" },
 		{ "wave_length", "waveLength" },
 		{ "update_period", "updatePeriod" },
-	};
+	});
 
 	// KSON to KSH AudioEffectType name mapping (for #define_fx and #define_filter type=)
-	const std::unordered_map<std::string_view, std::string_view> kKsonToKshAudioEffectTypeName
-	{
+	constexpr auto kKsonToKshAudioEffectTypeName = MakeLookupTable<std::string_view, std::string_view>({
 		{ "retrigger", "Retrigger" },
 		{ "gate", "Gate" },
 		{ "flanger", "Flanger" },
@@ -111,11 +112,10 @@ namespace
 		{ "high_pass_filter", "HighPassFilter" },
 		{ "low_pass_filter", "LowPassFilter" },
 		{ "peaking_filter", "PeakingFilter" },
-	};
+	});
 
 	// KSON to KSH preset FX effect name mapping (for fx-l/fx-r)
-	const std::unordered_map<std::string_view, std::string_view> kKsonToKshPresetFXEffectName
-	{
+	constexpr auto kKsonToKshPresetFXEffectName = MakeLookupTable<std::string_view, std::string_view>({
 		{ "retrigger", "Retrigger" },
 		{ "gate", "Gate" },
 		{ "flanger", "Flanger" },
@@ -127,35 +127,15 @@ namespace
 		{ "echo", "Echo" },
 		{ "sidechain", "SideChain" },
 		{ "switch_audio", "SwitchAudio" },
-	};
+	});
 
 	// KSON to KSH preset laser filter name mapping (for filtertype= and filter:)
-	const std::unordered_map<std::string_view, std::string_view> kKsonToKshPresetFilterName
-	{
+	constexpr auto kKsonToKshPresetFilterName = MakeLookupTable<std::string_view, std::string_view>({
 		{ "peaking_filter", "peak" },
 		{ "low_pass_filter", "lpf1" },
 		{ "high_pass_filter", "hpf1" },
 		{ "bitcrusher", "bitc" },
-	};
-
-	// Preset effect name to AudioEffectType mapping
-	const std::unordered_map<std::string_view, AudioEffectType> kPresetEffectTypeMap
-	{
-		{ "retrigger", AudioEffectType::Retrigger },
-		{ "gate", AudioEffectType::Gate },
-		{ "flanger", AudioEffectType::Flanger },
-		{ "pitch_shift", AudioEffectType::PitchShift },
-		{ "bitcrusher", AudioEffectType::Bitcrusher },
-		{ "phaser", AudioEffectType::Phaser },
-		{ "wobble", AudioEffectType::Wobble },
-		{ "tapestop", AudioEffectType::Tapestop },
-		{ "echo", AudioEffectType::Echo },
-		{ "sidechain", AudioEffectType::Sidechain },
-		{ "switch_audio", AudioEffectType::SwitchAudio },
-		{ "high_pass_filter", AudioEffectType::HighPassFilter },
-		{ "low_pass_filter", AudioEffectType::LowPassFilter },
-		{ "peaking_filter", AudioEffectType::PeakingFilter },
-	};
+	});
 
 	// GraphValue (0.0-1.0) to LaserX (0-50)
 	constexpr std::int32_t GraphValueToLaserX(double graphValue, bool wide)
@@ -387,9 +367,9 @@ namespace
 			for (const auto& [effectName, lanes] : fxInfo.longEvent)
 			{
 				AudioEffectType effectType = AudioEffectType::Unspecified;
-				if (fxInfo.defContains(effectName))
+				if (const AudioEffectDef* pDef = fxInfo.findDef(effectName))
 				{
-					effectType = fxInfo.defByName(effectName).type;
+					effectType = pDef->type;
 				}
 				else
 				{
@@ -458,6 +438,201 @@ namespace
 		stream.write(reinterpret_cast<const char*>(bom), sizeof(bom));
 	}
 
+	// Stream buffer that encodes UTF-8 text into Shift-JIS (CP932) while passing it to the destination
+	class ShiftJISEncodingStreamBuf : public std::streambuf
+	{
+	private:
+		std::streambuf* m_pDest;
+
+		std::array<char, 4096> m_buffer;
+
+		char32_t m_codePoint = 0;
+
+		std::int32_t m_numContinuationBytes = 0; // Remaining continuation bytes of the current UTF-8 sequence
+
+		std::set<char32_t> m_unmappableCodePoints;
+
+		bool m_hasInvalidSequence = false;
+
+		bool putChar(char c)
+		{
+			return !traits_type::eq_int_type(m_pDest->sputc(c), traits_type::eof());
+		}
+
+		bool putInvalid()
+		{
+			m_hasInvalidSequence = true;
+			return putChar('?');
+		}
+
+		bool putCodePoint(char32_t codePoint)
+		{
+			const std::uint16_t code = Encoding::CodePointToShiftJIS(codePoint);
+			if (code == 0)
+			{
+				m_unmappableCodePoints.insert(codePoint);
+				return putChar('?');
+			}
+			if (code > 0xFF && !putChar(static_cast<char>(code >> 8)))
+			{
+				return false;
+			}
+			return putChar(static_cast<char>(code & 0xFF));
+		}
+
+		bool encodeBuffer()
+		{
+			const char* p = pbase();
+			const char* const end = pptr();
+			while (p != end)
+			{
+				// ASCII is passed through as is
+				if (m_numContinuationBytes == 0 && static_cast<unsigned char>(*p) < 0x80)
+				{
+					const char* const asciiEnd = std::find_if(p, end, [](char c) { return static_cast<unsigned char>(c) >= 0x80; });
+					const std::streamsize size = asciiEnd - p;
+					if (m_pDest->sputn(p, size) != size)
+					{
+						return false;
+					}
+					p = asciiEnd;
+					continue;
+				}
+
+				const unsigned char c = static_cast<unsigned char>(*p);
+				if (m_numContinuationBytes > 0)
+				{
+					if ((c & 0xC0) != 0x80)
+					{
+						// Truncated sequence (the current byte is processed again as a leading byte)
+						m_numContinuationBytes = 0;
+						if (!putInvalid())
+						{
+							return false;
+						}
+						continue;
+					}
+					m_codePoint = (m_codePoint << 6) | (c & 0x3F);
+					--m_numContinuationBytes;
+					if (m_numContinuationBytes == 0 && !putCodePoint(m_codePoint))
+					{
+						return false;
+					}
+				}
+				else if ((c & 0xE0) == 0xC0)
+				{
+					m_codePoint = c & 0x1F;
+					m_numContinuationBytes = 1;
+				}
+				else if ((c & 0xF0) == 0xE0)
+				{
+					m_codePoint = c & 0x0F;
+					m_numContinuationBytes = 2;
+				}
+				else if ((c & 0xF8) == 0xF0)
+				{
+					m_codePoint = c & 0x07;
+					m_numContinuationBytes = 3;
+				}
+				else if (!putInvalid())
+				{
+					return false;
+				}
+				++p;
+			}
+			setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+			return true;
+		}
+
+	protected:
+		int_type overflow(int_type ch) override
+		{
+			if (!encodeBuffer())
+			{
+				return traits_type::eof();
+			}
+			if (!traits_type::eq_int_type(ch, traits_type::eof()))
+			{
+				*pptr() = traits_type::to_char_type(ch);
+				pbump(1);
+			}
+			return traits_type::not_eof(ch);
+		}
+
+		int sync() override
+		{
+			if (!encodeBuffer())
+			{
+				return -1;
+			}
+			return m_pDest->pubsync();
+		}
+
+	public:
+		explicit ShiftJISEncodingStreamBuf(std::streambuf* pDest)
+			: m_pDest(pDest)
+		{
+			setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+		}
+
+		// Flushes the buffer and terminates an incomplete UTF-8 sequence
+		bool finish()
+		{
+			if (!encodeBuffer())
+			{
+				return false;
+			}
+			if (m_numContinuationBytes > 0)
+			{
+				m_numContinuationBytes = 0;
+				if (!putInvalid())
+				{
+					return false;
+				}
+			}
+			return m_pDest->pubsync() != -1;
+		}
+
+		const std::set<char32_t>& unmappableCodePoints() const
+		{
+			return m_unmappableCodePoints;
+		}
+
+		bool hasInvalidSequence() const
+		{
+			return m_hasInvalidSequence;
+		}
+	};
+
+	void AddEncodingWarnings(const ShiftJISEncodingStreamBuf& encodingBuf, KshSavingDiag* pKshSavingDiag)
+	{
+		if (pKshSavingDiag == nullptr)
+		{
+			return;
+		}
+
+		for (const char32_t codePoint : encodingBuf.unmappableCodePoints())
+		{
+			std::ostringstream oss;
+			oss << "Character U+" << std::uppercase << std::hex << std::setw(4) << std::setfill('0') << static_cast<std::uint32_t>(codePoint)
+				<< " cannot be encoded in Shift-JIS and will be replaced with '?'";
+			pKshSavingDiag->warnings.push_back({
+				.type = KshSavingWarningType::UnmappableCharacter,
+				.scope = WarningScope::EditorOnly,
+				.message = oss.str(),
+			});
+		}
+
+		if (encodingBuf.hasInvalidSequence())
+		{
+			pKshSavingDiag->warnings.push_back({
+				.type = KshSavingWarningType::UnmappableCharacter,
+				.scope = WarningScope::EditorOnly,
+				.message = "Invalid UTF-8 sequences will be replaced with '?'",
+			});
+		}
+	}
+
 	// Round double value to 3 decimal places (0.001 precision) for KSH format
 	double RoundToKshDoubleValue(double value)
 	{
@@ -885,9 +1060,10 @@ namespace
 		if (!chartData.compat.kshVersion.empty())
 		{
 			verValue = chartData.compat.kshVersion;
-			try
+			int parsedVer = 0;
+			if (const auto r = std::from_chars(verValue.data(), verValue.data() + verValue.size(), parsedVer); r.ec == std::errc{})
 			{
-				verInt = std::stoi(verValue);
+				verInt = parsedVer;
 				if (verInt < kVerFXFormatChanged)
 				{
 					needVerCompat = true;
@@ -895,7 +1071,7 @@ namespace
 					verInt = kVerFXFormatChanged;
 				}
 			}
-			catch (...)
+			else
 			{
 				verValue = "171";
 				verInt = 171;
@@ -1101,12 +1277,14 @@ namespace
 		}
 
 		// Check if note continues at this pulse
-		for (const auto& [startPulse, interval] : lane)
+		// Notes in a lane do not overlap, so only the last note starting before this pulse needs to be checked
+		const auto itr = lane.lower_bound(pulse);
+		if (itr != lane.begin())
 		{
-			const Pulse endPulse = startPulse + interval.length;
+			const auto& [startPulse, interval] = *std::prev(itr);
 
 			// Note continues at this pulse (but not at the end)
-			if (pulse > startPulse && pulse < endPulse)
+			if (pulse < startPulse + interval.length)
 			{
 				return '2'; // Long note continuation
 			}
@@ -1133,12 +1311,14 @@ namespace
 		}
 
 		// Check if note continues at this pulse
-		for (const auto& [startPulse, interval] : lane)
+		// Notes in a lane do not overlap, so only the last note starting before this pulse needs to be checked
+		const auto itr = lane.lower_bound(pulse);
+		if (itr != lane.begin())
 		{
-			const Pulse endPulse = startPulse + interval.length;
+			const auto& [startPulse, interval] = *std::prev(itr);
 
 			// Note continues at this pulse (but not at the end)
-			if (pulse > startPulse && pulse < endPulse)
+			if (pulse < startPulse + interval.length)
 			{
 				return '1'; // Long note continuation
 			}
@@ -1369,17 +1549,15 @@ namespace
 	{
 		auto& laserState = state.laserStates[laneIdx];
 
-		// Find the segment containing this pulse
-		for (const auto& seg : segments)
+		// Find the first segment containing this pulse
+		// Segments are sorted and do not overlap, so the first segment ending at or after this pulse is the only candidate
+		const auto itr = std::partition_point(segments.begin(), segments.end(),
+			[pulse](const KshLaserSegment& seg) { return seg.startPulse + seg.length < pulse; });
+		if (itr != segments.end() && itr->startPulse <= pulse)
 		{
+			const auto& seg = *itr;
 			const Pulse segmentEnd = seg.startPulse + seg.length;
 
-			// Check if pulse is within this segment
-			if (pulse < seg.startPulse || pulse > segmentEnd)
-			{
-				continue;
-			}
-
 			if (pulse == seg.startPulse)
 			{
 				// Segment start
@@ -1409,14 +1587,24 @@ namespace
 	// Throws std::out_of_range if effectName is not a preset
 	std::string_view KsonPresetFXEffectNameToKsh(const std::string& effectName)
 	{
-		return kKsonToKshPresetFXEffectName.at(effectName);
+		const std::string_view* pName = kKsonToKshPresetFXEffectName.find(effectName);
+		if (pName == nullptr)
+		{
+			KSON_THROW(std::out_of_range("KsonPresetFXEffectNameToKsh: '" + effectName + "' is not a preset"));
+		}
+		return *pName;
 	}
 
 	// Convert KSON preset laser filter name to KSH filter name
 	// Throws std::out_of_range if effectName is not a preset
 	std::string_view KsonPresetLaserFilterNameToKsh(const std::string& effectName)
 	{
-		return kKsonToKshPresetFilterName.at(effectName);
+		const std::string_view* pName = kKsonToKshPresetFilterName.find(effectName);
+		if (pName == nullptr)
+		{
+			KSON_THROW(std::out_of_range("KsonPresetLaserFilterNameToKsh: '" + effectName + "' is not a preset"));
+		}
+		return *pName;
 	}
 
 	// Generate KSH audio effect string from KSON long_event parameters
@@ -1445,9 +1633,9 @@ namespace
 		}
 
 		// If not found in custom definitions, check if it's a preset effect
-		if (type == AudioEffectType::Unspecified && kPresetEffectTypeMap.contains(effectName))
+		if (type == AudioEffectType::Unspecified)
 		{
-			type = kPresetEffectTypeMap.at(effectName);
+			type = StrToAudioEffectType(effectName);
 		}
 
 		if (type != AudioEffectType::Unspecified)
@@ -1719,9 +1907,7 @@ namespace
 						const std::string_view kshEffectName = IsKsonPresetFXEffectName(effectName)
 							? KsonPresetFXEffectNameToKsh(effectName)
 							: std::string_view{ effectName };
-						const std::string kshParamName = kKsonToKshParamName.contains(paramName)
-							? std::string{ kKsonToKshParamName.at(paramName) }
-							: paramName;
+						const std::string_view kshParamName = kKsonToKshParamName.valueOr(paramName, paramName);
 						stream << "fx:" << kshEffectName << ":" << kshParamName << "=" << value << "\r\n";
 					}
 				}
@@ -1741,9 +1927,7 @@ namespace
 						const std::string_view kshEffectName = IsKsonPresetLaserFilterName(effectName)
 							? KsonPresetLaserFilterNameToKsh(effectName)
 							: std::string_view{ effectName };
-						const std::string kshParamName = kKsonToKshParamName.contains(paramName)
-							? std::string{ kKsonToKshParamName.at(paramName) }
-							: paramName;
+						const std::string_view kshParamName = kKsonToKshParamName.valueOr(paramName, paramName);
 						stream << "filter:" << kshEffectName << ":" << kshParamName << "=" << value << "\r\n";
 					}
 				}
@@ -1754,11 +1938,7 @@ namespace
 		// Only use legacy.filter_gain (do not convert from param_change)
 		if (!chartData.audio.audioEffect.laser.legacy.filterGain.empty())
 		{
-			const auto it = std::find_if(
-				chartData.audio.audioEffect.laser.legacy.filterGain.begin(),
-				chartData.audio.audioEffect.laser.legacy.filterGain.end(),
-				[pulse](const auto& pair) { return pair.first == pulse; }
-			);
+			const auto it = chartData.audio.audioEffect.laser.legacy.filterGain.find(pulse);
 			if (it != chartData.audio.audioEffect.laser.legacy.filterGain.end())
 			{
 				const double filterGain = it->second;
@@ -1953,9 +2133,13 @@ namespace
 		for (std::int32_t i = 0; i < kNumLaserLanes; ++i)
 		{
 			// Find segment starting at this pulse
-			for (const auto& seg : laserSegments[i])
+			const auto& segments = laserSegments[i];
+			auto segItr = std::partition_point(segments.begin(), segments.end(),
+				[pulse](const KshLaserSegment& seg) { return seg.startPulse < pulse; });
+			for (; segItr != segments.end() && segItr->startPulse == pulse; ++segItr)
 			{
-				if (seg.startPulse == pulse && seg.isSectionStart)
+				const auto& seg = *segItr;
+				if (seg.isSectionStart)
 				{
 					// Output wide annotation
 					if (seg.wide)
@@ -1970,8 +2154,18 @@ namespace
 		// Output laser curve for points at this pulse
 		for (std::int32_t i = 0; i < kNumLaserLanes; ++i)
 		{
-			for (const auto& [sectionPulse, section] : chartData.note.laser[i])
+			// Sections do not overlap except that a section may end where the next one starts,
+			// so only the last two sections starting at or before this pulse need to be checked
+			const auto& lane = chartData.note.laser[i];
+			const auto sectionEnd = lane.upper_bound(pulse);
+			auto sectionItr = sectionEnd;
+			for (int j = 0; j < 2 && sectionItr != lane.begin(); ++j)
 			{
+				--sectionItr;
+			}
+			for (; sectionItr != sectionEnd; ++sectionItr)
+			{
+				const auto& [sectionPulse, section] = *sectionItr;
 				const RelPulse relPulse = pulse - sectionPulse;
 				if (relPulse >= 0 && section.v.contains(relPulse))
 				{
@@ -2148,6 +2342,25 @@ namespace
 		stream << "\r\n";
 	}
 
+	// Returns the range of events in [first, last) of a map or set keyed by pulse
+	template <typename Container>
+	std::ranges::subrange<typename Container::const_iterator> EventsInRange(const Container& container, Pulse first, Pulse last)
+	{
+		return { container.lower_bound(first), container.lower_bound(last) };
+	}
+
+	// Returns the range of notes overlapping [first, last) in a lane
+	// Notes in a lane do not overlap, so only one note starting before first can reach the range
+	std::ranges::subrange<ByPulse<Interval>::const_iterator> NotesOverlappingRange(const ByPulse<Interval>& lane, Pulse first, Pulse last)
+	{
+		auto begin = lane.lower_bound(first);
+		if (begin != lane.begin())
+		{
+			begin = std::prev(begin);
+		}
+		return { begin, lane.lower_bound(last) };
+	}
+
 	// Calculate optimal division for a measure
 	std::int32_t CalculateOptimalDivision(const ChartData& chartData, const std::array<std::vector<KshLaserSegment>, kNumLaserLanes>& laserSegments, Pulse measureStart, Pulse measureLength)
 	{
@@ -2170,7 +2383,7 @@ namespace
 		// BT notes
 		for (const auto& lane : chartData.note.bt)
 		{
-			for (const auto& [pulse, interval] : lane)
+			for (const auto& [pulse, interval] : NotesOverlappingRange(lane, measureStart, measureEnd))
 			{
 				updateGCD(pulse);
 				updateGCD(pulse + interval.length);
@@ -2193,7 +2406,7 @@ namespace
 		// FX notes
 		for (const auto& lane : chartData.note.fx)
 		{
-			for (const auto& [pulse, interval] : lane)
+			for (const auto& [pulse, interval] : NotesOverlappingRange(lane, measureStart, measureEnd))
 			{
 				updateGCD(pulse);
 				updateGCD(pulse + interval.length);
@@ -2216,10 +2429,13 @@ namespace
 		// Laser notes
 		for (std::int32_t laneIdx = 0; laneIdx < kNumLaserLanes; ++laneIdx)
 		{
+			// Segments are sorted and do not overlap, so skip the ones ending before the measure
 			const auto& segments = laserSegments[laneIdx];
-			for (std::size_t segIdx = 0; segIdx < segments.size(); ++segIdx)
+			auto segItr = std::partition_point(segments.begin(), segments.end(),
+				[measureStart](const KshLaserSegment& seg) { return seg.startPulse + seg.length < measureStart; });
+			for (; segItr != segments.end() && segItr->startPulse < measureEnd; ++segItr)
 			{
-				const auto& seg = segments[segIdx];
+				const auto& seg = *segItr;
 				updateGCD(seg.startPulse);
 				updateGCD(seg.startPulse + seg.length);
 
@@ -2238,63 +2454,63 @@ namespace
 		}
 
 		// BPM changes
-		for (const auto& [pulse, bpm] : chartData.beat.bpm)
+		for (const auto& [pulse, bpm] : EventsInRange(chartData.beat.bpm, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
 		// Stops
-		for (const auto& [pulse, length] : chartData.beat.stop)
+		for (const auto& [pulse, length] : EventsInRange(chartData.beat.stop, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
 		// Scroll speed
-		for (const auto& [pulse, graphPoint] : chartData.beat.scrollSpeed)
+		for (const auto& [pulse, graphPoint] : EventsInRange(chartData.beat.scrollSpeed, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
 		// Camera rotation
-		for (const auto& [pulse, graphPoint] : chartData.camera.cam.body.rotationDeg)
+		for (const auto& [pulse, graphPoint] : EventsInRange(chartData.camera.cam.body.rotationDeg, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
 		// Camera zoom
-		for (const auto& [pulse, graphPoint] : chartData.camera.cam.body.zoomTop)
+		for (const auto& [pulse, graphPoint] : EventsInRange(chartData.camera.cam.body.zoomTop, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
-		for (const auto& [pulse, graphPoint] : chartData.camera.cam.body.zoomBottom)
+		for (const auto& [pulse, graphPoint] : EventsInRange(chartData.camera.cam.body.zoomBottom, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
-		for (const auto& [pulse, graphPoint] : chartData.camera.cam.body.zoomSide)
+		for (const auto& [pulse, graphPoint] : EventsInRange(chartData.camera.cam.body.zoomSide, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
-		for (const auto& [pulse, graphPoint] : chartData.camera.cam.body.centerSplit)
+		for (const auto& [pulse, graphPoint] : EventsInRange(chartData.camera.cam.body.centerSplit, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
 		// Camera tilt
-		for (const auto& [pulse, tiltValue] : chartData.camera.tilt)
+		for (const auto& [pulse, tiltValue] : EventsInRange(chartData.camera.tilt, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
 		// Spin events
-		for (const auto& [pulse, spinEvent] : chartData.camera.cam.pattern.laser.slamEvent.spin)
+		for (const auto& [pulse, spinEvent] : EventsInRange(chartData.camera.cam.pattern.laser.slamEvent.spin, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
-		for (const auto& [pulse, spinEvent] : chartData.camera.cam.pattern.laser.slamEvent.halfSpin)
+		for (const auto& [pulse, spinEvent] : EventsInRange(chartData.camera.cam.pattern.laser.slamEvent.halfSpin, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
-		for (const auto& [pulse, swingEvent] : chartData.camera.cam.pattern.laser.slamEvent.swing)
+		for (const auto& [pulse, swingEvent] : EventsInRange(chartData.camera.cam.pattern.laser.slamEvent.swing, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
@@ -2305,7 +2521,7 @@ namespace
 			{
 				for (std::int32_t laneIdx = 0; laneIdx < kNumFXLanes; ++laneIdx)
 				{
-					for (const auto& [pulse, params] : laneEvents[laneIdx])
+					for (const auto& [pulse, params] : EventsInRange(laneEvents[laneIdx], measureStart, measureEnd))
 					{
 						updateGCD(pulse);
 					}
@@ -2319,7 +2535,7 @@ namespace
 			{
 				for (const auto& [paramName, pulseValueMap] : paramMap)
 				{
-					for (const auto& [pulse, value] : pulseValueMap)
+					for (const auto& [pulse, value] : EventsInRange(pulseValueMap, measureStart, measureEnd))
 					{
 						updateGCD(pulse);
 					}
@@ -2333,7 +2549,7 @@ namespace
 			{
 				for (const auto& [paramName, pulseValueMap] : paramMap)
 				{
-					for (const auto& [pulse, value] : pulseValueMap)
+					for (const auto& [pulse, value] : EventsInRange(pulseValueMap, measureStart, measureEnd))
 					{
 						updateGCD(pulse);
 					}
@@ -2345,19 +2561,19 @@ namespace
 		{
 			for (const auto& [effectName, pulses] : chartData.audio.audioEffect.laser.pulseEvent)
 			{
-				for (const auto& pulse : pulses)
+				for (const Pulse pulse : EventsInRange(pulses, measureStart, measureEnd))
 				{
 					updateGCD(pulse);
 				}
 			}
 		}
 
-		for (const auto& [pulse, vol] : chartData.audio.keySound.laser.vol)
+		for (const auto& [pulse, vol] : EventsInRange(chartData.audio.keySound.laser.vol, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
-		for (const auto& [pulse, gain] : chartData.audio.audioEffect.laser.legacy.filterGain)
+		for (const auto& [pulse, gain] : EventsInRange(chartData.audio.audioEffect.laser.legacy.filterGain, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
@@ -2366,7 +2582,7 @@ namespace
 		{
 			for (const auto& [slamType, pulses] : chartData.audio.keySound.laser.slamEvent)
 			{
-				for (const auto& pulse : pulses)
+				for (const Pulse pulse : EventsInRange(pulses, measureStart, measureEnd))
 				{
 					updateGCD(pulse);
 				}
@@ -2380,7 +2596,7 @@ namespace
 			{
 				for (std::int32_t laneIdx = 0; laneIdx < kNumFXLanes; ++laneIdx)
 				{
-					for (const auto& [pulse, chipData] : lanes[laneIdx])
+					for (const auto& [pulse, chipData] : EventsInRange(lanes[laneIdx], measureStart, measureEnd))
 					{
 						updateGCD(pulse);
 					}
@@ -2388,20 +2604,20 @@ namespace
 			}
 		}
 
-		for (const auto& [pulse, comment] : chartData.editor.comment)
+		for (const auto& [pulse, comment] : EventsInRange(chartData.editor.comment, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
 
 		for (const auto& [optionKey, pulseValueMap] : chartData.compat.kshUnknown.option)
 		{
-			for (const auto& [pulse, values] : pulseValueMap)
+			for (const auto& [pulse, values] : EventsInRange(pulseValueMap, measureStart, measureEnd))
 			{
 				updateGCD(pulse);
 			}
 		}
 
-		for (const auto& [pulse, line] : chartData.compat.kshUnknown.line)
+		for (const auto& [pulse, line] : EventsInRange(chartData.compat.kshUnknown.line, measureStart, measureEnd))
 		{
 			updateGCD(pulse);
 		}
@@ -2557,26 +2773,12 @@ namespace
 			{
 				stream << "#define_fx " << name << " type=";
 				const std::string_view typeStr = AudioEffectTypeToStr(def.type);
-				if (kKsonToKshAudioEffectTypeName.contains(typeStr))
-				{
-					stream << kKsonToKshAudioEffectTypeName.at(typeStr);
-				}
-				else
-				{
-					stream << typeStr;
-				}
+				stream << kKsonToKshAudioEffectTypeName.valueOr(typeStr, typeStr);
 
 				for (const auto& [paramName, value] : def.v)
 				{
 					stream << ";";
-					if (kKsonToKshParamName.contains(paramName))
-					{
-						stream << kKsonToKshParamName.at(paramName);
-					}
-					else
-					{
-						stream << paramName;
-					}
+					stream << kKsonToKshParamName.valueOr(paramName, paramName);
 					stream << "=" << value;
 				}
 				stream << "\r\n";
@@ -2590,26 +2792,12 @@ namespace
 			{
 				stream << "#define_filter " << name << " type=";
 				const std::string_view typeStr = AudioEffectTypeToStr(def.type);
-				if (kKsonToKshAudioEffectTypeName.contains(typeStr))
-				{
-					stream << kKsonToKshAudioEffectTypeName.at(typeStr);
-				}
-				else
-				{
-					stream << typeStr;
-				}
+				stream << kKsonToKshAudioEffectTypeName.valueOr(typeStr, typeStr);
 
 				for (const auto& [paramName, value] : def.v)
 				{
 					stream << ";";
-					if (kKsonToKshParamName.contains(paramName))
-					{
-						stream << kKsonToKshParamName.at(paramName);
-					}
-					else
-					{
-						stream << paramName;
-					}
+					stream << kKsonToKshParamName.valueOr(paramName, paramName);
 					stream << "=" << value;
 				}
 				stream << "\r\n";
@@ -2619,34 +2807,74 @@ namespace
 }
 
 kson::ErrorType kson::SaveKshChartData(std::ostream& stream, const ChartData& chartData, KshSavingDiag* pKshSavingDiag)
+{
+	return SaveKshChartData(stream, chartData, KshSavingOptions{}, pKshSavingDiag);
+}
+
+kson::ErrorType kson::SaveKshChartData(const std::string& filePath, const ChartData& chartData, KshSavingDiag* pKshSavingDiag)
+{
+	return SaveKshChartData(filePath, chartData, KshSavingOptions{}, pKshSavingDiag);
+}
+
+kson::ErrorType kson::SaveKshChartData(std::ostream& stream, const ChartData& chartData, const KshSavingOptions& options, KshSavingDiag* pKshSavingDiag)
 {
 	if (!stream.good())
 	{
 		return ErrorType::GeneralIOError;
 	}
 
-	try
+	const auto save = [&]() -> ErrorType
 	{
-		WriteBOM(stream);
+		const auto writeChartData = [&chartData, pKshSavingDiag](std::ostream& outStream)
+		{
+			MeasureExportState state;
 
-		MeasureExportState state;
+			ScanForDataLossWarnings(chartData, pKshSavingDiag);
 
-		ScanForDataLossWarnings(chartData, pKshSavingDiag);
+			// Write header and store the header BPM string in state
+			WriteHeader(outStream, chartData, &state.headerBPMStr, pKshSavingDiag);
+			WriteMeasures(outStream, chartData, state, pKshSavingDiag);
+			WriteAudioEffectDefinitions(outStream, chartData);
+		};
 
-		// Write header and store the header BPM string in state
-		WriteHeader(stream, chartData, &state.headerBPMStr, pKshSavingDiag);
-		WriteMeasures(stream, chartData, state, pKshSavingDiag);
-		WriteAudioEffectDefinitions(stream, chartData);
+		if (options.encoding == KshEncoding::ShiftJIS)
+		{
+			// Text is encoded on the fly without BOM
+			ShiftJISEncodingStreamBuf encodingBuf(stream.rdbuf());
+			std::ostream encodingStream(&encodingBuf);
+			writeChartData(encodingStream);
+
+			const bool succeeded = encodingStream.good() && encodingBuf.finish();
+			AddEncodingWarnings(encodingBuf, pKshSavingDiag);
+			if (!succeeded)
+			{
+				stream.setstate(std::ios_base::badbit);
+			}
+		}
+		else
+		{
+			WriteBOM(stream);
+			writeChartData(stream);
+		}
 
 		return stream.good() ? ErrorType::None : ErrorType::GeneralIOError;
+	};
+
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		return save();
 	}
 	catch (const std::exception&)
 	{
 		return ErrorType::UnknownError;
 	}
+#else
+	return save();
+#endif
 }
 
-kson::ErrorType kson::SaveKshChartData(const std::string& filePath, const ChartData& chartData, KshSavingDiag* pKshSavingDiag)
+kson::ErrorType kson::SaveKshChartData(const std::string& filePath, const ChartData& chartData, const KshSavingOptions& options, KshSavingDiag* pKshSavingDiag)
 {
 	std::ofstream ofs(U8Path(filePath), std::ios_base::binary);
 	if (!ofs.good())
@@ -2654,7 +2882,7 @@ kson::ErrorType kson::SaveKshChartData(const std::string& filePath, const ChartD
 		return ErrorType::GeneralIOError;
 	}
 
-	const ErrorType result = SaveKshChartData(ofs, chartData, pKshSavingDiag);
+	const ErrorType result = SaveKshChartData(ofs, chartData, options, pKshSavingDiag);
 	ofs.close();
 
 	return result;
@@ -0,0 +1,447 @@
+#include "kson/IO/KshMeasureIndex.hpp"
+#include "kson/IO/KshIO.hpp"
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace
+{
+	using namespace kson;
+
+	std::filesystem::path U8Path(const std::string& utf8Str)
+	{
+		return std::filesystem::path(
+			std::u8string_view(reinterpret_cast<const char8_t*>(utf8Str.data()), utf8Str.size()));
+	}
+
+	constexpr std::string_view kIndexFileMagic = "kshidx";
+	constexpr std::int32_t kIndexFileVersion = 1;
+
+	// Shortest representation that is read back to the same value
+	std::string DoubleToString(double value)
+	{
+		char buf[32];
+		const auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+		return ec == std::errc{} ? std::string(buf, ptr) : std::string("0");
+	}
+
+	void WriteLongNote(std::ostream& stream, const std::optional<KshOpenLongNote>& note)
+	{
+		if (note.has_value())
+		{
+			stream << " 1 " << note->y << ' ' << note->elapsed << ' ' << note->length;
+		}
+		else
+		{
+			stream << " 0";
+		}
+	}
+
+	void WriteLaserPoint(std::ostream& stream, const std::optional<KshLaserPoint>& point)
+	{
+		if (point.has_value())
+		{
+			stream << " 1 " << point->y << ' ' << point->laserX;
+		}
+		else
+		{
+			stream << " 0";
+		}
+	}
+
+	bool ReadLongNote(std::istream& stream, std::optional<KshOpenLongNote>* pNote)
+	{
+		int exists = 0;
+		if (!(stream >> exists))
+		{
+			return false;
+		}
+		if (exists == 0)
+		{
+			pNote->reset();
+			return true;
+		}
+		KshOpenLongNote note;
+		if (!(stream >> note.y >> note.elapsed >> note.length))
+		{
+			return false;
+		}
+		*pNote = note;
+		return true;
+	}
+
+	bool ReadLaserPoint(std::istream& stream, std::optional<KshLaserPoint>* pPoint)
+	{
+		int exists = 0;
+		if (!(stream >> exists))
+		{
+			return false;
+		}
+		if (exists == 0)
+		{
+			pPoint->reset();
+			return true;
+		}
+		KshLaserPoint point;
+		if (!(stream >> point.y >> point.laserX))
+		{
+			return false;
+		}
+		*pPoint = point;
+		return true;
+	}
+
+	bool ReadCount(std::istream& stream, std::string_view name, std::size_t* pCount)
+	{
+		std::string token;
+		return (stream >> token >> *pCount) && token == name;
+	}
+
+	bool ReadIndexBody(std::istream& stream, KshMeasureIndex* pIndex)
+	{
+		std::string token;
+		std::int32_t version = 0;
+		if (!(stream >> token >> version) || token != kIndexFileMagic || version != kIndexFileVersion)
+		{
+			return false;
+		}
+
+		if (!(stream >> token >> pIndex->fileSize >> pIndex->fileTime) || token != "file")
+		{
+			return false;
+		}
+		if (!(stream >> token >> pIndex->trailerByteOffset >> pIndex->trailerLineNo) || token != "trailer")
+		{
+			return false;
+		}
+
+		std::size_t count = 0;
+		if (!ReadCount(stream, "bpm", &count))
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Pulse y = 0;
+			double bpm = 0.0;
+			if (!(stream >> y >> bpm))
+			{
+				return false;
+			}
+			pIndex->beat.bpm.insert_or_assign(y, bpm);
+		}
+
+		if (!ReadCount(stream, "time_sig", &count))
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			std::int64_t measureIdx = 0;
+			TimeSig timeSig;
+			if (!(stream >> measureIdx >> timeSig.n >> timeSig.d))
+			{
+				return false;
+			}
+			pIndex->beat.timeSig.insert_or_assign(measureIdx, timeSig);
+		}
+
+		if (!ReadCount(stream, "stop", &count))
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Pulse y = 0;
+			RelPulse length = 0;
+			if (!(stream >> y >> length))
+			{
+				return false;
+			}
+			pIndex->beat.stop.insert_or_assign(y, length);
+		}
+
+		if (!ReadCount(stream, "measures", &count))
+		{
+			return false;
+		}
+		pIndex->measures.resize(count);
+		for (auto& entry : pIndex->measures)
+		{
+			auto& state = entry.state;
+			if (!(stream >> entry.byteOffset >> entry.lineNo >> entry.y >> state.timeSig.n >> state.timeSig.d >> state.bpm))
+			{
+				return false;
+			}
+			for (auto& note : state.bt)
+			{
+				if (!ReadLongNote(stream, &note))
+				{
+					return false;
+				}
+			}
+			for (auto& note : state.fx)
+			{
+				if (!ReadLongNote(stream, &note))
+				{
+					return false;
+				}
+			}
+			for (auto& section : state.laser)
+			{
+				int exists = 0;
+				if (!(stream >> exists))
+				{
+					return false;
+				}
+				if (exists == 0)
+				{
+					section.reset();
+					continue;
+				}
+				KshOpenLaserSection laserSection;
+				std::optional<KshLaserPoint> lastPoint;
+				if (!(stream >> laserSection.wide) ||
+					!ReadLaserPoint(stream, &laserSection.prevPoint) ||
+					!ReadLaserPoint(stream, &lastPoint) || !lastPoint.has_value() ||
+					!ReadLaserPoint(stream, &laserSection.nextPoint))
+				{
+					return false;
+				}
+				laserSection.lastPoint = *lastPoint;
+				section = laserSection;
+			}
+		}
+
+		// Measures must be in the order of the file
+		for (std::size_t i = 1; i < pIndex->measures.size(); ++i)
+		{
+			if (pIndex->measures[i].byteOffset < pIndex->measures[i - 1].byteOffset || pIndex->measures[i].y < pIndex->measures[i - 1].y)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool GetFileSizeAndTime(const std::filesystem::path& fsPath, std::uint64_t* pFileSize, std::int64_t* pFileTime)
+	{
+		std::error_code ec;
+		const std::uintmax_t fileSize = std::filesystem::file_size(fsPath, ec);
+		if (ec)
+		{
+			return false;
+		}
+		const auto fileTime = std::filesystem::last_write_time(fsPath, ec);
+		if (ec)
+		{
+			return false;
+		}
+		*pFileSize = static_cast<std::uint64_t>(fileSize);
+		*pFileTime = static_cast<std::int64_t>(fileTime.time_since_epoch().count());
+		return true;
+	}
+}
+
+KshMeasureIndex kson::BuildKshMeasureIndex(const std::string& filePath)
+{
+	const auto fsPath = U8Path(filePath);
+	if (!std::filesystem::exists(fsPath))
+	{
+		return { .error = ErrorType::FileNotFound };
+	}
+
+	// Get the file size and time before reading so that a file modified while building is detected as outdated
+	std::uint64_t fileSize = 0;
+	std::int64_t fileTime = 0;
+	if (!GetFileSizeAndTime(fsPath, &fileSize, &fileTime))
+	{
+		return { .error = ErrorType::GeneralIOError };
+	}
+
+	std::ifstream ifs(fsPath, std::ios_base::binary);
+	if (!ifs.good())
+	{
+		return { .error = ErrorType::CouldNotOpenInputFileStream };
+	}
+
+	KshMeasureIndex index = BuildKshMeasureIndex(ifs);
+	index.fileSize = fileSize;
+	index.fileTime = fileTime;
+	return index;
+}
+
+std::string kson::KshMeasureIndexFilePath(const std::string& filePath)
+{
+	return filePath + ".kshidx";
+}
+
+ErrorType kson::SaveKshMeasureIndex(std::ostream& stream, const KshMeasureIndex& index)
+{
+	if (index.error != ErrorType::None)
+	{
+		return index.error;
+	}
+
+	stream << kIndexFileMagic << ' ' << kIndexFileVersion << '\n';
+	stream << "file " << index.fileSize << ' ' << index.fileTime << '\n';
+	stream << "trailer " << index.trailerByteOffset << ' ' << index.trailerLineNo << '\n';
+
+	stream << "bpm " << index.beat.bpm.size() << '\n';
+	for (const auto& [y, bpm] : index.beat.bpm)
+	{
+		stream << y << ' ' << DoubleToString(bpm) << '\n';
+	}
+	stream << "time_sig " << index.beat.timeSig.size() << '\n';
+	for (const auto& [measureIdx, timeSig] : index.beat.timeSig)
+	{
+		stream << measureIdx << ' ' << timeSig.n << ' ' << timeSig.d << '\n';
+	}
+	stream << "stop " << index.beat.stop.size() << '\n';
+	for (const auto& [y, length] : index.beat.stop)
+	{
+		stream << y << ' ' << length << '\n';
+	}
+
+	// One line per measure: offset, line number, pulse, time signature, BPM, BT/FX long notes and laser sections
+	stream << "measures " << index.measures.size() << '\n';
+	for (const auto& entry : index.measures)
+	{
+		const auto& state = entry.state;
+		stream << entry.byteOffset << ' ' << entry.lineNo << ' ' << entry.y << ' ' << state.timeSig.n << ' ' << state.timeSig.d << ' ' << DoubleToString(state.bpm);
+		for (const auto& note : state.bt)
+		{
+			WriteLongNote(stream, note);
+		}
+		for (const auto& note : state.fx)
+		{
+			WriteLongNote(stream, note);
+		}
+		for (const auto& section : state.laser)
+		{
+			if (section.has_value())
+			{
+				stream << " 1 " << (section->wide ? 1 : 0);
+				WriteLaserPoint(stream, section->prevPoint);
+				WriteLaserPoint(stream, section->lastPoint);
+				WriteLaserPoint(stream, section->nextPoint);
+			}
+			else
+			{
+				stream << " 0";
+			}
+		}
+		stream << '\n';
+	}
+
+	return stream.good() ? ErrorType::None : ErrorType::GeneralIOError;
+}
+
+ErrorType kson::SaveKshMeasureIndex(const std::string& indexFilePath, const KshMeasureIndex& index)
+{
+	std::ofstream ofs(U8Path(indexFilePath), std::ios_base::binary);
+	if (!ofs.good())
+	{
+		return ErrorType::CouldNotOpenOutputFileStream;
+	}
+
+	const ErrorType error = SaveKshMeasureIndex(ofs, index);
+	ofs.close();
+	if (error == ErrorType::None && ofs.fail())
+	{
+		return ErrorType::GeneralIOError;
+	}
+	return error;
+}
+
+KshMeasureIndex kson::LoadKshMeasureIndex(std::istream& stream)
+{
+	if (!stream.good())
+	{
+		return { .error = ErrorType::GeneralIOError };
+	}
+
+	KshMeasureIndex index;
+	if (!ReadIndexBody(stream, &index))
+	{
+		return { .error = ErrorType::GeneralChartFormatError };
+	}
+	return index;
+}
+
+KshMeasureIndex kson::LoadKshMeasureIndex(const std::string& indexFilePath)
+{
+	const auto fsPath = U8Path(indexFilePath);
+	if (!std::filesystem::exists(fsPath))
+	{
+		return { .error = ErrorType::FileNotFound };
+	}
+
+	std::ifstream ifs(fsPath, std::ios_base::binary);
+	if (!ifs.good())
+	{
+		return { .error = ErrorType::CouldNotOpenInputFileStream };
+	}
+
+	return LoadKshMeasureIndex(ifs);
+}
+
+bool kson::IsKshMeasureIndexUpToDate(const KshMeasureIndex& index, const std::string& filePath)
+{
+	if (index.error != ErrorType::None || (index.fileSize == 0 && index.fileTime == 0))
+	{
+		return false;
+	}
+
+	std::uint64_t fileSize = 0;
+	std::int64_t fileTime = 0;
+	if (!GetFileSizeAndTime(U8Path(filePath), &fileSize, &fileTime))
+	{
+		return false;
+	}
+	return index.fileSize == fileSize && index.fileTime == fileTime;
+}
+
+KshMeasureIndex kson::LoadOrBuildKshMeasureIndex(const std::string& filePath)
+{
+	const std::string indexFilePath = KshMeasureIndexFilePath(filePath);
+	{
+		KshMeasureIndex index = LoadKshMeasureIndex(indexFilePath);
+		if (IsKshMeasureIndexUpToDate(index, filePath))
+		{
+			return index;
+		}
+	}
+
+	KshMeasureIndex index = BuildKshMeasureIndex(filePath);
+	if (index.error == ErrorType::None)
+	{
+		// Write to a temporary file and rename it so that concurrent loads never read a partially written index
+		const std::string tmpFilePath = indexFilePath + "." + std::to_string(std::random_device{}()) + ".tmp";
+		std::error_code ec;
+		if (SaveKshMeasureIndex(tmpFilePath, index) == ErrorType::None)
+		{
+			std::filesystem::rename(U8Path(tmpFilePath), U8Path(indexFilePath), ec);
+		}
+		std::filesystem::remove(U8Path(tmpFilePath), ec);
+	}
+	return index;
+}
+
+ChartData kson::LoadKshChartDataRange(const std::string& filePath, std::int64_t firstMeasureIdx, std::int64_t numMeasures, KshLoadingDiag* pKshDiag)
+{
+	const KshMeasureIndex index = LoadOrBuildKshMeasureIndex(filePath);
+	if (index.error != ErrorType::None)
+	{
+		return { .error = index.error };
+	}
+
+	std::ifstream ifs(U8Path(filePath), std::ios_base::binary);
+	if (!ifs.good())
+	{
+		return { .error = ErrorType::CouldNotOpenInputFileStream };
+	}
+
+	return LoadKshChartDataRange(ifs, index, firstMeasureIdx, numMeasures, pKshDiag);
+}
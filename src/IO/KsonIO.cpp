@@ -1,5 +1,6 @@
 #ifndef KSON_WITHOUT_JSON_DEPENDENCY
 #include "kson/IO/KsonIO.hpp"
+#include "KsonJsonArena.hpp"
 #include <filesystem>
 #include <fstream>
 #include <optional>
@@ -972,7 +973,7 @@ namespace
 	// ==================== Reading/Loading Implementation ====================
 
 	template<typename T>
-	T GetWithDefault(const nlohmann::json& j, const std::string& key, const T& defaultValue)
+	T GetWithDefault(const KsonParseJson& j, const std::string& key, const T& defaultValue)
 	{
 		if (j.contains(key) && !j[key].is_null())
 		{
@@ -982,7 +983,7 @@ namespace
 	}
 
 	template<typename T>
-	std::optional<T> GetOptional(const nlohmann::json& j, const std::string& key)
+	std::optional<T> GetOptional(const KsonParseJson& j, const std::string& key)
 	{
 		if (j.contains(key) && !j[key].is_null())
 		{
@@ -991,7 +992,7 @@ namespace
 		return std::nullopt;
 	}
 
-	GraphValue ParseGraphValue(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	GraphValue ParseGraphValue(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		if (j.is_number())
 		{
@@ -1014,7 +1015,7 @@ namespace
 
 	// Parse GraphPoint from an array item where item[valueIdx] is the value and item[curveIdx] is the curve
 	GraphPoint ParseGraphPointFromArrayItem(
-		const nlohmann::json& item,
+		const KsonParseJson& item,
 		std::size_t valueIdx,
 		std::size_t curveIdx,
 		KsonLoadingDiag* pDiag)
@@ -1037,7 +1038,7 @@ namespace
 	}
 
 	template<typename T>
-	ByPulse<T> ParseByPulse(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	ByPulse<T> ParseByPulse(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		ByPulse<T> result;
 		if (!j.is_array())
@@ -1066,7 +1067,7 @@ namespace
 	}
 
 	template<typename T>
-	ByPulseMulti<T> ParseByPulseMulti(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	ByPulseMulti<T> ParseByPulseMulti(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		ByPulseMulti<T> result;
 		if (!j.is_array())
@@ -1094,7 +1095,7 @@ namespace
 		return result;
 	}
 
-	Graph ParseGraph(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	Graph ParseGraph(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		Graph result;
 		if (!j.is_array())
@@ -1123,7 +1124,7 @@ namespace
 	}
 
 	template<typename T>
-	ByMeasureIdx<T> ParseByMeasureIdx(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	ByMeasureIdx<T> ParseByMeasureIdx(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		ByMeasureIdx<T> result;
 		if (!j.is_array())
@@ -1151,7 +1152,7 @@ namespace
 		return result;
 	}
 
-	MetaInfo ParseMetaInfo(const nlohmann::json& j, KsonLoadingDiag*)
+	MetaInfo ParseMetaInfo(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		MetaInfo meta;
 		
@@ -1190,7 +1191,7 @@ namespace
 		return meta;
 	}
 
-	BeatInfo ParseBeatInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	BeatInfo ParseBeatInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		BeatInfo beat;
 		
@@ -1244,7 +1245,7 @@ namespace
 		return beat;
 	}
 
-	GaugeInfo ParseGaugeInfo(const nlohmann::json& j, KsonLoadingDiag*)
+	GaugeInfo ParseGaugeInfo(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		GaugeInfo gauge;
 		
@@ -1253,7 +1254,7 @@ namespace
 		return gauge;
 	}
 
-	void ParseLaneNotes(const nlohmann::json& j, ByPulse<Interval>& lane, KsonLoadingDiag* pDiag)
+	void ParseLaneNotes(const KsonParseJson& j, ByPulse<Interval>& lane, KsonLoadingDiag* pDiag)
 	{
 		if (!j.is_array())
 		{
@@ -1286,7 +1287,7 @@ namespace
 		}
 	}
 
-	void ParseLaserSection(const nlohmann::json& j, ByPulse<LaserSection>& lane, KsonLoadingDiag* pDiag)
+	void ParseLaserSection(const KsonParseJson& j, ByPulse<LaserSection>& lane, KsonLoadingDiag* pDiag)
 	{
 		if (!j.is_array())
 		{
@@ -1338,7 +1339,7 @@ namespace
 		}
 	}
 
-	NoteInfo ParseNoteInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	NoteInfo ParseNoteInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		NoteInfo note;
 
@@ -1384,7 +1385,7 @@ namespace
 		return note;
 	}
 
-	BGMPreviewInfo ParseBGMPreviewInfo(const nlohmann::json& j, KsonLoadingDiag*)
+	BGMPreviewInfo ParseBGMPreviewInfo(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		BGMPreviewInfo preview;
 		preview.offset = GetWithDefault<std::int32_t>(j, "offset", 0);
@@ -1392,7 +1393,7 @@ namespace
 		return preview;
 	}
 
-	LegacyBGMInfo ParseLegacyBGMInfo(const nlohmann::json& j, KsonLoadingDiag*)
+	LegacyBGMInfo ParseLegacyBGMInfo(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		LegacyBGMInfo legacy;
 		if (j.contains("fp_filenames") && j["fp_filenames"].is_array())
@@ -1405,7 +1406,7 @@ namespace
 		return legacy;
 	}
 
-	BGMInfo ParseBGMInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	BGMInfo ParseBGMInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		BGMInfo bgm;
 		bgm.filename = GetWithDefault<std::string>(j, "filename", "");
@@ -1425,40 +1426,13 @@ namespace
 		return bgm;
 	}
 
-	AudioEffectType ParseAudioEffectType(const std::string& typeStr)
-	{
-		static const std::unordered_map<std::string, AudioEffectType> typeMap = {
-			{"retrigger", AudioEffectType::Retrigger},
-			{"gate", AudioEffectType::Gate},
-			{"flanger", AudioEffectType::Flanger},
-			{"pitch_shift", AudioEffectType::PitchShift},
-			{"bitcrusher", AudioEffectType::Bitcrusher},
-			{"phaser", AudioEffectType::Phaser},
-			{"wobble", AudioEffectType::Wobble},
-			{"tapestop", AudioEffectType::Tapestop},
-			{"echo", AudioEffectType::Echo},
-			{"sidechain", AudioEffectType::Sidechain},
-			{"switch_audio", AudioEffectType::SwitchAudio},
-			{"high_pass_filter", AudioEffectType::HighPassFilter},
-			{"low_pass_filter", AudioEffectType::LowPassFilter},
-			{"peaking_filter", AudioEffectType::PeakingFilter}
-		};
-		
-		auto it = typeMap.find(typeStr);
-		if (it != typeMap.end())
-		{
-			return it->second;
-		}
-		return AudioEffectType::Unspecified;
-	}
-
-	AudioEffectDef ParseAudioEffectDef(const nlohmann::json& j, KsonLoadingDiag*)
+	AudioEffectDef ParseAudioEffectDef(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		AudioEffectDef def;
 		
 		if (j.contains("type") && j["type"].is_string())
 		{
-			def.type = ParseAudioEffectType(j["type"].get<std::string>());
+			def.type = StrToAudioEffectType(j["type"].get<std::string>());
 		}
 		
 		if (j.contains("v") && j["v"].is_object())
@@ -1475,7 +1449,7 @@ namespace
 		return def;
 	}
 
-	AudioEffectFXInfo ParseAudioEffectFXInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	AudioEffectFXInfo ParseAudioEffectFXInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		AudioEffectFXInfo fx;
 		
@@ -1559,7 +1533,7 @@ namespace
 		return fx;
 	}
 
-	AudioEffectLaserInfo ParseAudioEffectLaserInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	AudioEffectLaserInfo ParseAudioEffectLaserInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		AudioEffectLaserInfo laser;
 		
@@ -1632,7 +1606,7 @@ namespace
 		return laser;
 	}
 
-	AudioEffectInfo ParseAudioEffectInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	AudioEffectInfo ParseAudioEffectInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		AudioEffectInfo audioEffect;
 		
@@ -1649,7 +1623,7 @@ namespace
 		return audioEffect;
 	}
 
-	KeySoundFXInfo ParseKeySoundFXInfo(const nlohmann::json& j, KsonLoadingDiag*)
+	KeySoundFXInfo ParseKeySoundFXInfo(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		KeySoundFXInfo fx;
 		
@@ -1693,7 +1667,7 @@ namespace
 		return fx;
 	}
 
-	KeySoundLaserInfo ParseKeySoundLaserInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	KeySoundLaserInfo ParseKeySoundLaserInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		KeySoundLaserInfo laser;
 		
@@ -1729,7 +1703,7 @@ namespace
 		return laser;
 	}
 
-	KeySoundInfo ParseKeySoundInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	KeySoundInfo ParseKeySoundInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		KeySoundInfo keySound;
 		
@@ -1746,7 +1720,7 @@ namespace
 		return keySound;
 	}
 
-	AudioInfo ParseAudioInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	AudioInfo ParseAudioInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		AudioInfo audio;
 		
@@ -1768,7 +1742,7 @@ namespace
 		return audio;
 	}
 
-	CamGraphs ParseCamGraphs(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	CamGraphs ParseCamGraphs(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		CamGraphs graphs;
 
@@ -1792,7 +1766,7 @@ namespace
 		return AutoTiltType::kNormal;
 	}
 
-	ByPulse<TiltValue> ParseTilt(const nlohmann::json& j, KsonLoadingDiag*)
+	ByPulse<TiltValue> ParseTilt(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		ByPulse<TiltValue> tilt;
 
@@ -1873,7 +1847,7 @@ namespace
 		return tilt;
 	}
 
-	CameraInfo ParseCameraInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	CameraInfo ParseCameraInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		CameraInfo camera;
 		
@@ -1969,7 +1943,7 @@ namespace
 		return camera;
 	}
 
-	LegacyBGInfo ParseLegacyBGInfo(const nlohmann::json& j, KsonLoadingDiag*)
+	LegacyBGInfo ParseLegacyBGInfo(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		LegacyBGInfo legacy;
 		
@@ -2009,7 +1983,7 @@ namespace
 		return legacy;
 	}
 
-	BGInfo ParseBGInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	BGInfo ParseBGInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		BGInfo bg;
 
@@ -2023,7 +1997,7 @@ namespace
 		return bg;
 	}
 
-	EditorInfo ParseEditorInfo(const nlohmann::json& j, KsonLoadingDiag* pDiag)
+	EditorInfo ParseEditorInfo(const KsonParseJson& j, KsonLoadingDiag* pDiag)
 	{
 		EditorInfo editor;
 		
@@ -2038,7 +2012,7 @@ namespace
 		return editor;
 	}
 
-	CompatInfo ParseCompatInfo(const nlohmann::json& j, KsonLoadingDiag*)
+	CompatInfo ParseCompatInfo(const KsonParseJson& j, KsonLoadingDiag*)
 	{
 		CompatInfo compat;
 		
@@ -2101,7 +2075,7 @@ kson::ErrorType kson::SaveKsonChartData(std::ostream& stream, const ChartData& c
 		return ErrorType::GeneralIOError;
 	}
 
-	try
+	const auto save = [&]() -> ErrorType
 	{
 		nlohmann::json json = nlohmann::json::object();
 		Write(json, "format_version", kKsonFormatVersion);
@@ -2119,11 +2093,20 @@ kson::ErrorType kson::SaveKsonChartData(std::ostream& stream, const ChartData& c
 		stream << json.dump(-1, ' ', false, nlohmann::detail::error_handler_t::replace);
 
 		return stream.good() ? ErrorType::None : ErrorType::GeneralIOError;
+	};
+
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		return save();
 	}
 	catch (const std::exception&)
 	{
 		return ErrorType::UnknownError;
 	}
+#else
+	return save();
+#endif
 }
 
 kson::ErrorType kson::SaveKsonChartData(const std::string& filePath, const ChartData& chartData)
@@ -2140,7 +2123,7 @@ namespace
 {
 	bool ValidateAndParseKsonJson(
 		std::istream& stream,
-		nlohmann::json* pOutJson,
+		KsonParseJson* pOutJson,
 		ErrorType* pOutError,
 		KsonLoadingDiag* pKsonDiag)
 	{
@@ -2150,6 +2133,7 @@ namespace
 			return false;
 		}
 
+#if KSON_HAS_EXCEPTIONS
 		try
 		{
 			stream >> *pOutJson;
@@ -2164,6 +2148,19 @@ namespace
 			});
 			return false;
 		}
+#else
+		*pOutJson = KsonParseJson::parse(stream, nullptr, false);
+		if (pOutJson->is_discarded())
+		{
+			*pOutError = ErrorType::KsonParseError;
+			pKsonDiag->warnings.push_back({
+				.type = KsonLoadingWarningType::JsonParseError,
+				.scope = WarningScope::PlayerAndEditor,
+				.message = "JSON parse error",
+			});
+			return false;
+		}
+#endif
 
 		if (!pOutJson->contains("format_version"))
 		{
@@ -2213,12 +2210,14 @@ kson::ChartData kson::LoadKsonChartData(std::istream& stream, KsonLoadingDiag* p
 
 	ChartData chartData;
 
-	try
+	const auto parse = [&]() -> bool
 	{
-		nlohmann::json j;
+		// The DOM is released all at once when the scope ends (after j is destroyed)
+		const KsonJsonArenaScope arenaScope;
+		KsonParseJson j;
 		if (!ValidateAndParseKsonJson(stream, &j, &chartData.error, pKsonDiag))
 		{
-			return chartData;
+			return false;
 		}
 
 		if (j.contains("meta"))
@@ -2272,6 +2271,17 @@ kson::ChartData kson::LoadKsonChartData(std::istream& stream, KsonLoadingDiag* p
 		}
 
 		chartData.error = ErrorType::None;
+
+		return true;
+	};
+
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		if (!parse())
+		{
+			return chartData;
+		}
 	}
 	catch (const nlohmann::json::parse_error& e)
 	{
@@ -2300,6 +2310,12 @@ kson::ChartData kson::LoadKsonChartData(std::istream& stream, KsonLoadingDiag* p
 			.message = "Unexpected error: " + std::string(e.what()),
 		});
 	}
+#else
+	if (!parse())
+	{
+		return chartData;
+	}
+#endif
 
 	// Add default values at zero if not present
 	if (!chartData.camera.tilt.contains(0))
@@ -2380,12 +2396,14 @@ kson::MetaChartData kson::LoadKsonMetaChartData(std::istream& stream, KsonLoadin
 
 	MetaChartData metaChartData;
 
-	try
+	const auto parse = [&]()
 	{
-		nlohmann::json j;
+		// The DOM is released all at once when the scope ends (after j is destroyed)
+		const KsonJsonArenaScope arenaScope;
+		KsonParseJson j;
 		if (!ValidateAndParseKsonJson(stream, &j, &metaChartData.error, pKsonDiag))
 		{
-			return metaChartData;
+			return;
 		}
 
 		if (j.contains("meta"))
@@ -2402,6 +2420,12 @@ kson::MetaChartData kson::LoadKsonMetaChartData(std::istream& stream, KsonLoadin
 		}
 
 		metaChartData.error = ErrorType::None;
+	};
+
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		parse();
 	}
 	catch (const nlohmann::json::parse_error& e)
 	{
@@ -2430,6 +2454,9 @@ kson::MetaChartData kson::LoadKsonMetaChartData(std::istream& stream, KsonLoadin
 			.message = "Unexpected error: " + std::string(e.what()),
 		});
 	}
+#else
+	parse();
+#endif
 
 	return metaChartData;
 }
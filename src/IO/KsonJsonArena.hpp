@@ -0,0 +1,164 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "kson/third_party/nlohmann/json.hpp"
+
+// Monotonic arena for the JSON DOM built while loading KSON
+// Every array, object and string node of the DOM and the buffers of the arrays/objects are taken from the arena
+// of the loading thread and released all at once after loading, instead of being allocated and freed one by one.
+namespace kson
+{
+	class KsonJsonArena
+	{
+	private:
+		static constexpr std::size_t kMinBlockSize = 64 * 1024;
+
+		// Blocks larger than this are freed after loading instead of being kept for the next load
+		static constexpr std::size_t kMaxRetainedSize = 16 * 1024 * 1024;
+
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> data;
+			std::size_t size = 0;
+		};
+
+		std::vector<Block> m_blocks;
+
+		std::size_t m_offset = 0; // Used bytes of the last block
+
+		std::size_t m_scopeDepth = 0;
+
+		KsonJsonArena() = default;
+
+		void addBlock(std::size_t minSize)
+		{
+			const std::size_t size = std::max({ minSize, kMinBlockSize, m_blocks.empty() ? 0 : m_blocks.back().size * 2 });
+			m_blocks.push_back({ .data = std::make_unique<std::byte[]>(size), .size = size });
+			m_offset = 0;
+		}
+
+		void reset()
+		{
+			if (m_blocks.size() > 1)
+			{
+				// Replace with a single block large enough for the whole DOM so that the next load of a similar chart
+				// does not need to add blocks
+				std::size_t totalSize = 0;
+				for (const Block& block : m_blocks)
+				{
+					totalSize += block.size;
+				}
+				m_blocks.clear();
+				if (totalSize <= kMaxRetainedSize)
+				{
+					addBlock(totalSize);
+				}
+			}
+			else if (!m_blocks.empty() && m_blocks.back().size > kMaxRetainedSize)
+			{
+				m_blocks.clear();
+			}
+			m_offset = 0;
+		}
+
+	public:
+		KsonJsonArena(const KsonJsonArena&) = delete;
+
+		KsonJsonArena& operator=(const KsonJsonArena&) = delete;
+
+		static KsonJsonArena& ThreadLocal()
+		{
+			static thread_local KsonJsonArena arena;
+			return arena;
+		}
+
+		[[nodiscard]]
+		void* allocate(std::size_t size, std::size_t alignment)
+		{
+			assert(m_scopeDepth > 0 && "KsonJsonArena must be used inside a KsonJsonArenaScope");
+
+			if (!m_blocks.empty())
+			{
+				const std::size_t alignedOffset = (m_offset + alignment - 1) / alignment * alignment;
+				if (alignedOffset + size <= m_blocks.back().size)
+				{
+					m_offset = alignedOffset + size;
+					return m_blocks.back().data.get() + alignedOffset;
+				}
+			}
+
+			// Block data from make_unique<std::byte[]> is aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__
+			assert(alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+			addBlock(size);
+			m_offset = size;
+			return m_blocks.back().data.get();
+		}
+
+		friend class KsonJsonArenaScope;
+	};
+
+	// Releases the memory of the thread's arena when the outermost scope ends
+	// All JSON values using KsonJsonArenaAllocator must be destroyed before the scope ends
+	class KsonJsonArenaScope
+	{
+	public:
+		KsonJsonArenaScope()
+		{
+			++KsonJsonArena::ThreadLocal().m_scopeDepth;
+		}
+
+		~KsonJsonArenaScope()
+		{
+			KsonJsonArena& arena = KsonJsonArena::ThreadLocal();
+			if (--arena.m_scopeDepth == 0)
+			{
+				arena.reset();
+			}
+		}
+
+		KsonJsonArenaScope(const KsonJsonArenaScope&) = delete;
+
+		KsonJsonArenaScope& operator=(const KsonJsonArenaScope&) = delete;
+	};
+
+	// Stateless allocator for nlohmann::basic_json (which requires a default-constructible allocator template)
+	template <typename T>
+	class KsonJsonArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		KsonJsonArenaAllocator() = default;
+
+		template <typename U>
+		KsonJsonArenaAllocator(const KsonJsonArenaAllocator<U>&) noexcept
+		{
+		}
+
+		[[nodiscard]]
+		T* allocate(std::size_t n)
+		{
+			return static_cast<T*>(KsonJsonArena::ThreadLocal().allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, std::size_t) noexcept
+		{
+			// Released all at once by KsonJsonArenaScope
+		}
+
+		template <typename U>
+		bool operator==(const KsonJsonArenaAllocator<U>&) const noexcept
+		{
+			return true;
+		}
+	};
+
+	// JSON type used for loading KSON (only valid inside a KsonJsonArenaScope)
+	using KsonParseJson = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, KsonJsonArenaAllocator>;
+}
@@ -0,0 +1,465 @@
+#include "kson/Replay/ReplayCodec.hpp"
+#include "kson/Util/GraphUtils.hpp"
+#include <bit>
+#include <limits>
+
+namespace
+{
+	using namespace kson;
+
+	constexpr std::array<std::uint8_t, 4> kMagic = { 'K', 'R', 'D', 1 }; // The last byte is the format version
+
+	constexpr std::size_t kMaxVarintBytes = 10;
+
+	std::uint64_t ZigZagEncode(std::int64_t value)
+	{
+		return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+	}
+
+	std::int64_t ZigZagDecode(std::uint64_t value)
+	{
+		return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+	}
+
+	// Wrapping subtraction so that any pair of times can be encoded without overflow
+	std::int64_t WrappingSub(std::int64_t a, std::int64_t b)
+	{
+		return static_cast<std::int64_t>(static_cast<std::uint64_t>(a) - static_cast<std::uint64_t>(b));
+	}
+
+	std::int64_t WrappingAdd(std::int64_t a, std::int64_t b)
+	{
+		return static_cast<std::int64_t>(static_cast<std::uint64_t>(a) + static_cast<std::uint64_t>(b));
+	}
+
+	class Writer
+	{
+	private:
+		std::vector<std::uint8_t> m_data;
+
+	public:
+		void writeVarint(std::uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				m_data.push_back(static_cast<std::uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			m_data.push_back(static_cast<std::uint8_t>(value));
+		}
+
+		void writeSigned(std::int64_t value)
+		{
+			writeVarint(ZigZagEncode(value));
+		}
+
+		void writeBytes(std::span<const std::uint8_t> bytes)
+		{
+			m_data.insert(m_data.end(), bytes.begin(), bytes.end());
+		}
+
+		[[nodiscard]]
+		std::vector<std::uint8_t> release()
+		{
+			return std::move(m_data);
+		}
+	};
+
+	class Reader
+	{
+	private:
+		std::span<const std::uint8_t> m_data;
+		std::size_t m_pos = 0;
+
+	public:
+		explicit Reader(std::span<const std::uint8_t> data)
+			: m_data(data)
+		{
+		}
+
+		[[nodiscard]]
+		bool readVarint(std::uint64_t* pValue)
+		{
+			std::uint64_t value = 0;
+			for (std::size_t i = 0; i < kMaxVarintBytes; ++i)
+			{
+				if (m_pos >= m_data.size())
+				{
+					return false;
+				}
+				const std::uint8_t byte = m_data[m_pos++];
+				value |= static_cast<std::uint64_t>(byte & 0x7F) << (7 * i);
+				if ((byte & 0x80) == 0)
+				{
+					*pValue = value;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		[[nodiscard]]
+		bool readSigned(std::int64_t* pValue)
+		{
+			std::uint64_t value;
+			if (!readVarint(&value))
+			{
+				return false;
+			}
+			*pValue = ZigZagDecode(value);
+			return true;
+		}
+
+		// Reads an element count, rejecting counts that cannot fit in the remaining data (at least minBytesPerElement each)
+		[[nodiscard]]
+		bool readCount(std::size_t minBytesPerElement, std::size_t* pCount)
+		{
+			std::uint64_t count;
+			if (!readVarint(&count) || count > (m_data.size() - m_pos) / minBytesPerElement)
+			{
+				return false;
+			}
+			*pCount = static_cast<std::size_t>(count);
+			return true;
+		}
+
+		[[nodiscard]]
+		bool readBytes(std::span<std::uint8_t> bytes)
+		{
+			if (m_data.size() - m_pos < bytes.size())
+			{
+				return false;
+			}
+			std::copy_n(m_data.begin() + static_cast<std::ptrdiff_t>(m_pos), bytes.size(), bytes.begin());
+			m_pos += bytes.size();
+			return true;
+		}
+
+		[[nodiscard]]
+		bool atEnd() const
+		{
+			return m_pos == m_data.size();
+		}
+	};
+
+	class Hasher
+	{
+	private:
+		std::uint64_t m_hash = 0xCBF29CE484222325; // FNV-1a offset basis
+
+	public:
+		void add(std::uint64_t value)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				m_hash ^= (value >> (8 * i)) & 0xFF;
+				m_hash *= 0x100000001B3;
+			}
+		}
+
+		void add(std::int64_t value)
+		{
+			add(static_cast<std::uint64_t>(value));
+		}
+
+		void add(double value)
+		{
+			add(std::bit_cast<std::uint64_t>(value));
+		}
+
+		[[nodiscard]]
+		std::uint64_t value() const
+		{
+			return m_hash;
+		}
+	};
+
+	std::int64_t MsToUs(double ms)
+	{
+		return static_cast<std::int64_t>(std::llround(ms * 1000.0));
+	}
+
+	// Index of the note nearest to timeUs (the earlier one if tied)
+	std::size_t NearestNoteIdx(const std::vector<std::int64_t>& noteUs, std::int64_t timeUs)
+	{
+		assert(!noteUs.empty());
+		const auto itr = std::lower_bound(noteUs.begin(), noteUs.end(), timeUs);
+		if (itr == noteUs.end())
+		{
+			return noteUs.size() - 1;
+		}
+		const auto idx = static_cast<std::size_t>(itr - noteUs.begin());
+		if (idx > 0 && timeUs - noteUs[idx - 1] <= *itr - timeUs)
+		{
+			return idx - 1;
+		}
+		return idx;
+	}
+
+	// BT lanes followed by FX lanes
+	template <typename BTLanes, typename FXLanes>
+	auto& LaneAt(BTLanes& bt, FXLanes& fx, std::size_t laneIdx)
+	{
+		return laneIdx < kNumBTLanesSZ ? bt[laneIdx] : fx[laneIdx - kNumBTLanesSZ];
+	}
+}
+
+void kson::ReplayData::clear()
+{
+	for (auto& lane : bt)
+	{
+		lane.clear();
+	}
+	for (auto& lane : fx)
+	{
+		lane.clear();
+	}
+	for (auto& lane : laser)
+	{
+		lane.clear();
+	}
+}
+
+kson::ReplayCodec::ReplayCodec(const ChartData& chartData)
+	: m_chartData(chartData)
+{
+	const BeatInfo& beat = chartData.beat;
+	if (!beat.bpm.contains(0) || !beat.timeSig.contains(0))
+	{
+		// Without tempo, no note has a time and presses are encoded relative to the previous release
+		return;
+	}
+	m_timingCache = CreateTimingCache(beat);
+
+	Hasher hasher;
+	for (const auto& [y, bpm] : beat.bpm)
+	{
+		hasher.add(y);
+		hasher.add(bpm);
+	}
+	for (std::size_t laneIdx = 0; laneIdx < m_lanes.size(); ++laneIdx)
+	{
+		const ByPulse<Interval>& notes = laneIdx < kNumBTLanesSZ ? chartData.note.bt[laneIdx] : chartData.note.fx[laneIdx - kNumBTLanesSZ];
+		Lane& lane = m_lanes[laneIdx];
+		lane.noteUs.reserve(notes.size());
+		lane.noteEndUs.reserve(notes.size());
+		lane.isLong.reserve(notes.size());
+		for (const auto& [y, note] : notes)
+		{
+			lane.noteUs.push_back(MsToUs(PulseToMs(y, beat, m_timingCache)));
+			lane.noteEndUs.push_back(note.length > 0 ? MsToUs(PulseToMs(y + note.length, beat, m_timingCache)) : lane.noteUs.back());
+			lane.isLong.push_back(note.length > 0);
+			hasher.add(lane.noteUs.back());
+			hasher.add(lane.noteEndUs.back());
+		}
+		hasher.add(static_cast<std::uint64_t>(notes.size()));
+	}
+	for (std::size_t laneIdx = 0; laneIdx < kNumLaserLanesSZ; ++laneIdx)
+	{
+		const auto& lane = chartData.note.laser[laneIdx];
+		if (!lane.empty())
+		{
+			const auto& [lastY, lastSection] = *lane.rbegin();
+			const Pulse lastPulse = lastY + (lastSection.v.empty() ? 0 : lastSection.v.rbegin()->first);
+			m_laserRangeUs[laneIdx] = { MsToUs(PulseToMs(lane.begin()->first, beat, m_timingCache)), MsToUs(PulseToMs(lastPulse, beat, m_timingCache)) };
+		}
+		for (const auto& [y, section] : lane)
+		{
+			hasher.add(y);
+			hasher.add(static_cast<std::int64_t>(section.w));
+			for (const auto& [ry, point] : section.v)
+			{
+				hasher.add(ry);
+				hasher.add(point.v.v);
+				hasher.add(point.v.vf);
+				hasher.add(point.curve.a);
+				hasher.add(point.curve.b);
+			}
+		}
+		hasher.add(static_cast<std::uint64_t>(lane.size()));
+	}
+	m_chartHash = hasher.value();
+}
+
+std::optional<std::int32_t> kson::ReplayCodec::idealLaserPosition(std::size_t laneIdx, std::int64_t timeUs) const
+{
+	const auto& lane = m_chartData.note.laser[laneIdx];
+	const auto& [startUs, endUs] = m_laserRangeUs[laneIdx];
+	if (lane.empty() || timeUs < startUs || timeUs > endUs)
+	{
+		return std::nullopt;
+	}
+
+	const Pulse pulse = MsToPulse(static_cast<double>(timeUs) / 1000.0, m_chartData.beat, m_timingCache);
+	const std::optional<double> value = GraphSectionValueAt(lane, pulse);
+	if (!value.has_value())
+	{
+		return std::nullopt;
+	}
+	const bool wide = GraphSectionAt(lane, pulse)->second.wide();
+	const double x = wide ? *value * 2 - 0.5 : *value;
+	return static_cast<std::int32_t>(std::lround(x * kReplayLaserPositionScale));
+}
+
+std::uint64_t kson::ReplayCodec::chartHash() const
+{
+	return m_chartHash;
+}
+
+std::vector<std::uint8_t> kson::ReplayCodec::encode(const ReplayData& replay) const
+{
+	Writer writer;
+	writer.writeBytes(kMagic);
+	writer.writeVarint(m_chartHash);
+
+	for (std::size_t laneIdx = 0; laneIdx < m_lanes.size(); ++laneIdx)
+	{
+		const Lane& lane = m_lanes[laneIdx];
+		const std::vector<ReplayPress>& presses = LaneAt(replay.bt, replay.fx, laneIdx);
+		writer.writeVarint(presses.size());
+
+		std::int64_t prevNoteIdx = 0;
+		std::int64_t prevReleaseUs = 0;
+		for (const ReplayPress& press : presses)
+		{
+			if (lane.noteUs.empty())
+			{
+				writer.writeSigned(WrappingSub(press.pressUs, prevReleaseUs));
+				writer.writeSigned(WrappingSub(press.releaseUs, press.pressUs));
+				prevReleaseUs = press.releaseUs;
+				continue;
+			}
+
+			const std::size_t noteIdx = NearestNoteIdx(lane.noteUs, press.pressUs);
+			const std::int64_t releaseRefUs = lane.isLong[noteIdx] ? lane.noteEndUs[noteIdx] : press.pressUs;
+			writer.writeSigned(static_cast<std::int64_t>(noteIdx) - prevNoteIdx);
+			writer.writeSigned(WrappingSub(press.pressUs, lane.noteUs[noteIdx]));
+			writer.writeSigned(WrappingSub(press.releaseUs, releaseRefUs));
+			prevNoteIdx = static_cast<std::int64_t>(noteIdx);
+		}
+	}
+
+	for (std::size_t laneIdx = 0; laneIdx < kNumLaserLanesSZ; ++laneIdx)
+	{
+		const std::vector<ReplayLaserSample>& samples = replay.laser[laneIdx];
+		writer.writeVarint(samples.size());
+
+		// Samples are usually taken every frame, so the delta-of-delta of the time is mostly zero
+		std::int64_t prevTimeUs = 0;
+		std::int64_t prevDeltaUs = 0;
+		std::int32_t prevPosition = 0;
+		for (const ReplayLaserSample& sample : samples)
+		{
+			const std::int64_t deltaUs = WrappingSub(sample.timeUs, prevTimeUs);
+			writer.writeSigned(WrappingSub(deltaUs, prevDeltaUs));
+
+			// Deviation from the laser path, or from the previous position outside laser sections
+			const std::int32_t ideal = idealLaserPosition(laneIdx, sample.timeUs).value_or(prevPosition);
+			writer.writeSigned(std::int64_t{ sample.position } - ideal);
+
+			prevTimeUs = sample.timeUs;
+			prevDeltaUs = deltaUs;
+			prevPosition = sample.position;
+		}
+	}
+
+	return writer.release();
+}
+
+bool kson::ReplayCodec::decode(std::span<const std::uint8_t> data, ReplayData* pReplay) const
+{
+	pReplay->clear();
+
+	Reader reader(data);
+	std::array<std::uint8_t, kMagic.size()> magic;
+	std::uint64_t chartHash;
+	if (!reader.readBytes(magic) || magic != kMagic || !reader.readVarint(&chartHash) || chartHash != m_chartHash)
+	{
+		return false;
+	}
+
+	for (std::size_t laneIdx = 0; laneIdx < m_lanes.size(); ++laneIdx)
+	{
+		const Lane& lane = m_lanes[laneIdx];
+		std::vector<ReplayPress>& presses = LaneAt(pReplay->bt, pReplay->fx, laneIdx);
+		std::size_t count;
+		if (!reader.readCount(lane.noteUs.empty() ? 2 : 3, &count))
+		{
+			return false;
+		}
+		presses.reserve(count);
+
+		std::int64_t prevNoteIdx = 0;
+		std::int64_t prevReleaseUs = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			ReplayPress press;
+			if (lane.noteUs.empty())
+			{
+				std::int64_t pressDelta, releaseDelta;
+				if (!reader.readSigned(&pressDelta) || !reader.readSigned(&releaseDelta))
+				{
+					return false;
+				}
+				press.pressUs = WrappingAdd(prevReleaseUs, pressDelta);
+				press.releaseUs = WrappingAdd(press.pressUs, releaseDelta);
+				prevReleaseUs = press.releaseUs;
+				presses.push_back(press);
+				continue;
+			}
+
+			std::int64_t noteIdxDelta, pressDelta, releaseDelta;
+			if (!reader.readSigned(&noteIdxDelta) || !reader.readSigned(&pressDelta) || !reader.readSigned(&releaseDelta))
+			{
+				return false;
+			}
+			const std::int64_t noteIdx = WrappingAdd(prevNoteIdx, noteIdxDelta);
+			if (noteIdx < 0 || noteIdx >= static_cast<std::int64_t>(lane.noteUs.size()))
+			{
+				return false;
+			}
+			const auto idx = static_cast<std::size_t>(noteIdx);
+			press.pressUs = WrappingAdd(lane.noteUs[idx], pressDelta);
+			press.releaseUs = WrappingAdd(lane.isLong[idx] ? lane.noteEndUs[idx] : press.pressUs, releaseDelta);
+			prevNoteIdx = noteIdx;
+			presses.push_back(press);
+		}
+	}
+
+	for (std::size_t laneIdx = 0; laneIdx < kNumLaserLanesSZ; ++laneIdx)
+	{
+		std::vector<ReplayLaserSample>& samples = pReplay->laser[laneIdx];
+		std::size_t count;
+		if (!reader.readCount(2, &count))
+		{
+			return false;
+		}
+		samples.reserve(count);
+
+		std::int64_t prevTimeUs = 0;
+		std::int64_t prevDeltaUs = 0;
+		std::int32_t prevPosition = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			std::int64_t deltaOfDelta, deviation;
+			if (!reader.readSigned(&deltaOfDelta) || !reader.readSigned(&deviation))
+			{
+				return false;
+			}
+			const std::int64_t deltaUs = WrappingAdd(prevDeltaUs, deltaOfDelta);
+			const std::int64_t timeUs = WrappingAdd(prevTimeUs, deltaUs);
+			const std::int64_t position = WrappingAdd(idealLaserPosition(laneIdx, timeUs).value_or(prevPosition), deviation);
+			if (position < std::numeric_limits<std::int32_t>::min() || position > std::numeric_limits<std::int32_t>::max())
+			{
+				return false;
+			}
+			samples.push_back({ .timeUs = timeUs, .position = static_cast<std::int32_t>(position) });
+
+			prevTimeUs = timeUs;
+			prevDeltaUs = deltaUs;
+			prevPosition = static_cast<std::int32_t>(position);
+		}
+	}
+
+	return reader.atEnd();
+}
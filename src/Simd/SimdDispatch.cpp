@@ -0,0 +1,207 @@
+#include "SimdKernels.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+#if KSON_SIMD_X86_64
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+	using namespace kson::Simd;
+
+	// Name of the environment variable to force a lower level (e.g., for testing the fallbacks)
+	constexpr const char* kSimdLevelEnvName = "KSON_SIMD_LEVEL";
+
+#if KSON_SIMD_X86_64
+	struct CpuidResult
+	{
+		std::uint32_t eax = 0;
+		std::uint32_t ebx = 0;
+		std::uint32_t ecx = 0;
+		std::uint32_t edx = 0;
+	};
+
+	CpuidResult Cpuid(std::uint32_t leaf, std::uint32_t subleaf)
+	{
+		CpuidResult result;
+#ifdef _MSC_VER
+		int regs[4];
+		__cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+		result = {
+			.eax = static_cast<std::uint32_t>(regs[0]),
+			.ebx = static_cast<std::uint32_t>(regs[1]),
+			.ecx = static_cast<std::uint32_t>(regs[2]),
+			.edx = static_cast<std::uint32_t>(regs[3]),
+		};
+#else
+		__cpuid_count(leaf, subleaf, result.eax, result.ebx, result.ecx, result.edx);
+#endif
+		return result;
+	}
+
+	// Register states enabled by the OS (XCR0)
+	std::uint64_t Xgetbv()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		std::uint32_t eax = 0;
+		std::uint32_t edx = 0;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+	}
+
+	SimdLevel DetectSimdLevel()
+	{
+		// SSE2 is part of x86-64
+		const std::uint32_t maxLeaf = Cpuid(0, 0).eax;
+		const CpuidResult leaf1 = Cpuid(1, 0);
+		const bool osxsave = (leaf1.ecx & (1U << 27)) != 0;
+		const bool avx = (leaf1.ecx & (1U << 28)) != 0;
+		if (maxLeaf < 7 || !osxsave || !avx)
+		{
+			return SimdLevel::kSSE2;
+		}
+
+		// The OS must save the YMM (and ZMM) registers on context switches
+		const std::uint64_t xcr0 = Xgetbv();
+		constexpr std::uint64_t kYmmStateMask = 0x6; // XMM, YMM
+		constexpr std::uint64_t kZmmStateMask = 0xE6; // XMM, YMM, opmask, ZMM_Hi256, Hi16_ZMM
+		const CpuidResult leaf7 = Cpuid(7, 0);
+		const bool avx2 = (leaf7.ebx & (1U << 5)) != 0;
+		const bool avx512f = (leaf7.ebx & (1U << 16)) != 0;
+		const bool avx512bw = (leaf7.ebx & (1U << 30)) != 0;
+		if (!avx2 || (xcr0 & kYmmStateMask) != kYmmStateMask)
+		{
+			return SimdLevel::kSSE2;
+		}
+		if (!avx512f || !avx512bw || (xcr0 & kZmmStateMask) != kZmmStateMask)
+		{
+			return SimdLevel::kAVX2;
+		}
+		return SimdLevel::kAVX512;
+	}
+#else
+	SimdLevel DetectSimdLevel()
+	{
+		return SimdLevel::kScalar;
+	}
+#endif
+
+	SimdLevel DetectActiveSimdLevel()
+	{
+		const SimdLevel supportedLevel = SupportedSimdLevel();
+#ifdef _MSC_VER
+#pragma warning(suppress: 4996) // getenv (only read once at initialization)
+#endif
+		const char* envValue = std::getenv(kSimdLevelEnvName);
+		if (envValue == nullptr)
+		{
+			return supportedLevel;
+		}
+		const std::optional<SimdLevel> requestedLevel = ParseSimdLevel(envValue);
+		if (!requestedLevel.has_value() || *requestedLevel > supportedLevel)
+		{
+			return supportedLevel;
+		}
+		return *requestedLevel;
+	}
+
+	const SimdKernels& KernelsFor(SimdLevel level)
+	{
+		switch (std::min(level, SupportedSimdLevel()))
+		{
+#if KSON_SIMD_X86_64
+		case SimdLevel::kAVX512:
+			return kAVX512Kernels;
+
+		case SimdLevel::kAVX2:
+			return kAVX2Kernels;
+
+		case SimdLevel::kSSE2:
+			return kSSE2Kernels;
+#endif
+
+		default:
+			return kScalarKernels;
+		}
+	}
+
+	// Resolved at the first use (thread-safe initialization of the static local)
+	const SimdKernels& ActiveKernels()
+	{
+		static const SimdKernels& kernels = KernelsFor(ActiveSimdLevel());
+		return kernels;
+	}
+}
+
+kson::Simd::SimdLevel kson::Simd::SupportedSimdLevel()
+{
+	static const SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+kson::Simd::SimdLevel kson::Simd::ActiveSimdLevel()
+{
+	static const SimdLevel level = DetectActiveSimdLevel();
+	return level;
+}
+
+std::string_view kson::Simd::SimdLevelName(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::kScalar:
+		return "scalar";
+
+	case SimdLevel::kSSE2:
+		return "sse2";
+
+	case SimdLevel::kAVX2:
+		return "avx2";
+
+	case SimdLevel::kAVX512:
+		return "avx512";
+
+	default:
+		return "unknown";
+	}
+}
+
+std::optional<kson::Simd::SimdLevel> kson::Simd::ParseSimdLevel(std::string_view str)
+{
+	for (const SimdLevel level : { SimdLevel::kScalar, SimdLevel::kSSE2, SimdLevel::kAVX2, SimdLevel::kAVX512 })
+	{
+		if (str == SimdLevelName(level))
+		{
+			return level;
+		}
+	}
+	return std::nullopt;
+}
+
+std::size_t kson::Simd::AsciiPrefixLength(std::string_view str)
+{
+	return ActiveKernels().asciiPrefixLength(str.data(), str.size());
+}
+
+std::size_t kson::Simd::AsciiPrefixLength(std::string_view str, SimdLevel level)
+{
+	return KernelsFor(level).asciiPrefixLength(str.data(), str.size());
+}
+
+void kson::Simd::EvaluateCurves(double a, double b, const double* pXs, double* pResults, std::size_t count)
+{
+	ActiveKernels().evaluateCurves(a, b, pXs, pResults, count);
+}
+
+void kson::Simd::EvaluateCurves(double a, double b, const double* pXs, double* pResults, std::size_t count, SimdLevel level)
+{
+	KernelsFor(level).evaluateCurves(a, b, pXs, pResults, count);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "kson/Simd/SimdDispatch.hpp"
+
+// Each variant is compiled in its own translation unit with the instruction set flags of its level
+// (set by CMake when KSON_SIMD_DISPATCH is ON), so that the other units never contain instructions the CPU may lack
+#if defined(KSON_SIMD_DISPATCH) && (defined(__x86_64__) || defined(_M_X64))
+#define KSON_SIMD_X86_64 1
+#else
+#define KSON_SIMD_X86_64 0
+#endif
+
+namespace kson::Simd
+{
+	struct SimdKernels
+	{
+		std::size_t (*asciiPrefixLength)(const char* pData, std::size_t size);
+		void (*evaluateCurves)(double a, double b, const double* pXs, double* pResults, std::size_t count);
+	};
+
+	extern const SimdKernels kScalarKernels;
+
+#if KSON_SIMD_X86_64
+	extern const SimdKernels kSSE2Kernels;
+	extern const SimdKernels kAVX2Kernels;
+	extern const SimdKernels kAVX512Kernels;
+#endif
+
+	// Scalar kernels, also used for the remainders of the vector loops
+	std::size_t AsciiPrefixLengthScalar(const char* pData, std::size_t size);
+
+	void EvaluateCurvesScalar(double a, double b, const double* pXs, double* pResults, std::size_t count);
+
+	// Values shared by all elements of a batch of EvaluateCurve() (the branch depends only on a)
+	struct CurveParams
+	{
+		double a = 0.0;
+		double b = 0.0;
+		bool useConjugate = false; // true: t = x / (a + sqrt(d)), false: t = (a - sqrt(d)) / (-1 + 2a)
+		double denominator = 0.0; // -1 + 2a
+	};
+
+	[[nodiscard]]
+	CurveParams MakeCurveParams(double a, double b);
+}
@@ -0,0 +1,66 @@
+#include "SimdKernels.hpp"
+
+#if KSON_SIMD_X86_64
+#include <bit>
+#include <immintrin.h>
+
+namespace
+{
+	using namespace kson::Simd;
+
+	std::size_t AsciiPrefixLengthAVX2(const char* pData, std::size_t size)
+	{
+		std::size_t i = 0;
+		for (; i + 32 <= size; i += 32)
+		{
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pData + i));
+			const int mask = _mm256_movemask_epi8(chunk);
+			if (mask != 0)
+			{
+				return i + static_cast<std::size_t>(std::countr_zero(static_cast<unsigned int>(mask)));
+			}
+		}
+		return i + AsciiPrefixLengthScalar(pData + i, size - i);
+	}
+
+	// Same operations in the same order as EvaluateCurve(), so that the results are bit-identical
+	__m256d EvaluateCurve4(const CurveParams& params, __m256d x)
+	{
+		const __m256d zero = _mm256_setzero_pd();
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d two = _mm256_set1_pd(2.0);
+		const __m256d a = _mm256_set1_pd(params.a);
+
+		// Operand order keeps NaN as std::clamp() does
+		x = _mm256_min_pd(one, _mm256_max_pd(zero, x));
+
+		const __m256d discriminant = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(a, a), x), _mm256_mul_pd(_mm256_mul_pd(two, a), x));
+		const __m256d dSqrt = _mm256_and_pd(_mm256_sqrt_pd(discriminant), _mm256_cmp_pd(discriminant, zero, _CMP_GE_OQ));
+
+		const __m256d t = params.useConjugate
+			? _mm256_div_pd(x, _mm256_add_pd(a, dSqrt))
+			: _mm256_div_pd(_mm256_sub_pd(a, dSqrt), _mm256_set1_pd(params.denominator));
+
+		const __m256d result = _mm256_add_pd(
+			_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(two, _mm256_sub_pd(one, t)), t), _mm256_set1_pd(params.b)),
+			_mm256_mul_pd(t, t));
+		return _mm256_min_pd(one, _mm256_max_pd(zero, result));
+	}
+
+	void EvaluateCurvesAVX2(double a, double b, const double* pXs, double* pResults, std::size_t count)
+	{
+		const CurveParams params = MakeCurveParams(a, b);
+		std::size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm256_storeu_pd(pResults + i, EvaluateCurve4(params, _mm256_loadu_pd(pXs + i)));
+		}
+		EvaluateCurvesScalar(a, b, pXs + i, pResults + i, count - i);
+	}
+}
+
+const kson::Simd::SimdKernels kson::Simd::kAVX2Kernels = {
+	.asciiPrefixLength = &AsciiPrefixLengthAVX2,
+	.evaluateCurves = &EvaluateCurvesAVX2,
+};
+#endif
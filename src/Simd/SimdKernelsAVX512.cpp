@@ -0,0 +1,66 @@
+#include "SimdKernels.hpp"
+
+#if KSON_SIMD_X86_64
+#include <bit>
+#include <immintrin.h>
+
+namespace
+{
+	using namespace kson::Simd;
+
+	std::size_t AsciiPrefixLengthAVX512(const char* pData, std::size_t size)
+	{
+		std::size_t i = 0;
+		for (; i + 64 <= size; i += 64)
+		{
+			const __m512i chunk = _mm512_loadu_si512(pData + i);
+			const __mmask64 mask = _mm512_movepi8_mask(chunk);
+			if (mask != 0)
+			{
+				return i + static_cast<std::size_t>(std::countr_zero(static_cast<std::uint64_t>(mask)));
+			}
+		}
+		return i + AsciiPrefixLengthScalar(pData + i, size - i);
+	}
+
+	// Same operations in the same order as EvaluateCurve(), so that the results are bit-identical
+	__m512d EvaluateCurve8(const CurveParams& params, __m512d x)
+	{
+		const __m512d zero = _mm512_setzero_pd();
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d two = _mm512_set1_pd(2.0);
+		const __m512d a = _mm512_set1_pd(params.a);
+
+		// Operand order keeps NaN as std::clamp() does
+		x = _mm512_min_pd(one, _mm512_max_pd(zero, x));
+
+		const __m512d discriminant = _mm512_sub_pd(_mm512_add_pd(_mm512_mul_pd(a, a), x), _mm512_mul_pd(_mm512_mul_pd(two, a), x));
+		const __m512d dSqrt = _mm512_maskz_sqrt_pd(_mm512_cmp_pd_mask(discriminant, zero, _CMP_GE_OQ), discriminant);
+
+		const __m512d t = params.useConjugate
+			? _mm512_div_pd(x, _mm512_add_pd(a, dSqrt))
+			: _mm512_div_pd(_mm512_sub_pd(a, dSqrt), _mm512_set1_pd(params.denominator));
+
+		const __m512d result = _mm512_add_pd(
+			_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(two, _mm512_sub_pd(one, t)), t), _mm512_set1_pd(params.b)),
+			_mm512_mul_pd(t, t));
+		return _mm512_min_pd(one, _mm512_max_pd(zero, result));
+	}
+
+	void EvaluateCurvesAVX512(double a, double b, const double* pXs, double* pResults, std::size_t count)
+	{
+		const CurveParams params = MakeCurveParams(a, b);
+		std::size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			_mm512_storeu_pd(pResults + i, EvaluateCurve8(params, _mm512_loadu_pd(pXs + i)));
+		}
+		EvaluateCurvesScalar(a, b, pXs + i, pResults + i, count - i);
+	}
+}
+
+const kson::Simd::SimdKernels kson::Simd::kAVX512Kernels = {
+	.asciiPrefixLength = &AsciiPrefixLengthAVX512,
+	.evaluateCurves = &EvaluateCurvesAVX512,
+};
+#endif
@@ -0,0 +1,66 @@
+#include "SimdKernels.hpp"
+
+#if KSON_SIMD_X86_64
+#include <bit>
+#include <emmintrin.h>
+
+namespace
+{
+	using namespace kson::Simd;
+
+	std::size_t AsciiPrefixLengthSSE2(const char* pData, std::size_t size)
+	{
+		std::size_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData + i));
+			const int mask = _mm_movemask_epi8(chunk);
+			if (mask != 0)
+			{
+				return i + static_cast<std::size_t>(std::countr_zero(static_cast<unsigned int>(mask)));
+			}
+		}
+		return i + AsciiPrefixLengthScalar(pData + i, size - i);
+	}
+
+	// Same operations in the same order as EvaluateCurve(), so that the results are bit-identical
+	__m128d EvaluateCurve2(const CurveParams& params, __m128d x)
+	{
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d one = _mm_set1_pd(1.0);
+		const __m128d two = _mm_set1_pd(2.0);
+		const __m128d a = _mm_set1_pd(params.a);
+
+		// Operand order keeps NaN as std::clamp() does
+		x = _mm_min_pd(one, _mm_max_pd(zero, x));
+
+		const __m128d discriminant = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(a, a), x), _mm_mul_pd(_mm_mul_pd(two, a), x));
+		const __m128d dSqrt = _mm_and_pd(_mm_sqrt_pd(discriminant), _mm_cmpge_pd(discriminant, zero));
+
+		const __m128d t = params.useConjugate
+			? _mm_div_pd(x, _mm_add_pd(a, dSqrt))
+			: _mm_div_pd(_mm_sub_pd(a, dSqrt), _mm_set1_pd(params.denominator));
+
+		const __m128d result = _mm_add_pd(
+			_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(two, _mm_sub_pd(one, t)), t), _mm_set1_pd(params.b)),
+			_mm_mul_pd(t, t));
+		return _mm_min_pd(one, _mm_max_pd(zero, result));
+	}
+
+	void EvaluateCurvesSSE2(double a, double b, const double* pXs, double* pResults, std::size_t count)
+	{
+		const CurveParams params = MakeCurveParams(a, b);
+		std::size_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			_mm_storeu_pd(pResults + i, EvaluateCurve2(params, _mm_loadu_pd(pXs + i)));
+		}
+		EvaluateCurvesScalar(a, b, pXs + i, pResults + i, count - i);
+	}
+}
+
+const kson::Simd::SimdKernels kson::Simd::kSSE2Kernels = {
+	.asciiPrefixLength = &AsciiPrefixLengthSSE2,
+	.evaluateCurves = &EvaluateCurvesSSE2,
+};
+#endif
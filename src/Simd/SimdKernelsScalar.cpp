@@ -0,0 +1,39 @@
+#include "SimdKernels.hpp"
+#include "kson/Util/GraphCurve.hpp"
+#include <algorithm>
+
+std::size_t kson::Simd::AsciiPrefixLengthScalar(const char* pData, std::size_t size)
+{
+	std::size_t i = 0;
+	while (i < size && static_cast<unsigned char>(pData[i]) < 0x80)
+	{
+		++i;
+	}
+	return i;
+}
+
+void kson::Simd::EvaluateCurvesScalar(double a, double b, const double* pXs, double* pResults, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		pResults[i] = EvaluateCurve(a, b, pXs[i]);
+	}
+}
+
+kson::Simd::CurveParams kson::Simd::MakeCurveParams(double a, double b)
+{
+	// Same as EvaluateCurve()
+	a = std::clamp(a, 0.0, 1.0);
+	b = std::clamp(b, 0.0, 1.0);
+	return {
+		.a = a,
+		.b = b,
+		.useConjugate = !(a < 0.25),
+		.denominator = -1.0 + 2.0 * a,
+	};
+}
+
+const kson::Simd::SimdKernels kson::Simd::kScalarKernels = {
+	.asciiPrefixLength = &AsciiPrefixLengthScalar,
+	.evaluateCurves = &EvaluateCurvesScalar,
+};
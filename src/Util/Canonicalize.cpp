@@ -0,0 +1,318 @@
+#include "kson/Util/Canonicalize.hpp"
+#include <limits>
+
+namespace
+{
+	using namespace kson;
+
+	// Deviation allowed even with zero tolerance, to absorb floating-point errors
+	constexpr double kValueEpsilon = 1e-9;
+
+	constexpr double kInf = std::numeric_limits<double>::infinity();
+
+	bool IsPlainPoint(const GraphPoint& point)
+	{
+		return AlmostEquals(point.v.v, point.v.vf) && point.curve.isLinear();
+	}
+
+	// Removes points in one sweep while keeping the range of slopes from the last kept point (anchor)
+	// that pass within the tolerance of all points removed since the anchor
+	std::size_t SimplifyPointsBySweep(ByPulse<GraphPoint>& points, double tolerance)
+	{
+		if (points.size() < 3)
+		{
+			return 0;
+		}
+
+		std::size_t numRemoved = 0;
+		auto anchorItr = points.begin();
+		auto itr = std::next(anchorItr);
+		double minSlope = -kInf;
+		double maxSlope = kInf;
+		while (itr != points.end())
+		{
+			const auto nextItr = std::next(itr);
+			if (nextItr == points.end())
+			{
+				break;
+			}
+
+			const auto& [anchorY, anchor] = *anchorItr;
+			const auto& [y, point] = *itr;
+			if (anchor.curve.isLinear() && IsPlainPoint(point))
+			{
+				const double dx = static_cast<double>(y - anchorY);
+				const double newMinSlope = std::max(minSlope, (point.v.v - tolerance - anchor.v.vf) / dx);
+				const double newMaxSlope = std::min(maxSlope, (point.v.v + tolerance - anchor.v.vf) / dx);
+				const double slope = (nextItr->second.v.v - anchor.v.vf) / static_cast<double>(nextItr->first - anchorY);
+				if (newMinSlope <= slope && slope <= newMaxSlope)
+				{
+					points.erase(itr);
+					itr = nextItr;
+					minSlope = newMinSlope;
+					maxSlope = newMaxSlope;
+					++numRemoved;
+					continue;
+				}
+			}
+
+			anchorItr = itr;
+			itr = nextItr;
+			minSlope = -kInf;
+			maxSlope = kInf;
+		}
+
+		return numRemoved;
+	}
+
+	// Simplifies each run of removable points between two kept points with the Ramer-Douglas-Peucker algorithm
+	// (the distance is measured vertically, i.e., as the deviation of the evaluated value)
+	std::size_t SimplifyPointsByRDP(ByPulse<GraphPoint>& points, double tolerance)
+	{
+		if (points.size() < 3)
+		{
+			return 0;
+		}
+
+		std::vector<ByPulse<GraphPoint>::iterator> run;
+		std::vector<bool> keep;
+		std::vector<std::pair<std::size_t, std::size_t>> stack;
+		std::size_t numRemoved = 0;
+
+		auto itr = points.begin();
+		while (itr != points.end())
+		{
+			// itr is a kept point that starts a run
+			run.clear();
+			run.push_back(itr);
+			auto runItr = std::next(itr);
+			while (runItr != points.end() && std::next(runItr) != points.end() && std::prev(runItr)->second.curve.isLinear() && IsPlainPoint(runItr->second))
+			{
+				run.push_back(runItr);
+				++runItr;
+			}
+			if (runItr == points.end())
+			{
+				break;
+			}
+			run.push_back(runItr);
+
+			if (run.size() > 2)
+			{
+				const auto valueAt = [&run](std::size_t idx)
+				{
+					// The line starts from vf of the first point and ends at v of the last point
+					return idx == 0 ? run[idx]->second.v.vf : run[idx]->second.v.v;
+				};
+
+				keep.assign(run.size(), false);
+				keep.front() = true;
+				keep.back() = true;
+				stack.clear();
+				stack.emplace_back(0, run.size() - 1);
+				while (!stack.empty())
+				{
+					const auto [first, last] = stack.back();
+					stack.pop_back();
+
+					const double x1 = static_cast<double>(run[first]->first);
+					const double x2 = static_cast<double>(run[last]->first);
+					double maxDeviation = 0.0;
+					std::size_t maxIdx = first;
+					for (std::size_t i = first + 1; i < last; ++i)
+					{
+						const double rate = (static_cast<double>(run[i]->first) - x1) / (x2 - x1);
+						const double deviation = std::abs(valueAt(i) - std::lerp(valueAt(first), valueAt(last), rate));
+						if (deviation > maxDeviation)
+						{
+							maxDeviation = deviation;
+							maxIdx = i;
+						}
+					}
+
+					if (maxDeviation > tolerance)
+					{
+						keep[maxIdx] = true;
+						stack.emplace_back(first, maxIdx);
+						stack.emplace_back(maxIdx, last);
+					}
+				}
+
+				for (std::size_t i = 1; i + 1 < run.size(); ++i)
+				{
+					if (!keep[i])
+					{
+						points.erase(run[i]);
+						++numRemoved;
+					}
+				}
+			}
+
+			itr = runItr;
+		}
+
+		return numRemoved;
+	}
+
+	std::size_t SimplifyPoints(ByPulse<GraphPoint>& points, const CanonicalizeOptions& options)
+	{
+		const double tolerance = std::max(options.tolerance, kValueEpsilon);
+		return options.useRDP ? SimplifyPointsByRDP(points, tolerance) : SimplifyPointsBySweep(points, tolerance);
+	}
+
+	// Removes values that are the same as the previous one
+	template <typename K, typename V, typename Equal>
+	std::size_t RemoveRepeatedValues(std::map<K, V>& map, Equal equal)
+	{
+		std::size_t numRemoved = 0;
+		auto prevItr = map.begin();
+		for (auto itr = prevItr == map.end() ? map.end() : std::next(prevItr); itr != map.end();)
+		{
+			if (equal(prevItr->second, itr->second))
+			{
+				itr = map.erase(itr);
+				++numRemoved;
+			}
+			else
+			{
+				prevItr = itr;
+				++itr;
+			}
+		}
+		return numRemoved;
+	}
+
+	std::size_t RemoveRepeatedValues(ByPulse<double>& map)
+	{
+		return RemoveRepeatedValues(map, [](double a, double b) { return AlmostEquals(a, b); });
+	}
+
+	std::size_t RemoveRepeatedParamChanges(Dict<Dict<ByPulse<std::string>>>& paramChange)
+	{
+		std::size_t numRemoved = 0;
+		for (auto& [effectName, params] : paramChange)
+		{
+			for (auto& [paramName, values] : params)
+			{
+				numRemoved += RemoveRepeatedValues(values, std::equal_to<std::string>());
+			}
+		}
+		return numRemoved;
+	}
+
+	// Returns whether the tilt value can be removed without changing the evaluated tilt
+	bool IsRedundantTiltValue(const TiltValue& prevValue, const TiltValue& value, const TiltValue* pNextValue)
+	{
+		if (std::holds_alternative<AutoTiltType>(value))
+		{
+			return std::holds_alternative<AutoTiltType>(prevValue) && std::get<AutoTiltType>(prevValue) == std::get<AutoTiltType>(value);
+		}
+
+		if (!std::holds_alternative<TiltGraphPoint>(prevValue))
+		{
+			return false;
+		}
+
+		const TiltGraphPoint& prevPoint = std::get<TiltGraphPoint>(prevValue);
+		const TiltGraphPoint& point = std::get<TiltGraphPoint>(value);
+		if (!std::holds_alternative<double>(prevPoint.v.vf) || !std::holds_alternative<double>(point.v.vf) || !prevPoint.curve.isLinear() || !point.curve.isLinear())
+		{
+			return false;
+		}
+
+		const double prevVf = std::get<double>(prevPoint.v.vf);
+		if (!AlmostEquals(prevVf, point.v.v) || !AlmostEquals(point.v.v, std::get<double>(point.v.vf)))
+		{
+			return false;
+		}
+
+		// The next manual tilt point is interpolated from the previous point instead
+		if (pNextValue != nullptr && std::holds_alternative<TiltGraphPoint>(*pNextValue))
+		{
+			return AlmostEquals(std::get<TiltGraphPoint>(*pNextValue).v.v, prevVf);
+		}
+		return true;
+	}
+
+	std::size_t RemoveRedundantTiltValues(ByPulse<TiltValue>& tilt)
+	{
+		std::size_t numRemoved = 0;
+		auto prevItr = tilt.end();
+		for (auto itr = tilt.begin(); itr != tilt.end();)
+		{
+			const auto nextItr = std::next(itr);
+			const TiltValue* pNextValue = nextItr == tilt.end() ? nullptr : &nextItr->second;
+			if (prevItr != tilt.end() && IsRedundantTiltValue(prevItr->second, itr->second, pNextValue))
+			{
+				tilt.erase(itr);
+				++numRemoved;
+			}
+			else
+			{
+				prevItr = itr;
+			}
+			itr = nextItr;
+		}
+		return numRemoved;
+	}
+}
+
+std::size_t kson::CanonicalizeGraph(Graph& graph, const CanonicalizeOptions& options)
+{
+	std::size_t numRemoved = SimplifyPoints(graph, options);
+
+	// The last point can be removed if the value stays the same after it
+	if (graph.size() >= 2)
+	{
+		const auto lastItr = std::prev(graph.end());
+		const auto& prevPoint = std::prev(lastItr)->second;
+		const auto& lastPoint = lastItr->second;
+		if (prevPoint.curve.isLinear() && IsPlainPoint(lastPoint) && std::abs(lastPoint.v.v - prevPoint.v.vf) <= std::max(options.tolerance, kValueEpsilon))
+		{
+			graph.erase(lastItr);
+			++numRemoved;
+		}
+	}
+
+	return numRemoved;
+}
+
+std::size_t kson::CanonicalizeLaserSection(LaserSection& laserSection, const CanonicalizeOptions& options)
+{
+	return SimplifyPoints(laserSection.v, options);
+}
+
+std::size_t kson::CanonicalizeChart(ChartData& chartData, const CanonicalizeOptions& options)
+{
+	std::size_t numRemoved = 0;
+
+	// Beat
+	numRemoved += RemoveRepeatedValues(chartData.beat.bpm);
+	numRemoved += RemoveRepeatedValues(chartData.beat.timeSig, [](const TimeSig& a, const TimeSig& b) { return a.n == b.n && a.d == b.d; });
+	numRemoved += CanonicalizeGraph(chartData.beat.scrollSpeed, options);
+
+	// Note
+	for (auto& lane : chartData.note.laser)
+	{
+		for (auto& [y, section] : lane)
+		{
+			numRemoved += CanonicalizeLaserSection(section, options);
+		}
+	}
+
+	// Camera
+	auto& body = chartData.camera.cam.body;
+	for (Graph* pGraph : { &body.zoomBottom, &body.zoomSide, &body.zoomTop, &body.rotationDeg, &body.centerSplit })
+	{
+		numRemoved += CanonicalizeGraph(*pGraph, options);
+	}
+	numRemoved += RemoveRedundantTiltValues(chartData.camera.tilt);
+
+	// Audio
+	numRemoved += RemoveRepeatedValues(chartData.audio.keySound.laser.vol);
+	numRemoved += RemoveRepeatedParamChanges(chartData.audio.audioEffect.fx.paramChange);
+	numRemoved += RemoveRepeatedParamChanges(chartData.audio.audioEffect.laser.paramChange);
+	numRemoved += RemoveRepeatedValues(chartData.audio.audioEffect.laser.legacy.filterGain);
+
+	return numRemoved;
+}
@@ -0,0 +1,595 @@
+#include "kson/Util/ChartCache.hpp"
+#include "kson/IO/KsonIO.hpp"
+#include <cstring>
+#include <optional>
+#include <sstream>
+
+namespace
+{
+	using namespace kson;
+
+	// Approximate size of a std::map node excluding the value
+	constexpr std::size_t kMapNodeOverhead = 4 * sizeof(void*);
+
+	template <typename K, typename V>
+	std::size_t MapSize(const std::map<K, V>& map)
+	{
+		return map.size() * (kMapNodeOverhead + sizeof(typename std::map<K, V>::value_type));
+	}
+
+	template <typename T>
+	std::size_t SetSize(const std::set<T>& set)
+	{
+		return set.size() * (kMapNodeOverhead + sizeof(T));
+	}
+
+	template <typename V, typename SizeFunc>
+	std::size_t DictSize(const Dict<V>& dict, SizeFunc valueSize)
+	{
+		std::size_t size = MapSize(dict);
+		for (const auto& [key, value] : dict)
+		{
+			size += key.capacity() + valueSize(value);
+		}
+		return size;
+	}
+
+	template <typename Lanes, typename SizeFunc>
+	std::size_t LanesSize(const Lanes& lanes, SizeFunc valueSize)
+	{
+		std::size_t size = 0;
+		for (const auto& lane : lanes)
+		{
+			size += MapSize(lane);
+			for (const auto& [y, value] : lane)
+			{
+				size += valueSize(value);
+			}
+		}
+		return size;
+	}
+
+	template <typename T>
+	std::size_t ZeroSize(const T&)
+	{
+		return 0;
+	}
+
+	std::size_t StringMapSize(const ByPulse<std::string>& map)
+	{
+		std::size_t size = MapSize(map);
+		for (const auto& [y, str] : map)
+		{
+			size += str.capacity();
+		}
+		return size;
+	}
+
+	std::size_t AudioEffectParamsSize(const AudioEffectParams& params)
+	{
+		return DictSize(params, [](const std::string& value) { return value.capacity(); });
+	}
+
+	std::size_t AudioEffectDefsSize(const std::vector<AudioEffectDefKVP>& defs)
+	{
+		std::size_t size = defs.capacity() * sizeof(AudioEffectDefKVP);
+		for (const auto& def : defs)
+		{
+			size += def.name.capacity() + AudioEffectParamsSize(def.v.v);
+		}
+		return size;
+	}
+
+	std::size_t ParamChangeSize(const Dict<Dict<ByPulse<std::string>>>& paramChange)
+	{
+		return DictSize(paramChange, [](const auto& params) { return DictSize(params, StringMapSize); });
+	}
+
+	// Block compression in the LZ77 family (sequences of literals and back-references, similar to the LZ4 block format)
+	// Favors speed over ratio; the serialized KSON text is highly repetitive, so the ratio is still good
+	constexpr std::size_t kMinMatch = 4;
+	constexpr std::size_t kHashBits = 16;
+	constexpr std::size_t kMaxOffset = 65535;
+	constexpr std::size_t kNibbleMax = 15;
+
+	std::uint32_t Read32(std::string_view src, std::size_t pos)
+	{
+		std::uint32_t v;
+		std::memcpy(&v, src.data() + pos, sizeof(v));
+		return v;
+	}
+
+	void WriteLengthExtension(std::string& out, std::size_t length)
+	{
+		while (length >= 255)
+		{
+			out.push_back(static_cast<char>(255));
+			length -= 255;
+		}
+		out.push_back(static_cast<char>(length));
+	}
+
+	// matchLength = 0 means the last sequence without a back-reference
+	void WriteSequence(std::string& out, std::string_view literals, std::size_t offset, std::size_t matchLength)
+	{
+		const std::size_t matchLengthCode = matchLength == 0 ? 0 : matchLength - kMinMatch;
+		out.push_back(static_cast<char>((std::min(literals.size(), kNibbleMax) << 4) | std::min(matchLengthCode, kNibbleMax)));
+		if (literals.size() >= kNibbleMax)
+		{
+			WriteLengthExtension(out, literals.size() - kNibbleMax);
+		}
+		out.append(literals);
+
+		if (matchLength != 0)
+		{
+			out.push_back(static_cast<char>(offset & 0xFF));
+			out.push_back(static_cast<char>(offset >> 8));
+			if (matchLengthCode >= kNibbleMax)
+			{
+				WriteLengthExtension(out, matchLengthCode - kNibbleMax);
+			}
+		}
+	}
+
+	std::string Compress(std::string_view src)
+	{
+		std::string out;
+		out.reserve(src.size() / 4);
+
+		// Last position + 1 of each hashed 4-byte sequence
+		std::vector<std::uint32_t> table(std::size_t{ 1 } << kHashBits, 0);
+
+		std::size_t anchor = 0;
+		std::size_t i = 0;
+		while (i + kMinMatch <= src.size())
+		{
+			const std::uint32_t v = Read32(src, i);
+			const std::uint32_t hash = (v * 2654435761U) >> (32 - kHashBits);
+			const std::size_t candidate = table[hash];
+			table[hash] = static_cast<std::uint32_t>(i + 1);
+
+			if (candidate != 0 && i - (candidate - 1) <= kMaxOffset && Read32(src, candidate - 1) == v)
+			{
+				const std::size_t matchPos = candidate - 1;
+				std::size_t length = kMinMatch;
+				while (i + length < src.size() && src[matchPos + length] == src[i + length])
+				{
+					++length;
+				}
+				WriteSequence(out, src.substr(anchor, i - anchor), i - matchPos, length);
+				i += length;
+				anchor = i;
+				continue;
+			}
+			++i;
+		}
+		WriteSequence(out, src.substr(anchor), 0, 0);
+
+		return out;
+	}
+
+	std::optional<std::string> Decompress(std::string_view src, std::size_t originalSize)
+	{
+		std::string out;
+		out.reserve(originalSize);
+
+		std::size_t pos = 0;
+		const auto readLengthExtension = [&src, &pos](std::size_t* pLength)
+		{
+			std::uint8_t b;
+			do
+			{
+				if (pos >= src.size())
+				{
+					return false;
+				}
+				b = static_cast<std::uint8_t>(src[pos++]);
+				*pLength += b;
+			} while (b == 255);
+			return true;
+		};
+
+		while (pos < src.size())
+		{
+			const auto token = static_cast<std::uint8_t>(src[pos++]);
+
+			std::size_t literalLength = token >> 4;
+			if (literalLength == kNibbleMax && !readLengthExtension(&literalLength))
+			{
+				return std::nullopt;
+			}
+			if (src.size() - pos < literalLength || out.size() + literalLength > originalSize)
+			{
+				return std::nullopt;
+			}
+			out.append(src.substr(pos, literalLength));
+			pos += literalLength;
+
+			// The last sequence has no back-reference
+			if (pos == src.size())
+			{
+				break;
+			}
+
+			if (src.size() - pos < 2)
+			{
+				return std::nullopt;
+			}
+			const std::size_t offset = static_cast<std::uint8_t>(src[pos]) | (static_cast<std::size_t>(static_cast<std::uint8_t>(src[pos + 1])) << 8);
+			pos += 2;
+
+			std::size_t matchLength = token & 0xF;
+			if (matchLength == kNibbleMax && !readLengthExtension(&matchLength))
+			{
+				return std::nullopt;
+			}
+			matchLength += kMinMatch;
+			if (offset == 0 || offset > out.size() || out.size() + matchLength > originalSize)
+			{
+				return std::nullopt;
+			}
+
+			// Byte by byte since the source may overlap the output
+			const std::size_t start = out.size() - offset;
+			for (std::size_t k = 0; k < matchLength; ++k)
+			{
+				out.push_back(out[start + k]);
+			}
+		}
+
+		if (out.size() != originalSize)
+		{
+			return std::nullopt;
+		}
+		return out;
+	}
+}
+
+std::size_t kson::EstimateChartDataSize(const ChartData& chartData)
+{
+	std::size_t size = sizeof(ChartData);
+
+	// Meta
+	const MetaInfo& meta = chartData.meta;
+	for (const std::string* pStr : { &meta.title, &meta.titleTranslit, &meta.titleImgFilename, &meta.artist, &meta.artistTranslit, &meta.artistImgFilename, &meta.chartAuthor, &meta.dispBPM, &meta.jacketFilename, &meta.jacketAuthor, &meta.iconFilename, &meta.information })
+	{
+		size += pStr->capacity();
+	}
+
+	// Beat
+	size += MapSize(chartData.beat.bpm) + MapSize(chartData.beat.timeSig) + MapSize(chartData.beat.scrollSpeed) + MapSize(chartData.beat.stop);
+
+	// Note
+	size += LanesSize(chartData.note.bt, ZeroSize<Interval>);
+	size += LanesSize(chartData.note.fx, ZeroSize<Interval>);
+	size += LanesSize(chartData.note.laser, [](const LaserSection& section) { return MapSize(section.v); });
+
+	// Audio
+	const AudioInfo& audio = chartData.audio;
+	size += DictSize(audio.keySound.fx.chipEvent, [](const auto& lanes) { return LanesSize(lanes, ZeroSize<KeySoundInvokeFX>); });
+	size += MapSize(audio.keySound.laser.vol);
+	size += DictSize(audio.keySound.laser.slamEvent, SetSize<Pulse>);
+	size += AudioEffectDefsSize(audio.audioEffect.fx.def) + ParamChangeSize(audio.audioEffect.fx.paramChange);
+	size += DictSize(audio.audioEffect.fx.longEvent, [](const auto& lanes) { return LanesSize(lanes, AudioEffectParamsSize); });
+	size += AudioEffectDefsSize(audio.audioEffect.laser.def) + ParamChangeSize(audio.audioEffect.laser.paramChange);
+	size += DictSize(audio.audioEffect.laser.pulseEvent, SetSize<Pulse>);
+	size += MapSize(audio.audioEffect.laser.legacy.filterGain);
+
+	// Camera
+	const CamGraphs& body = chartData.camera.cam.body;
+	for (const Graph* pGraph : { &body.zoomBottom, &body.zoomSide, &body.zoomTop, &body.rotationDeg, &body.centerSplit })
+	{
+		size += MapSize(*pGraph);
+	}
+	const CamPatternLaserInvokeList& slamEvent = chartData.camera.cam.pattern.laser.slamEvent;
+	size += MapSize(slamEvent.spin) + MapSize(slamEvent.halfSpin) + MapSize(slamEvent.swing);
+	size += MapSize(chartData.camera.tilt);
+
+	return size;
+}
+
+kson::ChartCache::ChartCache(const ChartCacheOptions& options)
+	: m_options(options)
+{
+}
+
+std::shared_ptr<const kson::ChartData> kson::ChartCache::findResident(const std::string& key)
+{
+	const auto it = m_entries.find(key);
+	if (it == m_entries.end())
+	{
+		return nullptr;
+	}
+
+	m_lru.splice(m_lru.begin(), m_lru, it->second.lruItr);
+	return it->second.chartData;
+}
+
+void kson::ChartCache::insertResident(const std::string& key, std::shared_ptr<const ChartData> chartData)
+{
+	const std::size_t size = EstimateChartDataSize(*chartData);
+	if (const auto it = m_entries.find(key); it != m_entries.end())
+	{
+		m_residentBytes -= it->second.size;
+		it->second.chartData = std::move(chartData);
+		it->second.size = size;
+		m_lru.splice(m_lru.begin(), m_lru, it->second.lruItr);
+	}
+	else
+	{
+		m_lru.push_front(key);
+		m_entries.emplace(key, Entry{ .chartData = std::move(chartData), .size = size, .lruItr = m_lru.begin() });
+	}
+	m_residentBytes += size;
+}
+
+void kson::ChartCache::eraseCompressed(const std::string& key)
+{
+	if (const auto it = m_compressedEntries.find(key); it != m_compressedEntries.end())
+	{
+		m_compressedBytes -= it->second.data.size();
+		m_compressedLRU.erase(it->second.lruItr);
+		m_compressedEntries.erase(it);
+	}
+}
+
+void kson::ChartCache::insertCompressed(const std::string& key, std::string&& data, std::size_t originalSize)
+{
+	eraseCompressed(key);
+	if (data.size() > m_options.compressedByteBudget)
+	{
+		return;
+	}
+
+	while (m_compressedBytes + data.size() > m_options.compressedByteBudget && !m_compressedLRU.empty())
+	{
+		eraseCompressed(m_compressedLRU.back());
+	}
+
+	m_compressedBytes += data.size();
+	m_compressedLRU.push_front(key);
+	m_compressedEntries.emplace(key, CompressedEntry{ .data = std::move(data), .originalSize = originalSize, .lruItr = m_compressedLRU.begin() });
+}
+
+std::vector<kson::ChartCache::Victim> kson::ChartCache::evict()
+{
+	std::vector<Victim> victims;
+	auto itr = m_lru.end();
+	while (m_residentBytes > m_options.byteBudget && itr != m_lru.begin())
+	{
+		--itr;
+		const auto entryItr = m_entries.find(*itr);
+		if (entryItr->second.pinCount > 0)
+		{
+			continue;
+		}
+
+		m_residentBytes -= entryItr->second.size;
+		victims.emplace_back(*itr, std::move(entryItr->second.chartData));
+		m_entries.erase(entryItr);
+		itr = m_lru.erase(itr);
+		++m_stats.numEvictions;
+	}
+	return victims;
+}
+
+void kson::ChartCache::compressVictims(std::vector<Victim>&& victims)
+{
+	if (m_options.compressedByteBudget == 0)
+	{
+		return;
+	}
+
+	for (auto& [key, chartData] : victims)
+	{
+		std::ostringstream oss;
+		if (SaveKsonChartData(oss, *chartData) != ErrorType::None)
+		{
+			continue;
+		}
+		const std::string serialized = oss.str();
+		std::string compressed = Compress(serialized);
+
+		const std::lock_guard lock(m_mutex);
+
+		// Skip if the chart has been loaded or inserted again in the meantime
+		if (!m_entries.contains(key) && !m_loading.contains(key))
+		{
+			insertCompressed(key, std::move(compressed), serialized.size());
+		}
+	}
+}
+
+std::shared_ptr<const kson::ChartData> kson::ChartCache::getOrLoad(const std::string& key, const Loader& loader)
+{
+	std::promise<std::shared_ptr<const ChartData>> promise;
+	std::string compressedData;
+	std::size_t originalSize = 0;
+	{
+		std::unique_lock lock(m_mutex);
+		if (auto chartData = findResident(key))
+		{
+			++m_stats.numHits;
+			return chartData;
+		}
+
+		if (const auto it = m_loading.find(key); it != m_loading.end())
+		{
+			const auto future = it->second;
+			lock.unlock();
+			return future.get();
+		}
+
+		if (const auto it = m_compressedEntries.find(key); it != m_compressedEntries.end())
+		{
+			// Taken out of the compressed tier while decoding
+			compressedData = std::move(it->second.data);
+			originalSize = it->second.originalSize;
+			m_compressedBytes -= compressedData.size();
+			m_compressedLRU.erase(it->second.lruItr);
+			m_compressedEntries.erase(it);
+			++m_stats.numCompressedHits;
+		}
+		else
+		{
+			++m_stats.numMisses;
+		}
+
+		m_loading.emplace(key, promise.get_future().share());
+	}
+
+	std::shared_ptr<const ChartData> chartData;
+	const auto load = [&]()
+	{
+		if (!compressedData.empty())
+		{
+			if (const auto serialized = Decompress(compressedData, originalSize))
+			{
+				std::istringstream iss(*serialized);
+				auto decoded = std::make_shared<ChartData>(LoadKsonChartData(iss));
+				if (decoded->error == ErrorType::None)
+				{
+					chartData = std::move(decoded);
+				}
+			}
+		}
+
+		if (chartData == nullptr)
+		{
+			chartData = std::make_shared<const ChartData>(loader());
+		}
+	};
+
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		load();
+	}
+	catch (...)
+	{
+		{
+			const std::lock_guard lock(m_mutex);
+			m_loading.erase(key);
+		}
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+#else
+	load();
+#endif
+
+	std::vector<Victim> victims;
+	{
+		const std::lock_guard lock(m_mutex);
+		m_loading.erase(key);
+		if (chartData->error == ErrorType::None)
+		{
+			insertResident(key, chartData);
+			victims = evict();
+		}
+	}
+	promise.set_value(chartData);
+
+	compressVictims(std::move(victims));
+
+	return chartData;
+}
+
+std::shared_ptr<const kson::ChartData> kson::ChartCache::find(const std::string& key)
+{
+	{
+		const std::lock_guard lock(m_mutex);
+		if (auto chartData = findResident(key))
+		{
+			++m_stats.numHits;
+			return chartData;
+		}
+
+		if (!m_loading.contains(key) && !m_compressedEntries.contains(key))
+		{
+			return nullptr;
+		}
+	}
+
+	// Wait for the load in progress or decode the compressed chart
+	auto chartData = getOrLoad(key, [] { return ChartData{ .error = ErrorType::UnknownError }; });
+	return chartData->error == ErrorType::None ? chartData : nullptr;
+}
+
+void kson::ChartCache::insert(const std::string& key, ChartData&& chartData)
+{
+	auto pChartData = std::make_shared<const ChartData>(std::move(chartData));
+
+	std::vector<Victim> victims;
+	{
+		const std::lock_guard lock(m_mutex);
+		eraseCompressed(key);
+		insertResident(key, std::move(pChartData));
+		victims = evict();
+	}
+	compressVictims(std::move(victims));
+}
+
+bool kson::ChartCache::pin(const std::string& key)
+{
+	const std::lock_guard lock(m_mutex);
+	const auto it = m_entries.find(key);
+	if (it == m_entries.end())
+	{
+		return false;
+	}
+	++it->second.pinCount;
+	return true;
+}
+
+void kson::ChartCache::unpin(const std::string& key)
+{
+	std::vector<Victim> victims;
+	{
+		const std::lock_guard lock(m_mutex);
+		const auto it = m_entries.find(key);
+		if (it == m_entries.end() || it->second.pinCount == 0)
+		{
+			return;
+		}
+		--it->second.pinCount;
+
+		// The budget may have been exceeded while pinned
+		victims = evict();
+	}
+	compressVictims(std::move(victims));
+}
+
+void kson::ChartCache::erase(const std::string& key)
+{
+	const std::lock_guard lock(m_mutex);
+	if (const auto it = m_entries.find(key); it != m_entries.end())
+	{
+		m_residentBytes -= it->second.size;
+		m_lru.erase(it->second.lruItr);
+		m_entries.erase(it);
+	}
+	eraseCompressed(key);
+}
+
+void kson::ChartCache::clear()
+{
+	const std::lock_guard lock(m_mutex);
+	m_entries.clear();
+	m_lru.clear();
+	m_residentBytes = 0;
+	m_compressedEntries.clear();
+	m_compressedLRU.clear();
+	m_compressedBytes = 0;
+}
+
+kson::ChartCacheStats kson::ChartCache::stats() const
+{
+	const std::lock_guard lock(m_mutex);
+	ChartCacheStats stats = m_stats;
+	stats.numResident = m_entries.size();
+	stats.residentBytes = m_residentBytes;
+	stats.numCompressed = m_compressedEntries.size();
+	stats.compressedBytes = m_compressedBytes;
+	return stats;
+}
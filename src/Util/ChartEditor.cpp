@@ -0,0 +1,402 @@
+#include "kson/Util/ChartEditor.hpp"
+#include "kson/Util/TimingUtils.hpp"
+#include <algorithm>
+
+namespace
+{
+	using namespace kson;
+
+	// Range of a note or a laser section including its end pulse
+	PulseRange NoteRange(Pulse y, RelPulse length)
+	{
+		return { .begin = y, .end = y + std::max(length, RelPulse{ 0 }) + 1 };
+	}
+
+	PulseRange LaserSectionRange(Pulse y, const LaserSection& section)
+	{
+		return NoteRange(y, section.v.empty() ? 0 : section.v.rbegin()->first);
+	}
+
+	// Range of a step function (e.g., tempo) affected by changing the value at y
+	template <typename T>
+	PulseRange StepRangeAt(const ByPulse<T>& map, Pulse y)
+	{
+		const auto nextItr = map.upper_bound(y);
+		return { .begin = y, .end = nextItr == map.end() ? kPulseRangeUnbounded : nextItr->first };
+	}
+
+	// Pulse of the measure with the time signature changes, without requiring the tempo (unlike MeasureIdxToPulse)
+	Pulse TimeSigMeasureIdxToPulse(const ByMeasureIdx<TimeSig>& timeSig, std::int64_t measureIdx)
+	{
+		Pulse pulse = 0;
+		std::int64_t prevIdx = 0;
+		Pulse prevMeasurePulse = kResolution4; // 4/4 if missing at measure 0
+		for (const auto& [idx, sig] : timeSig)
+		{
+			if (idx >= measureIdx)
+			{
+				break;
+			}
+			pulse += (idx - prevIdx) * prevMeasurePulse;
+			prevIdx = idx;
+			prevMeasurePulse = TimeSigOneMeasurePulse(sig);
+		}
+		return pulse + (measureIdx - prevIdx) * prevMeasurePulse;
+	}
+
+	void MarkGraphPointDirty(const Graph& graph, Pulse y, PulseRangeSet* pRangeSet)
+	{
+		// The values are interpolated between the previous point and the next point
+		// (the value before the first point is the value of the first point)
+		const auto prevItr = graph.lower_bound(y);
+		const auto nextItr = graph.upper_bound(y);
+		pRangeSet->add(PulseRange{
+			.begin = prevItr == graph.begin() ? std::min(Pulse{ 0 }, y) : std::prev(prevItr)->first,
+			.end = nextItr == graph.end() ? kPulseRangeUnbounded : nextItr->first,
+		});
+	}
+
+	template <std::size_t N>
+	bool AnyRangeSet(const std::array<PulseRangeSet, N>& rangeSets)
+	{
+		return std::any_of(rangeSets.begin(), rangeSets.end(), [](const PulseRangeSet& rangeSet) { return !rangeSet.empty(); });
+	}
+
+	template <std::size_t N>
+	void AddRangeSets(std::array<PulseRangeSet, N>& dest, const std::array<PulseRangeSet, N>& src)
+	{
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			dest[i].add(src[i]);
+		}
+	}
+
+	void SetNote(ByPulse<Interval>& lane, Pulse y, const Interval& note, PulseRangeSet* pRangeSet)
+	{
+		if (const auto itr = lane.find(y); itr != lane.end())
+		{
+			pRangeSet->add(NoteRange(y, itr->second.length));
+		}
+		lane.insert_or_assign(y, note);
+		pRangeSet->add(NoteRange(y, note.length));
+	}
+
+	bool RemoveNote(ByPulse<Interval>& lane, Pulse y, PulseRangeSet* pRangeSet)
+	{
+		const auto itr = lane.find(y);
+		if (itr == lane.end())
+		{
+			return false;
+		}
+		pRangeSet->add(NoteRange(y, itr->second.length));
+		lane.erase(itr);
+		return true;
+	}
+}
+
+void kson::PulseRangeSet::add(const PulseRange& range)
+{
+	if (range.empty())
+	{
+		return;
+	}
+
+	Pulse begin = range.begin;
+	Pulse end = range.end;
+
+	auto itr = m_ranges.upper_bound(begin);
+	if (itr != m_ranges.begin())
+	{
+		const auto prevItr = std::prev(itr);
+		if (prevItr->second >= begin)
+		{
+			begin = prevItr->first;
+			itr = prevItr;
+		}
+	}
+
+	// Merge the following overlapping or adjacent ranges
+	while (itr != m_ranges.end() && itr->first <= end)
+	{
+		end = std::max(end, itr->second);
+		itr = m_ranges.erase(itr);
+	}
+
+	m_ranges.emplace(begin, end);
+}
+
+void kson::PulseRangeSet::add(const PulseRangeSet& rangeSet)
+{
+	for (const auto& [begin, end] : rangeSet.m_ranges)
+	{
+		add(PulseRange{ .begin = begin, .end = end });
+	}
+}
+
+bool kson::PulseRangeSet::empty() const
+{
+	return m_ranges.empty();
+}
+
+bool kson::PulseRangeSet::overlaps(const PulseRange& range) const
+{
+	if (range.empty())
+	{
+		return false;
+	}
+
+	const auto itr = m_ranges.upper_bound(range.begin);
+	if (itr != m_ranges.begin() && std::prev(itr)->second > range.begin)
+	{
+		return true;
+	}
+	return itr != m_ranges.end() && itr->first < range.end;
+}
+
+kson::Pulse kson::PulseRangeSet::minPulse() const
+{
+	return m_ranges.empty() ? kPulseRangeUnbounded : m_ranges.begin()->first;
+}
+
+std::vector<kson::PulseRange> kson::PulseRangeSet::ranges() const
+{
+	std::vector<PulseRange> ranges;
+	ranges.reserve(m_ranges.size());
+	for (const auto& [begin, end] : m_ranges)
+	{
+		ranges.push_back({ .begin = begin, .end = end });
+	}
+	return ranges;
+}
+
+void kson::PulseRangeSet::clear()
+{
+	m_ranges.clear();
+}
+
+bool kson::ChartDirtyRanges::empty() const
+{
+	return !timingDirty() && scrollSpeed.empty() && stop.empty() && !notesDirty() && !other;
+}
+
+bool kson::ChartDirtyRanges::timingDirty() const
+{
+	return !bpm.empty() || !timeSig.empty();
+}
+
+bool kson::ChartDirtyRanges::notesDirty() const
+{
+	return AnyRangeSet(bt) || AnyRangeSet(fx) || AnyRangeSet(laser);
+}
+
+void kson::ChartDirtyRanges::add(const ChartDirtyRanges& dirtyRanges)
+{
+	bpm.add(dirtyRanges.bpm);
+	timeSig.add(dirtyRanges.timeSig);
+	scrollSpeed.add(dirtyRanges.scrollSpeed);
+	stop.add(dirtyRanges.stop);
+	AddRangeSets(bt, dirtyRanges.bt);
+	AddRangeSets(fx, dirtyRanges.fx);
+	AddRangeSets(laser, dirtyRanges.laser);
+	other = other || dirtyRanges.other;
+}
+
+void kson::ChartDirtyRanges::clear()
+{
+	*this = ChartDirtyRanges{};
+}
+
+kson::ChartEditor::ChartEditor(ChartData chartData)
+	: m_chartData(std::move(chartData))
+{
+}
+
+const kson::ChartData& kson::ChartEditor::chartData() const
+{
+	return m_chartData;
+}
+
+kson::ChartData kson::ChartEditor::release()
+{
+	m_dirtyRanges.clear();
+	return std::move(m_chartData);
+}
+
+const kson::ChartDirtyRanges& kson::ChartEditor::dirtyRanges() const
+{
+	return m_dirtyRanges;
+}
+
+bool kson::ChartEditor::hasPendingChanges() const
+{
+	return !m_dirtyRanges.empty();
+}
+
+void kson::ChartEditor::setBPM(Pulse y, double bpm)
+{
+	m_chartData.beat.bpm.insert_or_assign(y, bpm);
+	m_dirtyRanges.bpm.add(StepRangeAt(m_chartData.beat.bpm, y));
+}
+
+bool kson::ChartEditor::removeBPM(Pulse y)
+{
+	if (m_chartData.beat.bpm.erase(y) == 0)
+	{
+		return false;
+	}
+	m_dirtyRanges.bpm.add(StepRangeAt(m_chartData.beat.bpm, y));
+	return true;
+}
+
+void kson::ChartEditor::setTimeSig(std::int64_t measureIdx, const TimeSig& timeSig)
+{
+	// Positions of all the following measures can change
+	const Pulse pulse = TimeSigMeasureIdxToPulse(m_chartData.beat.timeSig, measureIdx);
+	m_chartData.beat.timeSig.insert_or_assign(measureIdx, timeSig);
+	m_dirtyRanges.timeSig.add(PulseRange{ .begin = pulse, .end = kPulseRangeUnbounded });
+}
+
+bool kson::ChartEditor::removeTimeSig(std::int64_t measureIdx)
+{
+	if (!m_chartData.beat.timeSig.contains(measureIdx))
+	{
+		return false;
+	}
+	const Pulse pulse = TimeSigMeasureIdxToPulse(m_chartData.beat.timeSig, measureIdx);
+	m_chartData.beat.timeSig.erase(measureIdx);
+	m_dirtyRanges.timeSig.add(PulseRange{ .begin = pulse, .end = kPulseRangeUnbounded });
+	return true;
+}
+
+void kson::ChartEditor::setScrollSpeed(Pulse y, const GraphPoint& point)
+{
+	m_chartData.beat.scrollSpeed.insert_or_assign(y, point);
+	MarkGraphPointDirty(m_chartData.beat.scrollSpeed, y, &m_dirtyRanges.scrollSpeed);
+}
+
+bool kson::ChartEditor::removeScrollSpeed(Pulse y)
+{
+	if (m_chartData.beat.scrollSpeed.erase(y) == 0)
+	{
+		return false;
+	}
+	MarkGraphPointDirty(m_chartData.beat.scrollSpeed, y, &m_dirtyRanges.scrollSpeed);
+	return true;
+}
+
+void kson::ChartEditor::setStop(Pulse y, RelPulse length)
+{
+	if (const auto itr = m_chartData.beat.stop.find(y); itr != m_chartData.beat.stop.end())
+	{
+		m_dirtyRanges.stop.add(NoteRange(y, itr->second));
+	}
+	m_chartData.beat.stop.insert_or_assign(y, length);
+	m_dirtyRanges.stop.add(NoteRange(y, length));
+}
+
+bool kson::ChartEditor::removeStop(Pulse y)
+{
+	const auto itr = m_chartData.beat.stop.find(y);
+	if (itr == m_chartData.beat.stop.end())
+	{
+		return false;
+	}
+	m_dirtyRanges.stop.add(NoteRange(y, itr->second));
+	m_chartData.beat.stop.erase(itr);
+	return true;
+}
+
+void kson::ChartEditor::setBTNote(std::size_t lane, Pulse y, const Interval& note)
+{
+	if (lane < kNumBTLanesSZ)
+	{
+		SetNote(m_chartData.note.bt[lane], y, note, &m_dirtyRanges.bt[lane]);
+	}
+}
+
+bool kson::ChartEditor::removeBTNote(std::size_t lane, Pulse y)
+{
+	return lane < kNumBTLanesSZ && RemoveNote(m_chartData.note.bt[lane], y, &m_dirtyRanges.bt[lane]);
+}
+
+void kson::ChartEditor::setFXNote(std::size_t lane, Pulse y, const Interval& note)
+{
+	if (lane < kNumFXLanesSZ)
+	{
+		SetNote(m_chartData.note.fx[lane], y, note, &m_dirtyRanges.fx[lane]);
+	}
+}
+
+bool kson::ChartEditor::removeFXNote(std::size_t lane, Pulse y)
+{
+	return lane < kNumFXLanesSZ && RemoveNote(m_chartData.note.fx[lane], y, &m_dirtyRanges.fx[lane]);
+}
+
+void kson::ChartEditor::setLaserSection(std::size_t lane, Pulse y, const LaserSection& section)
+{
+	if (lane >= kNumLaserLanesSZ)
+	{
+		return;
+	}
+
+	auto& laserLane = m_chartData.note.laser[lane];
+	if (const auto itr = laserLane.find(y); itr != laserLane.end())
+	{
+		m_dirtyRanges.laser[lane].add(LaserSectionRange(y, itr->second));
+	}
+	laserLane.insert_or_assign(y, section);
+	m_dirtyRanges.laser[lane].add(LaserSectionRange(y, section));
+}
+
+bool kson::ChartEditor::removeLaserSection(std::size_t lane, Pulse y)
+{
+	if (lane >= kNumLaserLanesSZ)
+	{
+		return false;
+	}
+
+	auto& laserLane = m_chartData.note.laser[lane];
+	const auto itr = laserLane.find(y);
+	if (itr == laserLane.end())
+	{
+		return false;
+	}
+	m_dirtyRanges.laser[lane].add(LaserSectionRange(y, itr->second));
+	laserLane.erase(itr);
+	return true;
+}
+
+void kson::ChartEditor::modify(const std::function<void(ChartData&, ChartDirtyRanges&)>& func)
+{
+	func(m_chartData, m_dirtyRanges);
+}
+
+kson::ChartEditor::SubscriptionId kson::ChartEditor::subscribe(Subscriber subscriber)
+{
+	const SubscriptionId id = m_nextSubscriptionId++;
+	m_subscribers.emplace_back(id, std::move(subscriber));
+	return id;
+}
+
+void kson::ChartEditor::unsubscribe(SubscriptionId id)
+{
+	std::erase_if(m_subscribers, [id](const auto& pair) { return pair.first == id; });
+}
+
+void kson::ChartEditor::flush()
+{
+	if (m_dirtyRanges.empty())
+	{
+		return;
+	}
+
+	// Modifications and subscription changes made by the subscribers are handled in the next flush
+	const ChartDirtyRanges dirtyRanges = std::move(m_dirtyRanges);
+	m_dirtyRanges.clear();
+
+	const auto subscribers = m_subscribers;
+	for (const auto& [id, subscriber] : subscribers)
+	{
+		subscriber(m_chartData, dirtyRanges);
+	}
+}
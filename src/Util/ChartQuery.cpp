@@ -0,0 +1,861 @@
+#include "kson/Util/ChartQuery.hpp"
+#include "kson/Util/TimingUtils.hpp"
+#include <charconv>
+#include <span>
+
+namespace
+{
+	using namespace kson;
+
+	using ValueType = ChartQueryValueType;
+
+	// Derived data shared by the fields of one evaluation
+	class EvalContext
+	{
+	private:
+		mutable std::optional<TimingCache> m_timingCache;
+
+	public:
+		const ChartData& chartData;
+
+		explicit EvalContext(const ChartData& chartData)
+			: chartData(chartData)
+		{
+		}
+
+		[[nodiscard]]
+		bool hasTiming() const
+		{
+			return chartData.beat.bpm.contains(0) && chartData.beat.timeSig.contains(0);
+		}
+
+		[[nodiscard]]
+		const TimingCache& timingCache() const
+		{
+			if (!m_timingCache.has_value())
+			{
+				m_timingCache = CreateTimingCache(chartData.beat);
+			}
+			return *m_timingCache;
+		}
+	};
+
+	struct Field
+	{
+		std::string_view name;
+		ValueType type;
+		ChartQueryValue (*func)(const EvalContext& ctx);
+	};
+
+	struct Function
+	{
+		std::string_view name;
+		std::vector<ValueType> paramTypes;
+		ValueType type;
+		ChartQueryValue (*func)(const EvalContext& ctx, std::span<const ChartQueryValue> args);
+	};
+
+	template <typename Lanes>
+	std::size_t CountNotes(const Lanes& lanes, bool longNotes)
+	{
+		std::size_t count = 0;
+		for (const auto& lane : lanes)
+		{
+			for (const auto& [y, note] : lane)
+			{
+				if ((note.length > 0) == longNotes)
+				{
+					++count;
+				}
+			}
+		}
+		return count;
+	}
+
+	std::size_t CountLaserSlams(const NoteInfo& note)
+	{
+		std::size_t count = 0;
+		for (const auto& lane : note.laser)
+		{
+			for (const auto& [y, section] : lane)
+			{
+				for (const auto& [ry, point] : section.v)
+				{
+					if (point.v.v != point.v.vf)
+					{
+						++count;
+					}
+				}
+			}
+		}
+		return count;
+	}
+
+	bool HasWideLaser(const NoteInfo& note)
+	{
+		for (const auto& lane : note.laser)
+		{
+			for (const auto& [y, section] : lane)
+			{
+				if (section.wide())
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	double MinBPM(const BeatInfo& beat)
+	{
+		if (beat.bpm.empty())
+		{
+			return 0.0;
+		}
+		return std::min_element(beat.bpm.begin(), beat.bpm.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second;
+	}
+
+	double MaxBPM(const BeatInfo& beat)
+	{
+		if (beat.bpm.empty())
+		{
+			return 0.0;
+		}
+		return std::max_element(beat.bpm.begin(), beat.bpm.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second;
+	}
+
+	bool DefinesAudioEffectType(const std::vector<AudioEffectDefKVP>& defs, std::string_view typeStr)
+	{
+		const AudioEffectType type = StrToAudioEffectType(typeStr);
+		if (type == AudioEffectType::Unspecified)
+		{
+			return false;
+		}
+		return std::any_of(defs.begin(), defs.end(), [type](const AudioEffectDefKVP& def) { return def.v.type == type; });
+	}
+
+	template <typename T>
+	double Num(T value)
+	{
+		return static_cast<double>(value);
+	}
+
+	const std::string& Str(const ChartQueryValue& value)
+	{
+		return std::get<std::string>(value);
+	}
+
+	const std::vector<Field> kFields = {
+		{ "title", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.title; } },
+		{ "title_translit", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.titleTranslit; } },
+		{ "artist", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.artist; } },
+		{ "artist_translit", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.artistTranslit; } },
+		{ "chart_author", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.chartAuthor; } },
+		{ "difficulty", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.meta.difficulty.idx); } },
+		{ "difficulty_name", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.difficulty.name; } },
+		{ "level", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.meta.level); } },
+		{ "disp_bpm", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.dispBPM; } },
+		{ "std_bpm", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.stdBPM; } },
+		{ "jacket_filename", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.jacketFilename; } },
+		{ "jacket_author", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.jacketAuthor; } },
+		{ "information", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.meta.information; } },
+		{ "bgm_filename", ValueType::String, [](const EvalContext& ctx) -> ChartQueryValue { return ctx.chartData.audio.bgm.filename; } },
+		{ "gauge_total", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.gauge.total); } },
+		{ "min_bpm", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return MinBPM(ctx.chartData.beat); } },
+		{ "max_bpm", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return MaxBPM(ctx.chartData.beat); } },
+		{ "bpm_change_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.beat.bpm.size()); } },
+		{ "time_sig_change_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.beat.timeSig.size()); } },
+		{ "scroll_speed_change_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.beat.scrollSpeed.size()); } },
+		{ "stop_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.beat.stop.size()); } },
+		{ "tilt_change_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.camera.tilt.size()); } },
+		{ "bt_chip_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(CountNotes(ctx.chartData.note.bt, false)); } },
+		{ "bt_long_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(CountNotes(ctx.chartData.note.bt, true)); } },
+		{ "fx_chip_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(CountNotes(ctx.chartData.note.fx, false)); } },
+		{ "fx_long_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(CountNotes(ctx.chartData.note.fx, true)); } },
+		{ "note_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue
+		{
+			const auto& note = ctx.chartData.note;
+			return Num(CountNotes(note.bt, false) + CountNotes(note.bt, true) + CountNotes(note.fx, false) + CountNotes(note.fx, true));
+		} },
+		{ "laser_section_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue
+		{
+			std::size_t count = 0;
+			for (const auto& lane : ctx.chartData.note.laser)
+			{
+				count += lane.size();
+			}
+			return Num(count);
+		} },
+		{ "laser_slam_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(CountLaserSlams(ctx.chartData.note)); } },
+		{ "has_wide_laser", ValueType::Bool, [](const EvalContext& ctx) -> ChartQueryValue { return HasWideLaser(ctx.chartData.note); } },
+		{ "fx_effect_def_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.audio.audioEffect.fx.def.size()); } },
+		{ "laser_effect_def_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue { return Num(ctx.chartData.audio.audioEffect.laser.def.size()); } },
+		{ "duration_ms", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue
+		{
+			// From the beginning to the end of the last note
+			return ctx.hasTiming() ? PulseToMs(LastNoteEndY(ctx.chartData.note), ctx.chartData.beat, ctx.timingCache()) : 0.0;
+		} },
+		{ "measure_count", ValueType::Number, [](const EvalContext& ctx) -> ChartQueryValue
+		{
+			// Measures up to the one containing the end of the last note
+			return ctx.hasTiming() ? Num(PulseToMeasureIdx(LastNoteEndY(ctx.chartData.note), ctx.chartData.beat, ctx.timingCache()) + 1) : 0.0;
+		} },
+	};
+
+	const std::vector<Function> kFunctions = {
+		{ "contains", { ValueType::String, ValueType::String }, ValueType::Bool, [](const EvalContext&, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			return Str(args[0]).find(Str(args[1])) != std::string::npos;
+		} },
+		{ "starts_with", { ValueType::String, ValueType::String }, ValueType::Bool, [](const EvalContext&, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			return Str(args[0]).starts_with(Str(args[1]));
+		} },
+		{ "ends_with", { ValueType::String, ValueType::String }, ValueType::Bool, [](const EvalContext&, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			return Str(args[0]).ends_with(Str(args[1]));
+		} },
+		{ "defines_fx_type", { ValueType::String }, ValueType::Bool, [](const EvalContext& ctx, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			return DefinesAudioEffectType(ctx.chartData.audio.audioEffect.fx.def, Str(args[0]));
+		} },
+		{ "defines_laser_type", { ValueType::String }, ValueType::Bool, [](const EvalContext& ctx, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			return DefinesAudioEffectType(ctx.chartData.audio.audioEffect.laser.def, Str(args[0]));
+		} },
+		{ "uses_fx_effect", { ValueType::String }, ValueType::Bool, [](const EvalContext& ctx, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			const auto& longEvent = ctx.chartData.audio.audioEffect.fx.longEvent;
+			const auto itr = longEvent.find(Str(args[0]));
+			return itr != longEvent.end() && std::any_of(itr->second.begin(), itr->second.end(), [](const auto& lane) { return !lane.empty(); });
+		} },
+		{ "uses_laser_effect", { ValueType::String }, ValueType::Bool, [](const EvalContext& ctx, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			const auto& pulseEvent = ctx.chartData.audio.audioEffect.laser.pulseEvent;
+			const auto itr = pulseEvent.find(Str(args[0]));
+			return itr != pulseEvent.end() && !itr->second.empty();
+		} },
+		{ "uses_key_sound", { ValueType::String }, ValueType::Bool, [](const EvalContext& ctx, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			const auto& chipEvent = ctx.chartData.audio.keySound.fx.chipEvent;
+			const auto itr = chipEvent.find(Str(args[0]));
+			return itr != chipEvent.end() && std::any_of(itr->second.begin(), itr->second.end(), [](const auto& lane) { return !lane.empty(); });
+		} },
+		{ "bpm_count_above", { ValueType::Number }, ValueType::Number, [](const EvalContext& ctx, std::span<const ChartQueryValue> args) -> ChartQueryValue
+		{
+			const double threshold = std::get<double>(args[0]);
+			const auto& bpm = ctx.chartData.beat.bpm;
+			return Num(std::count_if(bpm.begin(), bpm.end(), [threshold](const auto& kvp) { return kvp.second > threshold; }));
+		} },
+	};
+
+	std::string_view TypeName(ValueType type)
+	{
+		switch (type)
+		{
+		case ValueType::Bool:
+			return "bool";
+		case ValueType::Number:
+			return "number";
+		case ValueType::String:
+			return "string";
+		}
+		return "unknown";
+	}
+
+	enum class TokenKind
+	{
+		End,
+		Identifier,
+		Number,
+		String,
+		Symbol,
+	};
+
+	struct Token
+	{
+		TokenKind kind = TokenKind::End;
+		std::string text; // Unescaped for strings
+		double number = 0.0;
+		std::size_t pos = 0;
+	};
+
+	bool IsIdentifierChar(char c, bool first)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (!first && c >= '0' && c <= '9');
+	}
+
+	class Parser
+	{
+	private:
+		std::string_view m_src;
+		std::size_t m_pos = 0;
+		Token m_token;
+		std::vector<ChartQueryNode> m_nodes;
+		std::string m_error;
+
+		bool fail(std::size_t pos, std::string_view message)
+		{
+			if (m_error.empty())
+			{
+				m_error = std::string(message) + " at position " + std::to_string(pos + 1);
+			}
+			return false;
+		}
+
+		bool next()
+		{
+			while (m_pos < m_src.size() && (m_src[m_pos] == ' ' || m_src[m_pos] == '\t' || m_src[m_pos] == '\r' || m_src[m_pos] == '\n'))
+			{
+				++m_pos;
+			}
+			m_token = Token{ .pos = m_pos };
+			if (m_pos >= m_src.size())
+			{
+				return true;
+			}
+
+			const char c = m_src[m_pos];
+			if (IsIdentifierChar(c, true))
+			{
+				const std::size_t begin = m_pos;
+				while (m_pos < m_src.size() && IsIdentifierChar(m_src[m_pos], false))
+				{
+					++m_pos;
+				}
+				m_token.kind = TokenKind::Identifier;
+				m_token.text = m_src.substr(begin, m_pos - begin);
+				return true;
+			}
+			if ((c >= '0' && c <= '9') || c == '.')
+			{
+				const char* begin = m_src.data() + m_pos;
+				const auto [ptr, ec] = std::from_chars(begin, m_src.data() + m_src.size(), m_token.number);
+				if (ec != std::errc{})
+				{
+					return fail(m_pos, "Invalid number");
+				}
+				m_pos += static_cast<std::size_t>(ptr - begin);
+				m_token.kind = TokenKind::Number;
+				return true;
+			}
+			if (c == '"' || c == '\'')
+			{
+				const std::size_t begin = m_pos++;
+				while (m_pos < m_src.size() && m_src[m_pos] != c)
+				{
+					if (m_src[m_pos] == '\\' && m_pos + 1 < m_src.size())
+					{
+						++m_pos;
+					}
+					m_token.text += m_src[m_pos++];
+				}
+				if (m_pos >= m_src.size())
+				{
+					return fail(begin, "Unterminated string");
+				}
+				++m_pos;
+				m_token.kind = TokenKind::String;
+				return true;
+			}
+
+			for (const std::string_view symbol : { "&&", "||", "==", "!=", "<=", ">=", "(", ")", ",", "!", "<", ">", "+", "-", "*", "/" })
+			{
+				if (m_src.substr(m_pos).starts_with(symbol))
+				{
+					m_pos += symbol.size();
+					m_token.kind = TokenKind::Symbol;
+					m_token.text = symbol;
+					return true;
+				}
+			}
+			return fail(m_pos, "Unexpected character '" + std::string(1, c) + "'");
+		}
+
+		[[nodiscard]]
+		bool isSymbol(std::string_view symbol) const
+		{
+			return m_token.kind == TokenKind::Symbol && m_token.text == symbol;
+		}
+
+		[[nodiscard]]
+		bool isKeyword(std::string_view keyword) const
+		{
+			return m_token.kind == TokenKind::Identifier && m_token.text == keyword;
+		}
+
+		std::size_t addNode(ChartQueryNode&& node)
+		{
+			m_nodes.push_back(std::move(node));
+			return m_nodes.size() - 1;
+		}
+
+		[[nodiscard]]
+		ValueType typeOf(std::size_t idx) const
+		{
+			return m_nodes[idx].type;
+		}
+
+		bool parseBinary(ChartQueryOp op, std::size_t lhs, std::size_t rhs, std::size_t pos, std::size_t* pIdx)
+		{
+			const ValueType lhsType = typeOf(lhs);
+			const ValueType rhsType = typeOf(rhs);
+			ValueType type = ValueType::Bool;
+			switch (op)
+			{
+			case ChartQueryOp::And:
+			case ChartQueryOp::Or:
+				break;
+
+			case ChartQueryOp::Equal:
+			case ChartQueryOp::NotEqual:
+				if (lhsType != rhsType)
+				{
+					return fail(pos, "Cannot compare " + std::string(TypeName(lhsType)) + " with " + std::string(TypeName(rhsType)));
+				}
+				break;
+
+			case ChartQueryOp::Less:
+			case ChartQueryOp::LessEqual:
+			case ChartQueryOp::Greater:
+			case ChartQueryOp::GreaterEqual:
+				if (lhsType != rhsType || lhsType == ValueType::Bool)
+				{
+					return fail(pos, "Cannot compare " + std::string(TypeName(lhsType)) + " with " + std::string(TypeName(rhsType)));
+				}
+				break;
+
+			default:
+				if (lhsType != ValueType::Number || rhsType != ValueType::Number)
+				{
+					return fail(pos, "Arithmetic operators require numbers");
+				}
+				type = ValueType::Number;
+				break;
+			}
+			*pIdx = addNode({ .op = op, .type = type, .args = { lhs, rhs } });
+			return true;
+		}
+
+		bool parseOr(std::size_t* pIdx)
+		{
+			if (!parseAnd(pIdx))
+			{
+				return false;
+			}
+			while (isSymbol("||") || isKeyword("or"))
+			{
+				const std::size_t pos = m_token.pos;
+				std::size_t rhs;
+				if (!next() || !parseAnd(&rhs) || !parseBinary(ChartQueryOp::Or, *pIdx, rhs, pos, pIdx))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool parseAnd(std::size_t* pIdx)
+		{
+			if (!parseNot(pIdx))
+			{
+				return false;
+			}
+			while (isSymbol("&&") || isKeyword("and"))
+			{
+				const std::size_t pos = m_token.pos;
+				std::size_t rhs;
+				if (!next() || !parseNot(&rhs) || !parseBinary(ChartQueryOp::And, *pIdx, rhs, pos, pIdx))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool parseNot(std::size_t* pIdx)
+		{
+			if (isSymbol("!") || isKeyword("not"))
+			{
+				std::size_t operand;
+				if (!next() || !parseNot(&operand))
+				{
+					return false;
+				}
+				*pIdx = addNode({ .op = ChartQueryOp::Not, .type = ValueType::Bool, .args = { operand } });
+				return true;
+			}
+			return parseComparison(pIdx);
+		}
+
+		bool parseComparison(std::size_t* pIdx)
+		{
+			if (!parseAdditive(pIdx))
+			{
+				return false;
+			}
+
+			static const std::array<std::pair<std::string_view, ChartQueryOp>, 6> kComparisonOps = { {
+				{ "==", ChartQueryOp::Equal },
+				{ "!=", ChartQueryOp::NotEqual },
+				{ "<", ChartQueryOp::Less },
+				{ "<=", ChartQueryOp::LessEqual },
+				{ ">", ChartQueryOp::Greater },
+				{ ">=", ChartQueryOp::GreaterEqual },
+			} };
+			for (const auto& [symbol, op] : kComparisonOps)
+			{
+				if (isSymbol(symbol))
+				{
+					const std::size_t pos = m_token.pos;
+					std::size_t rhs;
+					return next() && parseAdditive(&rhs) && parseBinary(op, *pIdx, rhs, pos, pIdx);
+				}
+			}
+			return true;
+		}
+
+		bool parseAdditive(std::size_t* pIdx)
+		{
+			if (!parseMultiplicative(pIdx))
+			{
+				return false;
+			}
+			while (isSymbol("+") || isSymbol("-"))
+			{
+				const ChartQueryOp op = isSymbol("+") ? ChartQueryOp::Add : ChartQueryOp::Subtract;
+				const std::size_t pos = m_token.pos;
+				std::size_t rhs;
+				if (!next() || !parseMultiplicative(&rhs) || !parseBinary(op, *pIdx, rhs, pos, pIdx))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool parseMultiplicative(std::size_t* pIdx)
+		{
+			if (!parseUnary(pIdx))
+			{
+				return false;
+			}
+			while (isSymbol("*") || isSymbol("/"))
+			{
+				const ChartQueryOp op = isSymbol("*") ? ChartQueryOp::Multiply : ChartQueryOp::Divide;
+				const std::size_t pos = m_token.pos;
+				std::size_t rhs;
+				if (!next() || !parseUnary(&rhs) || !parseBinary(op, *pIdx, rhs, pos, pIdx))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool parseUnary(std::size_t* pIdx)
+		{
+			if (isSymbol("-"))
+			{
+				const std::size_t pos = m_token.pos;
+				std::size_t operand;
+				if (!next() || !parseUnary(&operand))
+				{
+					return false;
+				}
+				if (typeOf(operand) != ValueType::Number)
+				{
+					return fail(pos, "Unary minus requires a number");
+				}
+				*pIdx = addNode({ .op = ChartQueryOp::Negate, .type = ValueType::Number, .args = { operand } });
+				return true;
+			}
+			return parsePrimary(pIdx);
+		}
+
+		bool parseCall(std::size_t funcIdx, std::size_t pos, std::size_t* pIdx)
+		{
+			const Function& func = kFunctions[funcIdx];
+			std::vector<std::size_t> args;
+			if (!next()) // Skip '('
+			{
+				return false;
+			}
+			while (!isSymbol(")"))
+			{
+				if (!args.empty() && (!isSymbol(",") || !next()))
+				{
+					return fail(m_token.pos, "Expected ',' or ')'");
+				}
+				std::size_t arg;
+				if (!parseOr(&arg))
+				{
+					return false;
+				}
+				args.push_back(arg);
+			}
+			if (args.size() != func.paramTypes.size())
+			{
+				return fail(pos, std::string(func.name) + "() takes " + std::to_string(func.paramTypes.size()) + " argument(s)");
+			}
+			for (std::size_t i = 0; i < args.size(); ++i)
+			{
+				if (typeOf(args[i]) != func.paramTypes[i])
+				{
+					return fail(pos, "Argument " + std::to_string(i + 1) + " of " + std::string(func.name) + "() must be " + std::string(TypeName(func.paramTypes[i])));
+				}
+			}
+			*pIdx = addNode({ .op = ChartQueryOp::Function, .type = func.type, .idx = funcIdx, .args = std::move(args) });
+			return next(); // Skip ')'
+		}
+
+		bool parsePrimary(std::size_t* pIdx)
+		{
+			const std::size_t pos = m_token.pos;
+			switch (m_token.kind)
+			{
+			case TokenKind::Number:
+				*pIdx = addNode({ .op = ChartQueryOp::Literal, .type = ValueType::Number, .literal = m_token.number });
+				return next();
+
+			case TokenKind::String:
+				*pIdx = addNode({ .op = ChartQueryOp::Literal, .type = ValueType::String, .literal = m_token.text });
+				return next();
+
+			case TokenKind::Identifier:
+			{
+				if (m_token.text == "true" || m_token.text == "false")
+				{
+					*pIdx = addNode({ .op = ChartQueryOp::Literal, .type = ValueType::Bool, .literal = m_token.text == "true" });
+					return next();
+				}
+
+				const std::string name = m_token.text;
+				if (!next())
+				{
+					return false;
+				}
+				if (isSymbol("("))
+				{
+					const auto itr = std::find_if(kFunctions.begin(), kFunctions.end(), [&name](const Function& func) { return func.name == name; });
+					if (itr == kFunctions.end())
+					{
+						return fail(pos, "Unknown function '" + name + "'");
+					}
+					return parseCall(static_cast<std::size_t>(itr - kFunctions.begin()), pos, pIdx);
+				}
+
+				const auto itr = std::find_if(kFields.begin(), kFields.end(), [&name](const Field& field) { return field.name == name; });
+				if (itr == kFields.end())
+				{
+					return fail(pos, "Unknown field '" + name + "'");
+				}
+				*pIdx = addNode({ .op = ChartQueryOp::Field, .type = itr->type, .idx = static_cast<std::size_t>(itr - kFields.begin()) });
+				return true;
+			}
+
+			case TokenKind::Symbol:
+				if (isSymbol("("))
+				{
+					if (!next() || !parseOr(pIdx))
+					{
+						return false;
+					}
+					if (!isSymbol(")"))
+					{
+						return fail(m_token.pos, "Expected ')'");
+					}
+					return next();
+				}
+				break;
+
+			case TokenKind::End:
+				return fail(pos, "Unexpected end of expression");
+			}
+			return fail(pos, "Unexpected '" + m_token.text + "'");
+		}
+
+	public:
+		explicit Parser(std::string_view src)
+			: m_src(src)
+		{
+		}
+
+		std::optional<std::vector<ChartQueryNode>> parse(std::string* pErrorMessage)
+		{
+			std::size_t root;
+			if (next() && parseOr(&root))
+			{
+				if (m_token.kind == TokenKind::End)
+				{
+					// The root must be the last node
+					assert(root == m_nodes.size() - 1);
+					return std::move(m_nodes);
+				}
+				fail(m_token.pos, "Unexpected '" + m_token.text + "'");
+			}
+			if (pErrorMessage != nullptr)
+			{
+				*pErrorMessage = m_error;
+			}
+			return std::nullopt;
+		}
+	};
+
+	bool IsTruthy(const ChartQueryValue& value)
+	{
+		if (const bool* pBool = std::get_if<bool>(&value))
+		{
+			return *pBool;
+		}
+		if (const double* pNumber = std::get_if<double>(&value))
+		{
+			return *pNumber != 0.0;
+		}
+		return !std::get<std::string>(value).empty();
+	}
+
+	ChartQueryValue Evaluate(const std::vector<ChartQueryNode>& nodes, std::size_t idx, const EvalContext& ctx)
+	{
+		const ChartQueryNode& node = nodes[idx];
+		const auto arg = [&](std::size_t i) { return Evaluate(nodes, node.args[i], ctx); };
+		const auto num = [&](std::size_t i) { return std::get<double>(arg(i)); };
+		switch (node.op)
+		{
+		case ChartQueryOp::Literal:
+			return node.literal;
+
+		case ChartQueryOp::Field:
+			return kFields[node.idx].func(ctx);
+
+		case ChartQueryOp::Function:
+		{
+			std::vector<ChartQueryValue> args;
+			args.reserve(node.args.size());
+			for (std::size_t i = 0; i < node.args.size(); ++i)
+			{
+				args.push_back(arg(i));
+			}
+			return kFunctions[node.idx].func(ctx, args);
+		}
+
+		case ChartQueryOp::Not:
+			return !IsTruthy(arg(0));
+
+		case ChartQueryOp::Negate:
+			return -num(0);
+
+		case ChartQueryOp::And:
+			return IsTruthy(arg(0)) && IsTruthy(arg(1));
+
+		case ChartQueryOp::Or:
+			return IsTruthy(arg(0)) || IsTruthy(arg(1));
+
+		case ChartQueryOp::Equal:
+			return arg(0) == arg(1);
+
+		case ChartQueryOp::NotEqual:
+			return arg(0) != arg(1);
+
+		case ChartQueryOp::Less:
+			return arg(0) < arg(1);
+
+		case ChartQueryOp::LessEqual:
+			return arg(0) <= arg(1);
+
+		case ChartQueryOp::Greater:
+			return arg(0) > arg(1);
+
+		case ChartQueryOp::GreaterEqual:
+			return arg(0) >= arg(1);
+
+		case ChartQueryOp::Add:
+			return num(0) + num(1);
+
+		case ChartQueryOp::Subtract:
+			return num(0) - num(1);
+
+		case ChartQueryOp::Multiply:
+			return num(0) * num(1);
+
+		case ChartQueryOp::Divide:
+		{
+			// Division by zero yields 0 so that ratios of empty charts do not match everything
+			const double divisor = num(1);
+			return divisor == 0.0 ? 0.0 : num(0) / divisor;
+		}
+		}
+		assert(false && "unknown ChartQueryOp");
+		return false;
+	}
+}
+
+kson::ChartQuery::ChartQuery(std::vector<ChartQueryNode>&& nodes)
+	: m_nodes(std::move(nodes))
+{
+	assert(!m_nodes.empty());
+}
+
+kson::ChartQueryValueType kson::ChartQuery::type() const
+{
+	return m_nodes.back().type;
+}
+
+kson::ChartQueryValue kson::ChartQuery::evaluate(const ChartData& chartData) const
+{
+	const EvalContext ctx(chartData);
+	return Evaluate(m_nodes, m_nodes.size() - 1, ctx);
+}
+
+bool kson::ChartQuery::matches(const ChartData& chartData) const
+{
+	return IsTruthy(evaluate(chartData));
+}
+
+std::optional<kson::ChartQuery> kson::ParseChartQuery(std::string_view expression, std::string* pErrorMessage)
+{
+	Parser parser(expression);
+	auto nodes = parser.parse(pErrorMessage);
+	if (!nodes.has_value())
+	{
+		return std::nullopt;
+	}
+	return ChartQuery(std::move(*nodes));
+}
+
+std::vector<std::string_view> kson::ChartQueryFieldNames()
+{
+	std::vector<std::string_view> names;
+	names.reserve(kFields.size());
+	for (const Field& field : kFields)
+	{
+		names.push_back(field.name);
+	}
+	return names;
+}
+
+std::vector<std::string_view> kson::ChartQueryFunctionNames()
+{
+	std::vector<std::string_view> names;
+	names.reserve(kFunctions.size());
+	for (const Function& func : kFunctions)
+	{
+		names.push_back(func.name);
+	}
+	return names;
+}
+
+std::string kson::ChartQueryValueToString(const ChartQueryValue& value)
+{
+	if (const bool* pBool = std::get_if<bool>(&value))
+	{
+		return *pBool ? "true" : "false";
+	}
+	if (const double* pNumber = std::get_if<double>(&value))
+	{
+		char buf[32];
+		const auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), *pNumber);
+		return ec == std::errc{} ? std::string(buf, ptr) : std::string{};
+	}
+	return std::get<std::string>(value);
+}
@@ -0,0 +1,369 @@
+#include "kson/Util/ChartThumbnail.hpp"
+#include "kson/Util/GraphCurve.hpp"
+#include "kson/Util/TimingUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+	using namespace kson;
+
+	// Chips are drawn with at least this fraction of the height so that they remain visible in long charts
+	constexpr std::int32_t kChipHeightDivisor = 256;
+
+	// Lasers are drawn with this fraction of the lane area width
+	constexpr std::int32_t kLaserThicknessDivisor = 24;
+
+	class Canvas
+	{
+	private:
+		ChartThumbnail& m_thumbnail;
+
+		Pulse m_lengthPulse;
+
+	public:
+		Canvas(ChartThumbnail& thumbnail, Pulse lengthPulse)
+			: m_thumbnail(thumbnail)
+			, m_lengthPulse(lengthPulse)
+		{
+		}
+
+		// Row of the pulse (the chart start is at the bottom row)
+		[[nodiscard]]
+		std::int32_t rowOf(Pulse pulse) const
+		{
+			const std::int64_t height = m_thumbnail.height;
+			const std::int64_t row = height - 1 - pulse * height / m_lengthPulse;
+			return static_cast<std::int32_t>(std::clamp<std::int64_t>(row, 0, height - 1));
+		}
+
+		// Fills the pixels in columns [x0, x1) and rows [row0, row1] (both clamped to the image)
+		void fillRect(std::int32_t x0, std::int32_t x1, std::int32_t row0, std::int32_t row1, const ThumbnailColor& color)
+		{
+			x0 = std::max(x0, 0);
+			x1 = std::min(x1, m_thumbnail.width);
+			row0 = std::max(row0, 0);
+			row1 = std::min(row1, m_thumbnail.height - 1);
+			for (std::int32_t row = row0; row <= row1; ++row)
+			{
+				std::uint8_t* pPixel = m_thumbnail.pixels.data() + (static_cast<std::size_t>(row) * static_cast<std::size_t>(m_thumbnail.width) + static_cast<std::size_t>(x0)) * 4;
+				for (std::int32_t x = x0; x < x1; ++x, pPixel += 4)
+				{
+					Blend(pPixel, color);
+				}
+			}
+		}
+
+		static void Blend(std::uint8_t* pPixel, const ThumbnailColor& color)
+		{
+			if (color.a == 255)
+			{
+				pPixel[0] = color.r;
+				pPixel[1] = color.g;
+				pPixel[2] = color.b;
+				pPixel[3] = 255;
+				return;
+			}
+
+			// Source-over with 8-bit alpha
+			const std::uint32_t a = color.a;
+			const std::uint32_t invA = 255 - a;
+			pPixel[0] = static_cast<std::uint8_t>((color.r * a + pPixel[0] * invA + 127) / 255);
+			pPixel[1] = static_cast<std::uint8_t>((color.g * a + pPixel[1] * invA + 127) / 255);
+			pPixel[2] = static_cast<std::uint8_t>((color.b * a + pPixel[2] * invA + 127) / 255);
+			pPixel[3] = static_cast<std::uint8_t>(a + (pPixel[3] * invA + 127) / 255);
+		}
+	};
+
+	ThumbnailColor LerpColor(const ThumbnailColor& color1, const ThumbnailColor& color2, double rate)
+	{
+		const auto lerpChannel = [rate](std::uint8_t c1, std::uint8_t c2)
+		{
+			return static_cast<std::uint8_t>(std::lround(std::lerp(static_cast<double>(c1), static_cast<double>(c2), rate)));
+		};
+		return {
+			.r = lerpChannel(color1.r, color2.r),
+			.g = lerpChannel(color1.g, color2.g),
+			.b = lerpChannel(color1.b, color2.b),
+			.a = lerpChannel(color1.a, color2.a),
+		};
+	}
+
+	void DrawBarLines(Canvas& canvas, const BeatInfo& beat, Pulse lengthPulse, std::int32_t x0, std::int32_t x1, const ThumbnailColor& color)
+	{
+		TimeSig timeSig;
+		auto timeSigItr = beat.timeSig.begin();
+		Pulse pulse = 0;
+		for (std::int64_t measureIdx = 0; pulse < lengthPulse; ++measureIdx)
+		{
+			while (timeSigItr != beat.timeSig.end() && timeSigItr->first <= measureIdx)
+			{
+				timeSig = timeSigItr->second;
+				++timeSigItr;
+			}
+			const Pulse measurePulse = TimeSigOneMeasurePulse(timeSig);
+			if (measurePulse <= 0)
+			{
+				break;
+			}
+
+			const std::int32_t row = canvas.rowOf(pulse);
+			canvas.fillRect(x0, x1, row, row, color);
+			pulse += measurePulse;
+		}
+	}
+
+	void DrawBPMGutter(Canvas& canvas, const ByPulse<double>& bpm, Pulse lengthPulse, std::int32_t gutterWidth, const ChartThumbnailParams& params)
+	{
+		if (bpm.empty() || gutterWidth <= 0)
+		{
+			return;
+		}
+
+		const auto [minItr, maxItr] = std::minmax_element(bpm.begin(), bpm.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+		const double minBPM = minItr->second;
+		const double bpmRange = maxItr->second - minBPM;
+		for (auto itr = bpm.begin(); itr != bpm.end(); ++itr)
+		{
+			const auto nextItr = std::next(itr);
+			const Pulse endPulse = nextItr != bpm.end() ? nextItr->first : lengthPulse;
+			const double rate = bpmRange > 0.0 ? (itr->second - minBPM) / bpmRange : 0.5;
+			canvas.fillRect(0, gutterWidth, canvas.rowOf(endPulse), canvas.rowOf(itr->first), LerpColor(params.lowBPMColor, params.highBPMColor, rate));
+			if (itr->first > 0)
+			{
+				const std::int32_t row = canvas.rowOf(itr->first);
+				canvas.fillRect(0, gutterWidth, row, row, params.bpmChangeColor);
+			}
+		}
+	}
+
+	void DrawButtonLane(Canvas& canvas, const ByPulse<Interval>& lane, std::int32_t x0, std::int32_t x1, std::int32_t chipHeight, const ThumbnailColor& chipColor, const ThumbnailColor& longColor)
+	{
+		for (const auto& [y, note] : lane)
+		{
+			const std::int32_t row = canvas.rowOf(y);
+			if (note.length > 0)
+			{
+				canvas.fillRect(x0, x1, canvas.rowOf(y + note.length), row, longColor);
+			}
+			else
+			{
+				canvas.fillRect(x0, x1, row - chipHeight + 1, row, chipColor);
+			}
+		}
+	}
+
+	class LaserPainter
+	{
+	private:
+		Canvas& m_canvas;
+		std::int32_t m_laneLeft;
+		std::int32_t m_laneWidth;
+		std::int32_t m_thickness;
+		ThumbnailColor m_color;
+
+		[[nodiscard]]
+		std::int32_t columnOf(double v, bool wide) const
+		{
+			const double x = wide ? (v - 0.5) * 2 + 0.5 : v;
+			return m_laneLeft + static_cast<std::int32_t>(std::lround(std::clamp(x, 0.0, 1.0) * static_cast<double>(m_laneWidth - m_thickness)));
+		}
+
+		void drawSpan(std::int32_t row, std::int32_t column1, std::int32_t column2)
+		{
+			m_canvas.fillRect(std::min(column1, column2), std::max(column1, column2) + m_thickness, row, row, m_color);
+		}
+
+	public:
+		LaserPainter(Canvas& canvas, std::int32_t laneLeft, std::int32_t laneWidth, const ThumbnailColor& color)
+			: m_canvas(canvas)
+			, m_laneLeft(laneLeft)
+			, m_laneWidth(laneWidth)
+			, m_thickness(std::clamp(laneWidth / kLaserThicknessDivisor, 1, laneWidth))
+			, m_color(color)
+		{
+		}
+
+		// Draws a straight segment as one horizontal span per row, so that it stays connected even when it is nearly horizontal
+		void drawSegment(Pulse y0, double v0, Pulse y1, double v1, bool wide)
+		{
+			const std::int32_t row0 = m_canvas.rowOf(y0);
+			const std::int32_t row1 = m_canvas.rowOf(y1);
+			const std::int32_t column0 = columnOf(v0, wide);
+			const std::int32_t column1 = columnOf(v1, wide);
+			const std::int32_t numRows = row0 - row1;
+			std::int32_t prevColumn = column0;
+			for (std::int32_t i = 0; i <= numRows; ++i)
+			{
+				const std::int32_t column = numRows > 0 ? column0 + (column1 - column0) * i / numRows : column1;
+				drawSpan(row0 - i, prevColumn, column);
+				prevColumn = column;
+			}
+		}
+
+		void drawSlam(Pulse y, double v, double vf, bool wide)
+		{
+			drawSpan(m_canvas.rowOf(y), columnOf(v, wide), columnOf(vf, wide));
+		}
+
+		void drawSection(Pulse y, const LaserSection& section)
+		{
+			const bool wide = section.wide();
+			for (auto itr = section.v.begin(); itr != section.v.end(); ++itr)
+			{
+				const auto& [ry, point] = *itr;
+				if (point.v.v != point.v.vf)
+				{
+					drawSlam(y + ry, point.v.v, point.v.vf, wide);
+				}
+
+				const auto nextItr = std::next(itr);
+				if (nextItr != section.v.end())
+				{
+					drawSegment(y + ry, point.v.vf, y + nextItr->first, nextItr->second.v.v, wide);
+				}
+			}
+		}
+	};
+
+	ErrorType SaveToFile(const std::string& filePath, const ChartThumbnail& thumbnail, ErrorType (*saveFunc)(std::ostream&, const ChartThumbnail&))
+	{
+		std::ofstream ofs(filePath, std::ios_base::binary);
+		if (!ofs)
+		{
+			return ErrorType::CouldNotOpenOutputFileStream;
+		}
+		return saveFunc(ofs, thumbnail);
+	}
+
+	bool IsValidThumbnail(const ChartThumbnail& thumbnail)
+	{
+		return thumbnail.width > 0 && thumbnail.height > 0 &&
+			thumbnail.pixels.size() == static_cast<std::size_t>(thumbnail.width) * static_cast<std::size_t>(thumbnail.height) * 4;
+	}
+}
+
+void kson::RenderChartThumbnail(const ChartData& chartData, const ChartThumbnailParams& params, ChartThumbnail* pThumbnail)
+{
+	ChartThumbnail& thumbnail = *pThumbnail;
+	thumbnail.error = chartData.error;
+	if (params.width <= 0 || params.height <= 0)
+	{
+		thumbnail.width = 0;
+		thumbnail.height = 0;
+		thumbnail.pixels.clear();
+		return;
+	}
+	thumbnail.width = params.width;
+	thumbnail.height = params.height;
+	thumbnail.pixels.resize(static_cast<std::size_t>(params.width) * static_cast<std::size_t>(params.height) * 4);
+	for (std::size_t i = 0; i < thumbnail.pixels.size(); i += 4)
+	{
+		thumbnail.pixels[i] = params.backgroundColor.r;
+		thumbnail.pixels[i + 1] = params.backgroundColor.g;
+		thumbnail.pixels[i + 2] = params.backgroundColor.b;
+		thumbnail.pixels[i + 3] = params.backgroundColor.a;
+	}
+
+	const NoteInfo& note = chartData.note;
+	const Pulse lengthPulse = std::max(LastNoteEndY(note), kResolution4);
+	Canvas canvas(thumbnail, lengthPulse);
+
+	const std::int32_t gutterWidth = std::clamp(params.bpmGutterWidth, 0, params.width);
+	const std::int32_t laneLeft = gutterWidth;
+	const std::int32_t laneWidth = params.width - gutterWidth;
+	DrawBPMGutter(canvas, chartData.beat.bpm, lengthPulse, gutterWidth, params);
+	if (laneWidth <= 0)
+	{
+		return;
+	}
+	DrawBarLines(canvas, chartData.beat, lengthPulse, laneLeft, params.width, params.barLineColor);
+
+	// Buttons (a one-pixel gap is left between lanes where they are wide enough)
+	const std::int32_t chipHeight = std::max(params.height / kChipHeightDivisor, 1);
+	for (std::size_t i = 0; i < kNumFXLanesSZ; ++i)
+	{
+		const std::int32_t x0 = laneLeft + laneWidth * static_cast<std::int32_t>(i) / kNumFXLanes;
+		const std::int32_t x1 = laneLeft + laneWidth * static_cast<std::int32_t>(i + 1) / kNumFXLanes;
+		DrawButtonLane(canvas, note.fx[i], x0, x1 - (x1 - x0 >= 3 ? 1 : 0), chipHeight, params.fxChipColor, params.fxLongColor);
+	}
+	for (std::size_t i = 0; i < kNumBTLanesSZ; ++i)
+	{
+		const std::int32_t x0 = laneLeft + laneWidth * static_cast<std::int32_t>(i) / kNumBTLanes;
+		const std::int32_t x1 = laneLeft + laneWidth * static_cast<std::int32_t>(i + 1) / kNumBTLanes;
+		DrawButtonLane(canvas, note.bt[i], x0, x1 - (x1 - x0 >= 3 ? 1 : 0), chipHeight, params.btChipColor, params.btLongColor);
+	}
+
+	// Lasers (curves are subdivided at about one pulse interval per row)
+	const RelPulse curveSubdivisionInterval = std::max(lengthPulse / params.height, RelPulse{ 1 });
+	for (std::size_t i = 0; i < kNumLaserLanesSZ; ++i)
+	{
+		LaserPainter painter(canvas, laneLeft, laneWidth, params.laserColors[i]);
+		for (const auto& [y, section] : note.laser[i])
+		{
+			const bool hasCurve = std::any_of(section.v.begin(), section.v.end(), [](const auto& pair) { return !pair.second.curve.isLinear(); });
+			if (hasCurve)
+			{
+				if (const std::optional<LaserSection> expandedSection = TryExpandCurveSegments(section, curveSubdivisionInterval))
+				{
+					painter.drawSection(y, *expandedSection);
+					continue;
+				}
+			}
+			painter.drawSection(y, section);
+		}
+	}
+}
+
+kson::ChartThumbnail kson::CreateChartThumbnail(const ChartData& chartData, const ChartThumbnailParams& params)
+{
+	ChartThumbnail thumbnail;
+	RenderChartThumbnail(chartData, params, &thumbnail);
+	return thumbnail;
+}
+
+kson::ErrorType kson::SaveChartThumbnailPPM(std::ostream& stream, const ChartThumbnail& thumbnail)
+{
+	if (!IsValidThumbnail(thumbnail))
+	{
+		return ErrorType::GeneralIOError;
+	}
+
+	stream << "P6\n" << thumbnail.width << ' ' << thumbnail.height << "\n255\n";
+	std::vector<char> row(static_cast<std::size_t>(thumbnail.width) * 3);
+	for (std::size_t rowIdx = 0; rowIdx < static_cast<std::size_t>(thumbnail.height); ++rowIdx)
+	{
+		const std::uint8_t* pPixel = thumbnail.pixels.data() + rowIdx * static_cast<std::size_t>(thumbnail.width) * 4;
+		for (std::size_t x = 0; x < static_cast<std::size_t>(thumbnail.width); ++x, pPixel += 4)
+		{
+			row[x * 3] = static_cast<char>(pPixel[0]);
+			row[x * 3 + 1] = static_cast<char>(pPixel[1]);
+			row[x * 3 + 2] = static_cast<char>(pPixel[2]);
+		}
+		stream.write(row.data(), static_cast<std::streamsize>(row.size()));
+	}
+	return stream.good() ? ErrorType::None : ErrorType::GeneralIOError;
+}
+
+kson::ErrorType kson::SaveChartThumbnailPPM(const std::string& filePath, const ChartThumbnail& thumbnail)
+{
+	return SaveToFile(filePath, thumbnail, &SaveChartThumbnailPPM);
+}
+
+kson::ErrorType kson::SaveChartThumbnailPAM(std::ostream& stream, const ChartThumbnail& thumbnail)
+{
+	if (!IsValidThumbnail(thumbnail))
+	{
+		return ErrorType::GeneralIOError;
+	}
+
+	stream << "P7\nWIDTH " << thumbnail.width << "\nHEIGHT " << thumbnail.height << "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+	stream.write(reinterpret_cast<const char*>(thumbnail.pixels.data()), static_cast<std::streamsize>(thumbnail.pixels.size()));
+	return stream.good() ? ErrorType::None : ErrorType::GeneralIOError;
+}
+
+kson::ErrorType kson::SaveChartThumbnailPAM(const std::string& filePath, const ChartThumbnail& thumbnail)
+{
+	return SaveToFile(filePath, thumbnail, &SaveChartThumbnailPAM);
+}
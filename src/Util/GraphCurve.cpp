@@ -1,10 +1,25 @@
 #include "kson/Util/GraphCurve.hpp"
 #include "kson/Note/NoteInfo.hpp"
+#include "kson/Simd/SimdDispatch.hpp"
 #include <cmath>
 #include <algorithm>
 
 namespace kson
 {
+	namespace
+	{
+		// Curve values at ry = subdivisionInterval, 2 * subdivisionInterval, ... (< segmentLength), evaluated in a batch
+		void EvaluateSubdivisionCurveValues(const GraphCurveValue& curve, RelPulse segmentLength, RelPulse subdivisionInterval, std::vector<double>* pValues)
+		{
+			pValues->clear();
+			for (RelPulse ry = subdivisionInterval; ry < segmentLength; ry += subdivisionInterval)
+			{
+				pValues->push_back(static_cast<double>(ry) / static_cast<double>(segmentLength));
+			}
+			Simd::EvaluateCurves(curve.a, curve.b, pValues->data(), pValues->data(), pValues->size());
+		}
+	}
+
 	double EvaluateCurve(double a, double b, double x)
 	{
 		// Quadratic bezier curve evaluation
@@ -46,10 +61,20 @@ namespace kson
 	}
 
 	Graph ExpandCurveSegments(const Graph& graph, Pulse subdivisionInterval)
+	{
+		std::optional<Graph> result = TryExpandCurveSegments(graph, subdivisionInterval);
+		if (!result.has_value())
+		{
+			KSON_THROW(std::invalid_argument("subdivisionInterval must be positive"));
+		}
+		return *std::move(result);
+	}
+
+	std::optional<Graph> TryExpandCurveSegments(const Graph& graph, Pulse subdivisionInterval)
 	{
 		if (subdivisionInterval <= 0)
 		{
-			throw std::invalid_argument("subdivisionInterval must be positive");
+			return std::nullopt;
 		}
 
 		if (graph.empty())
@@ -59,6 +84,8 @@ namespace kson
 
 		Graph result;
 
+		std::vector<double> curveValues; // Reused for all segments
+
 		auto itr = graph.begin();
 		const auto endItr = graph.end();
 
@@ -86,16 +113,16 @@ namespace kson
 
 			const Pulse segmentLength = y2 - y1;
 
-			for (Pulse ry = subdivisionInterval; ry < segmentLength; ry += subdivisionInterval)
+			EvaluateSubdivisionCurveValues(point1.curve, segmentLength, subdivisionInterval, &curveValues);
+			Pulse ry = subdivisionInterval;
+			for (const double curveValue : curveValues)
 			{
-				const double lerpRate = static_cast<double>(ry) / static_cast<double>(segmentLength);
-				const double curveValue = EvaluateCurve(point1.curve, lerpRate);
-
 				// Interpolate between point1.vf and point2.v using the curve
 				const double interpolatedValue = std::lerp(point1.v.vf, point2.v.v, curveValue);
 
 				// Add intermediate point with linear interpolation (no curve)
 				result[y1 + ry] = GraphPoint(GraphValue(interpolatedValue));
+				ry += subdivisionInterval;
 			}
 
 			// Add next point
@@ -108,10 +135,20 @@ namespace kson
 	}
 
 	GraphSection ExpandCurveSegments(const GraphSection& graphSection, RelPulse subdivisionInterval)
+	{
+		std::optional<GraphSection> result = TryExpandCurveSegments(graphSection, subdivisionInterval);
+		if (!result.has_value())
+		{
+			KSON_THROW(std::invalid_argument("subdivisionInterval must be positive"));
+		}
+		return *std::move(result);
+	}
+
+	std::optional<GraphSection> TryExpandCurveSegments(const GraphSection& graphSection, RelPulse subdivisionInterval)
 	{
 		if (subdivisionInterval <= 0)
 		{
-			throw std::invalid_argument("subdivisionInterval must be positive");
+			return std::nullopt;
 		}
 
 		if (graphSection.v.empty())
@@ -121,6 +158,8 @@ namespace kson
 
 		GraphSection result;
 
+		std::vector<double> curveValues; // Reused for all segments
+
 		auto itr = graphSection.v.begin();
 		const auto endItr = graphSection.v.end();
 
@@ -148,16 +187,16 @@ namespace kson
 
 			const RelPulse segmentLength = ry2 - ry1;
 
-			for (RelPulse ry = subdivisionInterval; ry < segmentLength; ry += subdivisionInterval)
+			EvaluateSubdivisionCurveValues(point1.curve, segmentLength, subdivisionInterval, &curveValues);
+			RelPulse ry = subdivisionInterval;
+			for (const double curveValue : curveValues)
 			{
-				const double lerpRate = static_cast<double>(ry) / static_cast<double>(segmentLength);
-				const double curveValue = EvaluateCurve(point1.curve, lerpRate);
-
 				// Interpolate between point1.vf and point2.v using the curve
 				const double interpolatedValue = std::lerp(point1.v.vf, point2.v.v, curveValue);
 
 				// Add intermediate point with linear interpolation (no curve)
 				result.v[ry1 + ry] = GraphPoint(GraphValue(interpolatedValue));
+				ry += subdivisionInterval;
 			}
 
 			// Add next point
@@ -170,10 +209,20 @@ namespace kson
 	}
 
 	LaserSection ExpandCurveSegments(const LaserSection& laserSection, RelPulse subdivisionInterval)
+	{
+		std::optional<LaserSection> result = TryExpandCurveSegments(laserSection, subdivisionInterval);
+		if (!result.has_value())
+		{
+			KSON_THROW(std::invalid_argument("subdivisionInterval must be positive"));
+		}
+		return *std::move(result);
+	}
+
+	std::optional<LaserSection> TryExpandCurveSegments(const LaserSection& laserSection, RelPulse subdivisionInterval)
 	{
 		if (subdivisionInterval <= 0)
 		{
-			throw std::invalid_argument("subdivisionInterval must be positive");
+			return std::nullopt;
 		}
 
 		if (laserSection.v.empty())
@@ -184,6 +233,8 @@ namespace kson
 		LaserSection result;
 		result.w = laserSection.w; // Copy the width flag
 
+		std::vector<double> curveValues; // Reused for all segments
+
 		auto itr = laserSection.v.begin();
 		const auto endItr = laserSection.v.end();
 
@@ -211,16 +262,16 @@ namespace kson
 
 			const RelPulse segmentLength = ry2 - ry1;
 
-			for (RelPulse ry = subdivisionInterval; ry < segmentLength; ry += subdivisionInterval)
+			EvaluateSubdivisionCurveValues(point1.curve, segmentLength, subdivisionInterval, &curveValues);
+			RelPulse ry = subdivisionInterval;
+			for (const double curveValue : curveValues)
 			{
-				const double lerpRate = static_cast<double>(ry) / static_cast<double>(segmentLength);
-				const double curveValue = EvaluateCurve(point1.curve, lerpRate);
-
 				// Interpolate between point1.vf and point2.v using the curve
 				const double interpolatedValue = std::lerp(point1.v.vf, point2.v.v, curveValue);
 
 				// Add intermediate point with linear interpolation (no curve)
 				result.v[ry1 + ry] = GraphPoint(GraphValue(interpolatedValue));
+				ry += subdivisionInterval;
 			}
 
 			// Add next point
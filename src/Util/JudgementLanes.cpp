@@ -0,0 +1,144 @@
+#include "kson/Util/JudgementLanes.hpp"
+#include <bit>
+
+namespace
+{
+	constexpr std::size_t kWordBits = 64;
+}
+
+kson::JudgementLane::JudgementLane(const ByPulse<Interval>& lane, const BeatInfo& beatInfo, const TimingCache& timingCache)
+{
+	m_notes.reserve(lane.size());
+	for (const auto& [y, interval] : lane)
+	{
+		const double ms = PulseToMs(y, beatInfo, timingCache);
+		const double endMs = interval.length > 0 ? PulseToMs(y + interval.length, beatInfo, timingCache) : ms;
+		m_notes.push_back({ .ms = ms, .endMs = endMs, .y = y, .length = interval.length });
+	}
+	m_judgedBits.assign((m_notes.size() + kWordBits - 1) / kWordBits, 0);
+}
+
+std::size_t kson::JudgementLane::nextUnjudged(std::size_t idx) const
+{
+	while (idx < m_notes.size())
+	{
+		const std::uint64_t unjudged = ~m_judgedBits[idx / kWordBits] >> (idx % kWordBits);
+		if (unjudged != 0)
+		{
+			return std::min(idx + static_cast<std::size_t>(std::countr_zero(unjudged)), m_notes.size());
+		}
+		idx = (idx / kWordBits + 1) * kWordBits;
+	}
+	return m_notes.size();
+}
+
+void kson::JudgementLane::advanceCursor()
+{
+	m_cursor = nextUnjudged(m_cursor);
+}
+
+std::size_t kson::JudgementLane::size() const
+{
+	return m_notes.size();
+}
+
+const kson::JudgementNote& kson::JudgementLane::note(std::size_t idx) const
+{
+	return m_notes[idx];
+}
+
+bool kson::JudgementLane::isJudged(std::size_t idx) const
+{
+	return (m_judgedBits[idx / kWordBits] >> (idx % kWordBits)) & 1;
+}
+
+std::size_t kson::JudgementLane::numJudged() const
+{
+	return m_numJudged;
+}
+
+std::size_t kson::JudgementLane::findCandidate(double ms, double windowMs) const
+{
+	std::size_t candidateIdx = kJudgementNoNote;
+	double candidateDistance = windowMs;
+	for (std::size_t idx = m_cursor; (idx = nextUnjudged(idx)) < m_notes.size(); ++idx)
+	{
+		// Notes are sorted, so the distance only increases after passing ms
+		const double diff = m_notes[idx].ms - ms;
+		if (diff > candidateDistance)
+		{
+			break;
+		}
+		if (std::abs(diff) <= candidateDistance && (candidateIdx == kJudgementNoNote || std::abs(diff) < candidateDistance))
+		{
+			candidateIdx = idx;
+			candidateDistance = std::abs(diff);
+		}
+	}
+	return candidateIdx;
+}
+
+void kson::JudgementLane::markJudged(std::size_t idx)
+{
+	if (idx >= m_notes.size() || isJudged(idx))
+	{
+		return;
+	}
+
+	m_judgedBits[idx / kWordBits] |= std::uint64_t{ 1 } << (idx % kWordBits);
+	++m_numJudged;
+	if (idx == m_cursor)
+	{
+		advanceCursor();
+	}
+}
+
+std::size_t kson::JudgementLane::advanceMisses(double ms, double windowMs, std::vector<std::size_t>* pMissedIndices)
+{
+	std::size_t numMissed = 0;
+	for (std::size_t idx = m_cursor; (idx = nextUnjudged(idx)) < m_notes.size() && m_notes[idx].ms + windowMs < ms; ++idx)
+	{
+		m_judgedBits[idx / kWordBits] |= std::uint64_t{ 1 } << (idx % kWordBits);
+		++m_numJudged;
+		++numMissed;
+		if (pMissedIndices != nullptr)
+		{
+			pMissedIndices->push_back(idx);
+		}
+	}
+	advanceCursor();
+	return numMissed;
+}
+
+void kson::JudgementLane::reset()
+{
+	std::fill(m_judgedBits.begin(), m_judgedBits.end(), 0);
+	m_cursor = 0;
+	m_numJudged = 0;
+}
+
+void kson::JudgementLanes::reset()
+{
+	for (auto& lane : bt)
+	{
+		lane.reset();
+	}
+	for (auto& lane : fx)
+	{
+		lane.reset();
+	}
+}
+
+kson::JudgementLanes kson::CreateJudgementLanes(const NoteInfo& noteInfo, const BeatInfo& beatInfo, const TimingCache& timingCache)
+{
+	JudgementLanes lanes;
+	for (std::size_t i = 0; i < kNumBTLanesSZ; ++i)
+	{
+		lanes.bt[i] = JudgementLane(noteInfo.bt[i], beatInfo, timingCache);
+	}
+	for (std::size_t i = 0; i < kNumFXLanesSZ; ++i)
+	{
+		lanes.fx[i] = JudgementLane(noteInfo.fx[i], beatInfo, timingCache);
+	}
+	return lanes;
+}
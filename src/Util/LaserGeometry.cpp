@@ -0,0 +1,263 @@
+#include "kson/Util/LaserGeometry.hpp"
+#include "kson/Util/GraphCurve.hpp"
+
+namespace
+{
+	using namespace kson;
+
+	double ToGeometryX(double v, bool wide)
+	{
+		return wide ? v * 2 - 0.5 : v;
+	}
+
+	class GeometryWriter
+	{
+	private:
+		LaserGeometryLane* m_pLane;
+
+		const ScrollPositionCache* m_pScrollCache; // nullptr if y is in pulses
+
+		bool m_stripOpen = false;
+
+		double m_lastPulse = 0.0;
+
+		double m_lastX = 0.0;
+
+		void pushVertex(double pulse, double x)
+		{
+			const double y = m_pScrollCache == nullptr ? pulse : PulseDoubleToScrollPosition(pulse, *m_pScrollCache);
+			m_pLane->vertices.push_back({ .x = x, .y = y });
+			++m_pLane->strips.back().vertexCount;
+		}
+
+	public:
+		GeometryWriter(LaserGeometryLane* pLane, const ScrollPositionCache* pScrollCache)
+			: m_pLane(pLane)
+			, m_pScrollCache(pScrollCache)
+		{
+		}
+
+		[[nodiscard]]
+		bool stripOpen() const
+		{
+			return m_stripOpen;
+		}
+
+		void beginStrip(Pulse sectionY, bool wide, double pulse, double x)
+		{
+			endStrip();
+			m_pLane->strips.push_back({
+				.vertexOffset = m_pLane->vertices.size(),
+				.vertexCount = 0,
+				.sectionY = sectionY,
+				.wide = wide,
+			});
+			m_stripOpen = true;
+			pushVertex(pulse, x);
+			m_lastPulse = pulse;
+			m_lastX = x;
+		}
+
+		void addVertex(double pulse, double x)
+		{
+			assert(m_stripOpen);
+
+			// The scroll position is not linear across scroll speed changes, so put vertices on them
+			if (m_pScrollCache != nullptr && pulse > m_lastPulse)
+			{
+				const auto& scrollPosition = m_pScrollCache->scrollPosition;
+				for (auto itr = scrollPosition.upper_bound(static_cast<Pulse>(std::floor(m_lastPulse))); itr != scrollPosition.end() && static_cast<double>(itr->first) < pulse; ++itr)
+				{
+					const double speedChangePulse = static_cast<double>(itr->first);
+					if (speedChangePulse <= m_lastPulse)
+					{
+						continue;
+					}
+					const double rate = (speedChangePulse - m_lastPulse) / (pulse - m_lastPulse);
+					pushVertex(speedChangePulse, std::lerp(m_lastX, x, rate));
+				}
+			}
+
+			pushVertex(pulse, x);
+			m_lastPulse = pulse;
+			m_lastX = x;
+		}
+
+		void endStrip()
+		{
+			m_stripOpen = false;
+		}
+	};
+
+	struct CurveSegment
+	{
+		double pulse1;
+		double pulse2;
+		double x1;
+		double x2;
+		GraphCurveValue curve;
+
+		// Evaluates the quadratic bezier at parameter t
+		// (subdividing on t rather than on the pulse keeps the vertical tangents of the curve bounded)
+		[[nodiscard]]
+		LaserGeometryVertex vertexAt(double t) const
+		{
+			const double a = std::clamp(curve.a, 0.0, 1.0);
+			const double b = std::clamp(curve.b, 0.0, 1.0);
+			const double s = 2 * (1 - t) * t * a + t * t;
+			const double f = 2 * (1 - t) * t * b + t * t;
+			return { .x = std::lerp(x1, x2, f), .y = std::lerp(pulse1, pulse2, s) };
+		}
+	};
+
+	// Horizontal distance between the point and the line through v1 and v2
+	double HorizontalDistance(const LaserGeometryVertex& point, const LaserGeometryVertex& v1, const LaserGeometryVertex& v2)
+	{
+		if (v1.y == v2.y)
+		{
+			return std::abs(point.x - (v1.x + v2.x) / 2);
+		}
+		const double rate = (point.y - v1.y) / (v2.y - v1.y);
+		return std::abs(point.x - std::lerp(v1.x, v2.x, rate));
+	}
+
+	// Subdivides the segment recursively until the midpoint deviation from the chord falls within the tolerance
+	// (the deviation of a quadratic bezier from its chord is largest at the middle of the parameter range)
+	void TessellateCurve(GeometryWriter& writer, const CurveSegment& segment, double t1, double t2, const LaserGeometryVertex& v1, const LaserGeometryVertex& v2, std::int32_t depth, const LaserGeometryParams& params)
+	{
+		const double tMid = (t1 + t2) / 2;
+		const LaserGeometryVertex vMid = segment.vertexAt(tMid);
+		if (depth < params.maxSubdivisionDepth && HorizontalDistance(vMid, v1, v2) > params.tolerance)
+		{
+			TessellateCurve(writer, segment, t1, tMid, v1, vMid, depth + 1, params);
+			TessellateCurve(writer, segment, tMid, t2, vMid, v2, depth + 1, params);
+			return;
+		}
+		writer.addVertex(v2.y, v2.x);
+	}
+
+	void BuildLaserGeometryLaneImpl(const ByPulse<LaserSection>& lane, Pulse startPulse, Pulse endPulse, const ScrollPositionCache* pScrollCache, const LaserGeometryParams& params, LaserGeometryLane* pLane)
+	{
+		assert(pLane != nullptr);
+
+		pLane->clear();
+		if (lane.empty() || endPulse < startPulse)
+		{
+			return;
+		}
+
+		// The section just before startPulse may still continue into the range
+		auto sectionItr = lane.upper_bound(startPulse);
+		if (sectionItr != lane.begin())
+		{
+			--sectionItr;
+		}
+
+		GeometryWriter writer(pLane, pScrollCache);
+		for (; sectionItr != lane.end() && sectionItr->first <= endPulse; ++sectionItr)
+		{
+			const auto& [sectionY, section] = *sectionItr;
+			const bool wide = section.wide();
+			for (auto itr = section.v.begin(); itr != section.v.end(); ++itr)
+			{
+				const auto& [ry, point] = *itr;
+				const Pulse y = sectionY + ry;
+				if (y > endPulse)
+				{
+					break;
+				}
+
+				if (!AlmostEquals(point.v.v, point.v.vf) && startPulse <= y)
+				{
+					writer.endStrip();
+					pLane->slams.push_back({
+						.y = pScrollCache == nullptr ? static_cast<double>(y) : PulseToScrollPosition(y, *pScrollCache),
+						.xFrom = ToGeometryX(point.v.v, wide),
+						.xTo = ToGeometryX(point.v.vf, wide),
+						.sectionY = sectionY,
+						.wide = wide,
+					});
+				}
+
+				const auto nextItr = std::next(itr);
+				if (nextItr == section.v.end())
+				{
+					break;
+				}
+
+				const Pulse nextY = sectionY + nextItr->first;
+				if (nextY < startPulse)
+				{
+					continue;
+				}
+
+				const CurveSegment segment{
+					.pulse1 = static_cast<double>(y),
+					.pulse2 = static_cast<double>(nextY),
+					.x1 = ToGeometryX(point.v.vf, wide),
+					.x2 = ToGeometryX(nextItr->second.v.v, wide),
+					.curve = point.curve,
+				};
+				if (!writer.stripOpen())
+				{
+					writer.beginStrip(sectionY, wide, segment.pulse1, segment.x1);
+				}
+
+				if (point.curve.isLinear())
+				{
+					writer.addVertex(segment.pulse2, segment.x2);
+				}
+				else
+				{
+					TessellateCurve(writer, segment, 0.0, 1.0, segment.vertexAt(0.0), segment.vertexAt(1.0), 0, params);
+				}
+			}
+			writer.endStrip();
+		}
+	}
+}
+
+void kson::LaserGeometryLane::clear()
+{
+	vertices.clear();
+	strips.clear();
+	slams.clear();
+}
+
+void kson::LaserGeometry::clear()
+{
+	for (auto& lane : lanes)
+	{
+		lane.clear();
+	}
+}
+
+void kson::BuildLaserGeometry(const LaserLane<LaserSection>& laser, Pulse startPulse, Pulse endPulse, const LaserGeometryParams& params, LaserGeometry* pGeometry)
+{
+	assert(pGeometry != nullptr);
+
+	for (std::size_t i = 0; i < kNumLaserLanesSZ; ++i)
+	{
+		BuildLaserGeometryLaneImpl(laser[i], startPulse, endPulse, nullptr, params, &pGeometry->lanes[i]);
+	}
+}
+
+void kson::BuildLaserGeometry(const LaserLane<LaserSection>& laser, Pulse startPulse, Pulse endPulse, const ScrollPositionCache& scrollCache, const LaserGeometryParams& params, LaserGeometry* pGeometry)
+{
+	assert(pGeometry != nullptr);
+
+	for (std::size_t i = 0; i < kNumLaserLanesSZ; ++i)
+	{
+		BuildLaserGeometryLaneImpl(laser[i], startPulse, endPulse, &scrollCache, params, &pGeometry->lanes[i]);
+	}
+}
+
+void kson::BuildLaserGeometryLane(const ByPulse<LaserSection>& lane, Pulse startPulse, Pulse endPulse, const LaserGeometryParams& params, LaserGeometryLane* pLane)
+{
+	BuildLaserGeometryLaneImpl(lane, startPulse, endPulse, nullptr, params, pLane);
+}
+
+void kson::BuildLaserGeometryLane(const ByPulse<LaserSection>& lane, Pulse startPulse, Pulse endPulse, const ScrollPositionCache& scrollCache, const LaserGeometryParams& params, LaserGeometryLane* pLane)
+{
+	BuildLaserGeometryLaneImpl(lane, startPulse, endPulse, &scrollCache, params, pLane);
+}
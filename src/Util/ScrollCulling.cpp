@@ -0,0 +1,295 @@
+#include "kson/Util/ScrollCulling.hpp"
+#include <algorithm>
+
+namespace
+{
+	using namespace kson;
+
+	struct ScrollPositionAt
+	{
+		double pulse = 0.0;
+		double position = 0.0;
+	};
+
+	// Minimum and maximum scroll positions over pulse ranges
+	// The scroll position is monotonic between the points of the scroll speed graph and the pulses where the speed
+	// crosses zero inside a segment, so the bounds of a range are at its ends or at one of these pulses
+	class ScrollPositionBounds
+	{
+	private:
+		const ScrollPositionCache& m_scrollCache;
+
+		std::vector<ScrollPositionAt> m_breakpoints; // Sorted by pulse
+
+		// Sparse tables (m_minTable[k][i] is the minimum of the 2^k breakpoints from i)
+		std::vector<std::vector<double>> m_minTable;
+		std::vector<std::vector<double>> m_maxTable;
+
+	public:
+		explicit ScrollPositionBounds(const ScrollPositionCache& scrollCache)
+			: m_scrollCache(scrollCache)
+		{
+			const Graph& scrollSpeed = scrollCache.scrollSpeed;
+			for (auto itr = scrollSpeed.begin(); itr != scrollSpeed.end(); ++itr)
+			{
+				const auto& [y1, point1] = *itr;
+				const double position1 = scrollCache.scrollPosition.at(y1);
+				m_breakpoints.push_back({ .pulse = static_cast<double>(y1), .position = position1 });
+
+				const auto nextItr = std::next(itr);
+				if (nextItr == scrollSpeed.end())
+				{
+					break;
+				}
+
+				// The speed changes linearly from vf to the next v, so the position turns back where it crosses zero
+				const auto& [y2, point2] = *nextItr;
+				const double vf = point1.v.vf;
+				const double v2 = point2.v.v;
+				if ((vf < 0.0 && v2 > 0.0) || (vf > 0.0 && v2 < 0.0))
+				{
+					const double length = static_cast<double>(y2 - y1);
+					const double dy = vf * length / (vf - v2);
+					m_breakpoints.push_back({
+						.pulse = static_cast<double>(y1) + dy,
+						.position = position1 + vf * dy + (v2 - vf) * dy * dy / (2 * length),
+					});
+				}
+			}
+
+			const std::size_t size = m_breakpoints.size();
+			m_minTable.emplace_back(size);
+			m_maxTable.emplace_back(size);
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				m_minTable[0][i] = m_maxTable[0][i] = m_breakpoints[i].position;
+			}
+			for (std::size_t k = 1; (std::size_t{ 1 } << k) <= size; ++k)
+			{
+				const std::size_t half = std::size_t{ 1 } << (k - 1);
+				const std::size_t levelSize = size - (std::size_t{ 1 } << k) + 1;
+				std::vector<double> minLevel(levelSize);
+				std::vector<double> maxLevel(levelSize);
+				for (std::size_t i = 0; i < levelSize; ++i)
+				{
+					minLevel[i] = std::min(m_minTable[k - 1][i], m_minTable[k - 1][i + half]);
+					maxLevel[i] = std::max(m_maxTable[k - 1][i], m_maxTable[k - 1][i + half]);
+				}
+				m_minTable.push_back(std::move(minLevel));
+				m_maxTable.push_back(std::move(maxLevel));
+			}
+		}
+
+		// Returns the minimum and maximum scroll positions over the pulse range [startPulse, endPulse]
+		[[nodiscard]]
+		std::pair<double, double> boundsOf(Pulse startPulse, Pulse endPulse) const
+		{
+			const double startPosition = PulseToScrollPosition(startPulse, m_scrollCache);
+			const double endPosition = PulseToScrollPosition(endPulse, m_scrollCache);
+			double minPosition = std::min(startPosition, endPosition);
+			double maxPosition = std::max(startPosition, endPosition);
+
+			// Breakpoints strictly inside the range
+			const auto pulseLess = [](const ScrollPositionAt& lhs, double pulse) { return lhs.pulse < pulse; };
+			const auto pulseGreater = [](double pulse, const ScrollPositionAt& rhs) { return pulse < rhs.pulse; };
+			const auto first = std::upper_bound(m_breakpoints.begin(), m_breakpoints.end(), static_cast<double>(startPulse), pulseGreater);
+			const auto last = std::lower_bound(first, m_breakpoints.end(), static_cast<double>(endPulse), pulseLess);
+			if (first < last)
+			{
+				const auto i = static_cast<std::size_t>(first - m_breakpoints.begin());
+				const auto j = static_cast<std::size_t>(last - m_breakpoints.begin());
+				std::size_t k = 0;
+				while ((std::size_t{ 2 } << k) <= j - i)
+				{
+					++k;
+				}
+				const std::size_t i2 = j - (std::size_t{ 1 } << k);
+				minPosition = std::min({ minPosition, m_minTable[k][i], m_minTable[k][i2] });
+				maxPosition = std::max({ maxPosition, m_maxTable[k][i], m_maxTable[k][i2] });
+			}
+
+			return { minPosition, maxPosition };
+		}
+	};
+
+	template <typename LaneArray>
+	void AddIntervalNotes(const LaneArray& lanes, ScrollCullingLaneType laneType, const ScrollPositionBounds& bounds, std::vector<ScrollCullingNote>* pNotes)
+	{
+		for (std::size_t laneIdx = 0; laneIdx < lanes.size(); ++laneIdx)
+		{
+			for (const auto& [y, interval] : lanes[laneIdx])
+			{
+				const auto [minPosition, maxPosition] = bounds.boundsOf(y, y + interval.length);
+				pNotes->push_back({
+					.laneType = laneType,
+					.laneIdx = static_cast<std::int32_t>(laneIdx),
+					.y = y,
+					.length = interval.length,
+					.minScrollPosition = minPosition,
+					.maxScrollPosition = maxPosition,
+				});
+			}
+		}
+	}
+
+	// Builds the subtree of the notes (indices in ascending order) and returns its node index
+	std::int32_t BuildNode(const std::vector<std::size_t>& noteIndices, ScrollCullingIndex* pIndex)
+	{
+		if (noteIndices.empty())
+		{
+			return -1;
+		}
+
+		// The median of the endpoints leaves at most half of the notes on each side
+		std::vector<double> endpoints;
+		endpoints.reserve(noteIndices.size() * 2);
+		for (const std::size_t idx : noteIndices)
+		{
+			endpoints.push_back(pIndex->notes[idx].minScrollPosition);
+			endpoints.push_back(pIndex->notes[idx].maxScrollPosition);
+		}
+		const auto medianItr = endpoints.begin() + static_cast<std::ptrdiff_t>(endpoints.size() / 2);
+		std::nth_element(endpoints.begin(), medianItr, endpoints.end());
+		const double center = *medianItr;
+
+		std::vector<std::size_t> leftIndices;
+		std::vector<std::size_t> rightIndices;
+		const std::size_t midOffset = pIndex->midByMin.size();
+		for (const std::size_t idx : noteIndices)
+		{
+			const ScrollCullingNote& note = pIndex->notes[idx];
+			if (note.maxScrollPosition < center)
+			{
+				leftIndices.push_back(idx);
+			}
+			else if (note.minScrollPosition > center)
+			{
+				rightIndices.push_back(idx);
+			}
+			else
+			{
+				// Already in ascending order of minScrollPosition since the notes are sorted by it
+				pIndex->midByMin.push_back(idx);
+				pIndex->midByMax.push_back(idx);
+			}
+		}
+		const std::size_t midCount = pIndex->midByMin.size() - midOffset;
+		const auto midByMaxBegin = pIndex->midByMax.begin() + static_cast<std::ptrdiff_t>(midOffset);
+		std::stable_sort(midByMaxBegin, pIndex->midByMax.end(), [pIndex](std::size_t lhs, std::size_t rhs)
+		{
+			return pIndex->notes[lhs].maxScrollPosition > pIndex->notes[rhs].maxScrollPosition;
+		});
+
+		const auto nodeIdx = static_cast<std::int32_t>(pIndex->nodes.size());
+		pIndex->nodes.push_back({
+			.center = center,
+			.midOffset = midOffset,
+			.midCount = midCount,
+		});
+
+		const std::int32_t left = BuildNode(leftIndices, pIndex);
+		const std::int32_t right = BuildNode(rightIndices, pIndex);
+		pIndex->nodes[static_cast<std::size_t>(nodeIdx)].left = left;
+		pIndex->nodes[static_cast<std::size_t>(nodeIdx)].right = right;
+		return nodeIdx;
+	}
+
+	// Finds the notes with minScrollPosition < position <= maxScrollPosition
+	void FindNotesStartingBefore(const ScrollCullingIndex& index, double position, std::vector<std::size_t>* pNoteIndices)
+	{
+		std::int32_t nodeIdx = index.nodes.empty() ? -1 : 0;
+		while (nodeIdx >= 0)
+		{
+			const ScrollCullingNode& node = index.nodes[static_cast<std::size_t>(nodeIdx)];
+			const std::size_t midEnd = node.midOffset + node.midCount;
+			if (position > node.center)
+			{
+				// Every note of the node starts at or before center
+				for (std::size_t i = node.midOffset; i < midEnd && index.notes[index.midByMax[i]].maxScrollPosition >= position; ++i)
+				{
+					pNoteIndices->push_back(index.midByMax[i]);
+				}
+				nodeIdx = node.right;
+			}
+			else
+			{
+				// Every note of the node ends at or after center
+				for (std::size_t i = node.midOffset; i < midEnd && index.notes[index.midByMin[i]].minScrollPosition < position; ++i)
+				{
+					pNoteIndices->push_back(index.midByMin[i]);
+				}
+
+				// The notes of the left subtree end before center, and those of the right one start after it
+				nodeIdx = position < node.center ? node.left : -1;
+			}
+		}
+	}
+}
+
+kson::ScrollCullingIndex kson::CreateScrollCullingIndex(const NoteInfo& noteInfo, const ScrollPositionCache& scrollCache)
+{
+	const ScrollPositionBounds bounds(scrollCache);
+
+	ScrollCullingIndex index;
+	AddIntervalNotes(noteInfo.bt, ScrollCullingLaneType::BT, bounds, &index.notes);
+	AddIntervalNotes(noteInfo.fx, ScrollCullingLaneType::FX, bounds, &index.notes);
+	for (std::size_t laneIdx = 0; laneIdx < noteInfo.laser.size(); ++laneIdx)
+	{
+		for (const auto& [y, section] : noteInfo.laser[laneIdx])
+		{
+			const RelPulse length = section.v.empty() ? 0 : section.v.rbegin()->first;
+			const auto [minPosition, maxPosition] = bounds.boundsOf(y, y + length);
+			index.notes.push_back({
+				.laneType = ScrollCullingLaneType::Laser,
+				.laneIdx = static_cast<std::int32_t>(laneIdx),
+				.y = y,
+				.length = length,
+				.minScrollPosition = minPosition,
+				.maxScrollPosition = maxPosition,
+			});
+		}
+	}
+
+	std::stable_sort(index.notes.begin(), index.notes.end(), [](const ScrollCullingNote& lhs, const ScrollCullingNote& rhs)
+	{
+		return lhs.minScrollPosition < rhs.minScrollPosition;
+	});
+
+	std::vector<std::size_t> noteIndices(index.notes.size());
+	for (std::size_t i = 0; i < noteIndices.size(); ++i)
+	{
+		noteIndices[i] = i;
+	}
+	index.midByMin.reserve(index.notes.size());
+	index.midByMax.reserve(index.notes.size());
+	BuildNode(noteIndices, &index);
+
+	return index;
+}
+
+void kson::FindNotesInScrollRange(const ScrollCullingIndex& index, double minPosition, double maxPosition, std::vector<std::size_t>* pNoteIndices)
+{
+	pNoteIndices->clear();
+	if (!(minPosition <= maxPosition))
+	{
+		return;
+	}
+
+	// A note overlaps the range iff it starts inside the range or starts before it and contains minPosition
+	FindNotesStartingBefore(index, minPosition, pNoteIndices);
+
+	const auto first = std::lower_bound(index.notes.begin(), index.notes.end(), minPosition, [](const ScrollCullingNote& note, double position)
+	{
+		return note.minScrollPosition < position;
+	});
+	for (auto itr = first; itr != index.notes.end() && itr->minScrollPosition <= maxPosition; ++itr)
+	{
+		pNoteIndices->push_back(static_cast<std::size_t>(itr - index.notes.begin()));
+	}
+}
+
+void kson::FindVisibleNotes(const ScrollCullingIndex& index, const ScrollPositionCache& scrollCache, double pulse, double minRelPosition, double maxRelPosition, std::vector<std::size_t>* pNoteIndices)
+{
+	const double position = PulseDoubleToScrollPosition(pulse, scrollCache);
+	FindNotesInScrollRange(index, position + minRelPosition, position + maxRelPosition, pNoteIndices);
+}
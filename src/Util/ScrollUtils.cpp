@@ -0,0 +1,65 @@
+#include "kson/Util/ScrollUtils.hpp"
+#include "kson/Util/GraphUtils.hpp"
+#include "kson/Util/GraphCurve.hpp"
+
+kson::ScrollPositionCache kson::CreateScrollPositionCache(const BeatInfo& beatInfo)
+{
+	ScrollPositionCache cache;
+	cache.scrollSpeed = ExpandCurveSegments(BakeStopIntoScrollSpeed(beatInfo.scrollSpeed, beatInfo.stop), kCurveSubdivisionInterval);
+	if (cache.scrollSpeed.empty())
+	{
+		cache.scrollSpeed.emplace(0, GraphValue{ 1.0 });
+	}
+
+	// The scroll position is zero at pulse 0 (the speed before the first point is its v value)
+	const auto& [firstY, firstPoint] = *cache.scrollSpeed.begin();
+	double position = firstPoint.v.v * static_cast<double>(firstY);
+	cache.scrollPosition.emplace(firstY, position);
+
+	for (auto itr = cache.scrollSpeed.begin(); std::next(itr) != cache.scrollSpeed.end(); ++itr)
+	{
+		const auto& [y1, point1] = *itr;
+		const auto& [y2, point2] = *std::next(itr);
+
+		// The speed changes linearly from vf to the next v (curves are already expanded)
+		position += (point1.v.vf + point2.v.v) / 2 * static_cast<double>(y2 - y1);
+		cache.scrollPosition.emplace(y2, position);
+	}
+
+	return cache;
+}
+
+double kson::PulseToScrollPosition(Pulse pulse, const ScrollPositionCache& cache)
+{
+	return PulseDoubleToScrollPosition(static_cast<double>(pulse), cache);
+}
+
+double kson::PulseDoubleToScrollPosition(double pulse, const ScrollPositionCache& cache)
+{
+	if (cache.scrollSpeed.empty())
+	{
+		return pulse;
+	}
+
+	// Fetch the nearest scroll speed change
+	const auto itr = ValueItrAt(cache.scrollSpeed, static_cast<Pulse>(std::floor(pulse)));
+	const auto& [y1, point1] = *itr;
+	const double position1 = cache.scrollPosition.at(y1);
+	const double dy = pulse - static_cast<double>(y1);
+	if (dy < 0.0)
+	{
+		// Before the first point
+		return position1 + point1.v.v * dy;
+	}
+
+	const auto nextItr = std::next(itr);
+	if (nextItr == cache.scrollSpeed.end())
+	{
+		return position1 + point1.v.vf * dy;
+	}
+
+	// Integrate the linearly changing speed
+	const auto& [y2, point2] = *nextItr;
+	const double length = static_cast<double>(y2 - y1);
+	return position1 + point1.v.vf * dy + (point2.v.v - point1.v.vf) * dy * dy / (2 * length);
+}
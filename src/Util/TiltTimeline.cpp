@@ -0,0 +1,420 @@
+#include "kson/Util/TiltTimeline.hpp"
+#include "kson/Util/GraphCurve.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	using namespace kson;
+
+	// Advancing the cursor by more points than this uses a binary search instead
+	constexpr std::size_t kMaxLinearCursorSteps = 8;
+
+	// Default laser positions (absent lasers do not tilt)
+	constexpr double kDefaultLeftLaserValue = 0.0;
+	constexpr double kDefaultRightLaserValue = 1.0;
+
+	class PointsBuilder
+	{
+	private:
+		std::vector<TiltTimelinePoint>& m_points;
+
+	public:
+		explicit PointsBuilder(std::vector<TiltTimelinePoint>& points)
+			: m_points(points)
+		{
+		}
+
+		// Adds a point, or overwrites vf if the last point is at the same pulse
+		void addPoint(double y, double v, double vf)
+		{
+			if (!m_points.empty() && m_points.back().y == y)
+			{
+				m_points.back().vf = vf;
+			}
+			else
+			{
+				assert(m_points.empty() || m_points.back().y < y);
+				m_points.push_back({ .y = y, .v = v, .vf = vf });
+			}
+		}
+
+		// Adds a linear segment from (y0, v0) to (y1, v1) continuing from the last point
+		void addSegment(double y0, double v0, double y1, double v1)
+		{
+			addPoint(y0, v0, v0);
+			if (y1 > y0)
+			{
+				m_points.push_back({ .y = y1, .v = v1, .vf = v1 });
+			}
+		}
+	};
+
+	double Lerp(const TiltTimelinePoint& point1, const TiltTimelinePoint& point2, double pulse)
+	{
+		const double rate = (pulse - point1.y) / (point2.y - point1.y);
+		return std::lerp(point1.vf, point2.v, rate);
+	}
+
+	// Value of piecewise linear points at the pulse (approaching it from before if fromLeft is true)
+	double PointsValueAt(const std::vector<TiltTimelinePoint>& points, double pulse, bool fromLeft, double defaultValue)
+	{
+		if (points.empty())
+		{
+			return defaultValue;
+		}
+
+		const auto itr = std::lower_bound(points.begin(), points.end(), pulse, [](const TiltTimelinePoint& point, double y) { return point.y < y; });
+		if (itr != points.end() && itr->y == pulse)
+		{
+			return fromLeft ? itr->v : itr->vf;
+		}
+		if (itr == points.begin())
+		{
+			return itr->v;
+		}
+		if (itr == points.end())
+		{
+			return points.back().vf;
+		}
+		return Lerp(*std::prev(itr), *itr, pulse);
+	}
+
+	// Laser position over the lane following GraphSectionValueAt() (the latest section starting at or before the pulse
+	// is used, and the value is the default outside of its points)
+	std::vector<TiltTimelinePoint> CreateLanePoints(const ByPulse<LaserSection>& lane, double defaultValue, RelPulse curveSubdivisionInterval)
+	{
+		std::vector<TiltTimelinePoint> points;
+		PointsBuilder builder(points);
+		for (const auto& [y, rawSection] : lane)
+		{
+			// A section starting while the previous one continues cuts it off
+			const double sectionY = static_cast<double>(y);
+			if (!points.empty() && points.back().y >= sectionY)
+			{
+				const double cutValue = PointsValueAt(points, sectionY, true, defaultValue);
+				while (!points.empty() && points.back().y >= sectionY)
+				{
+					points.pop_back();
+				}
+				points.push_back({ .y = sectionY, .v = cutValue, .vf = defaultValue });
+			}
+
+			if (rawSection.v.size() <= 1)
+			{
+				continue;
+			}
+
+			const std::optional<LaserSection> expandedSection = TryExpandCurveSegments(rawSection, curveSubdivisionInterval);
+			const LaserSection& section = expandedSection.has_value() ? *expandedSection : rawSection;
+			const auto lastItr = std::prev(section.v.end());
+			for (auto itr = section.v.begin(); itr != section.v.end(); ++itr)
+			{
+				const auto& [ry, point] = *itr;
+				const double pointY = static_cast<double>(y + ry);
+				if (itr == section.v.begin())
+				{
+					builder.addPoint(pointY, defaultValue, point.v.vf);
+				}
+				else if (itr == lastItr)
+				{
+					builder.addPoint(pointY, point.v.v, defaultValue);
+				}
+				else
+				{
+					builder.addPoint(pointY, point.v.v, point.v.vf);
+				}
+			}
+		}
+		return points;
+	}
+
+	// Sum of the laser positions minus one (-1.0 to 1.0 for normal lasers)
+	std::vector<TiltTimelinePoint> CreateLaserFactorPoints(const NoteInfo& noteInfo, RelPulse curveSubdivisionInterval)
+	{
+		const std::vector<TiltTimelinePoint> leftPoints = CreateLanePoints(noteInfo.laser[0], kDefaultLeftLaserValue, curveSubdivisionInterval);
+		const std::vector<TiltTimelinePoint> rightPoints = CreateLanePoints(noteInfo.laser[1], kDefaultRightLaserValue, curveSubdivisionInterval);
+
+		std::vector<double> ys;
+		ys.reserve(leftPoints.size() + rightPoints.size());
+		for (const auto& point : leftPoints)
+		{
+			ys.push_back(point.y);
+		}
+		for (const auto& point : rightPoints)
+		{
+			ys.push_back(point.y);
+		}
+		std::sort(ys.begin(), ys.end());
+		ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+		std::vector<TiltTimelinePoint> points;
+		points.reserve(ys.size());
+		for (const double y : ys)
+		{
+			points.push_back({
+				.y = y,
+				.v = PointsValueAt(leftPoints, y, true, kDefaultLeftLaserValue) + PointsValueAt(rightPoints, y, true, kDefaultRightLaserValue) - 1.0,
+				.vf = PointsValueAt(leftPoints, y, false, kDefaultLeftLaserValue) + PointsValueAt(rightPoints, y, false, kDefaultRightLaserValue) - 1.0,
+			});
+		}
+		return points;
+	}
+
+	// Manual tilt value of the entry at the pulse (same as ManualTiltValueAt())
+	double ManualTiltValue(ByPulse<TiltValue>::const_iterator entryItr, ByPulse<TiltValue>::const_iterator endItr, double pulse)
+	{
+		const TiltGraphPoint& point = std::get<TiltGraphPoint>(entryItr->second);
+		const double vf = std::get<double>(point.v.vf);
+		const auto nextItr = std::next(entryItr);
+		if (nextItr == endItr || !std::holds_alternative<TiltGraphPoint>(nextItr->second))
+		{
+			return vf;
+		}
+		const TiltGraphPoint& nextPoint = std::get<TiltGraphPoint>(nextItr->second);
+		const double rate = (pulse - static_cast<double>(entryItr->first)) / static_cast<double>(nextItr->first - entryItr->first);
+		return std::lerp(vf, nextPoint.v.v, EvaluateCurve(point.curve, rate));
+	}
+
+	bool IsManualTiltEntry(const TiltValue& value)
+	{
+		return std::holds_alternative<TiltGraphPoint>(value) && std::holds_alternative<double>(std::get<TiltGraphPoint>(value).v.vf);
+	}
+
+	// Auto tilt type of the entry (a manual tilt point with an auto tilt type returns to it after the point)
+	AutoTiltType EntryAutoTiltType(const TiltValue& value)
+	{
+		if (std::holds_alternative<AutoTiltType>(value))
+		{
+			return std::get<AutoTiltType>(value);
+		}
+		const auto& vf = std::get<TiltGraphPoint>(value).v.vf;
+		return std::holds_alternative<AutoTiltType>(vf) ? std::get<AutoTiltType>(vf) : AutoTiltType::kNormal;
+	}
+
+	// Adds a kept segment where the auto tilt value goes linearly from t0 to t1 without changing its sign in between
+	void AddKeptPiece(PointsBuilder& builder, double y0, double t0, double y1, double t1, double* pHeld)
+	{
+		const double tMid = (t0 + t1) / 2;
+		double held = *pHeld;
+		if (tMid == 0.0)
+		{
+			builder.addSegment(y0, held, y1, held);
+			return;
+		}
+
+		if (held == 0.0 || (held > 0.0) != (tMid > 0.0))
+		{
+			// Lasers moved to the opposite side
+			held = t0;
+		}
+		else if (std::abs(t0) > std::abs(held))
+		{
+			held = t0;
+		}
+
+		const double absHeld = std::abs(held);
+		const double abs0 = std::abs(t0);
+		const double abs1 = std::abs(t1);
+		if (abs1 <= absHeld)
+		{
+			builder.addSegment(y0, held, y1, held);
+			*pHeld = held;
+		}
+		else if (abs0 >= absHeld)
+		{
+			builder.addSegment(y0, t0, y1, t1);
+			*pHeld = t1;
+		}
+		else
+		{
+			// The lasers go beyond the kept value in the middle of the segment
+			const double yCross = y0 + (y1 - y0) * (absHeld - abs0) / (abs1 - abs0);
+			builder.addSegment(y0, held, yCross, held);
+			builder.addSegment(yCross, held, y1, t1);
+			*pHeld = t1;
+		}
+	}
+
+	void AddKeptSegment(PointsBuilder& builder, double y0, double t0, double y1, double t1, double* pHeld)
+	{
+		if ((t0 > 0.0 && t1 < 0.0) || (t0 < 0.0 && t1 > 0.0))
+		{
+			const double yZero = y0 + (y1 - y0) * t0 / (t0 - t1);
+			AddKeptPiece(builder, y0, t0, yZero, 0.0, pHeld);
+			AddKeptPiece(builder, yZero, 0.0, y1, t1, pHeld);
+		}
+		else
+		{
+			AddKeptPiece(builder, y0, t0, y1, t1, pHeld);
+		}
+	}
+
+	// Removes points on the straight line between their neighbors
+	void RemoveRedundantPoints(std::vector<TiltTimelinePoint>& points)
+	{
+		constexpr double kEpsilon = 1e-9;
+		if (points.size() <= 2)
+		{
+			return;
+		}
+
+		std::size_t numKept = 1;
+		for (std::size_t i = 1; i + 1 < points.size(); ++i)
+		{
+			const TiltTimelinePoint& prev = points[numKept - 1];
+			const TiltTimelinePoint& point = points[i];
+			const TiltTimelinePoint& next = points[i + 1];
+			if (point.v == point.vf && std::abs(Lerp(prev, next, point.y) - point.v) < kEpsilon)
+			{
+				continue;
+			}
+			points[numKept++] = point;
+		}
+		points[numKept++] = points.back();
+		points.resize(numKept);
+	}
+}
+
+kson::TiltTimeline kson::CreateTiltTimeline(const NoteInfo& noteInfo, const ByPulse<TiltValue>& tilt, const TiltTimelineParams& params)
+{
+	assert(params.curveSubdivisionInterval > 0);
+
+	const std::vector<TiltTimelinePoint> laserPoints = CreateLaserFactorPoints(noteInfo, params.curveSubdivisionInterval);
+
+	// Pulses where the value can bend or jump
+	std::vector<double> ys{ 0.0 };
+	ys.reserve(laserPoints.size() + tilt.size() + 1);
+	for (const auto& point : laserPoints)
+	{
+		ys.push_back(point.y);
+	}
+	for (auto itr = tilt.begin(); itr != tilt.end(); ++itr)
+	{
+		const Pulse y = itr->first;
+		ys.push_back(static_cast<double>(y));
+
+		const auto nextItr = std::next(itr);
+		if (IsManualTiltEntry(itr->second) && !std::get<TiltGraphPoint>(itr->second).curve.isLinear() &&
+			nextItr != tilt.end() && std::holds_alternative<TiltGraphPoint>(nextItr->second))
+		{
+			for (Pulse subY = y + params.curveSubdivisionInterval; subY < nextItr->first; subY += params.curveSubdivisionInterval)
+			{
+				ys.push_back(static_cast<double>(subY));
+			}
+		}
+	}
+	std::sort(ys.begin(), ys.end());
+	ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+	TiltTimeline timeline;
+	PointsBuilder builder(timeline.points);
+	double held = 0.0; // Value approaching the current pulse
+	auto entryItr = tilt.end(); // Latest entry at or before the current pulse
+	auto nextEntryItr = tilt.begin();
+	for (std::size_t i = 0; i < ys.size(); ++i)
+	{
+		const double y0 = ys[i];
+		const double y1 = i + 1 < ys.size() ? ys[i + 1] : y0;
+
+		while (nextEntryItr != tilt.end() && static_cast<double>(nextEntryItr->first) <= y0)
+		{
+			entryItr = nextEntryItr++;
+		}
+
+		if (entryItr != tilt.end() && IsManualTiltEntry(entryItr->second))
+		{
+			const double v0 = ManualTiltValue(entryItr, tilt.end(), y0);
+			const double v1 = ManualTiltValue(entryItr, tilt.end(), y1);
+			builder.addSegment(y0, v0, y1, v1);
+			held = v1;
+			continue;
+		}
+
+		// The laser factor is linear in [y0, y1] since its points are included in ys
+		const AutoTiltType type = entryItr != tilt.end() ? EntryAutoTiltType(entryItr->second) : AutoTiltType::kNormal;
+		const double scale = GetAutoTiltScale(type);
+		const double t0 = PointsValueAt(laserPoints, y0, false, 0.0) * scale;
+		const double t1 = y1 > y0 ? PointsValueAt(laserPoints, y1, true, 0.0) * scale : t0;
+		if (IsKeepAutoTiltType(type))
+		{
+			AddKeptSegment(builder, y0, t0, y1, t1, &held);
+		}
+		else
+		{
+			builder.addSegment(y0, t0, y1, t1);
+			held = t1;
+		}
+	}
+
+	RemoveRedundantPoints(timeline.points);
+	return timeline;
+}
+
+double kson::TiltTimelineValueAt(const TiltTimeline& timeline, double pulse)
+{
+	const auto& points = timeline.points;
+	if (points.empty())
+	{
+		return 0.0;
+	}
+
+	const auto itr = std::upper_bound(points.begin(), points.end(), pulse, [](double y, const TiltTimelinePoint& point) { return y < point.y; });
+	if (itr == points.begin())
+	{
+		return itr->v;
+	}
+	if (itr == points.end())
+	{
+		return points.back().vf;
+	}
+	return Lerp(*std::prev(itr), *itr, pulse);
+}
+
+kson::TiltTimelineCursor::TiltTimelineCursor(const TiltTimeline& timeline)
+	: m_pTimeline(&timeline)
+{
+}
+
+double kson::TiltTimelineCursor::valueAt(double pulse)
+{
+	const auto& points = m_pTimeline->points;
+	if (points.empty())
+	{
+		return 0.0;
+	}
+
+	const auto findIdx = [&]()
+	{
+		return static_cast<std::size_t>(std::upper_bound(points.begin(), points.end(), pulse, [](double y, const TiltTimelinePoint& point) { return y < point.y; }) - points.begin());
+	};
+	if (m_idx > 0 && pulse < points[m_idx - 1].y)
+	{
+		// Seek backward
+		m_idx = findIdx();
+	}
+	else
+	{
+		std::size_t numSteps = 0;
+		while (m_idx < points.size() && points[m_idx].y <= pulse)
+		{
+			if (++numSteps > kMaxLinearCursorSteps)
+			{
+				m_idx = findIdx();
+				break;
+			}
+			++m_idx;
+		}
+	}
+
+	if (m_idx == 0)
+	{
+		return points.front().v;
+	}
+	if (m_idx == points.size())
+	{
+		return points.back().vf;
+	}
+	return Lerp(points[m_idx - 1], points[m_idx], pulse);
+}
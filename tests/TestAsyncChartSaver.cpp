@@ -0,0 +1,180 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	kson::ChartData CreateTitledChart(const std::string& title)
+	{
+		kson::ChartData chartData;
+		chartData.meta.title = title;
+		chartData.beat.bpm[0] = 120.0;
+		chartData.note.bt[0][0] = kson::Interval{ 0 };
+		return chartData;
+	}
+
+	std::string ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream ifs(path, std::ios_base::binary);
+		return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	}
+}
+
+TEST_CASE("SaveChartDataAtomically", "[async_chart_saver]")
+{
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / "kson_test_save_atomically";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+
+	SECTION("KSON")
+	{
+		const std::string path = (dir / "chart.kson").string();
+		REQUIRE(kson::SaveChartDataAtomically(path, chartData) == kson::ErrorType::None);
+		REQUIRE(!std::filesystem::exists(path + ".tmp"));
+
+		std::ostringstream expected;
+		REQUIRE(kson::SaveKsonChartData(expected, chartData) == kson::ErrorType::None);
+		REQUIRE(ReadFile(path) == expected.str());
+	}
+
+	SECTION("KSH")
+	{
+		const std::string path = (dir / "chart.ksh").string();
+		const kson::ChartSavingOptions options{ .format = kson::ChartFileFormat::Ksh };
+		REQUIRE(kson::SaveChartDataAtomically(path, CreateTitledChart("old"), options) == kson::ErrorType::None);
+		REQUIRE(kson::SaveChartDataAtomically(path, chartData, options) == kson::ErrorType::None);
+		REQUIRE(!std::filesystem::exists(path + ".tmp"));
+
+		std::ostringstream expected;
+		REQUIRE(kson::SaveKshChartData(expected, chartData) == kson::ErrorType::None);
+		REQUIRE(ReadFile(path) == expected.str());
+	}
+
+	SECTION("Failure keeps the destination")
+	{
+		// The destination is a directory, so it cannot be replaced
+		const std::filesystem::path path = dir / "chart_dir.kson";
+		std::filesystem::create_directories(path / "child");
+		REQUIRE(kson::SaveChartDataAtomically(path.string(), chartData) != kson::ErrorType::None);
+		REQUIRE(std::filesystem::is_directory(path / "child"));
+		REQUIRE(!std::filesystem::exists(path.string() + ".tmp"));
+
+		// Nonexistent directory
+		REQUIRE(kson::SaveChartDataAtomically((dir / "missing" / "chart.kson").string(), chartData) == kson::ErrorType::CouldNotOpenOutputFileStream);
+	}
+
+	std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("AsyncChartSaver coalesces requests", "[async_chart_saver]")
+{
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / "kson_test_async_chart_saver";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	const std::string path = (dir / "autosave.kson").string();
+
+	SECTION("Only the latest snapshot is written")
+	{
+		kson::AsyncChartSaver saver(path, { .minWriteInterval = std::chrono::milliseconds(200) });
+		REQUIRE(saver.flush() == kson::ErrorType::None);
+		REQUIRE(saver.numWrites() == 0);
+
+		constexpr int kNumRequests = 50;
+		for (int i = 1; i <= kNumRequests; ++i)
+		{
+			REQUIRE(saver.requestSave(CreateTitledChart("title " + std::to_string(i))) == static_cast<kson::AsyncChartSaver::Generation>(i));
+		}
+		REQUIRE(saver.requestedGeneration() == kNumRequests);
+		REQUIRE(saver.flush() == kson::ErrorType::None);
+		REQUIRE(saver.writtenGeneration() == kNumRequests);
+
+		// The first request may be written at once; the others are coalesced into one write
+		REQUIRE(saver.numWrites() <= 2);
+		REQUIRE(kson::LoadKsonChartData(path).meta.title == "title 50");
+		REQUIRE(!std::filesystem::exists(path + ".tmp"));
+	}
+
+	SECTION("Writes are at least minWriteInterval apart")
+	{
+		kson::AsyncChartSaver saver(path, { .minWriteInterval = std::chrono::milliseconds(100) });
+		const auto start = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(350))
+		{
+			saver.requestSave(CreateTitledChart("edit"));
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		REQUIRE(saver.flush() == kson::ErrorType::None);
+		REQUIRE(saver.numWrites() >= 1);
+		REQUIRE(saver.numWrites() <= 6);
+	}
+
+	SECTION("Destruction writes the pending snapshot")
+	{
+		{
+			kson::AsyncChartSaver saver(path, { .minWriteInterval = std::chrono::hours(1) });
+			saver.requestSave(CreateTitledChart("first"));
+			saver.requestSave(std::make_shared<const kson::ChartData>(CreateTitledChart("last")));
+		}
+		REQUIRE(kson::LoadKsonChartData(path).meta.title == "last");
+	}
+
+	SECTION("Errors are reported")
+	{
+		kson::AsyncChartSaver saver((dir / "missing" / "autosave.kson").string());
+		saver.requestSave(CreateTitledChart("title"));
+		REQUIRE(saver.flush() == kson::ErrorType::CouldNotOpenOutputFileStream);
+		REQUIRE(saver.lastError() == kson::ErrorType::CouldNotOpenOutputFileStream);
+	}
+
+	std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("AsyncChartSaver requests from multiple threads", "[async_chart_saver][concurrency]")
+{
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / "kson_test_async_chart_saver_threads";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	const std::string path = (dir / "autosave.ksh").string();
+
+	{
+		kson::AsyncChartSaver saver(path, { .savingOptions = { .format = kson::ChartFileFormat::Ksh } });
+		const auto snapshot = std::make_shared<const kson::ChartData>(CreateTitledChart("shared"));
+		std::atomic<int> numFlushErrors = 0;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&saver, &snapshot, &numFlushErrors]
+			{
+				for (int j = 0; j < 100; ++j)
+				{
+					saver.requestSave(snapshot);
+				}
+				if (saver.flush() != kson::ErrorType::None)
+				{
+					++numFlushErrors;
+				}
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		REQUIRE(numFlushErrors == 0);
+		REQUIRE(saver.requestedGeneration() == 400);
+		REQUIRE(saver.writtenGeneration() == 400);
+		REQUIRE(saver.numWrites() <= 400);
+	}
+
+	const kson::ChartData chartData = kson::LoadKshChartData(path);
+	REQUIRE(chartData.error == kson::ErrorType::None);
+	REQUIRE(chartData.meta.title == "shared");
+	std::filesystem::remove_all(dir);
+}
@@ -2,6 +2,7 @@
 #include <kson/kson.hpp>
 #include <kson/Util/TimingUtils.hpp>
 #include <kson/Util/GraphUtils.hpp>
+#include <kson/Common/LookupTable.hpp>
 
 TEST_CASE("Basic Chart Data", "[chart]") {
 	SECTION("Empty ChartData initialization") {
@@ -255,6 +256,74 @@ TEST_CASE("Graph Utilities", "[graph]") {
 			REQUIRE(kson::GraphValueAt(graph, 360) == Approx(0.9375));
 		}
 	}
+
+	SECTION("Expanding curve segments without exceptions") {
+		kson::Graph graph;
+		graph.emplace(0, kson::GraphPoint{0.0, {0.0, 1.0}});
+		graph.emplace(480, 1.0);
+
+		REQUIRE(!kson::TryExpandCurveSegments(graph, 0).has_value());
+		REQUIRE(!kson::TryExpandCurveSegments(graph, -120).has_value());
+
+		const auto expanded = kson::TryExpandCurveSegments(graph, 120);
+		REQUIRE(expanded.has_value());
+		REQUIRE(expanded->size() == 5);
+		REQUIRE(kson::GraphValueAt(*expanded, 120) == Approx(0.75));
+
+#if KSON_HAS_EXCEPTIONS
+		REQUIRE_THROWS_AS(kson::ExpandCurveSegments(graph, 0), std::invalid_argument);
+#endif
+	}
+}
+
+TEST_CASE("Audio Effect Definitions", "[audio_effect]") {
+	kson::AudioEffectFXInfo fxInfo;
+	fxInfo.def.push_back({ .name = "myFlanger", .v = { .type = kson::AudioEffectType::Flanger } });
+
+	REQUIRE(fxInfo.findDef("myFlanger") != nullptr);
+	REQUIRE(fxInfo.findDef("myFlanger")->type == kson::AudioEffectType::Flanger);
+	REQUIRE(fxInfo.findDef("unknown") == nullptr);
+
+#if KSON_HAS_EXCEPTIONS
+	REQUIRE_THROWS_AS(fxInfo.defByName("unknown"), std::runtime_error);
+#endif
+}
+
+TEST_CASE("Audio Effect Type Names", "[audio_effect]") {
+	for (int i = static_cast<int>(kson::AudioEffectType::Retrigger); i <= static_cast<int>(kson::AudioEffectType::PeakingFilter); ++i) {
+		const auto type = static_cast<kson::AudioEffectType>(i);
+		REQUIRE(!kson::AudioEffectTypeToStr(type).empty());
+		REQUIRE(kson::StrToAudioEffectType(kson::AudioEffectTypeToStr(type)) == type);
+	}
+	REQUIRE(kson::AudioEffectTypeToStr(kson::AudioEffectType::Unspecified).empty());
+	REQUIRE(kson::StrToAudioEffectType("unknown") == kson::AudioEffectType::Unspecified);
+	REQUIRE(kson::StrToAudioEffectType("") == kson::AudioEffectType::Unspecified);
+}
+
+TEST_CASE("Lookup Table", "[lookup_table]") {
+	constexpr auto kTable = kson::MakeLookupTable<std::string_view, int>({
+		{ "c", 3 },
+		{ "a", 1 },
+		{ "e", 5 },
+		{ "b", 2 },
+		{ "d", 4 },
+	});
+	static_assert(*kTable.find("a") == 1);
+	static_assert(kTable.find("f") == nullptr);
+
+	for (const auto& [key, value] : kTable) {
+		REQUIRE(kTable.find(key) != nullptr);
+		REQUIRE(*kTable.find(key) == value);
+	}
+	REQUIRE(!kTable.contains(""));
+	REQUIRE(!kTable.contains("0"));
+	REQUIRE(!kTable.contains("bb"));
+	REQUIRE(!kTable.contains("z"));
+	REQUIRE(kTable.valueOr(std::string{ "d" }, 0) == 4);
+	REQUIRE(kTable.valueOr("x", -1) == -1);
+
+	constexpr auto kEmptyTable = kson::LookupTable<std::string_view, int, 0>({});
+	REQUIRE(!kEmptyTable.contains("a"));
 }
 
 TEST_CASE("Note Data", "[note]") {
@@ -0,0 +1,226 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	std::vector<std::string> CreatePaths(std::size_t count)
+	{
+		std::vector<std::string> paths;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			paths.push_back("songs/song" + std::to_string(i) + "/chart.ksh");
+		}
+		return paths;
+	}
+
+	std::string ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream ifs(path, std::ios_base::binary);
+		std::ostringstream oss;
+		oss << ifs.rdbuf();
+		return oss.str();
+	}
+}
+
+TEST_CASE("Batch shard parsing", "[batch]")
+{
+	const auto shard = kson::ParseBatchShard("2/8");
+	REQUIRE(shard.has_value());
+	REQUIRE(shard->idx == 2);
+	REQUIRE(shard->count == 8);
+
+	REQUIRE(kson::ParseBatchShard("0/1").has_value());
+	REQUIRE(!kson::ParseBatchShard("8/8").has_value());
+	REQUIRE(!kson::ParseBatchShard("0/0").has_value());
+	REQUIRE(!kson::ParseBatchShard("1").has_value());
+	REQUIRE(!kson::ParseBatchShard("/2").has_value());
+	REQUIRE(!kson::ParseBatchShard("1/2x").has_value());
+	REQUIRE(!kson::ParseBatchShard("-1/2").has_value());
+}
+
+TEST_CASE("Batch shards partition the manifest deterministically", "[batch]")
+{
+	const std::vector<std::string> paths = CreatePaths(200);
+	constexpr std::size_t kNumShards = 4;
+
+	std::multiset<std::string> selectedPaths;
+	for (std::size_t i = 0; i < kNumShards; ++i)
+	{
+		const std::vector<std::string> shardPaths = kson::SelectBatchShard(paths, { .idx = i, .count = kNumShards });
+
+		// Every shard gets a share of the files
+		REQUIRE(shardPaths.size() > paths.size() / kNumShards / 2);
+		selectedPaths.insert(shardPaths.begin(), shardPaths.end());
+
+		// The shard of a path does not depend on the order of the manifest
+		std::vector<std::string> reversedPaths(paths.rbegin(), paths.rend());
+		std::vector<std::string> reversedShardPaths = kson::SelectBatchShard(reversedPaths, { .idx = i, .count = kNumShards });
+		std::reverse(reversedShardPaths.begin(), reversedShardPaths.end());
+		REQUIRE(reversedShardPaths == shardPaths);
+	}
+
+	// Each path is in exactly one shard
+	REQUIRE(selectedPaths == std::multiset<std::string>(paths.begin(), paths.end()));
+
+	// A single shard contains everything
+	REQUIRE(kson::SelectBatchShard(paths, {}) == paths);
+}
+
+TEST_CASE("Batch manifest loading", "[batch]")
+{
+	std::istringstream iss("# comment\r\nsongs/a.ksh\r\n\r\nsongs/b c.ksh\nsongs/#c.ksh");
+	const kson::BatchManifest manifest = kson::LoadBatchManifest(iss);
+	REQUIRE(manifest.error == kson::ErrorType::None);
+	REQUIRE(manifest.paths == std::vector<std::string>{ "songs/a.ksh", "songs/b c.ksh", "songs/#c.ksh" });
+
+	REQUIRE(kson::LoadBatchManifest(g_assetsDir + "/not_found.txt").error == kson::ErrorType::FileNotFound);
+}
+
+TEST_CASE("Batch record formatting", "[batch]")
+{
+	const kson::BatchRecord record{
+		.status = kson::BatchStatus::Done,
+		.path = "songs/a\tb\\c.ksh",
+		.fields = { "out/a.kson", "Title\nwith break\r", "" },
+	};
+	const std::string line = kson::FormatBatchRecord(record);
+	REQUIRE(line == "done\tsongs/a\\tb\\\\c.ksh\tout/a.kson\tTitle\\nwith break\\r\t");
+	REQUIRE(kson::ParseBatchRecord(line) == record);
+
+	const kson::BatchRecord failedRecord{ .status = kson::BatchStatus::Failed, .path = "b.ksh", .fields = { "Error" } };
+	REQUIRE(kson::ParseBatchRecord(kson::FormatBatchRecord(failedRecord)) == failedRecord);
+
+	REQUIRE(!kson::ParseBatchRecord("").has_value());
+	REQUIRE(!kson::ParseBatchRecord("done").has_value());
+	REQUIRE(!kson::ParseBatchRecord("ok\ta.ksh").has_value());
+	REQUIRE(!kson::ParseBatchRecord("done\ta.ksh\\").has_value());
+	REQUIRE(!kson::ParseBatchRecord("#status\tpath").has_value());
+}
+
+TEST_CASE("Batch journal resume and merge", "[batch]")
+{
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / "kson_test_batch_journal";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	const std::string journalFilePath = (dir / "shard-0.journal").string();
+
+	{
+		kson::BatchJournal journal;
+		REQUIRE(journal.open(journalFilePath) == kson::ErrorType::None);
+		REQUIRE(journal.append({ .status = kson::BatchStatus::Done, .path = "a.ksh", .fields = { "a.kson" } }) == kson::ErrorType::None);
+		REQUIRE(journal.append({ .status = kson::BatchStatus::Failed, .path = "b.ksh", .fields = { "Error" } }) == kson::ErrorType::None);
+		REQUIRE(journal.isDone("a.ksh"));
+		REQUIRE(!journal.isDone("b.ksh"));
+	}
+
+	// Simulate a job interrupted while writing a record
+	{
+		std::ofstream ofs(journalFilePath, std::ios_base::binary | std::ios_base::app);
+		ofs << "done\tc.ks";
+	}
+	{
+		std::vector<kson::BatchRecord> records;
+		REQUIRE(kson::LoadBatchJournal(journalFilePath, &records) == kson::ErrorType::None);
+		REQUIRE(records.size() == 2);
+	}
+
+	{
+		kson::BatchJournal journal;
+		REQUIRE(journal.open(journalFilePath) == kson::ErrorType::None);
+		REQUIRE(journal.isDone("a.ksh"));
+		REQUIRE(!journal.isDone("b.ksh"));
+		REQUIRE(!journal.isDone("c.ks"));
+		REQUIRE(journal.append({ .status = kson::BatchStatus::Done, .path = "b.ksh", .fields = { "b.kson" } }) == kson::ErrorType::None);
+	}
+	REQUIRE(ReadFile(journalFilePath) == "done\ta.ksh\ta.kson\nfailed\tb.ksh\tError\ndone\tb.ksh\tb.kson\n");
+
+	const std::string otherJournalFilePath = (dir / "shard-1.journal").string();
+	{
+		kson::BatchJournal journal;
+		REQUIRE(journal.open(otherJournalFilePath) == kson::ErrorType::None);
+		REQUIRE(journal.append({ .status = kson::BatchStatus::Failed, .path = "c.ksh", .fields = { "Error" } }) == kson::ErrorType::None);
+	}
+
+	std::vector<kson::BatchRecord> records;
+	REQUIRE(kson::MergeBatchJournals({ otherJournalFilePath, journalFilePath }, &records) == kson::ErrorType::None);
+	REQUIRE(records == std::vector<kson::BatchRecord>{
+		{ .status = kson::BatchStatus::Done, .path = "a.ksh", .fields = { "a.kson" } },
+		{ .status = kson::BatchStatus::Done, .path = "b.ksh", .fields = { "b.kson" } },
+		{ .status = kson::BatchStatus::Failed, .path = "c.ksh", .fields = { "Error" } },
+	});
+
+	REQUIRE(kson::MergeBatchJournals({ (dir / "not_found.journal").string() }, &records) == kson::ErrorType::FileNotFound);
+
+	std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Batch job skips the files done in the journal", "[batch]")
+{
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / "kson_test_batch_job";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+
+	const std::vector<std::string> paths = CreatePaths(40);
+	const kson::BatchShard shard{ .idx = 1, .count = 3 };
+	const std::vector<std::string> shardPaths = kson::SelectBatchShard(paths, shard);
+	REQUIRE(shardPaths.size() > 2);
+	const std::string failingPath = shardPaths[1];
+
+	std::mutex mutex;
+	std::vector<std::string> processedPaths;
+	bool fail = true;
+	const auto processor = [&](const std::string& path)
+	{
+		const std::lock_guard lock(mutex);
+		processedPaths.push_back(path);
+		if (fail && path == failingPath)
+		{
+			return kson::BatchRecord{ .status = kson::BatchStatus::Failed, .fields = { "Error" } };
+		}
+		return kson::BatchRecord{ .status = kson::BatchStatus::Done, .fields = { path + ".kson" } };
+	};
+
+	const kson::BatchJobOptions options{
+		.shard = shard,
+		.journalFilePath = (dir / "shard-1.journal").string(),
+		.numThreads = 4,
+	};
+	kson::BatchJobResult result = kson::RunBatchJob(paths, options, processor);
+	REQUIRE(result.error == kson::ErrorType::None);
+	REQUIRE(result.numFiles == shardPaths.size());
+	REQUIRE(result.numSkipped == 0);
+	REQUIRE(result.numDone == shardPaths.size() - 1);
+	REQUIRE(result.numFailed == 1);
+	std::sort(processedPaths.begin(), processedPaths.end());
+	std::vector<std::string> sortedShardPaths = shardPaths;
+	std::sort(sortedShardPaths.begin(), sortedShardPaths.end());
+	REQUIRE(processedPaths == sortedShardPaths);
+
+	// Rerun: only the failed file is processed again
+	processedPaths.clear();
+	fail = false;
+	result = kson::RunBatchJob(paths, options, processor);
+	REQUIRE(result.error == kson::ErrorType::None);
+	REQUIRE(result.numSkipped == shardPaths.size() - 1);
+	REQUIRE(result.numDone == 1);
+	REQUIRE(result.numFailed == 0);
+	REQUIRE(processedPaths == std::vector<std::string>{ failingPath });
+
+	std::vector<kson::BatchRecord> records;
+	REQUIRE(kson::MergeBatchJournals({ options.journalFilePath }, &records) == kson::ErrorType::None);
+	REQUIRE(records.size() == shardPaths.size());
+	for (const kson::BatchRecord& record : records)
+	{
+		REQUIRE(record.status == kson::BatchStatus::Done);
+		REQUIRE(record.fields == std::vector<std::string>{ record.path + ".kson" });
+	}
+
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/Canonicalize.hpp>
+
+TEST_CASE("CanonicalizeGraph", "[canonicalize][graph]")
+{
+	SECTION("Collinear and repeated points are removed")
+	{
+		kson::Graph graph;
+		graph[0] = kson::GraphValue{ 0.0 };
+		graph[240] = kson::GraphValue{ 0.25 };
+		graph[480] = kson::GraphValue{ 0.5 };
+		graph[960] = kson::GraphValue{ 1.0 };
+		graph[1920] = kson::GraphValue{ 1.0 };
+		graph[2880] = kson::GraphValue{ 1.0 };
+
+		const kson::Graph original = graph;
+		REQUIRE(kson::CanonicalizeGraph(graph) == 4);
+		REQUIRE(graph.size() == 2);
+		REQUIRE(graph.contains(0));
+		REQUIRE(graph.contains(960));
+
+		for (kson::Pulse y = 0; y <= 3840; y += 60)
+		{
+			REQUIRE(kson::GraphValueAt(graph, y) == Approx(kson::GraphValueAt(original, y)));
+		}
+	}
+
+	SECTION("Slams and curves are kept")
+	{
+		kson::Graph graph;
+		graph[0] = kson::GraphValue{ 0.0 };
+		graph[240] = kson::GraphValue{ 0.25, 0.5 };
+		graph[480] = kson::GraphPoint{ kson::GraphValue{ 0.75 }, kson::GraphCurveValue{ 0.2, 0.8 } };
+		graph[720] = kson::GraphValue{ 1.0 };
+		graph[960] = kson::GraphValue{ 1.25 };
+
+		REQUIRE(kson::CanonicalizeGraph(graph) == 0);
+		REQUIRE(graph.size() == 5);
+	}
+
+	SECTION("Tolerance")
+	{
+		kson::Graph graph;
+		graph[0] = kson::GraphValue{ 0.0 };
+		graph[240] = kson::GraphValue{ 0.26 };
+		graph[480] = kson::GraphValue{ 0.49 };
+		graph[720] = kson::GraphValue{ 0.76 };
+		graph[960] = kson::GraphValue{ 1.0 };
+
+		kson::Graph exact = graph;
+		REQUIRE(kson::CanonicalizeGraph(exact) == 0);
+
+		const kson::Graph original = graph;
+		REQUIRE(kson::CanonicalizeGraph(graph, kson::CanonicalizeOptions{ .tolerance = 0.02 }) == 3);
+		for (kson::Pulse y = 0; y <= 960; y += 10)
+		{
+			REQUIRE(std::abs(kson::GraphValueAt(graph, y) - kson::GraphValueAt(original, y)) <= 0.02);
+		}
+	}
+
+	SECTION("Tolerance does not accumulate")
+	{
+		// Each point is within the tolerance from the line through its neighbors, but not from the line through the ends
+		kson::Graph graph;
+		for (kson::Pulse i = 0; i <= 10; ++i)
+		{
+			graph[i * 100] = kson::GraphValue{ static_cast<double>(i * i) * 0.01 };
+		}
+
+		const kson::Graph original = graph;
+		kson::CanonicalizeGraph(graph, kson::CanonicalizeOptions{ .tolerance = 0.05 });
+		REQUIRE(graph.size() > 2);
+		for (kson::Pulse y = 0; y <= 1000; y += 10)
+		{
+			REQUIRE(std::abs(kson::GraphValueAt(graph, y) - kson::GraphValueAt(original, y)) <= 0.05 + 1e-9);
+		}
+	}
+
+	SECTION("Ramer-Douglas-Peucker mode")
+	{
+		kson::Graph graph;
+		for (kson::Pulse i = 0; i <= 10; ++i)
+		{
+			graph[i * 100] = kson::GraphValue{ static_cast<double>(i * i) * 0.01 };
+		}
+
+		const kson::Graph original = graph;
+		kson::CanonicalizeGraph(graph, kson::CanonicalizeOptions{ .tolerance = 0.05, .useRDP = true });
+		REQUIRE(graph.size() > 2);
+		REQUIRE(graph.size() < original.size());
+		REQUIRE(graph.contains(0));
+		REQUIRE(graph.contains(1000));
+		for (kson::Pulse y = 0; y <= 1000; y += 10)
+		{
+			REQUIRE(std::abs(kson::GraphValueAt(graph, y) - kson::GraphValueAt(original, y)) <= 0.05 + 1e-9);
+		}
+	}
+}
+
+TEST_CASE("CanonicalizeChart", "[canonicalize]")
+{
+	kson::ChartData chartData;
+	chartData.beat.bpm[0] = 120.0;
+	chartData.beat.bpm[960] = 120.0;
+	chartData.beat.bpm[1920] = 150.0;
+	chartData.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+	chartData.beat.timeSig[4] = kson::TimeSig{ 4, 4 };
+	chartData.beat.scrollSpeed[0] = kson::GraphValue{ 1.0 };
+	chartData.beat.scrollSpeed[960] = kson::GraphValue{ 1.0 };
+
+	auto& section = chartData.note.laser[0][0];
+	section.v[0] = kson::GraphPoint{ kson::GraphValue{ 0.0 } };
+	section.v[240] = kson::GraphPoint{ kson::GraphValue{ 0.5 } };
+	section.v[480] = kson::GraphPoint{ kson::GraphValue{ 1.0 } };
+	section.v[720] = kson::GraphPoint{ kson::GraphValue{ 1.0 } };
+
+	chartData.camera.tilt[0] = kson::AutoTiltType::kBigger;
+	chartData.camera.tilt[240] = kson::AutoTiltType::kBigger;
+	chartData.camera.tilt[480] = kson::TiltGraphPoint{ 0.5 };
+	chartData.camera.tilt[720] = kson::TiltGraphPoint{ 0.5 };
+	chartData.camera.tilt[960] = kson::TiltGraphPoint{ 1.0 };
+	chartData.camera.tilt[1200] = kson::AutoTiltType::kNormal;
+
+	chartData.audio.audioEffect.fx.paramChange["retrigger"]["wave_length"][0] = "1/8";
+	chartData.audio.audioEffect.fx.paramChange["retrigger"]["wave_length"][960] = "1/8";
+	chartData.audio.audioEffect.fx.paramChange["retrigger"]["wave_length"][1920] = "1/16";
+
+	REQUIRE(kson::CanonicalizeChart(chartData) == 6);
+
+	REQUIRE(chartData.beat.bpm.size() == 2);
+	REQUIRE(chartData.beat.bpm.contains(1920));
+	REQUIRE(chartData.beat.timeSig.size() == 1);
+	REQUIRE(chartData.beat.scrollSpeed.size() == 1);
+
+	// The first and last laser points are kept
+	REQUIRE(section.v.size() == 3);
+	REQUIRE(!section.v.contains(240));
+	REQUIRE(section.v.contains(720));
+
+	// The repeated manual tilt value at 720 is not redundant because the next point is interpolated from it
+	REQUIRE(chartData.camera.tilt.size() == 5);
+	REQUIRE(!chartData.camera.tilt.contains(240));
+
+	REQUIRE(chartData.audio.audioEffect.fx.paramChange["retrigger"]["wave_length"].size() == 2);
+}
@@ -0,0 +1,174 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/ChartCache.hpp>
+#include <atomic>
+#include <thread>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	kson::ChartData CreateChart(std::size_t numNotes)
+	{
+		kson::ChartData chartData;
+		chartData.beat.bpm[0] = 120.0;
+		chartData.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+		for (std::size_t i = 0; i < numNotes; ++i)
+		{
+			chartData.note.bt[i % kson::kNumBTLanesSZ][static_cast<kson::Pulse>(i) * 120] = kson::Interval{ 0 };
+		}
+		return chartData;
+	}
+}
+
+TEST_CASE("EstimateChartDataSize", "[chart_cache]")
+{
+	const std::size_t emptySize = kson::EstimateChartDataSize(CreateChart(0));
+	const std::size_t size100 = kson::EstimateChartDataSize(CreateChart(100));
+	const std::size_t size200 = kson::EstimateChartDataSize(CreateChart(200));
+	REQUIRE(emptySize < size100);
+	REQUIRE(size200 - size100 == size100 - emptySize);
+}
+
+TEST_CASE("ChartCache eviction", "[chart_cache]")
+{
+	const std::size_t chartSize = kson::EstimateChartDataSize(CreateChart(100));
+	kson::ChartCache cache({ .byteBudget = chartSize * 2 });
+
+	cache.insert("a", CreateChart(100));
+	cache.insert("b", CreateChart(100));
+	REQUIRE(cache.find("a") != nullptr); // "b" is now the least recently used
+
+	SECTION("Least recently used")
+	{
+		cache.insert("c", CreateChart(100));
+		REQUIRE(cache.find("b") == nullptr);
+		REQUIRE(cache.find("a") != nullptr);
+		REQUIRE(cache.find("c") != nullptr);
+
+		const auto stats = cache.stats();
+		REQUIRE(stats.numEvictions == 1);
+		REQUIRE(stats.numResident == 2);
+		REQUIRE(stats.residentBytes == chartSize * 2);
+	}
+
+	SECTION("Pinned charts are not evicted")
+	{
+		REQUIRE(cache.pin("b"));
+		REQUIRE(!cache.pin("unknown"));
+		cache.insert("c", CreateChart(100));
+		REQUIRE(cache.find("a") == nullptr);
+		REQUIRE(cache.find("b") != nullptr);
+
+		// Over the budget while all charts are pinned
+		REQUIRE(cache.pin("c"));
+		cache.insert("d", CreateChart(100));
+		REQUIRE(cache.find("d") == nullptr);
+
+		cache.insert("e", CreateChart(100));
+		REQUIRE(cache.stats().numResident == 2);
+
+		cache.unpin("b");
+		cache.insert("f", CreateChart(100));
+		REQUIRE(cache.find("b") == nullptr);
+		REQUIRE(cache.find("c") != nullptr);
+		REQUIRE(cache.find("f") != nullptr);
+	}
+
+	SECTION("Erase and clear")
+	{
+		cache.erase("a");
+		REQUIRE(cache.find("a") == nullptr);
+		REQUIRE(cache.stats().residentBytes == chartSize);
+
+		cache.clear();
+		REQUIRE(cache.find("b") == nullptr);
+		REQUIRE(cache.stats().residentBytes == 0);
+	}
+}
+
+TEST_CASE("ChartCache getOrLoad", "[chart_cache]")
+{
+	kson::ChartCache cache;
+
+	SECTION("Concurrent loads of the same chart are deduplicated")
+	{
+		std::atomic<int> numLoads = 0;
+		const auto loader = [&numLoads]()
+		{
+			++numLoads;
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			return CreateChart(10);
+		};
+
+		std::vector<std::shared_ptr<const kson::ChartData>> results(8);
+		std::vector<std::thread> threads;
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			threads.emplace_back([&, i]() { results[i] = cache.getOrLoad("chart", loader); });
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		REQUIRE(numLoads == 1);
+		for (const auto& result : results)
+		{
+			REQUIRE(result == results[0]);
+		}
+
+		REQUIRE(cache.getOrLoad("chart", loader) == results[0]);
+		REQUIRE(numLoads == 1);
+	}
+
+	SECTION("Charts with an error are not cached")
+	{
+		int numLoads = 0;
+		const auto loader = [&numLoads]()
+		{
+			++numLoads;
+			return kson::ChartData{ .error = kson::ErrorType::FileNotFound };
+		};
+		REQUIRE(cache.getOrLoad("missing", loader)->error == kson::ErrorType::FileNotFound);
+		REQUIRE(cache.getOrLoad("missing", loader)->error == kson::ErrorType::FileNotFound);
+		REQUIRE(numLoads == 2);
+		REQUIRE(cache.find("missing") == nullptr);
+	}
+}
+
+TEST_CASE("ChartCache compressed tier", "[chart_cache]")
+{
+	const std::string path = g_assetsDir + "/Gram_ex.ksh";
+	const auto loader = [&path]() { return kson::LoadKshChartData(path); };
+
+	// No resident budget, so the chart goes to the compressed tier right after loading
+	kson::ChartCache cache({ .byteBudget = 0, .compressedByteBudget = 16 * 1024 * 1024 });
+	const auto original = cache.getOrLoad(path, loader);
+	REQUIRE(original->error == kson::ErrorType::None);
+
+	auto stats = cache.stats();
+	REQUIRE(stats.numResident == 0);
+	REQUIRE(stats.numCompressed == 1);
+	REQUIRE(stats.compressedBytes > 0);
+	REQUIRE(stats.compressedBytes < kson::EstimateChartDataSize(*original) / 4);
+
+	const auto decoded = cache.find(path);
+	REQUIRE(decoded != nullptr);
+	REQUIRE(decoded != original);
+	REQUIRE(decoded->meta.title == original->meta.title);
+	for (std::size_t i = 0; i < kson::kNumBTLanesSZ; ++i)
+	{
+		REQUIRE(decoded->note.bt[i].size() == original->note.bt[i].size());
+		for (const auto& [y, interval] : original->note.bt[i])
+		{
+			REQUIRE(decoded->note.bt[i].contains(y));
+			REQUIRE(decoded->note.bt[i].at(y).length == interval.length);
+		}
+	}
+	REQUIRE(decoded->note.laser[0].size() == original->note.laser[0].size());
+
+	stats = cache.stats();
+	REQUIRE(stats.numCompressedHits == 1);
+	REQUIRE(stats.numMisses == 1);
+}
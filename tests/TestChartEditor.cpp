@@ -0,0 +1,245 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/ChartEditor.hpp>
+
+namespace
+{
+	kson::ChartData CreateChart(std::size_t numMeasures)
+	{
+		kson::ChartData chartData;
+		chartData.beat.bpm[0] = 120.0;
+		chartData.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+		for (std::size_t i = 0; i < numMeasures; ++i)
+		{
+			const kson::Pulse y = static_cast<kson::Pulse>(i) * kson::kResolution4;
+			for (std::size_t lane = 0; lane < kson::kNumBTLanesSZ; ++lane)
+			{
+				chartData.note.bt[lane][y + static_cast<kson::Pulse>(lane) * kson::kResolution] = kson::Interval{ 0 };
+			}
+			chartData.note.fx[i % kson::kNumFXLanesSZ][y] = kson::Interval{ kson::kResolution };
+		}
+		return chartData;
+	}
+
+	std::vector<std::pair<kson::Pulse, kson::Pulse>> ToPairs(const kson::PulseRangeSet& rangeSet)
+	{
+		std::vector<std::pair<kson::Pulse, kson::Pulse>> pairs;
+		for (const auto& range : rangeSet.ranges())
+		{
+			pairs.emplace_back(range.begin, range.end);
+		}
+		return pairs;
+	}
+
+	// Derived data used to check incremental rebuilds: note times per BT lane
+	using NoteMsList = std::array<std::map<kson::Pulse, double>, kson::kNumBTLanesSZ>;
+
+	void RebuildNoteMs(NoteMsList& noteMs, const kson::ChartData& chartData, const kson::TimingCache& timingCache, std::size_t lane, const kson::PulseRange& range)
+	{
+		auto& laneNoteMs = noteMs[lane];
+		laneNoteMs.erase(laneNoteMs.lower_bound(range.begin), laneNoteMs.lower_bound(range.end));
+
+		const auto& btLane = chartData.note.bt[lane];
+		for (auto itr = btLane.lower_bound(range.begin); itr != btLane.end() && itr->first < range.end; ++itr)
+		{
+			laneNoteMs.emplace(itr->first, kson::PulseToMs(itr->first, chartData.beat, timingCache));
+		}
+	}
+}
+
+TEST_CASE("PulseRangeSet", "[chart_editor]")
+{
+	kson::PulseRangeSet rangeSet;
+	REQUIRE(rangeSet.empty());
+	REQUIRE(rangeSet.minPulse() == kson::kPulseRangeUnbounded);
+
+	rangeSet.add({ .begin = 100, .end = 200 });
+	rangeSet.add({ .begin = 300, .end = 400 });
+	rangeSet.add({ .begin = 500, .end = 500 }); // Empty
+	REQUIRE(ToPairs(rangeSet) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 100, 200 }, { 300, 400 } });
+
+	SECTION("Overlapping and adjacent ranges are merged")
+	{
+		rangeSet.add({ .begin = 150, .end = 250 });
+		REQUIRE(ToPairs(rangeSet) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 100, 250 }, { 300, 400 } });
+
+		rangeSet.add({ .begin = 250, .end = 300 });
+		REQUIRE(ToPairs(rangeSet) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 100, 400 } });
+
+		rangeSet.add({ .begin = 0, .end = 1000 });
+		REQUIRE(ToPairs(rangeSet) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 0, 1000 } });
+	}
+
+	SECTION("overlaps")
+	{
+		REQUIRE(rangeSet.overlaps({ .begin = 0, .end = 101 }));
+		REQUIRE(!rangeSet.overlaps({ .begin = 0, .end = 100 }));
+		REQUIRE(rangeSet.overlaps({ .begin = 199, .end = 300 }));
+		REQUIRE(!rangeSet.overlaps({ .begin = 200, .end = 300 }));
+		REQUIRE(rangeSet.overlaps({ .begin = 350, .end = 360 }));
+		REQUIRE(rangeSet.overlaps({ .begin = 0, .end = kson::kPulseRangeUnbounded }));
+		REQUIRE(!rangeSet.overlaps({ .begin = 400, .end = kson::kPulseRangeUnbounded }));
+	}
+}
+
+TEST_CASE("ChartEditor dirty ranges", "[chart_editor]")
+{
+	kson::ChartEditor editor(CreateChart(16));
+	REQUIRE(!editor.hasPendingChanges());
+
+	SECTION("Notes")
+	{
+		editor.setBTNote(1, 1000, kson::Interval{ 0 });
+		editor.setFXNote(0, 2000, kson::Interval{ 480 });
+		REQUIRE(!editor.removeBTNote(2, 12345));
+		editor.setBTNote(kson::kNumBTLanesSZ, 0, kson::Interval{ 0 }); // Ignored
+
+		const auto& dirtyRanges = editor.dirtyRanges();
+		REQUIRE(dirtyRanges.notesDirty());
+		REQUIRE(!dirtyRanges.timingDirty());
+		REQUIRE(ToPairs(dirtyRanges.bt[1]) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 1000, 1001 } });
+		REQUIRE(dirtyRanges.bt[0].empty());
+		REQUIRE(dirtyRanges.bt[2].empty());
+		REQUIRE(ToPairs(dirtyRanges.fx[0]) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 2000, 2481 } });
+		REQUIRE(editor.chartData().note.bt[1].contains(1000));
+
+		// Replacing a long note marks both the old and the new extent
+		editor.setFXNote(0, 0, kson::Interval{ 0 });
+		REQUIRE(ToPairs(editor.dirtyRanges().fx[0]) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 0, 241 }, { 2000, 2481 } });
+
+		REQUIRE(editor.removeBTNote(1, 1000));
+		REQUIRE(!editor.chartData().note.bt[1].contains(1000));
+	}
+
+	SECTION("Laser sections")
+	{
+		kson::LaserSection section;
+		section.v.emplace(0, kson::GraphPoint{ kson::GraphValue{ 0.0 } });
+		section.v.emplace(240, kson::GraphPoint{ kson::GraphValue{ 1.0 } });
+		editor.setLaserSection(1, 960, section);
+		REQUIRE(ToPairs(editor.dirtyRanges().laser[1]) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 960, 1201 } });
+		REQUIRE(editor.dirtyRanges().laser[0].empty());
+		REQUIRE(editor.removeLaserSection(1, 960));
+		REQUIRE(!editor.removeLaserSection(1, 960));
+	}
+
+	SECTION("Tempo and time signature")
+	{
+		editor.setBPM(1920, 180.0);
+		editor.setBPM(3840, 150.0);
+		REQUIRE(editor.dirtyRanges().timingDirty());
+		REQUIRE(!editor.dirtyRanges().notesDirty());
+		REQUIRE(ToPairs(editor.dirtyRanges().bpm) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 1920, kson::kPulseRangeUnbounded } });
+
+		editor.setTimeSig(2, kson::TimeSig{ 3, 4 });
+		REQUIRE(ToPairs(editor.dirtyRanges().timeSig) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 1920, kson::kPulseRangeUnbounded } });
+	}
+
+	SECTION("Scroll speed covers the neighboring points")
+	{
+		editor.setScrollSpeed(960, kson::GraphPoint{ kson::GraphValue{ 1.0 } });
+		editor.setScrollSpeed(1920, kson::GraphPoint{ kson::GraphValue{ 2.0 } });
+		editor.flush();
+
+		editor.setScrollSpeed(2880, kson::GraphPoint{ kson::GraphValue{ 0.5 } });
+		REQUIRE(ToPairs(editor.dirtyRanges().scrollSpeed) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 1920, kson::kPulseRangeUnbounded } });
+		editor.flush();
+
+		REQUIRE(editor.removeScrollSpeed(1920));
+		REQUIRE(ToPairs(editor.dirtyRanges().scrollSpeed) == std::vector<std::pair<kson::Pulse, kson::Pulse>>{ { 960, 2880 } });
+	}
+
+	SECTION("Arbitrary modification")
+	{
+		editor.modify([](kson::ChartData& chartData, kson::ChartDirtyRanges& dirtyRanges)
+		{
+			chartData.meta.title = "edited";
+			dirtyRanges.other = true;
+		});
+		REQUIRE(editor.hasPendingChanges());
+		REQUIRE(editor.chartData().meta.title == "edited");
+	}
+}
+
+TEST_CASE("ChartEditor subscribers", "[chart_editor]")
+{
+	kson::ChartEditor editor(CreateChart(64));
+
+	int numTimingRebuilds = 0;
+	kson::TimingCache timingCache = kson::CreateTimingCache(editor.chartData().beat);
+	NoteMsList noteMs;
+	for (std::size_t lane = 0; lane < kson::kNumBTLanesSZ; ++lane)
+	{
+		RebuildNoteMs(noteMs, editor.chartData(), timingCache, lane, kson::PulseRange{});
+	}
+
+	const auto timingSubscription = editor.subscribe([&](const kson::ChartData& chartData, const kson::ChartDirtyRanges& dirtyRanges)
+	{
+		if (dirtyRanges.timingDirty())
+		{
+			timingCache = kson::CreateTimingCache(chartData.beat);
+			++numTimingRebuilds;
+		}
+	});
+
+	// Subscribed later, so the timing cache is already up to date
+	int numNoteRanges = 0;
+	static_cast<void>(editor.subscribe([&](const kson::ChartData& chartData, const kson::ChartDirtyRanges& dirtyRanges)
+	{
+		for (std::size_t lane = 0; lane < kson::kNumBTLanesSZ; ++lane)
+		{
+			// Times of all the notes after a tempo change are affected
+			kson::PulseRangeSet rangeSet = dirtyRanges.bt[lane];
+			rangeSet.add(kson::PulseRange{ .begin = std::min(dirtyRanges.bpm.minPulse(), dirtyRanges.timeSig.minPulse()) });
+			for (const auto& range : rangeSet.ranges())
+			{
+				RebuildNoteMs(noteMs, chartData, timingCache, lane, range);
+				++numNoteRanges;
+			}
+		}
+	}));
+
+	const auto requireNoteMsUpToDate = [&]()
+	{
+		NoteMsList expected;
+		const kson::TimingCache fullTimingCache = kson::CreateTimingCache(editor.chartData().beat);
+		for (std::size_t lane = 0; lane < kson::kNumBTLanesSZ; ++lane)
+		{
+			RebuildNoteMs(expected, editor.chartData(), fullTimingCache, lane, kson::PulseRange{});
+		}
+		REQUIRE(noteMs == expected);
+	};
+
+	SECTION("Note edits do not rebuild the timing")
+	{
+		editor.setBTNote(2, 5000, kson::Interval{ 0 });
+		REQUIRE(editor.removeBTNote(0, 0));
+		editor.flush();
+		REQUIRE(numTimingRebuilds == 0);
+		REQUIRE(numNoteRanges == 2);
+		requireNoteMsUpToDate();
+
+		// Nothing to notify
+		editor.flush();
+		REQUIRE(numNoteRanges == 2);
+	}
+
+	SECTION("Tempo edits rebuild the following notes")
+	{
+		editor.setBTNote(3, 100, kson::Interval{ 0 });
+		editor.setBPM(kson::kResolution4 * 32, 240.0);
+		editor.flush();
+		REQUIRE(numTimingRebuilds == 1);
+		requireNoteMsUpToDate();
+		REQUIRE(noteMs[0].at(kson::kResolution4 * 33) == Approx(32 * 2000.0 + 1000.0));
+	}
+
+	SECTION("Unsubscribe")
+	{
+		editor.unsubscribe(timingSubscription);
+		editor.setBPM(0, 60.0);
+		editor.flush();
+		REQUIRE(numTimingRebuilds == 0);
+		REQUIRE(!editor.hasPendingChanges());
+	}
+}
@@ -0,0 +1,126 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/ChartQuery.hpp>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	kson::ChartData CreateChart()
+	{
+		kson::ChartData chartData;
+		chartData.meta.title = "Query, \"Test\"";
+		chartData.meta.level = 17;
+		chartData.beat.bpm[0] = 180.0;
+		chartData.beat.bpm[kson::kResolution4 * 4] = 320.0;
+		chartData.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+		chartData.note.bt[0][0] = kson::Interval{ 0 };
+		chartData.note.bt[1][kson::kResolution] = kson::Interval{ kson::kResolution };
+		chartData.note.fx[0][kson::kResolution4 * 7] = kson::Interval{ 0 };
+
+		auto& section = chartData.note.laser[0][0];
+		section.v.emplace(0, kson::GraphPoint{ kson::GraphValue{ 0.0, 1.0 } });
+		section.v.emplace(kson::kResolution, kson::GraphPoint{ kson::GraphValue{ 1.0, 0.0 } });
+		section.v.emplace(kson::kResolution * 2, kson::GraphPoint{ kson::GraphValue{ 0.5 } });
+
+		chartData.audio.audioEffect.fx.def.push_back({ .name = "SC", .v = { .type = kson::AudioEffectType::Sidechain } });
+		return chartData;
+	}
+
+	kson::ChartQueryValue Eval(std::string_view expression, const kson::ChartData& chartData)
+	{
+		std::string errorMessage;
+		const auto query = kson::ParseChartQuery(expression, &errorMessage);
+		INFO(expression << ": " << errorMessage);
+		REQUIRE(query.has_value());
+		return query->evaluate(chartData);
+	}
+
+	bool Matches(std::string_view expression, const kson::ChartData& chartData)
+	{
+		const auto query = kson::ParseChartQuery(expression);
+		INFO(expression);
+		REQUIRE(query.has_value());
+		return query->matches(chartData);
+	}
+}
+
+TEST_CASE("ChartQuery fields and functions", "[chart_query]")
+{
+	const kson::ChartData chartData = CreateChart();
+
+	REQUIRE(Eval("max_bpm", chartData) == kson::ChartQueryValue{ 320.0 });
+	REQUIRE(Eval("min_bpm", chartData) == kson::ChartQueryValue{ 180.0 });
+	REQUIRE(Eval("bt_chip_count", chartData) == kson::ChartQueryValue{ 1.0 });
+	REQUIRE(Eval("bt_long_count", chartData) == kson::ChartQueryValue{ 1.0 });
+	REQUIRE(Eval("note_count", chartData) == kson::ChartQueryValue{ 3.0 });
+	REQUIRE(Eval("laser_section_count", chartData) == kson::ChartQueryValue{ 1.0 });
+	REQUIRE(Eval("laser_slam_count", chartData) == kson::ChartQueryValue{ 2.0 });
+	REQUIRE(Eval("measure_count", chartData) == kson::ChartQueryValue{ 8.0 });
+	REQUIRE(std::get<double>(Eval("duration_ms", chartData)) == Approx(4 * 4 * 60000.0 / 180 + 3 * 4 * 60000.0 / 320));
+	REQUIRE(Eval("bpm_count_above(300)", chartData) == kson::ChartQueryValue{ 1.0 });
+	REQUIRE(Eval("title", chartData) == kson::ChartQueryValue{ std::string("Query, \"Test\"") });
+
+	REQUIRE(Matches("max_bpm > 300 && laser_slam_count >= 2", chartData));
+	REQUIRE(!Matches("max_bpm > 300 and laser_slam_count > 100", chartData));
+	REQUIRE(Matches("defines_fx_type(\"sidechain\")", chartData));
+	REQUIRE(!Matches("defines_laser_type('sidechain') or defines_fx_type('flanger')", chartData));
+	REQUIRE(Matches("contains(title, 'Test') && !starts_with(title, \"Test\")", chartData));
+	REQUIRE(Matches("not (level < 17) && level <= 17 && level != 18", chartData));
+	REQUIRE(Matches("(max_bpm - min_bpm) / 2 == 70 && -level * 2 + 34 == 0", chartData));
+	REQUIRE(!Matches("note_count / 0", chartData));
+	REQUIRE(Matches("title != ''", chartData));
+	REQUIRE(Matches("has_wide_laser == false", chartData));
+}
+
+TEST_CASE("ChartQuery errors", "[chart_query]")
+{
+	const auto requireError = [](std::string_view expression, std::string_view expectedMessage)
+	{
+		std::string errorMessage;
+		INFO(expression);
+		REQUIRE(!kson::ParseChartQuery(expression, &errorMessage).has_value());
+		REQUIRE(errorMessage.find(expectedMessage) != std::string::npos);
+	};
+
+	requireError("", "Unexpected end of expression");
+	requireError("unknown_field > 1", "Unknown field 'unknown_field'");
+	requireError("unknown_func()", "Unknown function 'unknown_func'");
+	requireError("title > 1", "Cannot compare string with number");
+	requireError("title + 1", "Arithmetic operators require numbers");
+	requireError("contains(title)", "contains() takes 2 argument(s)");
+	requireError("defines_fx_type(1)", "Argument 1 of defines_fx_type() must be string");
+	requireError("level > 1 )", "Unexpected ')' at position 11");
+	requireError("'abc", "Unterminated string");
+	requireError("level # 1", "Unexpected character '#'");
+	requireError("(level > 1", "Expected ')'");
+}
+
+TEST_CASE("ChartQuery on an empty chart", "[chart_query]")
+{
+	// Fields that depend on timing must not require tempo or time signature
+	const kson::ChartData chartData;
+	REQUIRE(Eval("duration_ms", chartData) == kson::ChartQueryValue{ 0.0 });
+	REQUIRE(Eval("measure_count", chartData) == kson::ChartQueryValue{ 0.0 });
+	REQUIRE(Eval("max_bpm", chartData) == kson::ChartQueryValue{ 0.0 });
+}
+
+TEST_CASE("ChartQuery value formatting", "[chart_query]")
+{
+	REQUIRE(kson::ChartQueryValueToString(true) == "true");
+	REQUIRE(kson::ChartQueryValueToString(300.0) == "300");
+	REQUIRE(kson::ChartQueryValueToString(0.25) == "0.25");
+	REQUIRE(kson::ChartQueryValueToString(std::string("abc")) == "abc");
+}
+
+TEST_CASE("ChartQuery on KSH files", "[chart_query]")
+{
+	const auto query = kson::ParseChartQuery("note_count > 0 && measure_count > 0 && max_bpm >= min_bpm");
+	REQUIRE(query.has_value());
+	for (const char* filename : { "Gram_ch.ksh", "Gram_ex.ksh", "Gram_in.ksh", "Gram_lt.ksh" })
+	{
+		const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/" + filename);
+		REQUIRE(chartData.error == kson::ErrorType::None);
+		REQUIRE(query->matches(chartData));
+	}
+}
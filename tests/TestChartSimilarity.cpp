@@ -0,0 +1,131 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Analysis/ChartSimilarity.hpp>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	kson::ChartData LoadAsset(const std::string& filename)
+	{
+		kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/" + filename);
+		REQUIRE(chartData.error == kson::ErrorType::None);
+		return chartData;
+	}
+
+	// Removes the n-th BT note
+	void RemoveBTNote(kson::ChartData& chartData, std::size_t n)
+	{
+		for (auto& lane : chartData.note.bt)
+		{
+			if (n < lane.size())
+			{
+				lane.erase(std::next(lane.begin(), static_cast<std::ptrdiff_t>(n)));
+				return;
+			}
+			n -= lane.size();
+		}
+	}
+}
+
+TEST_CASE("Chart shingles", "[chart_similarity]")
+{
+	SECTION("Shingles do not depend on leading empty measures")
+	{
+		kson::ChartData chartData;
+		chartData.beat.bpm[0] = 120.0;
+		chartData.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+		chartData.note.bt[0][0] = kson::Interval{ 0 };
+		chartData.note.bt[1][480] = kson::Interval{ 240 };
+		chartData.note.fx[0][1920] = kson::Interval{ 960 };
+		chartData.note.laser[0][3840].v.emplace(0, 0.0);
+		chartData.note.laser[0][3840].v.emplace(480, 1.0);
+
+		kson::ChartData shifted;
+		shifted.beat = chartData.beat;
+		for (std::size_t i = 0; i < kson::kNumBTLanesSZ; ++i)
+		{
+			for (const auto& [y, interval] : chartData.note.bt[i])
+			{
+				shifted.note.bt[i][y + 3 * kson::kResolution4] = interval;
+			}
+		}
+		for (std::size_t i = 0; i < kson::kNumFXLanesSZ; ++i)
+		{
+			for (const auto& [y, interval] : chartData.note.fx[i])
+			{
+				shifted.note.fx[i][y + 3 * kson::kResolution4] = interval;
+			}
+		}
+		shifted.note.laser[0][3840 + 3 * kson::kResolution4] = chartData.note.laser[0][3840];
+		shifted.meta.title = "Another title";
+
+		const auto shingles = kson::ExtractChartShingles(chartData);
+		REQUIRE(shingles.size() == 2);
+		REQUIRE(shingles == kson::ExtractChartShingles(shifted));
+	}
+
+	SECTION("Empty chart")
+	{
+		REQUIRE(kson::ExtractChartShingles(kson::ChartData{}).empty());
+	}
+}
+
+TEST_CASE("MinHash similarity", "[chart_similarity]")
+{
+	const kson::ChartData chartData = LoadAsset("Gram_ex.ksh");
+	const auto signature = kson::ComputeMinHashSignature(chartData);
+
+	SECTION("Same chart with different metadata")
+	{
+		kson::ChartData edited = chartData;
+		edited.meta.title = "Edited";
+		edited.audio.bgm.offset += 100;
+		REQUIRE(kson::EstimateSimilarity(signature, kson::ComputeMinHashSignature(edited)) == 1.0);
+	}
+
+	SECTION("One note changed")
+	{
+		kson::ChartData edited = chartData;
+		RemoveBTNote(edited, 100);
+		REQUIRE(kson::EstimateSimilarity(signature, kson::ComputeMinHashSignature(edited)) >= 0.8);
+	}
+
+	SECTION("Different difficulties")
+	{
+		const auto lightSignature = kson::ComputeMinHashSignature(LoadAsset("Gram_lt.ksh"));
+		REQUIRE(kson::EstimateSimilarity(signature, lightSignature) < 0.5);
+	}
+}
+
+TEST_CASE("ChartSimilarityIndex", "[chart_similarity]")
+{
+	kson::ChartSimilarityIndex index;
+	REQUIRE(index.numBands() == 16);
+
+	const std::array<std::string, 4> filenames = { "Gram_lt.ksh", "Gram_ch.ksh", "Gram_ex.ksh", "Gram_in.ksh" };
+	for (std::size_t i = 0; i < filenames.size(); ++i)
+	{
+		index.add(i + 100, kson::ComputeMinHashSignature(LoadAsset(filenames[i])));
+	}
+	REQUIRE(index.size() == 4);
+
+	kson::ChartData edited = LoadAsset("Gram_ex.ksh");
+	RemoveBTNote(edited, 10);
+	edited.meta.chartAuthor = "Someone else";
+
+	const auto similar = index.findSimilar(kson::ComputeMinHashSignature(edited), 0.8);
+	REQUIRE(similar.size() == 1);
+	REQUIRE(similar[0].id == 102);
+	REQUIRE(similar[0].similarity >= 0.8);
+
+	const auto candidates = index.findCandidates(kson::ComputeMinHashSignature(edited));
+	REQUIRE(std::find(candidates.begin(), candidates.end(), 102) != candidates.end());
+
+	SECTION("Number of bands is rounded to a divisor of the signature size")
+	{
+		REQUIRE(kson::ChartSimilarityIndex({ .numBands = 20 }).numBands() == 16);
+		REQUIRE(kson::ChartSimilarityIndex({ .numBands = 0 }).numBands() == 1);
+		REQUIRE(kson::ChartSimilarityIndex({ .numBands = 1000 }).numBands() == 128);
+	}
+}
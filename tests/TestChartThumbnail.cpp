@@ -0,0 +1,163 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/ChartThumbnail.hpp>
+#include <sstream>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	kson::ThumbnailColor PixelAt(const kson::ChartThumbnail& thumbnail, std::int32_t x, std::int32_t row)
+	{
+		const std::size_t offset = (static_cast<std::size_t>(row) * static_cast<std::size_t>(thumbnail.width) + static_cast<std::size_t>(x)) * 4;
+		return {
+			.r = thumbnail.pixels[offset],
+			.g = thumbnail.pixels[offset + 1],
+			.b = thumbnail.pixels[offset + 2],
+			.a = thumbnail.pixels[offset + 3],
+		};
+	}
+
+	bool IsSameColor(const kson::ThumbnailColor& a, const kson::ThumbnailColor& b)
+	{
+		return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+	}
+
+	bool RowContains(const kson::ChartThumbnail& thumbnail, std::int32_t row, const kson::ThumbnailColor& color)
+	{
+		for (std::int32_t x = 0; x < thumbnail.width; ++x)
+		{
+			if (IsSameColor(PixelAt(thumbnail, x, row), color))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+TEST_CASE("Chart thumbnail of notes", "[chart_thumbnail]")
+{
+	kson::ChartData chartData;
+	chartData.beat.bpm[0] = 120.0;
+	chartData.note.bt[0][0] = kson::Interval{ 0 };
+	chartData.note.bt[3][kson::kResolution4 * 2] = kson::Interval{ kson::kResolution4 };
+	chartData.note.fx[1][kson::kResolution4] = kson::Interval{ 0 };
+	chartData.note.laser[0][0].v[0] = kson::GraphPoint{ kson::GraphValue{ 0.0 } };
+	chartData.note.laser[0][0].v[kson::kResolution4 * 4] = kson::GraphPoint{ kson::GraphValue{ 0.0, 1.0 } };
+	chartData.note.laser[0][0].v[kson::kResolution4 * 4 + kson::kResolution / 8] = kson::GraphPoint{ kson::GraphValue{ 1.0 } };
+
+	const kson::ChartThumbnailParams params{ .width = 68, .height = 100, .bpmGutterWidth = 4 };
+	const kson::ChartThumbnail thumbnail = kson::CreateChartThumbnail(chartData, params);
+	REQUIRE(thumbnail.error == kson::ErrorType::None);
+	REQUIRE(thumbnail.width == 68);
+	REQUIRE(thumbnail.height == 100);
+	REQUIRE(thumbnail.pixels.size() == 68 * 100 * 4);
+
+	// The chart start is at the bottom, and the laser (the last note) ends at the top
+	const kson::Pulse lengthPulse = kson::kResolution4 * 4 + kson::kResolution / 8;
+	const auto rowOf = [&](kson::Pulse pulse) { return static_cast<std::int32_t>(99 - pulse * 100 / lengthPulse); };
+
+	// BT-A chip in the first lane column
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 4 + 8, rowOf(0)), params.btChipColor));
+
+	// BT-D long note from its start to its end
+	for (std::int32_t row = rowOf(kson::kResolution4 * 3); row <= rowOf(kson::kResolution4 * 2); ++row)
+	{
+		REQUIRE(IsSameColor(PixelAt(thumbnail, 4 + 56, row), params.btLongColor));
+	}
+	REQUIRE(!IsSameColor(PixelAt(thumbnail, 4 + 56, rowOf(kson::kResolution4 * 2) + 2), params.btLongColor));
+
+	// FX-R chip in the right half
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 4 + 40, rowOf(kson::kResolution4)), params.fxChipColor));
+
+	// Left laser at the left end, then a slam to the right end
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 4, rowOf(kson::kResolution4 * 3 + kson::kResolution4 / 2)), params.laserColors[0]));
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 4, rowOf(kson::kResolution4 * 4)), params.laserColors[0]));
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 40, rowOf(kson::kResolution4 * 4)), params.laserColors[0]));
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 67, rowOf(kson::kResolution4 * 4)), params.laserColors[0]));
+
+	// Untouched pixels keep the background color
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 4 + 24, rowOf(kson::kResolution4 / 2)), params.backgroundColor));
+}
+
+TEST_CASE("Chart thumbnail of BPM changes", "[chart_thumbnail]")
+{
+	kson::ChartData chartData;
+	chartData.beat.bpm[0] = 100.0;
+	chartData.beat.bpm[kson::kResolution4 * 2] = 200.0;
+	chartData.note.bt[0][kson::kResolution4 * 4] = kson::Interval{ 0 };
+
+	const kson::ChartThumbnailParams params{ .width = 20, .height = 64 };
+	const kson::ChartThumbnail thumbnail = kson::CreateChartThumbnail(chartData, params);
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 0, 63), params.lowBPMColor));
+	REQUIRE(IsSameColor(PixelAt(thumbnail, 0, 0), params.highBPMColor));
+	REQUIRE(RowContains(thumbnail, 31, params.bpmChangeColor));
+}
+
+TEST_CASE("Chart thumbnail rendering reuses the buffer", "[chart_thumbnail]")
+{
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+
+	const kson::ChartThumbnail expected = kson::CreateChartThumbnail(chartData);
+	REQUIRE(expected.width == 48);
+	REQUIRE(expected.height == 512);
+
+	kson::ChartThumbnail thumbnail;
+	kson::RenderChartThumbnail(kson::ChartData{}, {}, &thumbnail);
+	const std::uint8_t* pData = thumbnail.pixels.data();
+	kson::RenderChartThumbnail(chartData, {}, &thumbnail);
+	REQUIRE(thumbnail.pixels.data() == pData);
+	REQUIRE(thumbnail.pixels == expected.pixels);
+
+	const kson::ChartThumbnailParams params;
+	std::size_t numLaserPixels = 0;
+	for (std::int32_t row = 0; row < thumbnail.height; ++row)
+	{
+		for (std::int32_t x = 0; x < thumbnail.width; ++x)
+		{
+			const kson::ThumbnailColor color = PixelAt(thumbnail, x, row);
+			if (IsSameColor(color, params.laserColors[0]) || IsSameColor(color, params.laserColors[1]))
+			{
+				++numLaserPixels;
+			}
+		}
+	}
+	REQUIRE(numLaserPixels > 512);
+}
+
+TEST_CASE("Chart thumbnail saving", "[chart_thumbnail]")
+{
+	kson::ChartData chartData;
+	chartData.note.bt[0][0] = kson::Interval{ 0 };
+	const kson::ChartThumbnail thumbnail = kson::CreateChartThumbnail(chartData, { .width = 3, .height = 2 });
+
+	SECTION("PPM")
+	{
+		std::ostringstream stream;
+		REQUIRE(kson::SaveChartThumbnailPPM(stream, thumbnail) == kson::ErrorType::None);
+		const std::string str = stream.str();
+		const std::string header = "P6\n3 2\n255\n";
+		REQUIRE(str.starts_with(header));
+		REQUIRE(str.size() == header.size() + 3 * 2 * 3);
+		REQUIRE(static_cast<std::uint8_t>(str[header.size()]) == thumbnail.pixels[0]);
+		REQUIRE(static_cast<std::uint8_t>(str[header.size() + 3]) == thumbnail.pixels[4]);
+	}
+
+	SECTION("PAM")
+	{
+		std::ostringstream stream;
+		REQUIRE(kson::SaveChartThumbnailPAM(stream, thumbnail) == kson::ErrorType::None);
+		const std::string str = stream.str();
+		const std::string header = "P7\nWIDTH 3\nHEIGHT 2\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+		REQUIRE(str.starts_with(header));
+		REQUIRE(str.substr(header.size()) == std::string(thumbnail.pixels.begin(), thumbnail.pixels.end()));
+	}
+
+	SECTION("Empty")
+	{
+		std::ostringstream stream;
+		REQUIRE(kson::SaveChartThumbnailPPM(stream, kson::ChartThumbnail{}) != kson::ErrorType::None);
+	}
+}
@@ -0,0 +1,231 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <sstream>
+
+// Runs public APIs on generated inputs of doubling size and checks that the measured growth
+// does not exceed the declared complexity class (e.g., a quadratic regression in a linear API)
+
+namespace
+{
+	enum class ComplexityClass
+	{
+		kLinear, // O(n)
+		kLinearithmic, // O(n log n)
+	};
+
+	// Allowed growth exponent (measured over 8x input size)
+	// The margin absorbs timer noise and cache effects; a quadratic regression gives an exponent close to 2
+	double MaxGrowthExponent(ComplexityClass complexityClass)
+	{
+		switch (complexityClass)
+		{
+		case ComplexityClass::kLinear:
+			return 1.45;
+		case ComplexityClass::kLinearithmic:
+			return 1.55;
+		default:
+			return 1.0;
+		}
+	}
+
+	constexpr std::array<std::size_t, 4> kSizeMultipliers = { 1, 2, 4, 8 };
+	constexpr int kNumRepeats = 3;
+
+	// Returns the least-squares slope of log(time) against log(size)
+	// setup is excluded from the measurement and returns the function to measure
+	double MeasureGrowthExponent(std::size_t baseSize, const std::function<std::function<void()>(std::size_t)>& setup)
+	{
+		std::vector<double> logSizes;
+		std::vector<double> logTimes;
+		for (const std::size_t multiplier : kSizeMultipliers)
+		{
+			const std::size_t size = baseSize * multiplier;
+			const std::function<void()> func = setup(size);
+
+			double minSec = std::numeric_limits<double>::max();
+			for (int i = 0; i < kNumRepeats; ++i)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				func();
+				const auto end = std::chrono::steady_clock::now();
+				minSec = std::min(minSec, std::chrono::duration<double>(end - start).count());
+			}
+
+			logSizes.push_back(std::log(static_cast<double>(size)));
+			logTimes.push_back(std::log(std::max(minSec, 1e-7)));
+		}
+
+		const double n = static_cast<double>(logSizes.size());
+		double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+		for (std::size_t i = 0; i < logSizes.size(); ++i)
+		{
+			sumX += logSizes[i];
+			sumY += logTimes[i];
+			sumXX += logSizes[i] * logSizes[i];
+			sumXY += logSizes[i] * logTimes[i];
+		}
+		return (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+	}
+
+	void RequireComplexity(ComplexityClass complexityClass, std::size_t baseSize, const std::function<std::function<void()>(std::size_t)>& setup)
+	{
+		const double exponent = MeasureGrowthExponent(baseSize, setup);
+		INFO("Measured growth exponent: " << exponent);
+		REQUIRE(exponent <= MaxGrowthExponent(complexityClass));
+	}
+
+	// Generates a chart with the specified number of 4/4 measures containing typical notes and events
+	kson::ChartData GenerateChart(std::size_t numMeasures)
+	{
+		kson::ChartData chartData;
+		chartData.beat.bpm[0] = 180.0;
+		chartData.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+		chartData.beat.scrollSpeed[0] = kson::GraphValue{ 1.0 };
+
+		constexpr kson::Pulse kMeasure = kson::kResolution4;
+		for (std::size_t i = 0; i < numMeasures; ++i)
+		{
+			const kson::Pulse y = static_cast<kson::Pulse>(i) * kMeasure;
+
+			// 16th stream on BT and a long FX in every measure
+			for (kson::Pulse j = 0; j < 16; ++j)
+			{
+				chartData.note.bt[j % kson::kNumBTLanes][y + j * kMeasure / 16] = kson::Interval{ 0 };
+			}
+			chartData.note.fx[i % kson::kNumFXLanes][y] = kson::Interval{ kMeasure / 2 };
+
+			// Laser section with a slam in every measure
+			auto& section = chartData.note.laser[i % kson::kNumLaserLanes][y];
+			section.v.emplace(0, kson::GraphPoint{ kson::GraphValue{ 0.0, 1.0 } });
+			section.v.emplace(kMeasure / 2, kson::GraphPoint{ kson::GraphValue{ 0.5 }, kson::GraphCurveValue{ 0.2, 0.8 } });
+			section.v.emplace(kMeasure * 3 / 4, kson::GraphPoint{ kson::GraphValue{ 0.0 } });
+
+			if (i % 8 == 0)
+			{
+				chartData.beat.bpm[y] = 180.0 + static_cast<double>(i % 16);
+				chartData.beat.scrollSpeed[y] = kson::GraphValue{ 1.0 + static_cast<double>(i % 3) * 0.5 };
+				chartData.camera.cam.body.zoomBottom[y] = kson::GraphValue{ static_cast<double>(i % 5) * 0.1 };
+				chartData.audio.audioEffect.fx.paramChange["retrigger"]["wave_length"][y] = (i % 16 == 0) ? "1/8" : "1/16";
+			}
+		}
+		return chartData;
+	}
+
+	std::string ToKshString(const kson::ChartData& chartData)
+	{
+		std::ostringstream oss;
+		REQUIRE(kson::SaveKshChartData(oss, chartData) == kson::ErrorType::None);
+		return oss.str();
+	}
+
+	std::string ToKsonString(const kson::ChartData& chartData)
+	{
+		std::ostringstream oss;
+		REQUIRE(kson::SaveKsonChartData(oss, chartData) == kson::ErrorType::None);
+		return oss.str();
+	}
+}
+
+TEST_CASE("Complexity of KSH I/O", "[complexity]")
+{
+	SECTION("SaveKshChartData")
+	{
+		RequireComplexity(ComplexityClass::kLinearithmic, 64, [](std::size_t size) -> std::function<void()>
+		{
+			auto pChartData = std::make_shared<kson::ChartData>(GenerateChart(size));
+			return [pChartData]() { static_cast<void>(ToKshString(*pChartData)); };
+		});
+	}
+
+	SECTION("LoadKshChartData")
+	{
+		RequireComplexity(ComplexityClass::kLinearithmic, 64, [](std::size_t size) -> std::function<void()>
+		{
+			auto pKsh = std::make_shared<std::string>(ToKshString(GenerateChart(size)));
+			return [pKsh]()
+			{
+				std::istringstream iss(*pKsh);
+				REQUIRE(kson::LoadKshChartData(iss).error == kson::ErrorType::None);
+			};
+		});
+	}
+}
+
+TEST_CASE("Complexity of KSON I/O", "[complexity]")
+{
+	SECTION("SaveKsonChartData")
+	{
+		RequireComplexity(ComplexityClass::kLinearithmic, 64, [](std::size_t size) -> std::function<void()>
+		{
+			auto pChartData = std::make_shared<kson::ChartData>(GenerateChart(size));
+			return [pChartData]() { static_cast<void>(ToKsonString(*pChartData)); };
+		});
+	}
+
+	SECTION("LoadKsonChartData")
+	{
+		RequireComplexity(ComplexityClass::kLinearithmic, 64, [](std::size_t size) -> std::function<void()>
+		{
+			auto pKson = std::make_shared<std::string>(ToKsonString(GenerateChart(size)));
+			return [pKson]()
+			{
+				std::istringstream iss(*pKson);
+				REQUIRE(kson::LoadKsonChartData(iss).error == kson::ErrorType::None);
+			};
+		});
+	}
+}
+
+TEST_CASE("Complexity of timing and graph utilities", "[complexity]")
+{
+	SECTION("CreateTimingCache and PulseToMs")
+	{
+		RequireComplexity(ComplexityClass::kLinearithmic, 256, [](std::size_t size) -> std::function<void()>
+		{
+			auto pChartData = std::make_shared<kson::ChartData>(GenerateChart(size));
+			return [pChartData, size]()
+			{
+				const kson::TimingCache cache = kson::CreateTimingCache(pChartData->beat);
+				double sum = 0.0;
+				for (std::size_t i = 0; i < size * 16; ++i)
+				{
+					sum += kson::PulseToMs(static_cast<kson::Pulse>(i) * kson::kResolution4 / 16, pChartData->beat, cache);
+				}
+				REQUIRE(sum >= 0.0);
+			};
+		});
+	}
+
+	SECTION("GraphValueAt")
+	{
+		RequireComplexity(ComplexityClass::kLinearithmic, 256, [](std::size_t size) -> std::function<void()>
+		{
+			auto pChartData = std::make_shared<kson::ChartData>(GenerateChart(size));
+			return [pChartData, size]()
+			{
+				double sum = 0.0;
+				for (std::size_t i = 0; i < size * 16; ++i)
+				{
+					sum += kson::GraphValueAt(pChartData->beat.scrollSpeed, static_cast<kson::Pulse>(i) * kson::kResolution4 / 16);
+				}
+				REQUIRE(sum >= 0.0);
+			};
+		});
+	}
+
+	SECTION("ExpandCurveSegments")
+	{
+		RequireComplexity(ComplexityClass::kLinearithmic, 256, [](std::size_t size) -> std::function<void()>
+		{
+			auto pGraph = std::make_shared<kson::Graph>();
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				(*pGraph)[static_cast<kson::Pulse>(i) * 240] = kson::GraphPoint{ kson::GraphValue{ static_cast<double>(i % 2) }, kson::GraphCurveValue{ 0.3, 0.7 } };
+			}
+			return [pGraph]() { REQUIRE(!kson::ExpandCurveSegments(*pGraph, 30).empty()); };
+		});
+	}
+}
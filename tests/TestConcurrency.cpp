@@ -0,0 +1,224 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Encoding/Encoding.hpp>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+extern std::string g_assetsDir;
+
+// These tests are meant to be run under ThreadSanitizer (-DKSON_SANITIZE_THREAD=ON) to detect data races,
+// and they also check that concurrent calls give the same results as single-threaded calls
+namespace
+{
+	constexpr std::size_t kNumThreads = 8;
+	constexpr std::size_t kNumIterations = 3;
+
+	constexpr const char* kKshFilenames[] = { "Gram_ch.ksh", "Gram_ex.ksh", "Gram_in.ksh", "Gram_lt.ksh" };
+
+	// Runs func(threadIdx) on kNumThreads threads started at the same time
+	// Catch2 assertions are not thread-safe, so func must only record the results to be checked after joining
+	template <typename Func>
+	void RunConcurrently(Func func)
+	{
+		std::atomic<bool> start = false;
+		std::vector<std::thread> threads;
+		threads.reserve(kNumThreads);
+		for (std::size_t i = 0; i < kNumThreads; ++i)
+		{
+			threads.emplace_back([&start, &func, i]()
+			{
+				while (!start.load())
+				{
+					std::this_thread::yield();
+				}
+				func(i);
+			});
+		}
+		start = true;
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	void PushOptional(std::vector<double>& values, const std::optional<double>& value)
+	{
+		values.push_back(value.has_value() ? *value : -1e300);
+	}
+
+	// Calls the reading functions over the whole chart and collects the results
+	std::vector<double> ReadChart(const kson::ChartData& chartData, const kson::TimingCache& timingCache, const kson::ScrollPositionCache& scrollCache)
+	{
+		std::vector<double> values;
+		const kson::Pulse lastPulse = kson::LastNoteEndY(chartData.note) + kson::kResolution4;
+		for (kson::Pulse y = 0; y < lastPulse; y += kson::kResolution / 4)
+		{
+			const double ms = kson::PulseToMs(y, chartData.beat, timingCache);
+			values.push_back(ms);
+			values.push_back(kson::PulseToSec(y, chartData.beat, timingCache));
+			values.push_back(static_cast<double>(kson::MsToPulse(ms, chartData.beat, timingCache)));
+			values.push_back(static_cast<double>(kson::PulseToMeasureIdx(y, chartData.beat, timingCache)));
+			values.push_back(kson::IsBarLinePulse(y, chartData.beat, timingCache) ? 1.0 : 0.0);
+			values.push_back(kson::TempoAt(y, chartData.beat));
+			values.push_back(kson::GraphValueAt(chartData.beat.scrollSpeed, y));
+			values.push_back(kson::GraphValueAt(chartData.camera.cam.body.zoomTop, y));
+			values.push_back(kson::PulseToScrollPosition(y, scrollCache));
+			for (const auto& lane : chartData.note.laser)
+			{
+				PushOptional(values, kson::GraphSectionValueAt(lane, y));
+			}
+			PushOptional(values, kson::ManualTiltValueAt(chartData.camera.tilt, y));
+			values.push_back(kson::AutoTiltScaleAt(chartData.camera.tilt, y));
+			values.push_back(kson::AutoTiltKeepAt(chartData.camera.tilt, y) ? 1.0 : 0.0);
+		}
+
+		values.push_back(kson::GetModeBPM(chartData.beat, lastPulse));
+		values.push_back(kson::GetEffectiveStdBPM(chartData));
+		values.push_back(static_cast<double>(kson::EstimateChartDataSize(chartData)));
+		for (const auto& def : chartData.audio.audioEffect.fx.def)
+		{
+			values.push_back(static_cast<double>(chartData.audio.audioEffect.fx.defByName(def.name).v.size()));
+		}
+		for (const auto& def : chartData.audio.audioEffect.laser.def)
+		{
+			values.push_back(static_cast<double>(chartData.audio.audioEffect.laser.defByName(def.name).v.size()));
+		}
+
+		kson::LaserGeometry geometry;
+		for (kson::Pulse y = 0; y < lastPulse; y += kson::kResolution4)
+		{
+			kson::BuildLaserGeometry(chartData.note.laser, y, y + kson::kResolution4 * 2, scrollCache, {}, &geometry);
+			for (const auto& lane : geometry.lanes)
+			{
+				values.push_back(static_cast<double>(lane.vertices.size()));
+				values.push_back(static_cast<double>(lane.slams.size()));
+			}
+		}
+
+		const kson::JudgementLanes judgementLanes = kson::CreateJudgementLanes(chartData.note, chartData.beat, timingCache);
+		for (const auto& lane : judgementLanes.bt)
+		{
+			for (std::size_t i = 0; i < lane.size(); ++i)
+			{
+				values.push_back(lane.note(i).ms);
+			}
+		}
+
+		const auto query = kson::ParseChartQuery("note_count + max_bpm + duration_ms + laser_slam_count");
+		values.push_back(std::get<double>(query->evaluate(chartData)));
+		for (const std::uint32_t hash : kson::ComputeMinHashSignature(chartData))
+		{
+			values.push_back(static_cast<double>(hash));
+		}
+		return values;
+	}
+
+	std::string SaveKson(const kson::ChartData& chartData)
+	{
+		std::ostringstream oss;
+		return kson::SaveKsonChartData(oss, chartData) == kson::ErrorType::None ? oss.str() : std::string();
+	}
+
+	std::string SaveKsh(const kson::ChartData& chartData)
+	{
+		std::ostringstream oss;
+		return kson::SaveKshChartData(oss, chartData) == kson::ErrorType::None ? oss.str() : std::string();
+	}
+}
+
+TEST_CASE("Concurrent reads of shared chart data", "[concurrency]")
+{
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+	const kson::TimingCache timingCache = kson::CreateTimingCache(chartData.beat);
+	const kson::ScrollPositionCache scrollCache = kson::CreateScrollPositionCache(chartData.beat);
+	const kson::ReplayCodec replayCodec(chartData);
+
+	const std::vector<double> expectedValues = ReadChart(chartData, timingCache, scrollCache);
+	const std::string expectedKson = SaveKson(chartData);
+	const std::string expectedKsh = SaveKsh(chartData);
+	REQUIRE(!expectedKson.empty());
+	REQUIRE(!expectedKsh.empty());
+
+	std::atomic<std::size_t> numMismatches = 0;
+	RunConcurrently([&](std::size_t threadIdx)
+	{
+		for (std::size_t i = 0; i < kNumIterations; ++i)
+		{
+			// Vary the order of the calls between threads
+			if ((threadIdx + i) % 2 == 0)
+			{
+				numMismatches += ReadChart(chartData, timingCache, scrollCache) != expectedValues;
+				numMismatches += SaveKson(chartData) != expectedKson;
+			}
+			else
+			{
+				numMismatches += SaveKsh(chartData) != expectedKsh;
+				numMismatches += ReadChart(chartData, timingCache, scrollCache) != expectedValues;
+			}
+
+			kson::ReplayData replay;
+			replay.bt[threadIdx % kson::kNumBTLanesSZ].push_back({ .pressUs = static_cast<std::int64_t>(threadIdx) * 1000, .releaseUs = 500000 });
+			kson::ReplayData decoded;
+			numMismatches += !replayCodec.decode(replayCodec.encode(replay), &decoded) || decoded != replay;
+		}
+	});
+	REQUIRE(numMismatches == 0);
+}
+
+TEST_CASE("Concurrent loading", "[concurrency]")
+{
+	// Shift-JIS "テスト"
+	const std::string shiftJISStr = "\x83\x65\x83\x58\x83\x67";
+	const std::string expectedUTF8 = kson::Encoding::ShiftJISToUTF8(shiftJISStr);
+	REQUIRE(expectedUTF8 == "\xE3\x83\x86\xE3\x82\xB9\xE3\x83\x88");
+
+	std::vector<std::string> expectedKsons;
+	for (const char* filename : kKshFilenames)
+	{
+		expectedKsons.push_back(SaveKson(kson::LoadKshChartData(g_assetsDir + "/" + filename)));
+	}
+	const std::string ksonFilePath = g_assetsDir + "/Gram_ex.kson";
+	const std::string expectedKsonFromKson = SaveKson(kson::LoadKsonChartData(ksonFilePath));
+
+	const std::string rangeFilePath = g_assetsDir + "/Gram_in.ksh";
+	const kson::KshMeasureIndex index = [&]()
+	{
+		std::ifstream ifs(rangeFilePath, std::ios_base::binary);
+		return kson::BuildKshMeasureIndex(ifs);
+	}();
+	REQUIRE(index.error == kson::ErrorType::None);
+	const auto loadRange = [&]()
+	{
+		std::ifstream ifs(rangeFilePath, std::ios_base::binary);
+		return SaveKson(kson::LoadKshChartDataRange(ifs, index, 4, 8));
+	};
+	const std::string expectedRangeKson = loadRange();
+
+	std::atomic<std::size_t> numMismatches = 0;
+	RunConcurrently([&](std::size_t threadIdx)
+	{
+		for (std::size_t i = 0; i < kNumIterations; ++i)
+		{
+			for (std::size_t fileIdx = 0; fileIdx < std::size(kKshFilenames); ++fileIdx)
+			{
+				// Each thread starts from a different file
+				const std::size_t idx = (fileIdx + threadIdx) % std::size(kKshFilenames);
+				const std::string filePath = g_assetsDir + "/" + kKshFilenames[idx];
+				numMismatches += SaveKson(kson::LoadKshChartData(filePath)) != expectedKsons[idx];
+
+				std::ifstream ifs(filePath, std::ios_base::binary);
+				numMismatches += SaveKson(kson::LoadKshChartData(ifs)) != expectedKsons[idx];
+
+				numMismatches += kson::LoadKshMetaChartData(filePath).error != kson::ErrorType::None;
+			}
+			numMismatches += SaveKson(kson::LoadKsonChartData(ksonFilePath)) != expectedKsonFromKson;
+			numMismatches += kson::LoadKsonMetaChartData(ksonFilePath).error != kson::ErrorType::None;
+			numMismatches += loadRange() != expectedRangeKson;
+			numMismatches += kson::Encoding::ShiftJISToUTF8(shiftJISStr) != expectedUTF8;
+		}
+	});
+	REQUIRE(numMismatches == 0);
+}
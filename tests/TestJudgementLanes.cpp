@@ -0,0 +1,110 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/JudgementLanes.hpp>
+
+namespace
+{
+	// 120 BPM: 1 beat (240 pulses) = 500 ms
+	kson::BeatInfo CreateBeatInfo()
+	{
+		kson::BeatInfo beatInfo;
+		beatInfo.bpm[0] = 120.0;
+		beatInfo.timeSig[0] = kson::TimeSig{ 4, 4 };
+		return beatInfo;
+	}
+}
+
+TEST_CASE("JudgementLane", "[judgement]")
+{
+	const kson::BeatInfo beatInfo = CreateBeatInfo();
+	const kson::TimingCache timingCache = kson::CreateTimingCache(beatInfo);
+
+	kson::ByPulse<kson::Interval> btLane;
+	btLane[0] = kson::Interval{ 0 };
+	btLane[60] = kson::Interval{ 0 }; // 125 ms
+	btLane[240] = kson::Interval{ 480 }; // 500 ms - 1500 ms
+	btLane[960] = kson::Interval{ 0 }; // 2000 ms
+
+	kson::JudgementLane lane(btLane, beatInfo, timingCache);
+	REQUIRE(lane.size() == 4);
+	REQUIRE(lane.note(1).ms == Approx(125.0));
+	REQUIRE(lane.note(2).endMs == Approx(1500.0));
+	REQUIRE(lane.note(3).endMs == lane.note(3).ms);
+
+	SECTION("Nearest unjudged note")
+	{
+		REQUIRE(lane.findCandidate(50.0, 100.0) == 0);
+		REQUIRE(lane.findCandidate(80.0, 100.0) == 1);
+		REQUIRE(lane.findCandidate(300.0, 100.0) == kson::kJudgementNoNote);
+
+		// Equal distance prefers the earlier note
+		REQUIRE(lane.findCandidate(62.5, 100.0) == 0);
+
+		lane.markJudged(0);
+		REQUIRE(lane.isJudged(0));
+		REQUIRE(lane.findCandidate(50.0, 100.0) == 1);
+		REQUIRE(lane.findCandidate(-50.0, 100.0) == kson::kJudgementNoNote);
+	}
+
+	SECTION("Sweeping misses")
+	{
+		std::vector<std::size_t> missed;
+		REQUIRE(lane.advanceMisses(150.0, 100.0, &missed) == 1);
+		REQUIRE(missed == std::vector<std::size_t>{ 0 });
+
+		lane.markJudged(2);
+		missed.clear();
+		REQUIRE(lane.advanceMisses(1000.0, 100.0, &missed) == 1);
+		REQUIRE(missed == std::vector<std::size_t>{ 1 });
+		REQUIRE(lane.numJudged() == 3);
+
+		REQUIRE(lane.findCandidate(1950.0, 100.0) == 3);
+		REQUIRE(lane.advanceMisses(3000.0, 100.0) == 1);
+		REQUIRE(lane.findCandidate(2000.0, 100.0) == kson::kJudgementNoNote);
+		REQUIRE(lane.numJudged() == 4);
+
+		lane.reset();
+		REQUIRE(lane.numJudged() == 0);
+		REQUIRE(lane.findCandidate(0.0, 100.0) == 0);
+	}
+}
+
+TEST_CASE("JudgementLanes with many notes", "[judgement]")
+{
+	const kson::BeatInfo beatInfo = CreateBeatInfo();
+	const kson::TimingCache timingCache = kson::CreateTimingCache(beatInfo);
+
+	// 16th notes (125 ms) crossing multiple words of the judged bitset
+	kson::NoteInfo noteInfo;
+	for (kson::Pulse y = 0; y < 200 * 60; y += 60)
+	{
+		noteInfo.bt[1][y] = kson::Interval{ 0 };
+	}
+	noteInfo.fx[0][0] = kson::Interval{ 960 };
+
+	kson::JudgementLanes lanes = kson::CreateJudgementLanes(noteInfo, beatInfo, timingCache);
+	REQUIRE(lanes.bt[0].size() == 0);
+	REQUIRE(lanes.bt[1].size() == 200);
+	REQUIRE(lanes.fx[0].size() == 1);
+
+	// Hit every other note and let the rest be swept as misses
+	std::size_t numMissed = 0;
+	for (std::size_t i = 0; i < 200; ++i)
+	{
+		const double ms = static_cast<double>(i) * 125.0;
+		numMissed += lanes.bt[1].advanceMisses(ms, 50.0);
+		if (i % 2 == 0)
+		{
+			const std::size_t idx = lanes.bt[1].findCandidate(ms + 10.0, 50.0);
+			REQUIRE(idx == i);
+			lanes.bt[1].markJudged(idx);
+		}
+	}
+	numMissed += lanes.bt[1].advanceMisses(200 * 125.0, 50.0);
+	REQUIRE(numMissed == 100);
+	REQUIRE(lanes.bt[1].numJudged() == 200);
+
+	lanes.reset();
+	REQUIRE(lanes.bt[1].numJudged() == 0);
+	REQUIRE(lanes.bt[1].findCandidate(125.0 * 150, 50.0) == 150);
+}
@@ -0,0 +1,200 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/IO/KshMeasureIndex.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	constexpr const char* kAssetFilenames[] = { "Gram_ch.ksh", "Gram_ex.ksh", "Gram_in.ksh", "Gram_lt.ksh" };
+
+	kson::KshMeasureIndex BuildIndex(const std::string& filePath)
+	{
+		std::ifstream ifs(filePath, std::ios_base::binary);
+		return kson::BuildKshMeasureIndex(ifs);
+	}
+
+	// Notes of the full chart that are visible in [start, end)
+	kson::ByPulse<kson::Interval> NotesInRange(const kson::ByPulse<kson::Interval>& notes, kson::Pulse start, kson::Pulse end)
+	{
+		kson::ByPulse<kson::Interval> result;
+		for (const auto& [y, note] : notes)
+		{
+			if (y < end && (y >= start || y + note.length > start))
+			{
+				result.emplace(y, note);
+			}
+		}
+		return result;
+	}
+
+	void RequireSameNotes(const kson::ByPulse<kson::Interval>& expected, const kson::ByPulse<kson::Interval>& actual)
+	{
+		REQUIRE(actual.size() == expected.size());
+		for (auto itr1 = expected.begin(), itr2 = actual.begin(); itr1 != expected.end(); ++itr1, ++itr2)
+		{
+			REQUIRE(itr2->first == itr1->first);
+			REQUIRE(itr2->second.length == itr1->second.length);
+		}
+	}
+
+	void RequireSameRange(const kson::ChartData& fullChartData, const kson::ChartData& rangeChartData, kson::Pulse start, kson::Pulse end)
+	{
+		for (std::size_t i = 0; i < kson::kNumBTLanesSZ; ++i)
+		{
+			RequireSameNotes(NotesInRange(fullChartData.note.bt[i], start, end), rangeChartData.note.bt[i]);
+		}
+		for (std::size_t i = 0; i < kson::kNumFXLanesSZ; ++i)
+		{
+			RequireSameNotes(NotesInRange(fullChartData.note.fx[i], start, end), rangeChartData.note.fx[i]);
+		}
+		for (std::size_t i = 0; i < kson::kNumLaserLanesSZ; ++i)
+		{
+			for (kson::Pulse y = start; y < end; y += kson::kResolution / 8)
+			{
+				const auto expected = kson::GraphSectionValueAt(fullChartData.note.laser[i], y);
+				const auto actual = kson::GraphSectionValueAt(rangeChartData.note.laser[i], y);
+				INFO("laser lane " << i << ", y = " << y);
+				REQUIRE(actual.has_value() == expected.has_value());
+				if (expected.has_value())
+				{
+					REQUIRE(*actual == Approx(*expected));
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("KshMeasureIndex matches the full parse", "[ksh_measure_index]")
+{
+	for (const char* filename : kAssetFilenames)
+	{
+		INFO(filename);
+		const std::string filePath = g_assetsDir + "/" + filename;
+		const kson::ChartData chartData = kson::LoadKshChartData(filePath);
+		REQUIRE(chartData.error == kson::ErrorType::None);
+
+		const kson::KshMeasureIndex index = BuildIndex(filePath);
+		REQUIRE(index.error == kson::ErrorType::None);
+		REQUIRE(!index.measures.empty());
+		REQUIRE(index.beat.bpm == chartData.beat.bpm);
+		REQUIRE(index.beat.stop == chartData.beat.stop);
+		REQUIRE(index.beat.timeSig.size() == chartData.beat.timeSig.size());
+
+		const kson::TimingCache timingCache = kson::CreateTimingCache(chartData.beat);
+		for (std::size_t i = 0; i < index.measures.size(); ++i)
+		{
+			const auto& entry = index.measures[i];
+			REQUIRE(entry.y == kson::MeasureIdxToPulse(static_cast<std::int64_t>(i), chartData.beat, timingCache));
+			REQUIRE(entry.state.bpm == kson::TempoAt(entry.y, chartData.beat));
+		}
+
+		// All notes end before the last bar line
+		REQUIRE(kson::LastNoteEndY(chartData.note) <= index.measures.back().y + kson::kResolution4 * index.measures.back().state.timeSig.n / index.measures.back().state.timeSig.d);
+	}
+}
+
+TEST_CASE("KshMeasureIndex range loading", "[ksh_measure_index]")
+{
+	for (const char* filename : kAssetFilenames)
+	{
+		INFO(filename);
+		const std::string filePath = g_assetsDir + "/" + filename;
+		const kson::ChartData fullChartData = kson::LoadKshChartData(filePath);
+		const kson::KshMeasureIndex index = BuildIndex(filePath);
+		REQUIRE(index.error == kson::ErrorType::None);
+
+		const auto numMeasures = static_cast<std::int64_t>(index.measures.size());
+		for (const auto [firstMeasureIdx, numRangeMeasures] : { std::pair<std::int64_t, std::int64_t>{ 0, 4 }, { 7, 3 }, { numMeasures / 2, 1 }, { numMeasures / 3, 9 }, { numMeasures - 5, 100 } })
+		{
+			INFO("measures " << firstMeasureIdx << " + " << numRangeMeasures);
+			std::ifstream ifs(filePath, std::ios_base::binary);
+			const kson::ChartData rangeChartData = kson::LoadKshChartDataRange(ifs, index, firstMeasureIdx, numRangeMeasures);
+			REQUIRE(rangeChartData.error == kson::ErrorType::None);
+			REQUIRE(rangeChartData.meta.title == fullChartData.meta.title);
+			REQUIRE(rangeChartData.beat.bpm == fullChartData.beat.bpm);
+
+			// User-defined audio effects after the last measure are also loaded
+			REQUIRE(rangeChartData.audio.audioEffect.fx.def.size() == fullChartData.audio.audioEffect.fx.def.size());
+			REQUIRE(rangeChartData.audio.audioEffect.laser.def.size() == fullChartData.audio.audioEffect.laser.def.size());
+
+			const std::int64_t endMeasureIdx = std::min(firstMeasureIdx + numRangeMeasures, numMeasures);
+			const kson::Pulse start = index.measures[static_cast<std::size_t>(firstMeasureIdx)].y;
+			const kson::Pulse end = endMeasureIdx < numMeasures ? index.measures[static_cast<std::size_t>(endMeasureIdx)].y : std::numeric_limits<kson::Pulse>::max() / 2;
+			RequireSameRange(fullChartData, rangeChartData, start, std::min(end, kson::LastNoteEndY(fullChartData.note) + 1));
+		}
+
+		// Out of range
+		std::ifstream ifs(filePath, std::ios_base::binary);
+		const kson::ChartData emptyChartData = kson::LoadKshChartDataRange(ifs, index, numMeasures, 1);
+		REQUIRE(emptyChartData.error == kson::ErrorType::None);
+		REQUIRE(kson::LastNoteEndY(emptyChartData.note) == 0);
+	}
+}
+
+TEST_CASE("KshMeasureIndex save and load", "[ksh_measure_index]")
+{
+	const kson::KshMeasureIndex index = BuildIndex(g_assetsDir + "/Gram_ex.ksh");
+	REQUIRE(index.error == kson::ErrorType::None);
+
+	std::stringstream ss;
+	REQUIRE(kson::SaveKshMeasureIndex(ss, index) == kson::ErrorType::None);
+	const std::string saved = ss.str();
+
+	const kson::KshMeasureIndex loaded = kson::LoadKshMeasureIndex(ss);
+	REQUIRE(loaded.error == kson::ErrorType::None);
+	REQUIRE(loaded.measures.size() == index.measures.size());
+	REQUIRE(loaded.beat.bpm == index.beat.bpm);
+	REQUIRE(loaded.trailerByteOffset == index.trailerByteOffset);
+	for (std::size_t i = 0; i < index.measures.size(); ++i)
+	{
+		REQUIRE(loaded.measures[i].byteOffset == index.measures[i].byteOffset);
+		REQUIRE(loaded.measures[i].state.bt == index.measures[i].state.bt);
+		REQUIRE(loaded.measures[i].state.fx == index.measures[i].state.fx);
+		REQUIRE(loaded.measures[i].state.laser == index.measures[i].state.laser);
+	}
+
+	std::stringstream ss2;
+	REQUIRE(kson::SaveKshMeasureIndex(ss2, loaded) == kson::ErrorType::None);
+	REQUIRE(ss2.str() == saved);
+
+	// Truncated or unknown data
+	std::stringstream truncated(saved.substr(0, saved.size() / 2));
+	REQUIRE(kson::LoadKshMeasureIndex(truncated).error != kson::ErrorType::None);
+	std::stringstream unknown("kshidx 999\n");
+	REQUIRE(kson::LoadKshMeasureIndex(unknown).error != kson::ErrorType::None);
+}
+
+TEST_CASE("KshMeasureIndex file next to the chart", "[ksh_measure_index]")
+{
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / "kson_test_ksh_measure_index";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	const std::string filePath = (dir / "chart.ksh").string();
+	std::filesystem::copy_file(g_assetsDir + "/Gram_in.ksh", filePath);
+
+	// The index is built and saved on the first load
+	const kson::ChartData chartData = kson::LoadKshChartDataRange(filePath, 10, 2);
+	REQUIRE(chartData.error == kson::ErrorType::None);
+	const std::string indexFilePath = kson::KshMeasureIndexFilePath(filePath);
+	REQUIRE(std::filesystem::exists(indexFilePath));
+
+	const kson::KshMeasureIndex index = kson::LoadKshMeasureIndex(indexFilePath);
+	REQUIRE(index.error == kson::ErrorType::None);
+	REQUIRE(kson::IsKshMeasureIndexUpToDate(index, filePath));
+
+	// Modifying the chart makes the index outdated
+	{
+		std::ofstream ofs(filePath, std::ios_base::binary | std::ios_base::app);
+		ofs << "\r\n";
+	}
+	REQUIRE(!kson::IsKshMeasureIndexUpToDate(index, filePath));
+	REQUIRE(kson::IsKshMeasureIndexUpToDate(kson::LoadOrBuildKshMeasureIndex(filePath), filePath));
+
+	REQUIRE(kson::LoadKshChartDataRange((dir / "missing.ksh").string(), 0, 1).error == kson::ErrorType::FileNotFound);
+
+	std::filesystem::remove_all(dir);
+}
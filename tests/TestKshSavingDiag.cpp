@@ -210,3 +210,48 @@ TEST_CASE("KSH saving multiple data loss warnings", "[ksh_saving_diag]")
 	REQUIRE(laserWarnings.size() == 1);
 	REQUIRE(fxWarnings.size() == 1);
 }
+
+TEST_CASE("KSH saving in Shift-JIS", "[ksh_saving_diag][encoding]")
+{
+	auto chartData = MakeMinimalChartData();
+	chartData.meta.title = "\xE3\x83\x86\xE3\x82\xB9\xE3\x83\x88\xE2\x99\xAA"; // "テスト♪"
+	chartData.meta.artist = "artist\xF0\x9F\x98\x80"; // "artist" + U+1F600 (not representable in Shift-JIS)
+
+	kson::KshSavingDiag diag;
+	std::stringstream ss;
+	const kson::ErrorType error = kson::SaveKshChartData(ss, chartData, kson::KshSavingOptions{ .encoding = kson::KshEncoding::ShiftJIS }, &diag);
+	REQUIRE(error == kson::ErrorType::None);
+
+	const std::string output = ss.str();
+
+	SECTION("text is encoded without BOM")
+	{
+		REQUIRE(output.rfind("\xEF\xBB\xBF", 0) == std::string::npos);
+		REQUIRE(output.find("title=\x83\x65\x83\x58\x83\x67\x81\xF4\r\n") != std::string::npos);
+		REQUIRE(output.find("artist=artist?\r\n") != std::string::npos);
+	}
+
+	SECTION("unmappable characters are reported")
+	{
+		auto warnings = FilterByType(diag.warnings, kson::KshSavingWarningType::UnmappableCharacter);
+		REQUIRE(warnings.size() == 1);
+		REQUIRE(warnings[0].message.find("U+1F600") != std::string::npos);
+	}
+
+	SECTION("output can be loaded back")
+	{
+		const kson::ChartData loaded = kson::LoadKshChartData(ss);
+		REQUIRE(loaded.error == kson::ErrorType::None);
+		REQUIRE(loaded.meta.title == chartData.meta.title);
+		REQUIRE(loaded.meta.artist == "artist?");
+	}
+}
+
+TEST_CASE("KSH saving in UTF-8 has no encoding warnings", "[ksh_saving_diag][encoding]")
+{
+	auto chartData = MakeMinimalChartData();
+	chartData.meta.artist = "artist\xF0\x9F\x98\x80";
+
+	auto warnings = FilterByType(SaveAndGetWarnings(chartData), kson::KshSavingWarningType::UnmappableCharacter);
+	REQUIRE(warnings.empty());
+}
@@ -968,3 +968,56 @@ TEST_CASE("KSON Tilt Serialization", "[kson_io][tilt]") {
 		REQUIRE(point2880.curve.b == Approx(0.7));
 	}
 }
+
+TEST_CASE("KSON repeated loading", "[kson_io]") {
+	// The JSON DOM of each load is released at once after loading, so values copied out of it must stay valid
+	const std::string longString(1000, 'x');
+	const std::string ksonData = R"({
+		"format_version": 1,
+		"meta": {
+			"title": ")" + longString + R"(",
+			"artist": "Test",
+			"chart_author": "Test",
+			"level": 1,
+			"disp_bpm": "120"
+		},
+		"beat": {
+			"bpm": [[0, 120.0], [960, 180.0]]
+		},
+		"note": {
+			"bt": [[[0, 240]], [], [480], []]
+		},
+		"impl": {
+			"app": {"nested": [1, 2.5, "str", {"key": [true, null]}], "long": ")" + longString + R"("}
+		}
+	})";
+
+	const nlohmann::json expectedImpl = {
+		{ "app", {
+			{ "nested", nlohmann::json::array({ 1, 2.5, "str", { { "key", nlohmann::json::array({ true, nullptr }) } } }) },
+			{ "long", longString },
+		} },
+	};
+
+	std::vector<kson::ChartData> charts;
+	for (int i = 0; i < 3; ++i)
+	{
+		std::istringstream iss(ksonData);
+		charts.push_back(kson::LoadKsonChartData(iss));
+
+		// A failed load in between must not affect the others
+		std::istringstream invalidIss(R"({"format_version": 1, "beat": {"bpm": [[0, )");
+		REQUIRE(kson::LoadKsonChartData(invalidIss).error == kson::ErrorType::KsonParseError);
+	}
+
+	for (const kson::ChartData& chart : charts)
+	{
+		REQUIRE(chart.error == kson::ErrorType::None);
+		REQUIRE(chart.meta.title == longString);
+		REQUIRE(chart.beat.bpm.size() == 2);
+		REQUIRE(chart.beat.bpm.at(960) == Approx(180.0));
+		REQUIRE(chart.note.bt[0].at(0).length == 240);
+		REQUIRE(chart.note.bt[2].contains(480));
+		REQUIRE(chart.impl == expectedImpl);
+	}
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Audio/LaserFilterTables.hpp>
+#include <complex>
+#include <numbers>
+
+namespace
+{
+	// Magnitude response of the biquad at freq
+	double Magnitude(const kson::BiquadCoefficients& c, double freq, double sampleRate)
+	{
+		const std::complex<double> z1 = std::polar(1.0, -2 * std::numbers::pi * freq / sampleRate);
+		const std::complex<double> z2 = z1 * z1;
+		const std::complex<double> num = static_cast<double>(c.b0) + static_cast<double>(c.b1) * z1 + static_cast<double>(c.b2) * z2;
+		const std::complex<double> den = 1.0 + static_cast<double>(c.a1) * z1 + static_cast<double>(c.a2) * z2;
+		return std::abs(num / den);
+	}
+
+	void RequireCoefficientsNear(const kson::BiquadCoefficients& a, const kson::BiquadCoefficients& b, float margin)
+	{
+		REQUIRE(a.b0 == Approx(b.b0).margin(margin));
+		REQUIRE(a.b1 == Approx(b.b1).margin(margin));
+		REQUIRE(a.b2 == Approx(b.b2).margin(margin));
+		REQUIRE(a.a1 == Approx(b.a1).margin(margin));
+		REQUIRE(a.a2 == Approx(b.a2).margin(margin));
+	}
+}
+
+TEST_CASE("ParseLaserFilterParamValue", "[laser_filter]")
+{
+	using kson::LaserFilterParamUnit;
+
+	const auto freq = kson::ParseLaserFilterParamValue("1kHz>80Hz-2.5kHz", LaserFilterParamUnit::Frequency);
+	REQUIRE(freq.has_value());
+	REQUIRE(freq->off == Approx(1000.0));
+	REQUIRE(freq->onMin == Approx(80.0));
+	REQUIRE(freq->onMax == Approx(2500.0));
+	REQUIRE(freq->at(0.5, true) == Approx(std::sqrt(80.0 * 2500.0)));
+	REQUIRE(freq->at(0.5, false) == Approx(1290.0));
+
+	const auto single = kson::ParseLaserFilterParamValue("500Hz", LaserFilterParamUnit::Frequency);
+	REQUIRE(single.has_value());
+	REQUIRE(single->off == Approx(500.0));
+	REQUIRE(single->onMax == Approx(500.0));
+
+	const auto gain = kson::ParseLaserFilterParamValue("-3dB--6dB", LaserFilterParamUnit::Gain);
+	REQUIRE(gain.has_value());
+	REQUIRE(gain->onMin == Approx(-3.0));
+	REQUIRE(gain->onMax == Approx(-6.0));
+
+	const auto percent = kson::ParseLaserFilterParamValue("0%>50%", LaserFilterParamUnit::Gain);
+	REQUIRE(percent.has_value());
+	REQUIRE(percent->off == Approx(0.0));
+	REQUIRE(percent->onMin == Approx(kson::kPeakingFilterMaxGainDb / 2));
+
+	REQUIRE(!kson::ParseLaserFilterParamValue("", LaserFilterParamUnit::Plain).has_value());
+	REQUIRE(!kson::ParseLaserFilterParamValue("abc", LaserFilterParamUnit::Plain).has_value());
+	REQUIRE(!kson::ParseLaserFilterParamValue("1.5%", LaserFilterParamUnit::Plain).has_value());
+	REQUIRE(!kson::ParseLaserFilterParamValue("0Hz", LaserFilterParamUnit::Frequency).has_value());
+	REQUIRE(!kson::ParseLaserFilterParamValue("100Hz-", LaserFilterParamUnit::Frequency).has_value());
+}
+
+TEST_CASE("Biquad filter coefficients", "[laser_filter]")
+{
+	constexpr double kSampleRate = 48000.0;
+
+	const auto lpf = kson::LowPassFilterCoefficients(1000.0, std::numbers::sqrt2 / 2, kSampleRate);
+	REQUIRE(Magnitude(lpf, 0.0, kSampleRate) == Approx(1.0).margin(1e-4));
+	REQUIRE(Magnitude(lpf, 1000.0, kSampleRate) == Approx(std::numbers::sqrt2 / 2).margin(1e-3));
+	REQUIRE(Magnitude(lpf, 10000.0, kSampleRate) < 0.05);
+
+	const auto hpf = kson::HighPassFilterCoefficients(1000.0, std::numbers::sqrt2 / 2, kSampleRate);
+	REQUIRE(Magnitude(hpf, 0.0, kSampleRate) == Approx(0.0).margin(1e-4));
+	REQUIRE(Magnitude(hpf, 20000.0, kSampleRate) == Approx(1.0).margin(1e-2));
+
+	const auto peak = kson::PeakingFilterCoefficients(1000.0, 1.0, 6.0, kSampleRate);
+	REQUIRE(Magnitude(peak, 1000.0, kSampleRate) == Approx(std::pow(10.0, 6.0 / 20)).margin(1e-3));
+	REQUIRE(Magnitude(peak, 0.0, kSampleRate) == Approx(1.0).margin(1e-3));
+}
+
+TEST_CASE("LaserFilterCoefficientTable", "[laser_filter]")
+{
+	const kson::LaserFilterTableOptions options{ .sampleRate = 44100.0, .numPositionSteps = 256, .numFilterGainSteps = 8 };
+
+	SECTION("Low-pass filter")
+	{
+		const auto params = *kson::DefaultLaserFilterParams(kson::AudioEffectType::LowPassFilter);
+		const kson::LaserFilterCoefficientTable table(params, options);
+		REQUIRE(!table.empty());
+
+		// Exact on the grid and close to the direct computation between grid points
+		for (const double position : { 0.0, 0.25, 1.0 })
+		{
+			RequireCoefficientsNear(table.at(position), kson::LowPassFilterCoefficients(params.freq.at(position, true), params.q.at(position, false), options.sampleRate), 1e-6f);
+		}
+		for (const double position : { 0.1234, 0.5678, 0.999 })
+		{
+			RequireCoefficientsNear(table.at(position), kson::LowPassFilterCoefficients(params.freq.at(position, true), params.q.at(position, false), options.sampleRate), 1e-3f);
+		}
+
+		// Out-of-range positions are clamped
+		RequireCoefficientsNear(table.at(-1.0), table.at(0.0), 0.0f);
+		RequireCoefficientsNear(table.at(2.0), table.at(1.0), 0.0f);
+	}
+
+	SECTION("Peaking filter with legacy filter gain")
+	{
+		auto params = *kson::DefaultLaserFilterParams(kson::AudioEffectType::PeakingFilter);
+		kson::ApplyLaserFilterParams({ { "gain", "12dB" }, { "freq", "1kHz-4kHz" } }, &params);
+		const kson::LaserFilterCoefficientTable table(params, options);
+
+		const auto coefficients = table.at(0.0, 0.5);
+		REQUIRE(Magnitude(coefficients, 1000.0, options.sampleRate) == Approx(std::pow(10.0, 6.0 / 20)).margin(1e-2));
+
+		RequireCoefficientsNear(table.at(0.5, 0.3), kson::PeakingFilterCoefficients(2000.0, 1.0, 12.0 * 0.3, options.sampleRate), 2e-3f);
+
+		// Flat response at zero gain
+		const auto flat = table.at(0.5, 0.0);
+		REQUIRE(flat.b0 == Approx(1.0f));
+		REQUIRE(flat.b1 == Approx(flat.a1));
+		REQUIRE(flat.b2 == Approx(flat.a2));
+	}
+}
+
+TEST_CASE("LaserFilterTables", "[laser_filter]")
+{
+	kson::AudioEffectLaserInfo laserInfo;
+	laserInfo.def.push_back({ .name = "myLPF", .v = { .type = kson::AudioEffectType::LowPassFilter, .v = { { "freq", "5kHz-1kHz" } } } });
+	laserInfo.def.push_back({ .name = "GA16", .v = { .type = kson::AudioEffectType::Gate } });
+	laserInfo.paramChange["myLPF"]["freq"].emplace(960, "2kHz-500Hz");
+	laserInfo.paramChange["myLPF"]["q"].emplace(1920, "3");
+	laserInfo.legacy.filterGain.emplace(480, 0.25);
+
+	const kson::LaserFilterTableOptions options;
+	const kson::LaserFilterTables tables(laserInfo, options);
+
+	REQUIRE(tables.find("peaking_filter", 0) != nullptr);
+	REQUIRE(tables.find("low_pass_filter", 0) != nullptr);
+	REQUIRE(tables.find("high_pass_filter", 0) != nullptr);
+	REQUIRE(tables.find("GA16", 0) == nullptr);
+	REQUIRE(tables.find("unknown", 0) == nullptr);
+
+	const auto expected = [&options](double freq, double q)
+	{
+		return kson::LowPassFilterCoefficients(freq, q, options.sampleRate);
+	};
+	const double defaultQ = kson::DefaultLaserFilterParams(kson::AudioEffectType::LowPassFilter)->q.onMin;
+	RequireCoefficientsNear(tables.find("myLPF", 0)->at(0.0), expected(5000.0, defaultQ), 1e-6f);
+	RequireCoefficientsNear(tables.find("myLPF", 959)->at(1.0), expected(1000.0, defaultQ), 1e-6f);
+	RequireCoefficientsNear(tables.find("myLPF", 960)->at(0.0), expected(2000.0, defaultQ), 1e-6f);
+	RequireCoefficientsNear(tables.find("myLPF", 1920)->at(1.0), expected(500.0, 3.0), 1e-6f);
+	RequireCoefficientsNear(tables.find("myLPF", 100000)->at(1.0), expected(500.0, 3.0), 1e-6f);
+
+	REQUIRE(tables.filterGainAt(0) == 1.0);
+	REQUIRE(tables.filterGainAt(480) == 0.25);
+	REQUIRE(tables.filterGainAt(10000) == 0.25);
+}
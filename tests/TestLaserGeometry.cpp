@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/LaserGeometry.hpp>
+#include <kson/Util/ScrollUtils.hpp>
+
+TEST_CASE("PulseToScrollPosition", "[scroll_speed][laser_geometry]")
+{
+	kson::BeatInfo beatInfo;
+	beatInfo.bpm[0] = 120.0;
+	beatInfo.scrollSpeed[0] = kson::GraphValue{ 1.0 };
+	beatInfo.scrollSpeed[960] = kson::GraphValue{ 2.0 };
+	beatInfo.scrollSpeed[1920] = kson::GraphValue{ -1.0, 1.0 };
+	beatInfo.stop[2880] = 480;
+
+	const kson::ScrollPositionCache cache = kson::CreateScrollPositionCache(beatInfo);
+
+	REQUIRE(kson::PulseToScrollPosition(0, cache) == Approx(0.0));
+	REQUIRE(kson::PulseToScrollPosition(480, cache) == Approx(480.0 + 480.0 * 0.5 / 2)); // Linear speed change 1.0->1.5
+	REQUIRE(kson::PulseToScrollPosition(960, cache) == Approx(960.0 * 1.5));
+	REQUIRE(kson::PulseToScrollPosition(1920, cache) == Approx(960.0 * 1.5 + 960.0 * 0.5));
+	REQUIRE(kson::PulseToScrollPosition(2880, cache) == Approx(960.0 * 1.5 + 960.0 * 0.5 + 960.0));
+	REQUIRE(kson::PulseToScrollPosition(3360, cache) == Approx(960.0 * 1.5 + 960.0 * 0.5 + 960.0));
+	REQUIRE(kson::PulseToScrollPosition(3840, cache) == Approx(960.0 * 1.5 + 960.0 * 0.5 + 960.0 + 480.0));
+}
+
+TEST_CASE("BuildLaserGeometry with linear segments and slams", "[laser_geometry]")
+{
+	kson::LaserLane<kson::LaserSection> laser;
+	auto& section = laser[0][960];
+	section.v[0] = kson::GraphPoint{ kson::GraphValue{ 0.0 } };
+	section.v[240] = kson::GraphPoint{ kson::GraphValue{ 0.5, 1.0 } };
+	section.v[480] = kson::GraphPoint{ kson::GraphValue{ 0.0 } };
+
+	auto& wideSection = laser[1][0];
+	wideSection.w = kson::kLaserXScale2x;
+	wideSection.v[0] = kson::GraphPoint{ kson::GraphValue{ 1.0 } };
+	wideSection.v[240] = kson::GraphPoint{ kson::GraphValue{ 0.0 } };
+
+	kson::LaserGeometry geometry;
+	kson::BuildLaserGeometry(laser, 0, 3840, kson::LaserGeometryParams{}, &geometry);
+
+	SECTION("Strips are split at slams")
+	{
+		const auto& lane = geometry.lanes[0];
+		REQUIRE(lane.strips.size() == 2);
+		REQUIRE(lane.strips[0].vertexOffset == 0);
+		REQUIRE(lane.strips[0].vertexCount == 2);
+		REQUIRE(lane.strips[1].vertexOffset == 2);
+		REQUIRE(lane.strips[1].vertexCount == 2);
+		REQUIRE(lane.strips[0].sectionY == 960);
+
+		REQUIRE(lane.vertices[1].x == Approx(0.5));
+		REQUIRE(lane.vertices[1].y == Approx(1200.0));
+		REQUIRE(lane.vertices[2].x == Approx(1.0));
+		REQUIRE(lane.vertices[2].y == Approx(1200.0));
+
+		REQUIRE(lane.slams.size() == 1);
+		REQUIRE(lane.slams[0].y == Approx(1200.0));
+		REQUIRE(lane.slams[0].xFrom == Approx(0.5));
+		REQUIRE(lane.slams[0].xTo == Approx(1.0));
+	}
+
+	SECTION("Wide lasers are scaled")
+	{
+		const auto& lane = geometry.lanes[1];
+		REQUIRE(lane.strips.size() == 1);
+		REQUIRE(lane.strips[0].wide);
+		REQUIRE(lane.vertices.size() == 2);
+		REQUIRE(lane.vertices[0].x == Approx(1.5));
+		REQUIRE(lane.vertices[1].x == Approx(-0.5));
+	}
+
+	SECTION("Sections outside the range are skipped")
+	{
+		kson::BuildLaserGeometry(laser, 1441, 3840, kson::LaserGeometryParams{}, &geometry);
+		REQUIRE(geometry.lanes[0].vertices.empty());
+		REQUIRE(geometry.lanes[1].vertices.empty());
+
+		kson::BuildLaserGeometry(laser, 1300, 3840, kson::LaserGeometryParams{}, &geometry);
+		REQUIRE(geometry.lanes[0].strips.size() == 1);
+		REQUIRE(geometry.lanes[0].slams.empty());
+		REQUIRE(geometry.lanes[0].vertices.size() == 2);
+		REQUIRE(geometry.lanes[0].vertices[0].y == Approx(1200.0));
+	}
+}
+
+TEST_CASE("BuildLaserGeometry curve tessellation", "[laser_geometry][curve]")
+{
+	kson::LaserLane<kson::LaserSection> laser;
+	auto& section = laser[0][0];
+	section.v[0] = kson::GraphPoint{ kson::GraphValue{ 0.0 }, kson::GraphCurveValue{ 0.0, 1.0 } };
+	section.v[960] = kson::GraphPoint{ kson::GraphValue{ 1.0 } };
+
+	kson::LaserGeometry coarse;
+	kson::BuildLaserGeometry(laser, 0, 960, kson::LaserGeometryParams{ .tolerance = 0.05 }, &coarse);
+	kson::LaserGeometry fine;
+	kson::BuildLaserGeometry(laser, 0, 960, kson::LaserGeometryParams{ .tolerance = 0.001 }, &fine);
+
+	REQUIRE(coarse.lanes[0].vertices.size() > 2);
+	REQUIRE(fine.lanes[0].vertices.size() > coarse.lanes[0].vertices.size());
+
+	// Every vertex is on the curve and the chords stay within the tolerance
+	const auto& vertices = fine.lanes[0].vertices;
+	REQUIRE(vertices.front().y == Approx(0.0));
+	REQUIRE(vertices.back().y == Approx(960.0));
+	for (std::size_t i = 0; i < vertices.size(); ++i)
+	{
+		REQUIRE(vertices[i].x == Approx(kson::EvaluateCurve(0.0, 1.0, vertices[i].y / 960.0)));
+		if (i > 0)
+		{
+			const double midY = (vertices[i - 1].y + vertices[i].y) / 2;
+			const double midX = (vertices[i - 1].x + vertices[i].x) / 2;
+			REQUIRE(std::abs(midX - kson::EvaluateCurve(0.0, 1.0, midY / 960.0)) <= 0.001);
+		}
+	}
+
+	// Buffers are reused
+	const auto capacity = fine.lanes[0].vertices.capacity();
+	kson::BuildLaserGeometry(laser, 0, 960, kson::LaserGeometryParams{ .tolerance = 0.001 }, &fine);
+	REQUIRE(fine.lanes[0].vertices.capacity() == capacity);
+}
+
+TEST_CASE("BuildLaserGeometry in scroll space", "[laser_geometry][scroll_speed]")
+{
+	kson::BeatInfo beatInfo;
+	beatInfo.bpm[0] = 120.0;
+	beatInfo.scrollSpeed[0] = kson::GraphValue{ 1.0 };
+	beatInfo.scrollSpeed[480] = kson::GraphValue{ 2.0 };
+	const kson::ScrollPositionCache cache = kson::CreateScrollPositionCache(beatInfo);
+
+	kson::LaserLane<kson::LaserSection> laser;
+	auto& section = laser[0][0];
+	section.v[0] = kson::GraphPoint{ kson::GraphValue{ 0.0 } };
+	section.v[960] = kson::GraphPoint{ kson::GraphValue{ 1.0 } };
+
+	kson::LaserGeometry geometry;
+	kson::BuildLaserGeometry(laser, 0, 960, cache, kson::LaserGeometryParams{}, &geometry);
+
+	// A vertex is inserted at the scroll speed change
+	const auto& vertices = geometry.lanes[0].vertices;
+	REQUIRE(vertices.size() == 3);
+	REQUIRE(vertices[1].x == Approx(0.5));
+	REQUIRE(vertices[1].y == Approx(480.0 * 1.5));
+	REQUIRE(vertices[2].y == Approx(480.0 * 1.5 + 480.0 * 2.0));
+}
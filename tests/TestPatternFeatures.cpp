@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Analysis/PatternFeatures.hpp>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	constexpr kson::Pulse kCell = kson::kPatternGridPulse;
+}
+
+TEST_CASE("Pattern features", "[pattern_features]")
+{
+	kson::ChartData chartData;
+
+	SECTION("Chords")
+	{
+		chartData.note.bt[0][0] = kson::Interval{ 0 };
+		chartData.note.bt[1][0] = kson::Interval{ 0 };
+		chartData.note.fx[1][0] = kson::Interval{ 0 };
+		chartData.note.bt[2][480] = kson::Interval{ 0 };
+
+		const auto features = kson::AnalyzePatternFeatures(chartData);
+		REQUIRE(features.numNotes == 4);
+		REQUIRE(features.numChords == 1);
+	}
+
+	SECTION("Jacks")
+	{
+		// 16th jacks in BT-A crossing a word boundary of the bitset
+		for (kson::Pulse i = 0; i < 8; ++i)
+		{
+			chartData.note.bt[0][60 * kCell + i * 12 * kCell] = kson::Interval{ 0 };
+		}
+		// Too far from each other
+		chartData.note.bt[1][0] = kson::Interval{ 0 };
+		chartData.note.bt[1][960] = kson::Interval{ 0 };
+
+		const auto features = kson::AnalyzePatternFeatures(chartData);
+		REQUIRE(features.numJacks == 7);
+	}
+
+	SECTION("Trills")
+	{
+		// A B A B A
+		for (kson::Pulse i = 0; i < 5; ++i)
+		{
+			chartData.note.bt[i % 2][i * 12 * kCell] = kson::Interval{ 0 };
+		}
+
+		const auto features = kson::AnalyzePatternFeatures(chartData);
+		REQUIRE(features.numTrills == 3);
+	}
+
+	SECTION("Streams")
+	{
+		for (kson::Pulse i = 0; i < 10; ++i)
+		{
+			chartData.note.bt[i % 4][i * 12 * kCell] = kson::Interval{ 0 };
+		}
+		for (kson::Pulse i = 0; i < 4; ++i)
+		{
+			chartData.note.bt[i % 4][3840 + i * 12 * kCell] = kson::Interval{ 0 };
+		}
+
+		const auto features = kson::AnalyzePatternFeatures(chartData, kson::PatternAnalysisParams{ .streamMinLength = 8 });
+		REQUIRE(features.numStreamNotes == 10);
+		REQUIRE(features.maxStreamLength == 10);
+	}
+
+	SECTION("Crossovers")
+	{
+		chartData.note.fx[0][0] = kson::Interval{ 960 };
+		chartData.note.bt[3][480] = kson::Interval{ 0 };
+		chartData.note.bt[0][480] = kson::Interval{ 0 };
+		chartData.note.bt[2][960] = kson::Interval{ 0 }; // After the FX long note ends
+
+		const auto features = kson::AnalyzePatternFeatures(chartData);
+		REQUIRE(features.numCrossovers == 1);
+	}
+}
+
+TEST_CASE("Pattern features batch", "[pattern_features][bundled]")
+{
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+
+	const auto single = kson::AnalyzePatternFeatures(chartData);
+	REQUIRE(single.numNotes > 0);
+
+	const std::vector<const kson::ChartData*> charts(8, &chartData);
+	const auto results = kson::AnalyzePatternFeatures(charts, {}, 4);
+	REQUIRE(results.size() == charts.size());
+	for (const auto& features : results)
+	{
+		REQUIRE(features.numNotes == single.numNotes);
+		REQUIRE(features.numChords == single.numChords);
+		REQUIRE(features.numJacks == single.numJacks);
+		REQUIRE(features.numTrills == single.numTrills);
+		REQUIRE(features.numStreamNotes == single.numStreamNotes);
+		REQUIRE(features.numCrossovers == single.numCrossovers);
+	}
+}
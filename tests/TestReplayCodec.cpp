@@ -0,0 +1,165 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Replay/ReplayCodec.hpp>
+#include <random>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	std::int64_t NoteUs(kson::Pulse y, const kson::ChartData& chartData, const kson::TimingCache& timingCache)
+	{
+		return static_cast<std::int64_t>(std::llround(kson::PulseToMs(y, chartData.beat, timingCache) * 1000.0));
+	}
+
+	// A play that hits every note with small random offsets and follows lasers at 240 fps with jitter
+	kson::ReplayData CreateReplay(const kson::ChartData& chartData, std::uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<std::int64_t> timingDist(-30000, 30000);
+		std::uniform_int_distribution<std::int32_t> jitterDist(-8, 8);
+		const kson::TimingCache timingCache = kson::CreateTimingCache(chartData.beat);
+
+		kson::ReplayData replay;
+		const auto addPresses = [&](const kson::ByPulse<kson::Interval>& notes, std::vector<kson::ReplayPress>& presses)
+		{
+			for (const auto& [y, note] : notes)
+			{
+				const std::int64_t pressUs = NoteUs(y, chartData, timingCache) + timingDist(rng);
+				const std::int64_t releaseUs = note.length > 0 ? NoteUs(y + note.length, chartData, timingCache) + timingDist(rng) : pressUs + 50000;
+				presses.push_back({ .pressUs = pressUs, .releaseUs = releaseUs });
+			}
+		};
+		for (std::size_t i = 0; i < kson::kNumBTLanesSZ; ++i)
+		{
+			addPresses(chartData.note.bt[i], replay.bt[i]);
+		}
+		for (std::size_t i = 0; i < kson::kNumFXLanesSZ; ++i)
+		{
+			addPresses(chartData.note.fx[i], replay.fx[i]);
+		}
+
+		const kson::Pulse lastPulse = kson::LastNoteEndY(chartData.note);
+		const std::int64_t endUs = NoteUs(lastPulse, chartData, timingCache);
+		for (std::size_t i = 0; i < kson::kNumLaserLanesSZ; ++i)
+		{
+			std::int32_t position = 0;
+			for (std::int64_t us = 0; us < endUs; us += 1000000 / 240)
+			{
+				const kson::Pulse pulse = kson::MsToPulse(static_cast<double>(us) / 1000.0, chartData.beat, timingCache);
+				const auto value = kson::GraphSectionValueAt(chartData.note.laser[i], pulse);
+				if (value.has_value())
+				{
+					const bool wide = kson::GraphSectionAt(chartData.note.laser[i], pulse)->second.wide();
+					position = static_cast<std::int32_t>(std::lround((wide ? *value * 2 - 0.5 : *value) * kson::kReplayLaserPositionScale)) + jitterDist(rng);
+				}
+				replay.laser[i].push_back({ .timeUs = us, .position = position });
+			}
+		}
+		return replay;
+	}
+
+	std::size_t RawSize(const kson::ReplayData& replay)
+	{
+		std::size_t size = 0;
+		for (const auto& lane : replay.bt)
+		{
+			size += lane.size() * sizeof(kson::ReplayPress);
+		}
+		for (const auto& lane : replay.fx)
+		{
+			size += lane.size() * sizeof(kson::ReplayPress);
+		}
+		for (const auto& lane : replay.laser)
+		{
+			size += lane.size() * (sizeof(std::int64_t) + sizeof(std::int32_t));
+		}
+		return size;
+	}
+}
+
+TEST_CASE("ReplayCodec round trip", "[replay_codec]")
+{
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+	const kson::ReplayCodec codec(chartData);
+
+	const kson::ReplayData replay = CreateReplay(chartData, 1234);
+	const std::vector<std::uint8_t> encoded = codec.encode(replay);
+
+	kson::ReplayData decoded;
+	REQUIRE(codec.decode(encoded, &decoded));
+	REQUIRE(decoded == replay);
+
+	// Timing deltas and laser deviations are small, so the encoded size is much smaller than the raw timestamps
+	REQUIRE(encoded.size() * 3 < RawSize(replay));
+
+	// Decoding into a used buffer gives the same result
+	REQUIRE(codec.decode(encoded, &decoded));
+	REQUIRE(decoded == replay);
+}
+
+TEST_CASE("ReplayCodec arbitrary inputs", "[replay_codec]")
+{
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ch.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+	const kson::ReplayCodec codec(chartData);
+
+	// Unsorted, overlapping, extreme and off-note inputs are also restored exactly
+	kson::ReplayData replay;
+	replay.bt[0] = {
+		{ .pressUs = 5000000, .releaseUs = 4000000 },
+		{ .pressUs = -1, .releaseUs = std::numeric_limits<std::int64_t>::max() },
+		{ .pressUs = std::numeric_limits<std::int64_t>::min(), .releaseUs = std::numeric_limits<std::int64_t>::max() },
+		{ .pressUs = 123456789, .releaseUs = 123456790 },
+	};
+	replay.fx[1] = { { .pressUs = 0, .releaseUs = 0 } };
+	replay.laser[0] = {
+		{ .timeUs = 1000000, .position = 0 },
+		{ .timeUs = 500000, .position = std::numeric_limits<std::int32_t>::max() },
+		{ .timeUs = std::numeric_limits<std::int64_t>::min(), .position = std::numeric_limits<std::int32_t>::min() },
+	};
+
+	kson::ReplayData decoded;
+	REQUIRE(codec.decode(codec.encode(replay), &decoded));
+	REQUIRE(decoded == replay);
+
+	// Charts without notes
+	kson::ChartData emptyChart;
+	emptyChart.beat.bpm[0] = 120.0;
+	emptyChart.beat.timeSig[0] = kson::TimeSig{ 4, 4 };
+	const kson::ReplayCodec emptyCodec(emptyChart);
+	REQUIRE(emptyCodec.decode(emptyCodec.encode(replay), &decoded));
+	REQUIRE(decoded == replay);
+}
+
+TEST_CASE("ReplayCodec rejects invalid data", "[replay_codec]")
+{
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+	const kson::ChartData otherChartData = kson::LoadKshChartData(g_assetsDir + "/Gram_in.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+	REQUIRE(otherChartData.error == kson::ErrorType::None);
+	const kson::ReplayCodec codec(chartData);
+	const kson::ReplayCodec otherCodec(otherChartData);
+	REQUIRE(codec.chartHash() != otherCodec.chartHash());
+
+	const std::vector<std::uint8_t> encoded = codec.encode(CreateReplay(chartData, 5678));
+	kson::ReplayData decoded;
+
+	// Encoded with another chart
+	REQUIRE(!otherCodec.decode(encoded, &decoded));
+
+	// Truncated or trailing data
+	for (const std::size_t size : { std::size_t{ 0 }, std::size_t{ 3 }, std::size_t{ 10 }, encoded.size() / 2, encoded.size() - 1 })
+	{
+		REQUIRE(!codec.decode(std::span(encoded).first(size), &decoded));
+	}
+	std::vector<std::uint8_t> trailing = encoded;
+	trailing.push_back(0);
+	REQUIRE(!codec.decode(trailing, &decoded));
+
+	// Wrong magic
+	std::vector<std::uint8_t> wrongMagic = encoded;
+	wrongMagic[0] = 'X';
+	REQUIRE(!codec.decode(wrongMagic, &decoded));
+}
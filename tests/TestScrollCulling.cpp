@@ -0,0 +1,192 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/ScrollCulling.hpp>
+#include <random>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	// Chart scrolling backward in the middle, with a stop and a speed jump
+	kson::ChartData CreateReverseScrollChart()
+	{
+		kson::ChartData chartData;
+		chartData.beat.bpm[0] = 120.0;
+
+		auto& scrollSpeed = chartData.beat.scrollSpeed;
+		scrollSpeed[0] = kson::GraphValue{ 1.0 };
+		scrollSpeed[960] = kson::GraphValue{ 1.0 };
+		scrollSpeed[1920] = kson::GraphValue{ -1.0 }; // Crosses zero at 1440
+		scrollSpeed[2880] = kson::GraphValue{ -1.0, 2.0 };
+		chartData.beat.stop[3840] = 240;
+
+		auto& note = chartData.note;
+		for (kson::Pulse y = 0; y < 4800; y += 120)
+		{
+			note.bt[static_cast<std::size_t>(y / 120 % 4)][y] = kson::Interval{ 0 };
+		}
+		note.bt[0][1200] = kson::Interval{ 1200 }; // Turns back at 1440
+		note.fx[1][2400] = kson::Interval{ 960 }; // Goes back and forth
+		note.fx[0][3840] = kson::Interval{ 240 }; // Inside the stop
+		note.laser[0][2000].v = { { 0, kson::GraphValue{ 0.0 } }, { 1000, kson::GraphValue{ 1.0 } } };
+		return chartData;
+	}
+
+	std::vector<std::size_t> BruteForceNotesInScrollRange(const kson::ScrollCullingIndex& index, double minPosition, double maxPosition)
+	{
+		std::vector<std::size_t> noteIndices;
+		for (std::size_t i = 0; i < index.notes.size(); ++i)
+		{
+			if (index.notes[i].maxScrollPosition >= minPosition && index.notes[i].minScrollPosition <= maxPosition)
+			{
+				noteIndices.push_back(i);
+			}
+		}
+		return noteIndices;
+	}
+
+	void CheckQueries(const kson::ChartData& chartData)
+	{
+		const kson::ScrollPositionCache scrollCache = kson::CreateScrollPositionCache(chartData.beat);
+		const kson::ScrollCullingIndex index = kson::CreateScrollCullingIndex(chartData.note, scrollCache);
+		REQUIRE(!index.notes.empty());
+
+		// Every note is in exactly one node
+		REQUIRE(index.midByMin.size() == index.notes.size());
+		REQUIRE(index.midByMax.size() == index.notes.size());
+
+		// The bounds cover the scroll positions at every pulse of the note
+		for (const auto& note : index.notes)
+		{
+			double sampledMin = kson::PulseToScrollPosition(note.y, scrollCache);
+			double sampledMax = sampledMin;
+			for (kson::Pulse y = note.y; y <= note.y + note.length; ++y)
+			{
+				const double position = kson::PulseToScrollPosition(y, scrollCache);
+				sampledMin = std::min(sampledMin, position);
+				sampledMax = std::max(sampledMax, position);
+			}
+			REQUIRE(note.minScrollPosition <= sampledMin + 1e-6);
+			REQUIRE(note.maxScrollPosition >= sampledMax - 1e-6);
+			REQUIRE(note.minScrollPosition == Approx(sampledMin).margin(1.0));
+			REQUIRE(note.maxScrollPosition == Approx(sampledMax).margin(1.0));
+		}
+
+		const double firstPosition = index.notes.front().minScrollPosition;
+		const double lastPosition = std::max_element(index.notes.begin(), index.notes.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.maxScrollPosition < rhs.maxScrollPosition;
+		})->maxScrollPosition;
+
+		std::mt19937 engine(12345);
+		std::uniform_real_distribution<double> positionDist(firstPosition - 500.0, lastPosition + 500.0);
+		std::uniform_real_distribution<double> lengthDist(0.0, 4000.0);
+		std::vector<std::size_t> noteIndices;
+		for (int i = 0; i < 500; ++i)
+		{
+			const double minPosition = positionDist(engine);
+			const double maxPosition = minPosition + (i % 10 == 0 ? 0.0 : lengthDist(engine));
+			kson::FindNotesInScrollRange(index, minPosition, maxPosition, &noteIndices);
+			std::sort(noteIndices.begin(), noteIndices.end());
+			INFO("Range: [" << minPosition << ", " << maxPosition << "]");
+			REQUIRE(noteIndices == BruteForceNotesInScrollRange(index, minPosition, maxPosition));
+		}
+
+		// Ranges starting or ending exactly at note positions
+		for (std::size_t i = 0; i < index.notes.size(); i += 7)
+		{
+			const double position = index.notes[i].minScrollPosition;
+			for (const auto& [minPosition, maxPosition] : { std::pair{ position, position }, std::pair{ position - 100.0, position }, std::pair{ position, position + 100.0 } })
+			{
+				kson::FindNotesInScrollRange(index, minPosition, maxPosition, &noteIndices);
+				std::sort(noteIndices.begin(), noteIndices.end());
+				REQUIRE(noteIndices == BruteForceNotesInScrollRange(index, minPosition, maxPosition));
+			}
+		}
+
+		// Empty range
+		kson::FindNotesInScrollRange(index, 1.0, 0.0, &noteIndices);
+		REQUIRE(noteIndices.empty());
+	}
+}
+
+TEST_CASE("ScrollCullingIndex bounds with reverse scroll", "[scroll_culling]")
+{
+	const kson::ChartData chartData = CreateReverseScrollChart();
+	const kson::ScrollPositionCache scrollCache = kson::CreateScrollPositionCache(chartData.beat);
+	const kson::ScrollCullingIndex index = kson::CreateScrollCullingIndex(chartData.note, scrollCache);
+
+	const auto findNote = [&index](kson::ScrollCullingLaneType laneType, std::int32_t laneIdx, kson::Pulse y) -> const kson::ScrollCullingNote&
+	{
+		const auto itr = std::find_if(index.notes.begin(), index.notes.end(), [&](const kson::ScrollCullingNote& note)
+		{
+			return note.laneType == laneType && note.laneIdx == laneIdx && note.y == y;
+		});
+		REQUIRE(itr != index.notes.end());
+		return *itr;
+	};
+
+	// The long note is farthest where the speed crosses zero, not at its end
+	const auto& longNote = findNote(kson::ScrollCullingLaneType::BT, 0, 1200);
+	REQUIRE(longNote.length == 1200);
+	REQUIRE(longNote.maxScrollPosition == Approx(kson::PulseToScrollPosition(1440, scrollCache)));
+	REQUIRE(longNote.minScrollPosition == Approx(kson::PulseToScrollPosition(2400, scrollCache)));
+	REQUIRE(kson::PulseToScrollPosition(1200, scrollCache) > longNote.minScrollPosition);
+
+	// Chip notes are points
+	const auto& chipNote = findNote(kson::ScrollCullingLaneType::BT, 1, 120);
+	REQUIRE(chipNote.minScrollPosition == chipNote.maxScrollPosition);
+	REQUIRE(chipNote.minScrollPosition == Approx(120.0));
+
+	// A long note inside the stop does not move
+	const auto& stopNote = findNote(kson::ScrollCullingLaneType::FX, 0, 3840);
+	REQUIRE(stopNote.maxScrollPosition - stopNote.minScrollPosition == Approx(0.0).margin(1e-9));
+
+	const auto& laserNote = findNote(kson::ScrollCullingLaneType::Laser, 0, 2000);
+	REQUIRE(laserNote.length == 1000);
+
+	// The notes scrolled back appear again on screen after passing the judgement line
+	std::vector<std::size_t> noteIndices;
+	kson::FindVisibleNotes(index, scrollCache, 2880.0, 0.0, 10.0, &noteIndices);
+	const double position = kson::PulseToScrollPosition(2880, scrollCache);
+	bool foundEarlyChip = false;
+	for (const std::size_t idx : noteIndices)
+	{
+		const auto& note = index.notes[idx];
+		REQUIRE(note.maxScrollPosition >= position);
+		REQUIRE(note.minScrollPosition <= position + 10.0);
+		if (note.y < 2880 && note.length == 0)
+		{
+			foundEarlyChip = true;
+		}
+	}
+	REQUIRE(foundEarlyChip);
+}
+
+TEST_CASE("ScrollCullingIndex queries match brute force", "[scroll_culling]")
+{
+	SECTION("Reverse scroll")
+	{
+		CheckQueries(CreateReverseScrollChart());
+	}
+
+	SECTION("Gram_ex")
+	{
+		const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+		REQUIRE(chartData.error == kson::ErrorType::None);
+		CheckQueries(chartData);
+	}
+}
+
+TEST_CASE("ScrollCullingIndex of empty notes", "[scroll_culling]")
+{
+	const kson::ChartData chartData;
+	const kson::ScrollPositionCache scrollCache = kson::CreateScrollPositionCache(chartData.beat);
+	const kson::ScrollCullingIndex index = kson::CreateScrollCullingIndex(chartData.note, scrollCache);
+	REQUIRE(index.notes.empty());
+	REQUIRE(index.nodes.empty());
+
+	std::vector<std::size_t> noteIndices{ 1, 2, 3 };
+	kson::FindNotesInScrollRange(index, 0.0, 1000.0, &noteIndices);
+	REQUIRE(noteIndices.empty());
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Simd/SimdDispatch.hpp>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace
+{
+	using kson::Simd::SimdLevel;
+
+	constexpr std::array kAllSimdLevels = { SimdLevel::kScalar, SimdLevel::kSSE2, SimdLevel::kAVX2, SimdLevel::kAVX512 };
+
+	std::vector<SimdLevel> SupportedSimdLevels()
+	{
+		std::vector<SimdLevel> levels;
+		for (const SimdLevel level : kAllSimdLevels)
+		{
+			if (level <= kson::Simd::SupportedSimdLevel())
+			{
+				levels.push_back(level);
+			}
+		}
+		return levels;
+	}
+}
+
+TEST_CASE("SIMD levels", "[simd]")
+{
+	REQUIRE(kson::Simd::ActiveSimdLevel() <= kson::Simd::SupportedSimdLevel());
+	for (const SimdLevel level : kAllSimdLevels)
+	{
+		REQUIRE(kson::Simd::ParseSimdLevel(kson::Simd::SimdLevelName(level)) == level);
+	}
+	REQUIRE(!kson::Simd::ParseSimdLevel("avx").has_value());
+	REQUIRE(!kson::Simd::ParseSimdLevel("").has_value());
+	INFO("Supported: " << kson::Simd::SimdLevelName(kson::Simd::SupportedSimdLevel()));
+	INFO("Active: " << kson::Simd::SimdLevelName(kson::Simd::ActiveSimdLevel()));
+	SUCCEED();
+}
+
+TEST_CASE("AsciiPrefixLength at every SIMD level", "[simd]")
+{
+	const std::string asciiStr(300, 'a');
+	std::string str;
+	for (const SimdLevel level : SupportedSimdLevels())
+	{
+		INFO("Level: " << kson::Simd::SimdLevelName(level));
+		REQUIRE(kson::Simd::AsciiPrefixLength("", level) == 0);
+		REQUIRE(kson::Simd::AsciiPrefixLength(asciiStr, level) == asciiStr.size());
+
+		// A non-ASCII byte at every position of every length (covering the vector loops and the remainders)
+		for (std::size_t size = 1; size <= 200; size += 7)
+		{
+			for (std::size_t pos = 0; pos < size; ++pos)
+			{
+				str.assign(size, '\x7F');
+				str[pos] = '\x80';
+				if (pos + 1 < size)
+				{
+					str[pos + 1] = '\xFF';
+				}
+				REQUIRE(kson::Simd::AsciiPrefixLength(str, level) == pos);
+
+				// Unaligned start
+				REQUIRE(kson::Simd::AsciiPrefixLength(std::string_view(str).substr(1), level) == (pos == 0 ? 0 : pos - 1));
+			}
+		}
+
+		// Shift-JIS text
+		REQUIRE(kson::Simd::AsciiPrefixLength("title=\x83\x65\x83\x58\x83\x67", level) == 6);
+	}
+}
+
+TEST_CASE("EvaluateCurves at every SIMD level", "[simd]")
+{
+	std::mt19937 engine(12345);
+	std::uniform_real_distribution<double> dist(-0.1, 1.1);
+	std::vector<double> xs;
+	for (int i = 0; i < 1000; ++i)
+	{
+		xs.push_back(dist(engine));
+	}
+	for (const double x : { 0.0, -0.0, 1.0, 0.5, 0.25, 1e-300, std::numeric_limits<double>::quiet_NaN() })
+	{
+		xs.push_back(x);
+	}
+
+	std::vector<double> results(xs.size());
+	for (const double a : { 0.0, 0.1, 0.2499, 0.25, 0.5, 0.75, 1.0, -0.5, 2.0 })
+	{
+		for (const double b : { 0.0, 0.3, 1.0 })
+		{
+			for (const SimdLevel level : SupportedSimdLevels())
+			{
+				INFO("Level: " << kson::Simd::SimdLevelName(level) << ", a = " << a << ", b = " << b);
+
+				// Every count to cover the remainders of the vector loops
+				for (std::size_t count : { std::size_t{ 0 }, std::size_t{ 1 }, std::size_t{ 3 }, std::size_t{ 7 }, std::size_t{ 9 }, xs.size() })
+				{
+					std::fill(results.begin(), results.end(), -1.0);
+					kson::Simd::EvaluateCurves(a, b, xs.data(), results.data(), count, level);
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						const double expected = kson::EvaluateCurve(a, b, xs[i]);
+						INFO("x = " << xs[i]);
+						if (std::isnan(expected))
+						{
+							REQUIRE(std::isnan(results[i]));
+						}
+						else
+						{
+							REQUIRE(std::bit_cast<std::uint64_t>(results[i]) == std::bit_cast<std::uint64_t>(expected));
+						}
+					}
+					for (std::size_t i = count; i < results.size(); ++i)
+					{
+						REQUIRE(results[i] == -1.0);
+					}
+				}
+
+				// In place
+				std::vector<double> values = xs;
+				kson::Simd::EvaluateCurves(a, b, values.data(), values.data(), values.size(), level);
+				for (std::size_t i = 0; i < values.size(); ++i)
+				{
+					const double expected = kson::EvaluateCurve(a, b, xs[i]);
+					REQUIRE((std::isnan(expected) ? std::isnan(values[i]) : values[i] == expected));
+				}
+			}
+		}
+	}
+}
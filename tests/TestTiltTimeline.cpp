@@ -0,0 +1,202 @@
+#include <catch2/catch.hpp>
+#include <kson/kson.hpp>
+#include <kson/Util/TiltTimeline.hpp>
+
+extern std::string g_assetsDir;
+
+namespace
+{
+	bool IsKeepAt(const kson::ByPulse<kson::TiltValue>& tilt, kson::Pulse y)
+	{
+		const auto itr = kson::ValueItrAt(tilt, y);
+		return itr != tilt.end() && y >= itr->first && std::holds_alternative<kson::AutoTiltType>(itr->second) &&
+			kson::IsKeepAutoTiltType(std::get<kson::AutoTiltType>(itr->second));
+	}
+
+	// Tilt value computed per pulse from the existing lookups (without keep)
+	double ReferenceTiltValueAt(const kson::ChartData& chartData, kson::Pulse y)
+	{
+		const auto& tilt = chartData.camera.tilt;
+		if (const auto manualValue = kson::ManualTiltValueAt(tilt, y))
+		{
+			return *manualValue;
+		}
+		const double left = kson::GraphSectionValueAtWithDefault(chartData.note.laser[0], y, 0.0);
+		const double right = kson::GraphSectionValueAtWithDefault(chartData.note.laser[1], y, 1.0);
+		return (left + right - 1.0) * kson::AutoTiltScaleAt(tilt, y);
+	}
+
+	kson::LaserSection CreateLaserSection(std::initializer_list<std::pair<const kson::RelPulse, kson::GraphPoint>> points)
+	{
+		kson::LaserSection section;
+		section.v = points;
+		return section;
+	}
+}
+
+TEST_CASE("TiltTimeline follows lasers, tilt types and manual tilt", "[tilt_timeline]")
+{
+	kson::ChartData chartData;
+	auto& laser = chartData.note.laser;
+	laser[0][0] = CreateLaserSection({
+		{ 0, kson::GraphValue{ 0.0 } },
+		{ 240, kson::GraphValue{ 1.0, 0.5 } }, // Slam
+		{ 480, kson::GraphValue{ 0.0 } },
+	});
+	laser[0][1200] = CreateLaserSection({
+		{ 0, kson::GraphValue{ 0.5 } },
+		{ 480, kson::GraphValue{ 0.5 } },
+	});
+	laser[0][1440] = CreateLaserSection({ // Cuts off the previous section
+		{ 0, kson::GraphValue{ 0.2 } },
+		{ 240, kson::GraphValue{ 0.8 } },
+	});
+	laser[1][120] = CreateLaserSection({
+		{ 0, kson::GraphValue{ 1.0 } },
+		{ 360, kson::GraphValue{ 0.0 } },
+	});
+	laser[1][1560] = CreateLaserSection({
+		{ 0, kson::GraphValue{ 0.0, 1.0 } }, // Slam at the start
+		{ 120, kson::GraphValue{ 0.5 } },
+	});
+
+	auto& tilt = chartData.camera.tilt;
+	tilt[0] = kson::AutoTiltType::kNormal;
+	tilt[300] = kson::AutoTiltType::kBigger;
+	tilt[900] = kson::TiltGraphPoint{ kson::TiltGraphValue{ 0.5 } };
+	tilt[1000] = kson::TiltGraphPoint{ kson::TiltGraphValue{ 1.0, 2.0 } };
+	tilt[1100] = kson::AutoTiltType::kZero;
+	tilt[1300] = kson::AutoTiltType::kBiggest;
+
+	const kson::TiltTimeline timeline = kson::CreateTiltTimeline(chartData.note, tilt);
+	REQUIRE(!timeline.points.empty());
+
+	kson::TiltTimelineCursor cursor(timeline);
+	for (kson::Pulse y = 0; y < 2400; ++y)
+	{
+		const double expected = ReferenceTiltValueAt(chartData, y);
+		INFO("y = " << y);
+		REQUIRE(kson::TiltTimelineValueAt(timeline, static_cast<double>(y)) == Approx(expected).margin(1e-9));
+		REQUIRE(cursor.valueAt(static_cast<double>(y)) == Approx(expected).margin(1e-9));
+	}
+
+	// Between pulses
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 60.5) == Approx(60.5 / 240));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 950.0) == Approx(0.75));
+}
+
+TEST_CASE("TiltTimeline keeps the value with keep types", "[tilt_timeline]")
+{
+	kson::ChartData chartData;
+	auto& laser = chartData.note.laser;
+	laser[0][0] = CreateLaserSection({
+		{ 0, kson::GraphValue{ 0.0 } },
+		{ 480, kson::GraphValue{ 1.0 } },
+		{ 960, kson::GraphValue{ 0.2 } },
+		{ 1200, kson::GraphValue{ 1.0 } },
+		{ 1440, kson::GraphValue{ 0.0 } },
+	});
+	laser[1][1920] = CreateLaserSection({
+		{ 0, kson::GraphValue{ 1.0 } },
+		{ 480, kson::GraphValue{ 0.4 } },
+		{ 720, kson::GraphValue{ 0.8 } },
+	});
+
+	auto& tilt = chartData.camera.tilt;
+	tilt[0] = kson::AutoTiltType::kKeepNormal;
+	tilt[3000] = kson::AutoTiltType::kNormal;
+
+	const kson::TiltTimeline timeline = kson::CreateTiltTimeline(chartData.note, tilt);
+
+	// The value follows the lasers going right, and stays while they return
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 240.0) == Approx(0.5));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 480.0) == Approx(1.0));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 720.0) == Approx(1.0));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 1100.0) == Approx(1.0));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 1800.0) == Approx(1.0));
+
+	// It follows the lasers again once they move to the left side
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 2160.0) == Approx(-0.3));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 2400.0) == Approx(-0.6));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 2500.0) == Approx(-0.6));
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 2700.0) == Approx(-0.6));
+
+	// Not kept after returning to a normal type
+	REQUIRE(kson::TiltTimelineValueAt(timeline, 3000.0) == Approx(0.0));
+
+	// Compare with a per-pulse simulation of keep (allowing the movement of the lasers within a pulse)
+	double held = 0.0;
+	kson::TiltTimelineCursor cursor(timeline);
+	for (kson::Pulse y = 0; y < 3600; ++y)
+	{
+		const double target = ReferenceTiltValueAt(chartData, y);
+		if (!IsKeepAt(tilt, y) || (target != 0.0 && ((held > 0.0) != (target > 0.0) || std::abs(target) > std::abs(held))))
+		{
+			held = target;
+		}
+		INFO("y = " << y);
+		const double value = cursor.valueAt(static_cast<double>(y));
+		if (target == 0.0 && value == 0.0)
+		{
+			// The lasers leave the center toward the opposite side just after this pulse
+			continue;
+		}
+		REQUIRE(value == Approx(held).margin(0.01));
+	}
+}
+
+TEST_CASE("TiltTimeline subdivides curves", "[tilt_timeline]")
+{
+	kson::ChartData chartData;
+	chartData.note.laser[0][0] = CreateLaserSection({
+		{ 0, kson::GraphPoint{ kson::GraphValue{ 0.0 }, kson::GraphCurveValue{ 0.9, 0.1 } } },
+		{ 960, kson::GraphValue{ 1.0 } },
+	});
+	chartData.camera.tilt[0] = kson::AutoTiltType::kNormal;
+	chartData.camera.tilt[1200] = kson::TiltGraphPoint{ kson::TiltGraphValue{ 0.0 }, kson::GraphCurveValue{ 0.1, 0.9 } };
+	chartData.camera.tilt[2160] = kson::TiltGraphPoint{ kson::TiltGraphValue{ 2.0 } };
+
+	const kson::TiltTimeline timeline = kson::CreateTiltTimeline(chartData.note, chartData.camera.tilt, { .curveSubdivisionInterval = 10 });
+	for (kson::Pulse y = 0; y < 2400; y += 5)
+	{
+		INFO("y = " << y);
+		REQUIRE(kson::TiltTimelineValueAt(timeline, static_cast<double>(y)) == Approx(ReferenceTiltValueAt(chartData, y)).margin(0.02));
+	}
+}
+
+TEST_CASE("TiltTimelineCursor seeking", "[tilt_timeline]")
+{
+	const kson::ChartData chartData = kson::LoadKshChartData(g_assetsDir + "/Gram_ex.ksh");
+	REQUIRE(chartData.error == kson::ErrorType::None);
+	const kson::TiltTimeline timeline = kson::CreateTiltTimeline(chartData.note, chartData.camera.tilt);
+
+	// Non-keep parts match the per-pulse lookups
+	const kson::Pulse lastPulse = kson::LastNoteEndY(chartData.note) + kson::kResolution4;
+	for (kson::Pulse y = 0; y < lastPulse; y += 7)
+	{
+		if (IsKeepAt(chartData.camera.tilt, y))
+		{
+			continue;
+		}
+		INFO("y = " << y);
+		REQUIRE(kson::TiltTimelineValueAt(timeline, static_cast<double>(y)) == Approx(ReferenceTiltValueAt(chartData, y)).margin(0.02));
+	}
+
+	// Forward playback with backward and forward seeks
+	kson::TiltTimelineCursor cursor(timeline);
+	double pulse = 0.0;
+	for (int frame = 0; pulse < static_cast<double>(lastPulse); ++frame)
+	{
+		if (frame % 500 == 499)
+		{
+			pulse = std::max(pulse - kson::kResolution4 * 4, 0.0);
+		}
+		else if (frame % 700 == 699)
+		{
+			pulse += kson::kResolution4 * 8;
+		}
+		INFO("pulse = " << pulse);
+		REQUIRE(cursor.valueAt(pulse) == kson::TiltTimelineValueAt(timeline, pulse));
+		pulse += 3.7;
+	}
+}
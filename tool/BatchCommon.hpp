@@ -0,0 +1,351 @@
+#pragma once
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include "kson/kson.hpp"
+
+// Batch mode shared by the converter tools (ksh2kson, kson2ksh)
+//   <tool> --batch <manifest> --out-dir <dir> [--shard <i>/<n>] [--jobs <n>] [--journal <file>] [--index]
+//   <tool> --merge <output.tsv> <journal...>
+namespace batch
+{
+	enum ExitCode : int
+	{
+		kExitSuccess = 0,
+		kExitInvalidArgument,
+		kExitError,
+	};
+
+	struct Converter
+	{
+		std::string_view toolName;
+
+		std::string_view outputExtension; // e.g., ".kson"
+
+		std::function<kson::ChartData(std::istream&)> load;
+
+		std::function<kson::ErrorType(std::ostream&, const kson::ChartData&)> save;
+
+		bool canBuildIndex = false; // Whether --index (KSH measure index of the input) is available
+	};
+
+	struct Options
+	{
+		std::string manifestFilePath;
+
+		std::string outDir;
+
+		std::string journalFilePath;
+
+		kson::BatchShard shard;
+
+		std::size_t numThreads = 0;
+
+		bool buildIndex = false;
+	};
+
+	// Columns of the records after "status" and "path" (a failed record has the error message only)
+	constexpr const char* kRecordColumns[] = { "output", "title", "artist", "level", "note_count", "max_bpm", "duration_ms" };
+
+	inline void PrintHelp(std::string_view toolName, bool canBuildIndex)
+	{
+		std::cerr <<
+			"  Batch mode:\n"
+			"    " << toolName << " --batch <manifest> --out-dir <dir> [options]\n"
+			"      Convert the files listed in the manifest (one path per line) into <dir>, keeping their relative paths\n"
+			"      --shard <i>/<n>      Process only shard i (0-based) of n; the partition is the same on every node\n"
+			"      -j, --jobs <n>       Number of worker threads (default: number of hardware threads)\n"
+			"      --journal <file>     Journal of completed files (default: <dir>/" << toolName << "-shard-<i>-of-<n>.journal)\n";
+		if (canBuildIndex)
+		{
+			std::cerr << "      --index              Also write the measure index of each input to <dir> (.kshidx)\n";
+		}
+		std::cerr <<
+			"      Rerunning the same command resumes an interrupted job, skipping the files already done in the journal.\n"
+			"    " << toolName << " --merge <output.tsv> <journal...>\n"
+			"      Combine the journals of all shards into one tab-separated list (the last record of each file wins)\n";
+	}
+
+	inline bool IsBatchArgs(int argc, char* argv[])
+	{
+		if (argc < 2)
+		{
+			return false;
+		}
+		const std::string_view arg = argv[1];
+		return arg == "--batch" || arg == "--merge";
+	}
+
+	inline bool ParseArgs(int argc, char* argv[], std::string_view toolName, bool canBuildIndex, Options* pOptions)
+	{
+		bool hasShard = false;
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			if (arg == "--index" && canBuildIndex)
+			{
+				pOptions->buildIndex = true;
+				continue;
+			}
+			if (arg != "--batch" && arg != "--out-dir" && arg != "--shard" && arg != "-j" && arg != "--jobs" && arg != "--journal")
+			{
+				std::cerr << "Error: Unknown option: " << arg << '\n';
+				return false;
+			}
+			if (i + 1 >= argc)
+			{
+				std::cerr << "Error: Missing value for " << arg << '\n';
+				return false;
+			}
+			const char* value = argv[++i];
+			if (arg == "--batch")
+			{
+				pOptions->manifestFilePath = value;
+			}
+			else if (arg == "--out-dir")
+			{
+				pOptions->outDir = value;
+			}
+			else if (arg == "--journal")
+			{
+				pOptions->journalFilePath = value;
+			}
+			else if (arg == "--shard")
+			{
+				const auto shard = kson::ParseBatchShard(value);
+				if (!shard.has_value())
+				{
+					std::cerr << "Error: Invalid value for --shard (expected <i>/<n> with i < n): " << value << '\n';
+					return false;
+				}
+				pOptions->shard = *shard;
+				hasShard = true;
+			}
+			else
+			{
+				char* end = nullptr;
+				const unsigned long long numThreads = std::strtoull(value, &end, 10);
+				if (end == value || *end != '\0' || numThreads == 0)
+				{
+					std::cerr << "Error: Invalid value for " << arg << ": " << value << '\n';
+					return false;
+				}
+				pOptions->numThreads = static_cast<std::size_t>(numThreads);
+			}
+		}
+
+		if (pOptions->manifestFilePath.empty() || pOptions->outDir.empty())
+		{
+			std::cerr << "Error: --batch and --out-dir are required\n";
+			return false;
+		}
+		if (pOptions->journalFilePath.empty())
+		{
+			const kson::BatchShard shard = hasShard ? pOptions->shard : kson::BatchShard{};
+			pOptions->journalFilePath = (std::filesystem::path(pOptions->outDir) /
+				(std::string(toolName) + "-shard-" + std::to_string(shard.idx) + "-of-" + std::to_string(shard.count) + ".journal")).string();
+		}
+		return true;
+	}
+
+	// Path in the output directory that keeps the relative path of the input ("../" and the root are dropped so that
+	// all outputs stay inside the directory)
+	inline std::filesystem::path OutputPathOf(const Options& options, const std::string& inputPath, std::string_view extension)
+	{
+		std::filesystem::path outputPath = options.outDir;
+		for (const auto& part : std::filesystem::path(inputPath).relative_path().lexically_normal())
+		{
+			if (part != ".." && part != "." && !part.empty())
+			{
+				outputPath /= part;
+			}
+		}
+		outputPath.replace_extension(extension);
+		return outputPath;
+	}
+
+	// Writes the file via a temporary file so that an interrupted job never leaves a truncated output
+	inline kson::ErrorType WriteOutputFile(const std::filesystem::path& outputPath, const std::function<kson::ErrorType(std::ostream&)>& write)
+	{
+		std::error_code ec;
+		if (outputPath.has_parent_path())
+		{
+			std::filesystem::create_directories(outputPath.parent_path(), ec);
+		}
+		if (ec)
+		{
+			return kson::ErrorType::CouldNotOpenOutputFileStream;
+		}
+
+		std::filesystem::path tempPath = outputPath;
+		tempPath += ".tmp";
+		{
+			std::ofstream ofs(tempPath, std::ios_base::binary);
+			if (!ofs.good())
+			{
+				return kson::ErrorType::CouldNotOpenOutputFileStream;
+			}
+			if (const kson::ErrorType error = write(ofs); error != kson::ErrorType::None)
+			{
+				ofs.close();
+				std::filesystem::remove(tempPath, ec);
+				return error;
+			}
+		}
+		std::filesystem::rename(tempPath, outputPath, ec);
+		return ec ? kson::ErrorType::GeneralIOError : kson::ErrorType::None;
+	}
+
+	inline kson::BatchRecord ProcessFile(const Converter& converter, const Options& options, const std::vector<kson::ChartQuery>& statQueries, const std::string& inputPath)
+	{
+		const auto failed = [&inputPath](std::string_view message)
+		{
+			return kson::BatchRecord{ .status = kson::BatchStatus::Failed, .path = inputPath, .fields = { std::string(message) } };
+		};
+
+		std::ifstream ifs(inputPath, std::ios_base::binary);
+		if (!ifs.good())
+		{
+			return failed(kson::GetErrorString(kson::ErrorType::CouldNotOpenInputFileStream));
+		}
+		const kson::ChartData chartData = converter.load(ifs);
+		if (chartData.error != kson::ErrorType::None)
+		{
+			return failed(kson::GetErrorString(chartData.error));
+		}
+
+		const std::filesystem::path outputPath = OutputPathOf(options, inputPath, converter.outputExtension);
+		kson::ErrorType error = WriteOutputFile(outputPath, [&](std::ostream& stream) { return converter.save(stream, chartData); });
+		if (error != kson::ErrorType::None)
+		{
+			return failed(kson::GetErrorString(error));
+		}
+
+		if (options.buildIndex)
+		{
+			// Built from the file path so that the index records the size and time of the input
+			const kson::KshMeasureIndex index = kson::BuildKshMeasureIndex(inputPath);
+			error = index.error;
+			if (error == kson::ErrorType::None)
+			{
+				error = WriteOutputFile(OutputPathOf(options, inputPath, ".ksh.kshidx"), [&](std::ostream& stream) { return kson::SaveKshMeasureIndex(stream, index); });
+			}
+			if (error != kson::ErrorType::None)
+			{
+				return failed(kson::GetErrorString(error));
+			}
+		}
+
+		kson::BatchRecord record{ .status = kson::BatchStatus::Done, .path = inputPath };
+		record.fields.push_back(outputPath.string());
+		for (const kson::ChartQuery& query : statQueries)
+		{
+			record.fields.push_back(kson::ChartQueryValueToString(query.evaluate(chartData)));
+		}
+		return record;
+	}
+
+	inline int RunBatch(const Converter& converter, int argc, char* argv[])
+	{
+		Options options;
+		if (!ParseArgs(argc, argv, converter.toolName, converter.canBuildIndex, &options))
+		{
+			PrintHelp(converter.toolName, converter.canBuildIndex);
+			return kExitInvalidArgument;
+		}
+
+		const kson::BatchManifest manifest = kson::LoadBatchManifest(options.manifestFilePath);
+		if (manifest.error != kson::ErrorType::None)
+		{
+			std::cerr << "Error: " << kson::GetErrorString(manifest.error) << ": " << options.manifestFilePath << '\n';
+			return kExitError;
+		}
+
+		std::error_code ec;
+		std::filesystem::create_directories(options.outDir, ec);
+		if (ec)
+		{
+			std::cerr << "Error: Cannot create directory: " << options.outDir << " (" << ec.message() << ")\n";
+			return kExitError;
+		}
+
+		std::vector<kson::ChartQuery> statQueries;
+		for (std::size_t i = 1; i < std::size(kRecordColumns); ++i)
+		{
+			statQueries.push_back(*kson::ParseChartQuery(kRecordColumns[i]));
+		}
+
+		const kson::BatchJobOptions jobOptions{
+			.shard = options.shard,
+			.journalFilePath = options.journalFilePath,
+			.numThreads = options.numThreads,
+		};
+		const kson::BatchJobResult result = kson::RunBatchJob(manifest.paths, jobOptions, [&](const std::string& inputPath)
+		{
+			return ProcessFile(converter, options, statQueries, inputPath);
+		});
+		std::cerr << "Shard " << options.shard.idx << '/' << options.shard.count << ": "
+			<< result.numFiles << " files, " << result.numSkipped << " skipped (already done), "
+			<< result.numDone << " done, " << result.numFailed << " failed\n";
+		if (result.error != kson::ErrorType::None)
+		{
+			std::cerr << "Error: " << kson::GetErrorString(result.error) << ": " << options.journalFilePath << '\n';
+			return kExitError;
+		}
+		return result.numFailed > 0 ? kExitError : kExitSuccess;
+	}
+
+	inline int RunMerge(std::string_view toolName, bool canBuildIndex, int argc, char* argv[])
+	{
+		if (argc < 4)
+		{
+			std::cerr << "Error: --merge requires an output file and at least one journal\n";
+			PrintHelp(toolName, canBuildIndex);
+			return kExitInvalidArgument;
+		}
+
+		const std::vector<std::string> journalFilePaths(argv + 3, argv + argc);
+		std::vector<kson::BatchRecord> records;
+		if (const kson::ErrorType error = kson::MergeBatchJournals(journalFilePaths, &records); error != kson::ErrorType::None)
+		{
+			std::cerr << "Error: " << kson::GetErrorString(error) << '\n';
+			return kExitError;
+		}
+
+		// The merged file has the same format as the journals (with a header comment), so it can be merged again
+		std::size_t numFailed = 0;
+		const kson::ErrorType error = WriteOutputFile(argv[2], [&](std::ostream& stream)
+		{
+			stream << "#status\tpath";
+			for (const char* column : kRecordColumns)
+			{
+				stream << '\t' << column;
+			}
+			stream << '\n';
+			for (const kson::BatchRecord& record : records)
+			{
+				stream << kson::FormatBatchRecord(record) << '\n';
+				numFailed += record.status == kson::BatchStatus::Failed;
+			}
+			return stream.good() ? kson::ErrorType::None : kson::ErrorType::GeneralIOError;
+		});
+		if (error != kson::ErrorType::None)
+		{
+			std::cerr << "Error: " << kson::GetErrorString(error) << ": " << argv[2] << '\n';
+			return kExitError;
+		}
+		std::cerr << records.size() << " files, " << numFailed << " failed\n";
+		return numFailed > 0 ? kExitError : kExitSuccess;
+	}
+
+	inline int Run(const Converter& converter, int argc, char* argv[])
+	{
+		if (std::string_view(argv[1]) == "--merge")
+		{
+			return RunMerge(converter.toolName, converter.canBuildIndex, argc, argv);
+		}
+		return RunBatch(converter, argc, argv);
+	}
+}
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <filesystem>
 #include "kson/kson.hpp"
+#include "BatchCommon.hpp"
 #include "ksh2kson_version.h"
 
 enum ExitCode : int
@@ -20,6 +21,7 @@ void PrintHelp()
 		"    ksh2kson <input.ksh>         Convert file and output to stdout\n"
 		"    ksh2kson < input.ksh         Read from stdin and output to stdout\n"
 		"    cat input.ksh | ksh2kson     Read from pipe and output to stdout\n";
+	batch::PrintHelp("ksh2kson", true);
 }
 
 void PrintError(kson::ErrorType errorType)
@@ -50,31 +52,59 @@ int DoConvert(std::istream& input)
 	return kExitSuccess;
 }
 
-int main(int argc, char *argv[])
+int RunBatch(int argc, char *argv[])
 {
-	try
-	{
-		if (argc == 1)
+	const batch::Converter converter{
+		.toolName = "ksh2kson",
+		.outputExtension = ".kson",
+		.load = [](std::istream& input)
 		{
-			// Read from stdin
-			return DoConvert(std::cin);
-		}
-		else if (argc == 2)
-		{
-			// Read from file
-			std::ifstream ifs{ argv[1] };
-			if (!ifs)
-			{
-				std::cerr << "Error: Cannot open file: " << argv[1] << '\n';
-				return kExitError;
-			}
-			return DoConvert(ifs);
-		}
-		else
+			kson::ChartData chartData = kson::LoadKshChartData(input);
+			chartData.editor.appName = kKsh2KsonAppName;
+			chartData.editor.appVersion = kKsh2KsonVersionFull;
+			return chartData;
+		},
+		.save = [](std::ostream& output, const kson::ChartData& chartData) { return kson::SaveKsonChartData(output, chartData); },
+		.canBuildIndex = true,
+	};
+	return batch::Run(converter, argc, argv);
+}
+
+int Run(int argc, char *argv[])
+{
+	if (batch::IsBatchArgs(argc, argv))
+	{
+		return RunBatch(argc, argv);
+	}
+	else if (argc == 1)
+	{
+		// Read from stdin
+		return DoConvert(std::cin);
+	}
+	else if (argc == 2)
+	{
+		// Read from file
+		std::ifstream ifs{ argv[1] };
+		if (!ifs)
 		{
-			PrintHelp();
-			return kExitNoArgument;
+			std::cerr << "Error: Cannot open file: " << argv[1] << '\n';
+			return kExitError;
 		}
+		return DoConvert(ifs);
+	}
+	else
+	{
+		PrintHelp();
+		return kExitNoArgument;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		return Run(argc, argv);
 	}
 	catch (const std::exception& e)
 	{
@@ -86,4 +116,7 @@ int main(int argc, char *argv[])
 		std::cerr << "Error: Uncaught exception (unknown)\n";
 		return kExitError;
 	}
+#else
+	return Run(argc, argv);
+#endif
 }
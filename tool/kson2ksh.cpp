@@ -3,6 +3,7 @@
 #include <sstream>
 #include <filesystem>
 #include "kson/kson.hpp"
+#include "BatchCommon.hpp"
 
 enum ExitCode : int
 {
@@ -19,6 +20,7 @@ void PrintHelp()
 		"    kson2ksh <input.kson>         Convert file and output to stdout\n"
 		"    kson2ksh < input.kson         Read from stdin and output to stdout\n"
 		"    cat input.kson | kson2ksh     Read from pipe and output to stdout\n";
+	batch::PrintHelp("kson2ksh", false);
 }
 
 void PrintError(kson::ErrorType errorType)
@@ -45,31 +47,52 @@ int DoConvert(std::istream& input)
 	return kExitSuccess;
 }
 
-int main(int argc, char *argv[])
+int RunBatch(int argc, char *argv[])
 {
-	try
+	const batch::Converter converter{
+		.toolName = "kson2ksh",
+		.outputExtension = ".ksh",
+		.load = [](std::istream& input) { return kson::LoadKsonChartData(input); },
+		.save = [](std::ostream& output, const kson::ChartData& chartData) { return kson::SaveKshChartData(output, chartData); },
+	};
+	return batch::Run(converter, argc, argv);
+}
+
+int Run(int argc, char *argv[])
+{
+	if (batch::IsBatchArgs(argc, argv))
 	{
-		if (argc == 1)
-		{
-			// Read from stdin
-			return DoConvert(std::cin);
-		}
-		else if (argc == 2)
-		{
-			// Read from file
-			std::ifstream ifs{ argv[1] };
-			if (!ifs)
-			{
-				std::cerr << "Error: Cannot open file: " << argv[1] << '\n';
-				return kExitError;
-			}
-			return DoConvert(ifs);
-		}
-		else
+		return RunBatch(argc, argv);
+	}
+	else if (argc == 1)
+	{
+		// Read from stdin
+		return DoConvert(std::cin);
+	}
+	else if (argc == 2)
+	{
+		// Read from file
+		std::ifstream ifs{ argv[1] };
+		if (!ifs)
 		{
-			PrintHelp();
-			return kExitNoArgument;
+			std::cerr << "Error: Cannot open file: " << argv[1] << '\n';
+			return kExitError;
 		}
+		return DoConvert(ifs);
+	}
+	else
+	{
+		PrintHelp();
+		return kExitNoArgument;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		return Run(argc, argv);
 	}
 	catch (const std::exception& e)
 	{
@@ -81,4 +104,7 @@ int main(int argc, char *argv[])
 		std::cerr << "Error: Uncaught exception (unknown)\n";
 		return kExitError;
 	}
+#else
+	return Run(argc, argv);
+#endif
 }
@@ -0,0 +1,313 @@
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "kson/kson.hpp"
+
+enum ExitCode : int
+{
+	kExitSuccess = 0,
+	kExitInvalidArgument,
+	kExitError,
+};
+
+namespace
+{
+	struct QueryOptions
+	{
+		std::string expression;
+
+		std::vector<std::string> columns; // CSV output if not empty
+
+		std::vector<std::string> inputPaths;
+
+		std::size_t numThreads = 0;
+
+		bool listFields = false;
+	};
+
+	void PrintHelp()
+	{
+		std::cerr <<
+			"kson_query chart query tool\n"
+			"  Usage:\n"
+			"    kson_query [options] <expression> <file or directory ...>\n"
+			"  Options:\n"
+			"    -j, --jobs <n>         Number of worker threads (default: number of hardware threads)\n"
+			"    -c, --column <expr>    Output matching charts as CSV with the path and this column (repeatable)\n"
+			"    --list                 List the available fields and functions\n"
+			"  Directories are searched recursively for .ksh and .kson files. Charts are loaded in parallel\n"
+			"  and results are written to stdout as soon as each chart is evaluated (in completion order).\n"
+			"  Example:\n"
+			"    kson_query 'max_bpm > 300 && laser_slam_count > 100' songs/\n"
+			"    kson_query -c title -c level 'defines_fx_type(\"sidechain\")' songs/\n";
+	}
+
+	void PrintFieldList()
+	{
+		std::cout << "Fields:\n";
+		for (const std::string_view name : kson::ChartQueryFieldNames())
+		{
+			std::cout << "  " << name << '\n';
+		}
+		std::cout << "Functions:\n";
+		for (const std::string_view name : kson::ChartQueryFunctionNames())
+		{
+			std::cout << "  " << name << "()\n";
+		}
+	}
+
+	bool ParseArgs(int argc, char* argv[], QueryOptions* pOptions)
+	{
+		std::vector<std::string> positionalArgs;
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			if (arg == "--help" || arg == "-h")
+			{
+				return false;
+			}
+			else if (arg == "--list")
+			{
+				pOptions->listFields = true;
+			}
+			else if (arg == "-j" || arg == "--jobs" || arg == "-c" || arg == "--column")
+			{
+				if (i + 1 >= argc)
+				{
+					std::cerr << "Error: Missing value for " << arg << '\n';
+					return false;
+				}
+				const char* value = argv[++i];
+				if (arg == "-c" || arg == "--column")
+				{
+					pOptions->columns.emplace_back(value);
+					continue;
+				}
+				char* end = nullptr;
+				const unsigned long long numThreads = std::strtoull(value, &end, 10);
+				if (end == value || *end != '\0' || numThreads == 0)
+				{
+					std::cerr << "Error: Invalid value for " << arg << ": " << value << '\n';
+					return false;
+				}
+				pOptions->numThreads = static_cast<std::size_t>(numThreads);
+			}
+			else if (arg.starts_with("-") && arg.size() > 1)
+			{
+				std::cerr << "Error: Unknown option: " << arg << '\n';
+				return false;
+			}
+			else
+			{
+				positionalArgs.emplace_back(arg);
+			}
+		}
+
+		if (pOptions->listFields)
+		{
+			return true;
+		}
+		if (positionalArgs.size() < 2)
+		{
+			std::cerr << "Error: An expression and at least one input path are required\n";
+			return false;
+		}
+		pOptions->expression = positionalArgs.front();
+		pOptions->inputPaths.assign(positionalArgs.begin() + 1, positionalArgs.end());
+		return true;
+	}
+
+	bool IsChartFile(const std::filesystem::path& path)
+	{
+		const auto ext = path.extension();
+		return ext == ".ksh" || ext == ".kson";
+	}
+
+	bool CollectChartFiles(const std::vector<std::string>& inputPaths, std::vector<std::filesystem::path>* pFiles)
+	{
+		for (const std::string& inputPath : inputPaths)
+		{
+			std::error_code ec;
+			if (std::filesystem::is_directory(inputPath, ec))
+			{
+				for (auto itr = std::filesystem::recursive_directory_iterator(inputPath, std::filesystem::directory_options::skip_permission_denied, ec);
+					!ec && itr != std::filesystem::recursive_directory_iterator(); itr.increment(ec))
+				{
+					if (itr->is_regular_file(ec) && IsChartFile(itr->path()))
+					{
+						pFiles->push_back(itr->path());
+					}
+				}
+			}
+			else if (std::filesystem::is_regular_file(inputPath, ec))
+			{
+				pFiles->emplace_back(inputPath);
+			}
+			else
+			{
+				std::cerr << "Error: Cannot open: " << inputPath << '\n';
+				return false;
+			}
+			if (ec)
+			{
+				std::cerr << "Error: Cannot read directory: " << inputPath << " (" << ec.message() << ")\n";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string EscapeCSV(std::string_view str)
+	{
+		if (str.find_first_of(",\"\r\n") == std::string_view::npos)
+		{
+			return std::string(str);
+		}
+		std::string escaped = "\"";
+		for (const char c : str)
+		{
+			if (c == '"')
+			{
+				escaped += '"';
+			}
+			escaped += c;
+		}
+		escaped += '"';
+		return escaped;
+	}
+}
+
+int Run(int argc, char* argv[])
+{
+	QueryOptions options;
+	if (!ParseArgs(argc, argv, &options))
+	{
+		PrintHelp();
+		return kExitInvalidArgument;
+	}
+	if (options.listFields)
+	{
+		PrintFieldList();
+		return kExitSuccess;
+	}
+
+	std::string errorMessage;
+	const std::optional<kson::ChartQuery> query = kson::ParseChartQuery(options.expression, &errorMessage);
+	if (!query.has_value())
+	{
+		std::cerr << "Error: Invalid expression: " << errorMessage << '\n';
+		return kExitInvalidArgument;
+	}
+	std::vector<kson::ChartQuery> columns;
+	for (const std::string& column : options.columns)
+	{
+		std::optional<kson::ChartQuery> columnQuery = kson::ParseChartQuery(column, &errorMessage);
+		if (!columnQuery.has_value())
+		{
+			std::cerr << "Error: Invalid column '" << column << "': " << errorMessage << '\n';
+			return kExitInvalidArgument;
+		}
+		columns.push_back(std::move(*columnQuery));
+	}
+
+	std::vector<std::filesystem::path> files;
+	if (!CollectChartFiles(options.inputPaths, &files))
+	{
+		return kExitError;
+	}
+
+	if (!columns.empty())
+	{
+		std::cout << "path";
+		for (const std::string& column : options.columns)
+		{
+			std::cout << ',' << EscapeCSV(column);
+		}
+		std::cout << '\n';
+	}
+
+	std::mutex outputMutex;
+	std::atomic<std::size_t> nextIdx = 0;
+	std::atomic<std::size_t> numErrors = 0;
+	const auto worker = [&]()
+	{
+		std::string line;
+		for (std::size_t idx = nextIdx++; idx < files.size(); idx = nextIdx++)
+		{
+			const std::filesystem::path& file = files[idx];
+			const std::string filePath = file.string();
+			const kson::ChartData chartData = file.extension() == ".kson" ? kson::LoadKsonChartData(filePath) : kson::LoadKshChartData(filePath);
+			if (chartData.error != kson::ErrorType::None)
+			{
+				++numErrors;
+				const std::lock_guard lock(outputMutex);
+				std::cerr << "Error: " << kson::GetErrorString(chartData.error) << ": " << filePath << '\n';
+				continue;
+			}
+			if (!query->matches(chartData))
+			{
+				continue;
+			}
+
+			// Format outside the lock so that only the write is serialized
+			if (columns.empty())
+			{
+				line = filePath;
+			}
+			else
+			{
+				line = EscapeCSV(filePath);
+				for (const kson::ChartQuery& column : columns)
+				{
+					line += ',';
+					line += EscapeCSV(kson::ChartQueryValueToString(column.evaluate(chartData)));
+				}
+			}
+			line += '\n';
+
+			const std::lock_guard lock(outputMutex);
+			std::cout << line << std::flush;
+		}
+	};
+
+	std::size_t numThreads = options.numThreads != 0 ? options.numThreads : std::max(std::thread::hardware_concurrency(), 1U);
+	numThreads = std::max(std::min(numThreads, files.size()), std::size_t{ 1 });
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for (std::size_t i = 0; i + 1 < numThreads; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	return numErrors > 0 ? kExitError : kExitSuccess;
+}
+
+int main(int argc, char* argv[])
+{
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		return Run(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: Uncaught exception '" << e.what() << "'\n";
+		return kExitError;
+	}
+	catch (...)
+	{
+		std::cerr << "Error: Uncaught exception (unknown)\n";
+		return kExitError;
+	}
+#else
+	return Run(argc, argv);
+#endif
+}
@@ -0,0 +1,341 @@
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "kson/kson.hpp"
+#include "kson/Util/ChartThumbnail.hpp"
+
+enum ExitCode : int
+{
+	kExitSuccess = 0,
+	kExitInvalidArgument,
+	kExitError,
+};
+
+namespace
+{
+	enum class ImageFormat
+	{
+		PPM,
+		PAM,
+	};
+
+	struct ThumbnailOptions
+	{
+		std::filesystem::path outputDirectory;
+
+		std::vector<std::string> inputPaths;
+
+		kson::ChartThumbnailParams params;
+
+		ImageFormat format = ImageFormat::PPM;
+
+		std::size_t numThreads = 0;
+
+		bool update = false;
+	};
+
+	// Chart file and its output path relative to the output directory
+	struct ThumbnailJob
+	{
+		std::filesystem::path inputPath;
+		std::filesystem::path relativeOutputPath;
+	};
+
+	void PrintHelp()
+	{
+		std::cerr <<
+			"kson_thumbnail chart overview image generator\n"
+			"  Usage:\n"
+			"    kson_thumbnail [options] -o <output directory> <file or directory ...>\n"
+			"  Options:\n"
+			"    -o, --out-dir <dir>    Output directory (required)\n"
+			"    -f, --format <fmt>     Image format: ppm (RGB, default) or pam (RGBA)\n"
+			"    --width <n>            Image width in pixels (default: 48)\n"
+			"    --height <n>           Image height in pixels (default: 512)\n"
+			"    -j, --jobs <n>         Number of worker threads (default: number of hardware threads)\n"
+			"    -u, --update           Skip charts whose image is newer than the chart file\n"
+			"  Directories are searched recursively for .ksh and .kson files, and the images are written to\n"
+			"  the same relative paths under the output directory with the image extension appended\n"
+			"  (e.g., songs/foo/ex.ksh -> <output directory>/foo/ex.ksh.ppm).\n";
+	}
+
+	bool ParsePositiveInteger(const char* value, std::size_t* pResult)
+	{
+		char* end = nullptr;
+		const unsigned long long result = std::strtoull(value, &end, 10);
+		if (end == value || *end != '\0' || result == 0 || result > 65536)
+		{
+			return false;
+		}
+		*pResult = static_cast<std::size_t>(result);
+		return true;
+	}
+
+	bool ParseArgs(int argc, char* argv[], ThumbnailOptions* pOptions)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			if (arg == "--help" || arg == "-h")
+			{
+				return false;
+			}
+			else if (arg == "-u" || arg == "--update")
+			{
+				pOptions->update = true;
+			}
+			else if (arg == "-o" || arg == "--out-dir" || arg == "-f" || arg == "--format" || arg == "--width" || arg == "--height" || arg == "-j" || arg == "--jobs")
+			{
+				if (i + 1 >= argc)
+				{
+					std::cerr << "Error: Missing value for " << arg << '\n';
+					return false;
+				}
+				const char* value = argv[++i];
+				if (arg == "-o" || arg == "--out-dir")
+				{
+					pOptions->outputDirectory = value;
+					continue;
+				}
+				if (arg == "-f" || arg == "--format")
+				{
+					const std::string_view format = value;
+					if (format == "ppm")
+					{
+						pOptions->format = ImageFormat::PPM;
+					}
+					else if (format == "pam")
+					{
+						pOptions->format = ImageFormat::PAM;
+					}
+					else
+					{
+						std::cerr << "Error: Invalid value for " << arg << ": " << value << '\n';
+						return false;
+					}
+					continue;
+				}
+
+				std::size_t number = 0;
+				if (!ParsePositiveInteger(value, &number))
+				{
+					std::cerr << "Error: Invalid value for " << arg << ": " << value << '\n';
+					return false;
+				}
+				if (arg == "--width")
+				{
+					pOptions->params.width = static_cast<std::int32_t>(number);
+				}
+				else if (arg == "--height")
+				{
+					pOptions->params.height = static_cast<std::int32_t>(number);
+				}
+				else
+				{
+					pOptions->numThreads = number;
+				}
+			}
+			else if (arg.starts_with("-") && arg.size() > 1)
+			{
+				std::cerr << "Error: Unknown option: " << arg << '\n';
+				return false;
+			}
+			else
+			{
+				pOptions->inputPaths.emplace_back(arg);
+			}
+		}
+
+		if (pOptions->outputDirectory.empty())
+		{
+			std::cerr << "Error: An output directory is required\n";
+			return false;
+		}
+		if (pOptions->inputPaths.empty())
+		{
+			std::cerr << "Error: At least one input path is required\n";
+			return false;
+		}
+		return true;
+	}
+
+	bool IsChartFile(const std::filesystem::path& path)
+	{
+		const auto ext = path.extension();
+		return ext == ".ksh" || ext == ".kson";
+	}
+
+	bool CollectJobs(const std::vector<std::string>& inputPaths, std::vector<ThumbnailJob>* pJobs)
+	{
+		for (const std::string& inputPath : inputPaths)
+		{
+			std::error_code ec;
+			if (std::filesystem::is_directory(inputPath, ec))
+			{
+				for (auto itr = std::filesystem::recursive_directory_iterator(inputPath, std::filesystem::directory_options::skip_permission_denied, ec);
+					!ec && itr != std::filesystem::recursive_directory_iterator(); itr.increment(ec))
+				{
+					if (itr->is_regular_file(ec) && IsChartFile(itr->path()))
+					{
+						pJobs->push_back({
+							.inputPath = itr->path(),
+							.relativeOutputPath = itr->path().lexically_relative(inputPath),
+						});
+					}
+				}
+			}
+			else if (std::filesystem::is_regular_file(inputPath, ec))
+			{
+				pJobs->push_back({
+					.inputPath = inputPath,
+					.relativeOutputPath = std::filesystem::path(inputPath).filename(),
+				});
+			}
+			else
+			{
+				std::cerr << "Error: Cannot open: " << inputPath << '\n';
+				return false;
+			}
+			if (ec)
+			{
+				std::cerr << "Error: Cannot read directory: " << inputPath << " (" << ec.message() << ")\n";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool IsUpToDate(const std::filesystem::path& inputPath, const std::filesystem::path& outputPath)
+	{
+		std::error_code ec;
+		const auto outputTime = std::filesystem::last_write_time(outputPath, ec);
+		if (ec)
+		{
+			return false;
+		}
+		const auto inputTime = std::filesystem::last_write_time(inputPath, ec);
+		return !ec && inputTime < outputTime;
+	}
+
+	// Writes to a temporary file first so that an interrupted run does not leave a truncated image regarded as up to date
+	kson::ErrorType SaveThumbnail(const std::filesystem::path& outputPath, const kson::ChartThumbnail& thumbnail, ImageFormat format)
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(outputPath.parent_path(), ec);
+		if (ec)
+		{
+			return kson::ErrorType::CouldNotOpenOutputFileStream;
+		}
+
+		std::filesystem::path tmpPath = outputPath;
+		tmpPath += ".tmp";
+		const kson::ErrorType error = format == ImageFormat::PAM
+			? kson::SaveChartThumbnailPAM(tmpPath.string(), thumbnail)
+			: kson::SaveChartThumbnailPPM(tmpPath.string(), thumbnail);
+		if (error != kson::ErrorType::None)
+		{
+			std::filesystem::remove(tmpPath, ec);
+			return error;
+		}
+		std::filesystem::rename(tmpPath, outputPath, ec);
+		return ec ? kson::ErrorType::GeneralIOError : kson::ErrorType::None;
+	}
+}
+
+int Run(int argc, char* argv[])
+{
+	ThumbnailOptions options;
+	if (!ParseArgs(argc, argv, &options))
+	{
+		PrintHelp();
+		return kExitInvalidArgument;
+	}
+
+	std::vector<ThumbnailJob> jobs;
+	if (!CollectJobs(options.inputPaths, &jobs))
+	{
+		return kExitError;
+	}
+
+	const std::string_view imageExtension = options.format == ImageFormat::PAM ? ".pam" : ".ppm";
+	std::mutex outputMutex;
+	std::atomic<std::size_t> nextIdx = 0;
+	std::atomic<std::size_t> numDone = 0;
+	std::atomic<std::size_t> numSkipped = 0;
+	std::atomic<std::size_t> numErrors = 0;
+	const auto worker = [&]()
+	{
+		// Reused for all charts of this thread
+		kson::ChartThumbnail thumbnail;
+		for (std::size_t idx = nextIdx++; idx < jobs.size(); idx = nextIdx++)
+		{
+			const ThumbnailJob& job = jobs[idx];
+			std::filesystem::path outputPath = options.outputDirectory / job.relativeOutputPath;
+			outputPath += imageExtension;
+			if (options.update && IsUpToDate(job.inputPath, outputPath))
+			{
+				++numSkipped;
+				continue;
+			}
+
+			const std::string inputPath = job.inputPath.string();
+			const kson::ChartData chartData = job.inputPath.extension() == ".kson" ? kson::LoadKsonChartData(inputPath) : kson::LoadKshChartData(inputPath);
+			kson::ErrorType error = chartData.error;
+			if (error == kson::ErrorType::None)
+			{
+				kson::RenderChartThumbnail(chartData, options.params, &thumbnail);
+				error = SaveThumbnail(outputPath, thumbnail, options.format);
+			}
+			if (error != kson::ErrorType::None)
+			{
+				++numErrors;
+				const std::lock_guard lock(outputMutex);
+				std::cerr << "Error: " << kson::GetErrorString(error) << ": " << inputPath << '\n';
+				continue;
+			}
+			++numDone;
+		}
+	};
+
+	std::size_t numThreads = options.numThreads != 0 ? options.numThreads : std::max(std::thread::hardware_concurrency(), 1U);
+	numThreads = std::max(std::min(numThreads, jobs.size()), std::size_t{ 1 });
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for (std::size_t i = 0; i + 1 < numThreads; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	std::cerr << jobs.size() << " charts: " << numDone << " done, " << numSkipped << " skipped (up to date), " << numErrors << " failed\n";
+	return numErrors > 0 ? kExitError : kExitSuccess;
+}
+
+int main(int argc, char* argv[])
+{
+#if KSON_HAS_EXCEPTIONS
+	try
+	{
+		return Run(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: Uncaught exception '" << e.what() << "'\n";
+		return kExitError;
+	}
+	catch (...)
+	{
+		std::cerr << "Error: Uncaught exception (unknown)\n";
+		return kExitError;
+	}
+#else
+	return Run(argc, argv);
+#endif
+}